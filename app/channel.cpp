@@ -1,9 +1,13 @@
 #include "channel.hpp"
+#include "host-ipmid/ipmid-async.hpp"
+#include "host-ipmid/ipmid-view.hpp"
 #include "types.hpp"
 #include "transporthandler.hpp"
 #include "utils.hpp"
 #include "net.hpp"
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <arpa/inet.h>
 
@@ -47,15 +51,194 @@ struct GetChannelAccessResponse
     uint8_t privilegeLimit;    //!< Channel privilege level limit.
 } __attribute__((packed));
 
-ipmi_ret_t ipmi_set_channel_access(ipmi_netfn_t netfn,
-                                   ipmi_cmd_t cmd,
-                                   ipmi_request_t request,
-                                   ipmi_response_t response,
-                                   ipmi_data_len_t data_len,
-                                   ipmi_context_t context)
+namespace
 {
-    ipmi_ret_t rc = IPMI_CC_OK;
 
+/** @brief Deadline of each round of deletes of a Set Channel Access command */
+constexpr auto deleteTimeout = std::chrono::seconds(30);
+
+/** @brief Whether the network data of a Set Channel Access is being applied */
+bool applyRunning = false;
+
+/** @struct NetworkApply
+ *
+ *  Network data a Set Channel Access command applies, kept across the
+ *  rounds of deletes.
+ */
+struct NetworkApply
+{
+    std::string ethdevice;
+    std::string ethIp;
+    ipmi::network::IPOrigin ipsrc;
+    std::string ipaddress;
+    std::string gateway;
+    uint8_t prefix {};
+    uint32_t vlanID {};
+    ipmi::DbusObjectInfo systemObject;
+    std::string networkInterfacePath;
+    ipmid_responder_t responder;
+};
+
+void applyDone(NetworkApply& apply, ipmi_ret_t rc)
+{
+    applyRunning = false;
+    apply.responder(rc, {});
+}
+
+void applyFailed(NetworkApply& apply)
+{
+    log<level::ERR>("Failed to set network data",
+                    entry("PREFIX=%d", apply.prefix),
+                    entry("ADDRESS=%s", apply.ipaddress.c_str()),
+                    entry("GATEWAY=%s", apply.gateway.c_str()),
+                    entry("VLANID=%d", apply.vlanID),
+                    entry("IPSRC=%d", apply.ipsrc));
+
+    commit<InternalFailure>();
+    applyDone(apply, IPMI_CC_UNSPECIFIED_ERROR);
+}
+
+/** @brief Creates the VLAN interface and sets the IP source, address and
+ *         gateway, once the old VLAN interfaces and addresses are deleted.
+ */
+void configure(NetworkApply& apply)
+{
+    try
+    {
+        sdbusplus::bus::bus bus(ipmid_get_sd_bus_connection());
+        auto networkInterfacePath = apply.networkInterfacePath;
+
+        if (apply.vlanID)
+        {
+            ipmi::network::createVLAN(bus,
+                                      ipmi::network::SERVICE,
+                                      ipmi::network::ROOT,
+                                      apply.ethdevice,
+                                      apply.vlanID);
+
+            auto networkInterfaceObject = ipmi::getDbusObject(
+                    bus,
+                    ipmi::network::VLAN_INTERFACE,
+                    ipmi::network::ROOT);
+
+            networkInterfacePath = networkInterfaceObject.first;
+        }
+
+        if (apply.ipsrc == ipmi::network::IPOrigin::DHCP)
+        {
+            ipmi::setDbusProperty(bus,
+                                  ipmi::network::SERVICE,
+                                  networkInterfacePath,
+                                  ipmi::network::ETHERNET_INTERFACE,
+                                  "DHCPEnabled",
+                                  true);
+        }
+        else
+        {
+            //change the mode to static
+            ipmi::setDbusProperty(bus,
+                                  ipmi::network::SERVICE,
+                                  networkInterfacePath,
+                                  ipmi::network::ETHERNET_INTERFACE,
+                                  "DHCPEnabled",
+                                  false);
+
+            if (!apply.ipaddress.empty())
+            {
+                ipmi::network::createIP(bus,
+                                        ipmi::network::SERVICE,
+                                        networkInterfacePath,
+                                        ipv4Protocol,
+                                        apply.ipaddress,
+                                        apply.prefix);
+            }
+
+            if (!apply.gateway.empty())
+            {
+                ipmi::setDbusProperty(bus,
+                                      apply.systemObject.second,
+                                      apply.systemObject.first,
+                                      ipmi::network::SYSTEMCONFIG_INTERFACE,
+                                      "DefaultGateway",
+                                      std::string(apply.gateway));
+            }
+        }
+    }
+    catch (InternalFailure& e)
+    {
+        applyFailed(apply);
+        return;
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>(e.what());
+        applyFailed(apply);
+        return;
+    }
+
+    applyDone(apply, IPMI_CC_OK);
+}
+
+/** @brief Sets the physical interface to static and deletes its ipv4
+ *         addresses, once the VLAN interfaces are deleted.
+ */
+void deleteAddresses(std::shared_ptr<NetworkApply> apply)
+{
+    auto bus = ipmid_get_sd_bus_connection();
+    try
+    {
+        sdbusplus::bus::bus dbus{bus};
+
+        // set the interface mode  to static
+        auto networkInterfaceObject = ipmi::getDbusObject(
+                dbus,
+                ipmi::network::ETHERNET_INTERFACE,
+                ipmi::network::ROOT,
+                apply->ethdevice);
+
+        // setting the physical interface mode to static.
+        ipmi::setDbusProperty(dbus,
+                              ipmi::network::SERVICE,
+                              networkInterfaceObject.first,
+                              ipmi::network::ETHERNET_INTERFACE,
+                              "DHCPEnabled",
+                              false);
+
+        apply->networkInterfacePath = std::move(networkInterfaceObject.first);
+    }
+    catch (InternalFailure& e)
+    {
+        applyFailed(*apply);
+        return;
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>(e.what());
+        applyFailed(*apply);
+        return;
+    }
+
+    //delete all the ipv4 addresses
+    ipmi::deleteAllDbusObjects(bus,
+                               ipmi::network::ROOT,
+                               ipmi::network::IP_INTERFACE,
+                               apply->ethIp,
+                               deleteTimeout,
+                               [apply]()
+                               {
+                                   configure(*apply);
+                               });
+}
+
+} // namespace
+
+void ipmi_set_channel_access(ipmi_netfn_t netfn,
+                             ipmi_cmd_t cmd,
+                             ipmi_request_t request,
+                             size_t len,
+                             ipmid_responder_t responder,
+                             ipmi_context_t context)
+{
     std::string ipaddress;
     std::string gateway;
     uint8_t prefix {};
@@ -64,19 +247,30 @@ ipmi_ret_t ipmi_set_channel_access(ipmi_netfn_t netfn,
     ipmi::DbusObjectInfo ipObject;
     ipmi::DbusObjectInfo systemObject;
 
-    if (*data_len < sizeof(SetChannelAccessRequest))
+    ipmi::RequestView req(request, len);
+
+    auto requestData = req.get<SetChannelAccessRequest>();
+    if (requestData == nullptr)
     {
-        return IPMI_CC_INVALID;
+        responder(IPMI_CC_REQ_DATA_LEN_INVALID, {});
+        return;
     }
 
-    auto requestData = reinterpret_cast<const SetChannelAccessRequest*>
-                   (request);
     int channel = requestData->channelNumber & CHANNEL_MASK;
     auto ethdevice = ipmi::network::ChanneltoEthernet(channel);
     if (ethdevice.empty())
     {
-        return IPMI_CC_INVALID_FIELD_REQUEST;
+        responder(IPMI_CC_INVALID_FIELD_REQUEST, {});
+        return;
+    }
+
+    // The data of a previous command is still being applied.
+    if (applyRunning)
+    {
+        responder(IPMI_CC_BUSY, {});
+        return;
     }
+
     auto ethIp = ethdevice + "/" + ipmi::network::IP_TYPE;
     auto channelConf = getChannelConfig(channel);
 
@@ -144,9 +338,9 @@ ipmi_ret_t ipmi_set_channel_access(ipmi_netfn_t netfn,
                                     entry("INTERFACE=%s",
                                           ipmi::network::ETHERNET_INTERFACE));
                     commit<InternalFailure>();
-                    rc = IPMI_CC_UNSPECIFIED_ERROR;
                     channelConf->clear();
-                    return rc;
+                    responder(IPMI_CC_UNSPECIFIED_ERROR, {});
+                    return;
                 }
 
                 networkInterfacePath = ancestorMap.begin()->first;
@@ -249,102 +443,6 @@ ipmi_ret_t ipmi_set_channel_access(ipmi_netfn_t netfn,
             }
         }
 
-        // Currently network manager doesn't support purging of all the
-        // ip addresses and the vlan interfaces from the parent interface,
-        // TODO once the support is there, will make the change here.
-        // https://github.com/openbmc/openbmc/issues/2141.
-
-        // TODO Currently IPMI supports single interface,need to handle
-        // Multiple interface through
-        // https://github.com/openbmc/openbmc/issues/2138
-
-        // instead of deleting all the vlan interfaces and
-        // all the ipv4 address,we will call reset method.
-        //delete all the vlan interfaces
-
-        ipmi::deleteAllDbusObjects(bus,
-                                   ipmi::network::ROOT,
-                                   ipmi::network::VLAN_INTERFACE);
-
-        // set the interface mode  to static
-        auto networkInterfaceObject = ipmi::getDbusObject(
-                bus,
-                ipmi::network::ETHERNET_INTERFACE,
-                ipmi::network::ROOT,
-                ethdevice);
-
-        // setting the physical interface mode to static.
-        ipmi::setDbusProperty(bus,
-                              ipmi::network::SERVICE,
-                              networkInterfaceObject.first,
-                              ipmi::network::ETHERNET_INTERFACE,
-                              "DHCPEnabled",
-                              false);
-
-        networkInterfacePath = networkInterfaceObject.first;
-
-        //delete all the ipv4 addresses
-        ipmi::deleteAllDbusObjects(bus,
-                                   ipmi::network::ROOT,
-                                   ipmi::network::IP_INTERFACE,
-                                   ethIp);
-
-        if (vlanID)
-        {
-            ipmi::network::createVLAN(bus,
-                                      ipmi::network::SERVICE,
-                                      ipmi::network::ROOT,
-                                      ethdevice,
-                                      vlanID);
-
-            auto networkInterfaceObject = ipmi::getDbusObject(
-                    bus,
-                    ipmi::network::VLAN_INTERFACE,
-                    ipmi::network::ROOT);
-
-           networkInterfacePath = networkInterfaceObject.first;
-        }
-
-        if (channelConf->ipsrc == ipmi::network::IPOrigin::DHCP)
-        {
-            ipmi::setDbusProperty(bus,
-                                  ipmi::network::SERVICE,
-                                  networkInterfacePath,
-                                  ipmi::network::ETHERNET_INTERFACE,
-                                  "DHCPEnabled",
-                                  true);
-        }
-        else
-        {
-            //change the mode to static
-            ipmi::setDbusProperty(bus,
-                                  ipmi::network::SERVICE,
-                                  networkInterfacePath,
-                                  ipmi::network::ETHERNET_INTERFACE,
-                                  "DHCPEnabled",
-                                  false);
-
-            if (!ipaddress.empty())
-            {
-                ipmi::network::createIP(bus,
-                                        ipmi::network::SERVICE,
-                                        networkInterfacePath,
-                                        ipv4Protocol,
-                                        ipaddress,
-                                        prefix);
-            }
-
-            if (!gateway.empty())
-            {
-                ipmi::setDbusProperty(bus,
-                                      systemObject.second,
-                                      systemObject.first,
-                                      ipmi::network::SYSTEMCONFIG_INTERFACE,
-                                      "DefaultGateway",
-                                      std::string(gateway));
-            }
-        }
-
     }
     catch (InternalFailure& e)
     {
@@ -356,11 +454,49 @@ ipmi_ret_t ipmi_set_channel_access(ipmi_netfn_t netfn,
                         entry("IPSRC=%d", channelConf->ipsrc));
 
         commit<InternalFailure>();
-        rc = IPMI_CC_UNSPECIFIED_ERROR;
+        channelConf->clear();
+        responder(IPMI_CC_UNSPECIFIED_ERROR, {});
+        return;
     }
 
+    // The data is applied from the cache as it is now, Set LAN commands
+    // that arrive meanwhile go to the next Set Channel Access.
+    auto apply = std::make_shared<NetworkApply>();
+    apply->ethdevice = std::move(ethdevice);
+    apply->ethIp = std::move(ethIp);
+    apply->ipsrc = channelConf->ipsrc;
+    apply->ipaddress = std::move(ipaddress);
+    apply->gateway = std::move(gateway);
+    apply->prefix = prefix;
+    apply->vlanID = vlanID;
+    apply->systemObject = std::move(systemObject);
+    apply->responder = std::move(responder);
     channelConf->clear();
-    return rc;
+    applyRunning = true;
+
+    // Currently network manager doesn't support purging of all the
+    // ip addresses and the vlan interfaces from the parent interface,
+    // TODO once the support is there, will make the change here.
+    // https://github.com/openbmc/openbmc/issues/2141.
+
+    // TODO Currently IPMI supports single interface,need to handle
+    // Multiple interface through
+    // https://github.com/openbmc/openbmc/issues/2138
+
+    // instead of deleting all the vlan interfaces and
+    // all the ipv4 address,we will call reset method.
+    // The deletes of each round are in flight together, requests from the
+    // host are handled as their replies come in.
+    //delete all the vlan interfaces
+    ipmi::deleteAllDbusObjects(ipmid_get_sd_bus_connection(),
+                               ipmi::network::ROOT,
+                               ipmi::network::VLAN_INTERFACE,
+                               {},
+                               deleteTimeout,
+                               [apply]()
+                               {
+                                   deleteAddresses(apply);
+                               });
 }
 
 ipmi_ret_t ipmi_get_channel_access(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
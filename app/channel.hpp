@@ -1,22 +1,25 @@
+#include "host-ipmid/ipmid-async.hpp"
 #include "ipmid.hpp"
 
 /** @brief The set channel access IPMI command.
+ *
+ *  Applies the network data of the Set LAN commands. The response is sent
+ *  once the old VLAN interfaces and addresses are deleted and the new ones
+ *  are set, it has no data.
  *
  *  @param[in] netfn
  *  @param[in] cmd
  *  @param[in] request
- *  @param[in,out] response
- *  @param[out] data_len
+ *  @param[in] len
+ *  @param[in] responder
  *  @param[in] context
- *
- *  @return IPMI_CC_OK on success, non-zero otherwise.
  */
-ipmi_ret_t ipmi_set_channel_access(
+void ipmi_set_channel_access(
         ipmi_netfn_t netfn,
         ipmi_cmd_t cmd,
         ipmi_request_t request,
-        ipmi_response_t response,
-        ipmi_data_len_t data_len,
+        size_t len,
+        ipmid_responder_t responder,
         ipmi_context_t context);
 
 /** @brief The get channel access IPMI command.
@@ -3,7 +3,6 @@
 
 #include <systemd/sd-bus.h>
 
-#include <mapper.h>
 #include <sdbusplus/bus.hpp>
 
 extern sd_bus *bus;
@@ -50,7 +49,7 @@ ipmi_ret_t ipmi_app_set_watchdog(
     printf("WATCHDOG SET Timer:[0x%X] 100ms intervals\n",timer);
 
     // Get bus name
-    r = mapper_get_service(bus, objname, &busname);
+    r = ipmi::getService(bus, objname, &busname);
     if (r < 0) {
         fprintf(stderr, "Failed to get %s bus name: %s\n",
                 objname, strerror(-r));
@@ -58,9 +57,9 @@ ipmi_ret_t ipmi_app_set_watchdog(
     }
 
     // Disable watchdog if running
-    r = sd_bus_call_method(bus, busname, objname, property_iface,
-                           "Set", &error, &reply, "ssv",
-                           iface, "Enabled", "b", false);
+    r = ipmi::callMethod(bus, busname, objname, property_iface,
+                         "Set", &error, &reply, "ssv",
+                         iface, "Enabled", "b", false);
     if(r < 0) {
         fprintf(stderr, "Failed to disable Watchdog: %s\n",
                     strerror(-r));
@@ -83,9 +82,9 @@ ipmi_ret_t ipmi_app_set_watchdog(
         reply = sd_bus_message_unref(reply);
 
         // Set the Interval for the Watchdog
-        r = sd_bus_call_method(bus, busname, objname, property_iface,
-                               "Set", &error, &reply, "ssv",
-                               iface, "Interval", "t", timer_ms);
+        r = ipmi::callMethod(bus, busname, objname, property_iface,
+                             "Set", &error, &reply, "ssv",
+                             iface, "Interval", "t", timer_ms);
         if(r < 0) {
             fprintf(stderr, "Failed to set new expiration time: %s\n",
                     strerror(-r));
@@ -93,9 +92,9 @@ ipmi_ret_t ipmi_app_set_watchdog(
         }
 
         // Now Enable Watchdog
-        r = sd_bus_call_method(bus, busname, objname, property_iface,
-                               "Set", &error, &reply, "ssv",
-                               iface, "Enabled", "b", true);
+        r = ipmi::callMethod(bus, busname, objname, property_iface,
+                             "Set", &error, &reply, "ssv",
+                             iface, "Enabled", "b", true);
         if(r < 0) {
             fprintf(stderr, "Failed to Enable Watchdog: %s\n",
                     strerror(-r));
@@ -133,7 +132,7 @@ ipmi_ret_t ipmi_app_reset_watchdog(
 
     printf("WATCHDOG RESET\n");
     // Get bus name
-    r = mapper_get_service(bus, objname, &busname);
+    r = ipmi::getService(bus, objname, &busname);
     if (r < 0) {
         fprintf(stderr, "Failed to get %s bus name: %s\n",
                 objname, strerror(-r));
@@ -141,9 +140,9 @@ ipmi_ret_t ipmi_app_reset_watchdog(
     }
 
     // Get the current interval and set it back.
-    r = sd_bus_call_method(bus, busname, objname, property_iface,
-                           "Get", &error, &reply, "ss",
-                           iface, "Interval");
+    r = ipmi::callMethod(bus, busname, objname, property_iface,
+                         "Get", &error, &reply, "ss",
+                         iface, "Interval");
 
     if(r < 0) {
         fprintf(stderr, "Failed to get current Interval msg: %s\n",
@@ -163,9 +162,9 @@ ipmi_ret_t ipmi_app_reset_watchdog(
     reply = sd_bus_message_unref(reply);
 
     // Set watchdog timer
-    r = sd_bus_call_method(bus, busname, objname, property_iface,
-                           "Set", &error, &reply, "ssv",
-                           iface, "TimeRemaining", "t", interval);
+    r = ipmi::callMethod(bus, busname, objname, property_iface,
+                         "Set", &error, &reply, "ssv",
+                         iface, "TimeRemaining", "t", interval);
     if(r < 0) {
         fprintf(stderr, "Failed to refresh the timer: %s\n",
                 strerror(-r));
@@ -11,7 +11,6 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <systemd/sd-bus.h>
-#include <mapper.h>
 #include <array>
 #include <vector>
 #include <string>
@@ -161,8 +160,9 @@ ipmi_ret_t ipmi_app_get_device_id(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     ipmi_ret_t rc = IPMI_CC_OK;
     const char  *objname = "/org/openbmc/inventory/system/chassis/motherboard/bmc";
     const char  *iface   = "org.openbmc.InventoryItem";
-    char *ver = NULL;
+    const char *ver = NULL;
     char *busname = NULL;
+    sd_bus_message *reply = NULL;
     int r;
     rev_t rev = {0};
     static ipmi_device_id_t dev_id{};
@@ -176,14 +176,17 @@ ipmi_ret_t ipmi_app_get_device_id(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     {
         // Firmware revision is already implemented,
         // so get it from appropriate position.
-        r = mapper_get_service(bus, objname, &busname);
+        r = ipmi::getService(bus, objname, &busname);
         if (r < 0) {
             fprintf(stderr, "Failed to get %s bus name: %s\n",
                     objname, strerror(-r));
             goto finish;
         }
-        r = sd_bus_get_property_string(bus,busname,objname,iface,"version",
-                NULL, &ver);
+        r = ipmi::callMethod(bus, busname, objname, ipmi::PROP_INTF, "Get",
+                             NULL, &reply, "ss", iface, "version");
+        if (r >= 0) {
+            r = sd_bus_message_read(reply, "v", "s", &ver);
+        }
         if ( r < 0 ) {
             fprintf(stderr, "Failed to obtain version property: %s\n",
                     strerror(-r));
@@ -245,7 +248,7 @@ ipmi_ret_t ipmi_app_get_device_id(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     memcpy(response, &dev_id, *data_len);
 finish:
     free(busname);
-    free(ver);
+    sd_bus_message_unref(reply);
     return rc;
 }
 
@@ -306,7 +309,7 @@ ipmi_ret_t ipmi_app_get_device_guid(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     // Ex: 0x2332fc2c40e66298e511f2782395a361
 
     const int resp_size = 16; // Response is 16 hex bytes per IPMI Spec
-    uint8_t resp_uuid[resp_size]; // Array to hold the formatted response
+    uint8_t resp_uuid[resp_size] {}; // Array to hold the formatted response
     int resp_loc = resp_size-1; // Point resp end of array to save in reverse order
     int i = 0;
     char *tokptr = NULL;
@@ -319,15 +322,15 @@ ipmi_ret_t ipmi_app_get_device_guid(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     printf("IPMI GET DEVICE GUID\n");
 
     // Call Get properties method with the interface and property name
-    r = mapper_get_service(bus, objname, &busname);
+    r = ipmi::getService(bus, objname, &busname);
     if (r < 0) {
         fprintf(stderr, "Failed to get %s bus name: %s\n",
                 objname, strerror(-r));
         goto finish;
     }
-    r = sd_bus_call_method(bus,busname,objname,iface,
-                           "Get",&error, &reply, "ss",
-                           chassis_iface, "uuid");
+    r = ipmi::callMethod(bus,busname,objname,iface,
+                         "Get",&error, &reply, "ss",
+                         chassis_iface, "uuid");
     if (r < 0)
     {
         fprintf(stderr, "Failed to call Get Method: %s\n", strerror(-r));
@@ -471,8 +474,8 @@ void register_netfn_app_functions()
     // <Set Channel Access>
     printf("Registering NetFn:[0x%X], Cmd:[0x%X]\n",NETFUN_APP,
                                             IPMI_CMD_SET_CHAN_ACCESS);
-    ipmi_register_callback(NETFUN_APP, IPMI_CMD_SET_CHAN_ACCESS, NULL,
-                                    ipmi_set_channel_access, PRIVILEGE_ADMIN);
+    ipmi_register_async_callback(NETFUN_APP, IPMI_CMD_SET_CHAN_ACCESS, NULL,
+                                 ipmi_set_channel_access, PRIVILEGE_ADMIN);
 
     // <Get Channel Access>
     printf("Registering NetFn:[0x%X], Cmd:[0x%X]\n",NETFUN_APP, IPMI_CMD_GET_CHANNEL_ACCESS);
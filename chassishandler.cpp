@@ -1,5 +1,6 @@
 #include "chassishandler.h"
 #include "host-ipmid/ipmid-api.h"
+#include "host-ipmid/ipmid-init.hpp"
 #include "types.hpp"
 #include "ipmid.hpp"
 #include "settings.hpp"
@@ -8,7 +9,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include <mapper.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <limits.h>
@@ -120,8 +120,23 @@ sdbusplus::bus::bus dbus(ipmid_get_sd_bus_connection());
 namespace cache
 {
 
-settings::Objects objects(dbus,
-                          {bootModeIntf, bootSourceIntf, powerRestoreIntf});
+std::unique_ptr<settings::Objects> objects = nullptr;
+
+// The settings are looked up once ipmid runs its event loop, the commands
+// using them are answered busy until then.
+ipmi::init::Once settingsInit(
+    "chassis settings",
+    [](ipmi::init::Done&& done)
+    {
+        settings::Objects::fetch(
+            dbus,
+            {bootModeIntf, bootSourceIntf, powerRestoreIntf},
+            [done](std::unique_ptr<settings::Objects>&& found)
+            {
+                objects = std::move(found);
+                done(objects ? 0 : -ENOENT);
+            });
+    });
 
 } // namespace cache
 } // namespace internal
@@ -143,7 +158,7 @@ int dbus_get_property(const char *name, char **buf)
     // Get the system bus where most system services are provided.
     bus = ipmid_get_sd_bus_connection();
 
-    r = mapper_get_service(bus, settings_object_name, &connection);
+    r = ipmi::getService(bus, settings_object_name, &connection);
     if (r < 0) {
         fprintf(stderr, "Failed to get %s connection: %s\n",
                 settings_object_name, strerror(-r));
@@ -156,16 +171,16 @@ int dbus_get_property(const char *name, char **buf)
      * Signatures and input arguments are provided by the arguments at the
      * end.
      */
-    r = sd_bus_call_method(bus,
-                           connection,                                 /* service to contact */
-                           settings_object_name,                       /* object path */
-                           settings_intf_name,                         /* interface name */
-                           "Get",                                      /* method name */
-                           &error,                                     /* object to return error in */
-                           &m,                                         /* return message on success */
-                           "ss",                                       /* input signature */
-                           host_intf_name,                             /* first argument */
-                           name);                                      /* second argument */
+    r = ipmi::callMethod(bus,
+                         connection,                                 /* service to contact */
+                         settings_object_name,                       /* object path */
+                         settings_intf_name,                         /* interface name */
+                         "Get",                                      /* method name */
+                         &error,                                     /* object to return error in */
+                         &m,                                         /* return message on success */
+                         "ss",                                       /* input signature */
+                         host_intf_name,                             /* first argument */
+                         name);                                      /* second argument */
 
     if (r < 0) {
         fprintf(stderr, "Failed to issue method call: %s\n", error.message);
@@ -214,7 +229,7 @@ int dbus_set_property(const char * name, const char *value)
     // Get the system bus where most system services are provided.
     bus = ipmid_get_sd_bus_connection();
 
-    r = mapper_get_service(bus, settings_object_name, &connection);
+    r = ipmi::getService(bus, settings_object_name, &connection);
     if (r < 0) {
         fprintf(stderr, "Failed to get %s connection: %s\n",
                 settings_object_name, strerror(-r));
@@ -227,18 +242,18 @@ int dbus_set_property(const char * name, const char *value)
      * Signatures and input arguments are provided by the arguments at the
      * end.
      */
-    r = sd_bus_call_method(bus,
-                           connection,                                 /* service to contact */
-                           settings_object_name,                       /* object path */
-                           settings_intf_name,                         /* interface name */
-                           "Set",                                      /* method name */
-                           &error,                                     /* object to return error in */
-                           &m,                                         /* return message on success */
-                           "ssv",                                      /* input signature */
-                           host_intf_name,                             /* first argument */
-                           name,                                       /* second argument */
-                           "s",                                        /* third argument */
-                           value);                                     /* fourth argument */
+    r = ipmi::callMethod(bus,
+                         connection,                                 /* service to contact */
+                         settings_object_name,                       /* object path */
+                         settings_intf_name,                         /* interface name */
+                         "Set",                                      /* method name */
+                         &error,                                     /* object to return error in */
+                         &m,                                         /* return message on success */
+                         "ssv",                                      /* input signature */
+                         host_intf_name,                             /* first argument */
+                         name,                                       /* second argument */
+                         "s",                                        /* third argument */
+                         value);                                     /* fourth argument */
 
     if (r < 0) {
         fprintf(stderr, "Failed to issue method call: %s\n", error.message);
@@ -657,7 +672,7 @@ int initiate_state_transition(State::Host::Transition transition)
 
     // Gets a hook onto either a SYSTEM or SESSION bus
     sd_bus *bus_type = ipmid_get_sd_bus_connection();
-    rc = mapper_get_service(bus_type, HOST_STATE_MANAGER_ROOT, &busname);
+    rc = ipmi::getService(bus_type, HOST_STATE_MANAGER_ROOT, &busname);
     if (rc < 0)
     {
         log<level::ERR>("Failed to get bus name",
@@ -669,17 +684,17 @@ int initiate_state_transition(State::Host::Transition transition)
     // Convert to string equivalent of the passed in transition enum.
     auto request = State::convertForMessage(transition);
 
-    rc = sd_bus_call_method(bus_type,                // On the system bus
-                            busname,                 // Service to contact
-                            HOST_STATE_MANAGER_ROOT, // Object path
-                            DBUS_PROPERTY_IFACE,     // Interface name
-                            "Set",                   // Method to be called
-                            &bus_error,              // object to return error
-                            nullptr,                 // Response buffer if any
-                            "ssv",                   // Takes 3 arguments
-                            HOST_STATE_MANAGER_IFACE,
-                            PROPERTY,
-                            "s", request.c_str());
+    rc = ipmi::callMethod(bus_type,                // On the system bus
+                          busname,                 // Service to contact
+                          HOST_STATE_MANAGER_ROOT, // Object path
+                          DBUS_PROPERTY_IFACE,     // Interface name
+                          "Set",                   // Method to be called
+                          &bus_error,              // object to return error
+                          nullptr,                 // Response buffer if any
+                          "ssv",                   // Takes 3 arguments
+                          HOST_STATE_MANAGER_IFACE,
+                          PROPERTY,
+                          "s", request.c_str());
     if(rc < 0)
     {
         log<level::ERR>("Failed to initiate transition",
@@ -739,48 +754,55 @@ ipmi_ret_t ipmi_get_chassis_status(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     using namespace chassis::internal::cache;
     using namespace power_policy;
 
-    const auto& powerRestoreSetting = objects.map.at(powerRestoreIntf).front();
-    auto method =
-        dbus.new_method_call(
-            objects.service(powerRestoreSetting, powerRestoreIntf).c_str(),
-            powerRestoreSetting.c_str(),
-            ipmi::PROP_INTF,
-            "Get");
-    method.append(powerRestoreIntf, "PowerRestorePolicy");
-    auto resp = dbus.call(method);
-    if (resp.is_method_error())
+    if (!settingsInit.ready())
+    {
+        *data_len = 0;
+        return IPMI_CC_BUSY;
+    }
+
+    const auto& powerRestoreSetting = objects->map.at(powerRestoreIntf).front();
+    std::string result;
+    try
+    {
+        result = ipmi::propertyCache().get<std::string>(
+            dbus,
+            objects->service(powerRestoreSetting, powerRestoreIntf),
+            powerRestoreSetting,
+            powerRestoreIntf,
+            "PowerRestorePolicy");
+    }
+    catch (const InternalFailure& e)
     {
         log<level::ERR>("Error in PowerRestorePolicy Get");
         report<InternalFailure>();
         *data_len = 0;
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
-    sdbusplus::message::variant<std::string> result;
-    resp.read(result);
-    auto powerRestore =
-        RestorePolicy::convertPolicyFromString(result.get<std::string>());
+    auto powerRestore = RestorePolicy::convertPolicyFromString(result);
 
-    *data_len = 4;
+    // Only reported once packed, not on the errors below.
+    *data_len = 0;
 
     bus = ipmid_get_sd_bus_connection();
 
-    r = mapper_get_service(bus, objname, &busname);
+    r = ipmi::getService(bus, objname, &busname);
     if (r < 0) {
         fprintf(stderr, "Failed to get bus name, return value: %s.\n", strerror(-r));
         rc = IPMI_CC_UNSPECIFIED_ERROR;
         goto finish;
     }
 
-    r = sd_bus_get_property(bus, busname, objname, intf, "pgood", NULL, &reply, "i");
+    r = ipmi::callMethod(bus, busname, objname, ipmi::PROP_INTF, "Get", NULL,
+                         &reply, "ss", intf, "pgood");
     if (r < 0) {
-        fprintf(stderr, "Failed to call sd_bus_get_property:%d,  %s\n", r, strerror(-r));
+        fprintf(stderr, "Failed to get the pgood property:%d,  %s\n", r, strerror(-r));
         fprintf(stderr, "Bus: %s, Path: %s, Interface: %s\n",
                 busname, objname, intf);
         rc = IPMI_CC_UNSPECIFIED_ERROR;
         goto finish;
     }
 
-    r = sd_bus_message_read(reply, "i", &pgood);
+    r = sd_bus_message_read(reply, "v", "i", &pgood);
     if (r < 0) {
         fprintf(stderr, "Failed to read sensor: %s\n", strerror(-r));
         rc = IPMI_CC_UNSPECIFIED_ERROR;
@@ -862,6 +884,7 @@ ipmi_ret_t ipmi_get_chassis_status(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     chassis_status.front_panel_button_cap_status = 0;
 
     // Pack the actual response
+    *data_len = 4;
     memcpy(response, &chassis_status, *data_len);
 
 finish:
@@ -904,9 +927,9 @@ int stop_soft_off_timer()
     //}
 
     // No error object or reply expected.
-    int rc = sd_bus_call_method(bus, SOFTOFF_BUSNAME, SOFTOFF_OBJPATH, iface,
-                                "Set", nullptr, nullptr, "ssv",
-                                soft_off_iface, property, "s", value);
+    int rc = ipmi::callMethod(bus, SOFTOFF_BUSNAME, SOFTOFF_OBJPATH, iface,
+                              "Set", nullptr, nullptr, "ssv",
+                              soft_off_iface, property, "s", value);
     if (rc < 0)
     {
         fprintf(stderr, "Failed to set property in SoftPowerOff object: %s\n",
@@ -1050,6 +1073,7 @@ ipmi_ret_t ipmi_chassis_identify(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                DEFAULT_IDENTIFY_TIME_OUT;
     bool forceIdentify =
         *data_len == 2 ? (static_cast<uint8_t*>(request))[1] & 0x01 : false;
+    *data_len = 0;
 
     currentCallerId++;
 
@@ -1069,7 +1093,7 @@ ipmi_ret_t ipmi_chassis_identify(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         "xyz.openbmc_project.Led.Group"
     };
     mapperCall.append(interfaces);
-    auto mapperReply = chassis::internal::dbus.call(mapperCall);
+    auto mapperReply = ipmi::call(chassis::internal::dbus, mapperCall);
     if (mapperReply.is_method_error())
     {
         log<level::ERR>("Chassis Identify: Error communicating to mapper.");
@@ -1092,7 +1116,7 @@ ipmi_ret_t ipmi_chassis_identify(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                 "xyz.openbmc_project.Led.Group", "Asserted",
                 sdbusplus::message::variant<bool>(
                     true));
-            auto ledReply = chassis::internal::dbus.call(ledOn);
+            auto ledReply = ipmi::call(chassis::internal::dbus, ledOn);
             if (ledReply.is_method_error())
             {
                 log<level::ERR>("Chassis Identify: Error Setting State On\n");
@@ -1125,7 +1149,7 @@ ipmi_ret_t ipmi_chassis_identify(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             ledOff.append("xyz.openbmc_project.Led.Group", "Asserted",
             sdbusplus::message::variant<bool>(
                 false));
-            auto ledReply = chassis::internal::dbus.call(ledOff);
+            auto ledReply = ipmi::call(chassis::internal::dbus, ledOff);
             if (ledReply.is_method_error())
             {
                 log<level::ERR>("Chassis Identify: Error Setting State Off\n");
@@ -1206,21 +1230,27 @@ ipmi_ret_t ipmi_chassis_get_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         using namespace chassis::internal;
         using namespace chassis::internal::cache;
 
+        if (!settingsInit.ready())
+        {
+            *data_len = 0;
+            return IPMI_CC_BUSY;
+        }
+
         try
         {
-            auto bootSetting = settings::boot::setting(objects, bootSourceIntf);
+            auto bootSetting = settings::boot::setting(*objects, bootSourceIntf);
             const auto& bootSourceSetting =
                 std::get<settings::Path>(bootSetting);
             auto oneTimeEnabled =
                 std::get<settings::boot::OneTimeEnabled>(bootSetting);
             auto method =
                 dbus.new_method_call(
-                     objects.service(bootSourceSetting, bootSourceIntf).c_str(),
+                     objects->service(bootSourceSetting, bootSourceIntf).c_str(),
                      bootSourceSetting.c_str(),
                      ipmi::PROP_INTF,
                      "Get");
             method.append(bootSourceIntf, "BootSource");
-            auto reply = dbus.call(method);
+            auto reply = ipmi::call(dbus, method);
             if (reply.is_method_error())
             {
                 log<level::ERR>("Error in BootSource Get");
@@ -1233,16 +1263,16 @@ ipmi_ret_t ipmi_chassis_get_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             auto bootSource =
                 Source::convertSourcesFromString(result.get<std::string>());
 
-            bootSetting = settings::boot::setting(objects, bootModeIntf);
+            bootSetting = settings::boot::setting(*objects, bootModeIntf);
             const auto& bootModeSetting = std::get<settings::Path>(bootSetting);
             method = dbus.new_method_call(
-                          objects.service(bootModeSetting, bootModeIntf).
+                          objects->service(bootModeSetting, bootModeIntf).
                               c_str(),
                           bootModeSetting.c_str(),
                           ipmi::PROP_INTF,
                           "Get");
             method.append(bootModeIntf, "BootMode");
-            reply = dbus.call(method);
+            reply = ipmi::call(dbus, method);
             if (reply.is_method_error())
             {
                 log<level::ERR>("Error in BootMode Get");
@@ -1338,6 +1368,12 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         IpmiValue bootOption = ((reqptr->data[1] & 0x3C) >> 2);
         using namespace chassis::internal;
         using namespace chassis::internal::cache;
+
+        if (!settingsInit.ready())
+        {
+            return IPMI_CC_BUSY;
+        }
+
         auto oneTimeEnabled = false;
         constexpr auto enabledIntf = "xyz.openbmc_project.Object.Enable";
         constexpr auto oneTimePath =
@@ -1350,7 +1386,7 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                 SET_PARM_BOOT_FLAGS_PERMANENT;
 
             auto bootSetting =
-                settings::boot::setting(objects, bootSourceIntf);
+                settings::boot::setting(*objects, bootSourceIntf);
 
             oneTimeEnabled =
                 std::get<settings::boot::OneTimeEnabled>(bootSetting);
@@ -1383,19 +1419,19 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             {
                 sdbusplus::message::variant<std::string> property =
                     convertForMessage(sourceItr->second);
-                auto bootSetting = settings::boot::setting(objects,
+                auto bootSetting = settings::boot::setting(*objects,
                                                            bootSourceIntf);
                 const auto& bootSourceSetting =
                     std::get<settings::Path>(bootSetting);
                 auto method =
                     dbus.new_method_call(
-                         objects.service(bootSourceSetting, bootSourceIntf).
+                         objects->service(bootSourceSetting, bootSourceIntf).
                              c_str(),
                          bootSourceSetting.c_str(),
                          ipmi::PROP_INTF,
                          "Set");
                 method.append(bootSourceIntf, "BootSource", property);
-                auto reply = dbus.call(method);
+                auto reply = ipmi::call(dbus, method);
                 if (reply.is_method_error())
                 {
                     log<level::ERR>("Error in BootSource Set");
@@ -1409,18 +1445,18 @@ ipmi_ret_t ipmi_chassis_set_sys_boot_options(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             {
                 sdbusplus::message::variant<std::string> property =
                     convertForMessage(modeItr->second);
-                auto bootSetting = settings::boot::setting(objects,
+                auto bootSetting = settings::boot::setting(*objects,
                                                            bootModeIntf);
                 const auto& bootModeSetting =
                     std::get<settings::Path>(bootSetting);
                 auto method =
                     dbus.new_method_call(
-                         objects.service(bootModeSetting, bootModeIntf).c_str(),
+                         objects->service(bootModeSetting, bootModeIntf).c_str(),
                          bootModeSetting.c_str(),
                          ipmi::PROP_INTF,
                          "Set");
                 method.append(bootModeIntf, "BootMode", property);
-                auto reply = dbus.call(method);
+                auto reply = ipmi::call(dbus, method);
                 if (reply.is_method_error())
                 {
                     log<level::ERR>("Error in BootMode Set");
@@ -31,23 +31,8 @@ uint32_t getPcap(sdbusplus::bus::bus& bus)
     auto settingService = ipmi::getService(bus,
                                            PCAP_INTERFACE,PCAP_PATH);
 
-    auto method = bus.new_method_call(settingService.c_str(),
-                                      PCAP_PATH,
-                                      "org.freedesktop.DBus.Properties",
-                                      "Get");
-
-    method.append(PCAP_INTERFACE, POWER_CAP_PROP);
-    auto reply = bus.call(method);
-
-    if (reply.is_method_error())
-    {
-        log<level::ERR>("Error in getPcap prop");
-        elog<InternalFailure>();
-    }
-    sdbusplus::message::variant<uint32_t> pcap;
-    reply.read(pcap);
-
-    return pcap.get<uint32_t>();
+    return ipmi::propertyCache().get<uint32_t>(bus, settingService, PCAP_PATH,
+                                               PCAP_INTERFACE, POWER_CAP_PROP);
 }
 
 bool getPcapEnabled(sdbusplus::bus::bus& bus)
@@ -55,23 +40,9 @@ bool getPcapEnabled(sdbusplus::bus::bus& bus)
     auto settingService = ipmi::getService(bus,
                                            PCAP_INTERFACE,PCAP_PATH);
 
-    auto method = bus.new_method_call(settingService.c_str(),
-                                      PCAP_PATH,
-                                      "org.freedesktop.DBus.Properties",
-                                      "Get");
-
-    method.append(PCAP_INTERFACE, POWER_CAP_ENABLE_PROP);
-    auto reply = bus.call(method);
-
-    if (reply.is_method_error())
-    {
-        log<level::ERR>("Error in getPcapEnabled prop");
-        elog<InternalFailure>();
-    }
-    sdbusplus::message::variant<bool> pcapEnabled;
-    reply.read(pcapEnabled);
-
-    return pcapEnabled.get<bool>();
+    return ipmi::propertyCache().get<bool>(bus, settingService, PCAP_PATH,
+                                           PCAP_INTERFACE,
+                                           POWER_CAP_ENABLE_PROP);
 }
 
 void setPcap(sdbusplus::bus::bus& bus, const uint32_t powerCap)
@@ -86,13 +57,14 @@ void setPcap(sdbusplus::bus::bus& bus, const uint32_t powerCap)
     method.append(PCAP_INTERFACE, POWER_CAP_PROP);
     method.append(sdbusplus::message::variant<uint32_t>(powerCap));
 
-    auto reply = bus.call(method);
+    auto reply = ipmi::call(bus, method);
 
     if (reply.is_method_error())
     {
         log<level::ERR>("Error in setPcap property");
         elog<InternalFailure>();
     }
+    ipmi::propertyCache().invalidate(PCAP_PATH, PCAP_INTERFACE);
 }
 
 void setPcapEnable(sdbusplus::bus::bus& bus, bool enabled)
@@ -107,13 +79,14 @@ void setPcapEnable(sdbusplus::bus::bus& bus, bool enabled)
     method.append(PCAP_INTERFACE, POWER_CAP_ENABLE_PROP);
     method.append(sdbusplus::message::variant<bool>(enabled));
 
-    auto reply = bus.call(method);
+    auto reply = ipmi::call(bus, method);
 
     if (reply.is_method_error())
     {
         log<level::ERR>("Error in setPcapEnabled property");
         elog<InternalFailure>();
     }
+    ipmi::propertyCache().invalidate(PCAP_PATH, PCAP_INTERFACE);
 }
 
 void readAssetTagObjectTree(dcmi::assettag::ObjectTree& objectTree)
@@ -135,7 +108,7 @@ void readAssetTagObjectTree(dcmi::assettag::ObjectTree& objectTree)
     mapperCall.append(depth);
     mapperCall.append(std::vector<std::string>({dcmi::assetTagIntf}));
 
-    auto mapperReply = bus.call(mapperCall);
+    auto mapperReply = ipmi::call(bus, mapperCall);
     if (mapperReply.is_method_error())
     {
         log<level::ERR>("Error in mapper call");
@@ -168,7 +141,7 @@ std::string readAssetTag()
     method.append(dcmi::assetTagIntf);
     method.append(dcmi::assetTagProp);
 
-    auto reply = bus.call(method);
+    auto reply = ipmi::call(bus, method);
     if (reply.is_method_error())
     {
         log<level::ERR>("Error in reading asset tag");
@@ -199,7 +172,7 @@ void writeAssetTag(const std::string& assetTag)
     method.append(dcmi::assetTagProp);
     method.append(sdbusplus::message::variant<std::string>(assetTag));
 
-    auto reply = bus.call(method);
+    auto reply = ipmi::call(bus, method);
     if (reply.is_method_error())
     {
         log<level::ERR>("Error in writing asset tag");
@@ -532,6 +505,9 @@ ipmi_ret_t getMgmntCtrlIdStr(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     responseData->groupID = dcmi::groupExtId;
     responseData->strLen = hostName.length();
     std::copy(begin(responseStr), end(responseStr), responseData->data);
+    // The terminator, when it is reported.
+    std::fill(responseData->data + responseStr.length(),
+              responseData->data + responseStrLen, 0);
 
     *data_len = sizeof(*responseData) + responseStrLen;
     return IPMI_CC_OK;
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include "dispatch.hpp"
+
+namespace ipmi
+{
+namespace dispatch
+{
+
+namespace
+{
+
+// Zero initialized, so this lives in .bss rather than in the binary.
+Table routerTable;
+
+} // namespace
+
+Table& table()
+{
+    return routerTable;
+}
+
+bool Table::add(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_context_t context,
+                ipmid_callback_t handler, ipmi_cmd_privilege_t priv,
+                ipmi_cmd_concurrency_t concurrency)
+{
+    Slot slot{};
+    slot.handler = handler;
+    slot.context = context;
+    slot.priv = priv;
+    slot.concurrency = concurrency;
+    return add(netfn, cmd, slot);
+}
+
+bool Table::add(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_context_t context,
+                ipmid_async_callback_t handler, ipmi_cmd_privilege_t priv)
+{
+    Slot slot{};
+    slot.asyncHandler = handler;
+    slot.context = context;
+    slot.priv = priv;
+    return add(netfn, cmd, slot);
+}
+
+bool Table::add(ipmi_netfn_t netfn, ipmi_cmd_t cmd, const Slot& slot)
+{
+    if (frozen)
+    {
+        fprintf(stderr, "ERROR : Late registration for NetFn [0x%X], "
+                "Cmd:[0x%X], handlers are frozen\n", netfn, cmd);
+        return false;
+    }
+
+    if (netfn >= maxNetFn)
+    {
+        fprintf(stderr, "ERROR : Invalid NetFn [0x%X] for Cmd:[0x%X]\n",
+                netfn, cmd);
+        return false;
+    }
+
+    auto row = &slots[netfn * maxCmd];
+    if (row[cmd].exact)
+    {
+        fprintf(stderr, "ERROR : Duplicate registration for NetFn [0x%X], "
+                "Cmd:[0x%X]\n", netfn, cmd);
+        return false;
+    }
+
+    auto fill = [&slot](Slot& target, bool exact)
+    {
+        // The whitelist flag belongs to the [NetFn, Cmd] pair, not to the
+        // handler, so it survives (re)assignment of the handler.
+        auto whitelisted = target.whitelisted;
+        target = slot;
+        target.exact = exact;
+        target.whitelisted = whitelisted;
+    };
+
+    fill(row[cmd], true);
+
+    // Precompute the wildcard fallback for every command of this NetFn that
+    // does not have a handler of its own.
+    if (cmd == IPMI_CMD_WILDCARD)
+    {
+        for (size_t i = 0; i < maxCmd; ++i)
+        {
+            if (!row[i].exact)
+            {
+                fill(row[i], false);
+            }
+        }
+    }
+
+    return true;
+}
+
+void Table::allow(ipmi_netfn_t netfn, ipmi_cmd_t cmd)
+{
+    if (netfn >= maxNetFn)
+    {
+        return;
+    }
+    slots[(netfn * maxCmd) + cmd].whitelisted = true;
+}
+
+bool Table::markReadOnly(ipmi_netfn_t netfn, ipmi_cmd_t cmd)
+{
+    if (netfn >= maxNetFn || !slots[(netfn * maxCmd) + cmd].exact)
+    {
+        fprintf(stderr, "ERROR : No handler to declare read only for "
+                "NetFn [0x%X], Cmd:[0x%X]\n", netfn, cmd);
+        return false;
+    }
+    slots[(netfn * maxCmd) + cmd].readOnly = true;
+    return true;
+}
+
+} // namespace dispatch
+} // namespace ipmi
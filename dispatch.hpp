@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "host-ipmid/ipmid-api.h"
+#include "host-ipmid/ipmid-async.hpp"
+
+namespace ipmi
+{
+namespace dispatch
+{
+
+/** @brief Number of NetFn values addressable by the 6-bit NetFn field */
+constexpr size_t maxNetFn = 64;
+
+/** @brief Number of commands per NetFn */
+constexpr size_t maxCmd = 256;
+
+/** @struct Slot
+ *  @brief Routing information for a single [NetFn, Cmd] pair.
+ *
+ *  A slot without an exact registration carries a copy of the NetFn's
+ *  wildcard handler, if there is one, so the router never has to perform
+ *  a second lookup.
+ */
+struct Slot
+{
+    ipmid_callback_t handler;   //!< Handler to invoke, nullptr if none.
+    ipmid_async_callback_t asyncHandler; //!< Deferred response handler.
+    ipmi_context_t context;     //!< Opaque provider data for the handler.
+    ipmi_cmd_privilege_t priv;  //!< Privilege required by the command.
+    ipmi_cmd_concurrency_t concurrency; //!< Where the handler may run.
+    bool exact;                 //!< Registered for this exact command.
+    bool whitelisted;           //!< Allowed while in restricted mode.
+    bool readOnly;              //!< Identical requests share a response.
+
+    /** @brief Whether either kind of handler is registered */
+    inline bool registered() const
+    {
+        return handler != nullptr || asyncHandler != nullptr;
+    }
+};
+
+/** @class Table
+ *  @brief Direct indexed [NetFn, Cmd] -> handler table.
+ *
+ *  Providers populate the table through ipmi_register_callback() while they
+ *  are being loaded. Once every provider has been loaded the table is frozen
+ *  and lookups are a single array access.
+ */
+class Table
+{
+    public:
+        Table() = default;
+        ~Table() = default;
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+        Table(Table&&) = delete;
+        Table& operator=(Table&&) = delete;
+
+        /** @brief Register a handler for a [NetFn, Cmd] pair.
+         *
+         *  Registering IPMI_CMD_WILDCARD fills every slot of the NetFn that
+         *  has no exact registration of its own.
+         *
+         *  @param[in] netfn - Network function.
+         *  @param[in] cmd - Command, or IPMI_CMD_WILDCARD.
+         *  @param[in] context - Provider data passed back to the handler.
+         *  @param[in] handler - Command handler.
+         *  @param[in] priv - Privilege required to execute the command.
+         *  @param[in] concurrency - Where the handler may run.
+         *
+         *  @return true if registered, false on a duplicate registration,
+         *          an out of range NetFn or a frozen table.
+         */
+        bool add(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_context_t context,
+                 ipmid_callback_t handler, ipmi_cmd_privilege_t priv,
+                 ipmi_cmd_concurrency_t concurrency = CONCURRENCY_EVENT_LOOP);
+
+        /** @brief Register a deferred response handler for a [NetFn, Cmd]
+         *         pair. Same rules as for the synchronous handlers apply.
+         */
+        bool add(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_context_t context,
+                 ipmid_async_callback_t handler, ipmi_cmd_privilege_t priv);
+
+        /** @brief Allow a [NetFn, Cmd] pair while in restricted mode.
+         *
+         *  @param[in] netfn - Network function.
+         *  @param[in] cmd - Command.
+         */
+        void allow(ipmi_netfn_t netfn, ipmi_cmd_t cmd);
+
+        /** @brief Declare the handler of a [NetFn, Cmd] pair read only, see
+         *         ipmi_register_read_only().
+         *
+         *  Only for exact registrations, a wildcard handler also serves
+         *  commands it knows nothing of.
+         *
+         *  @param[in] netfn - Network function.
+         *  @param[in] cmd - Command.
+         *
+         *  @return false if the command has no exact registration.
+         */
+        bool markReadOnly(ipmi_netfn_t netfn, ipmi_cmd_t cmd);
+
+        /** @brief Look up the routing slot of a [NetFn, Cmd] pair.
+         *
+         *  @param[in] netfn - Network function.
+         *  @param[in] cmd - Command.
+         *
+         *  @return The slot; it is not registered() if neither the command
+         *          nor the NetFn wildcard is registered.
+         */
+        inline const Slot& find(ipmi_netfn_t netfn, ipmi_cmd_t cmd) const
+        {
+            if (netfn >= maxNetFn)
+            {
+                return empty;
+            }
+            return slots[(netfn * maxCmd) + cmd];
+        }
+
+        /** @brief Reject any further registration */
+        inline void freeze()
+        {
+            frozen = true;
+        }
+
+        /** @brief Allow registrations again, e.g. while loading a provider */
+        inline void thaw()
+        {
+            frozen = false;
+        }
+
+        inline bool isFrozen() const
+        {
+            return frozen;
+        }
+
+    private:
+        /** @brief Fill the slot of a [NetFn, Cmd] pair, and the wildcard
+         *         fallbacks of the NetFn when cmd is IPMI_CMD_WILDCARD.
+         */
+        bool add(ipmi_netfn_t netfn, ipmi_cmd_t cmd, const Slot& slot);
+
+        /** @brief Slots, indexed by (NetFn * maxCmd) + Cmd. Only the rows of
+         *         NetFns that are registered get touched, so the rest of the
+         *         table stays in untouched zero pages.
+         */
+        std::array<Slot, maxNetFn * maxCmd> slots{};
+
+        /** @brief Returned for NetFns outside the table */
+        Slot empty{};
+
+        /** @brief Set once all providers have registered */
+        bool frozen = false;
+};
+
+/** @brief Get the process wide dispatch table */
+Table& table();
+
+} // namespace dispatch
+} // namespace ipmi
@@ -6,22 +6,27 @@ if [ "x$*" == "x" ]; then
     exit -1
 fi
 
-cat << EOF
-#include <ipmiwhitelist.hpp>
-
-const std::vector<netfncmd_pair> whitelist = {
-
-EOF
-
 # Output each row of whitelist vector.
 # Concatenate all the passed files.
 # Remove comments and empty lines.
 # Sort the list [numerically].
 # Remove any duplicates.
 # Turn "a:b //<NetFn>:<Command>" -> "{ a, b }, //<NetFn>:<Command>"
-cat $* | sed "s/#.*//" | sed '/^$/d' | sort -n | uniq | sed "s/^/    { /" | \
-    sed "s/\:\(....\)\(.*\)/ , \1 }, \2/"
+rows=$(cat $* | sed "s/#.*//" | sed '/^$/d' | sort -n | uniq | \
+    sed "s/^/    { /" | sed "s/\:\(....\)\(.*\)/ , \1 }, \2/")
 
 cat << EOF
+#include <ipmiwhitelist.hpp>
+
+const std::vector<netfncmd_pair> whitelist = {
+
+${rows}
 };
+
+// Same list as a bitmap, built at compile time, for a single bit test per
+// command.
+constexpr whitelist_bitmap_t whitelist_bitmap = make_whitelist_bitmap({
+
+${rows}
+});
 EOF
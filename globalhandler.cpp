@@ -3,7 +3,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
-#include <mapper.h>
+#include "utils.hpp"
 
 const char  *control_object_name  =  "/org/openbmc/control/bmc0";
 const char  *control_intf_name    =  "org.openbmc.control.Bmc";
@@ -19,7 +19,7 @@ int dbus_reset(const char *method)
     int r;
 
     bus = ipmid_get_sd_bus_connection();
-    r = mapper_get_service(bus, control_object_name, &connection);
+    r = ipmi::getService(bus, control_object_name, &connection);
     if (r < 0) {
         fprintf(stderr, "Failed to get connection for %s: %s\n",
                 control_object_name, strerror(-r));
@@ -37,7 +37,7 @@ int dbus_reset(const char *method)
      * Signatures and input arguments are provided by the arguments at the
      * end.
      */
-    r = sd_bus_call_method(bus,
+    r = ipmi::callMethod(bus,
             connection,                                /* service to contact */
             control_object_name,                       /* object path */
             control_intf_name,                         /* interface name */
@@ -117,7 +117,7 @@ void Manager::checkQueueAndAlertHost()
                                                 IPMI_PATH.c_str(),
                                                 IPMI_INTERFACE.c_str(),
                                                 "setAttention");
-        auto reply = this->bus.call(method);
+        auto reply = ipmi::call(this->bus, method);
 
         if (reply.is_method_error())
         {
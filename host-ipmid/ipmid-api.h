@@ -22,6 +22,18 @@ enum CommandPrivilege {
   SYSTEM_INTERFACE   = 0xFF,
 };
 
+/*
+ * Specifies where the command handler may run when ipmid is started with
+ * worker threads. Handlers run on the sd_event loop by default. A handler
+ * that runs on a worker thread must not touch the sd_bus connection or the
+ * sd_event loop of ipmid, neither of which is thread safe.
+ */
+enum CommandConcurrency {
+  CONCURRENCY_EVENT_LOOP = 0,  // Only on the sd_event loop
+  CONCURRENCY_SERIAL_NETFN,    // On a worker, one command of the NetFn at a time
+  CONCURRENCY_PARALLEL,        // On a worker, concurrently with any command
+};
+
 // length of Completion Code and its ALWAYS _1_
 #define IPMI_CC_LEN 1
 
@@ -63,6 +75,8 @@ typedef unsigned char ipmi_ret_t;
 
 typedef enum CommandPrivilege ipmi_cmd_privilege_t;
 
+typedef enum CommandConcurrency ipmi_cmd_concurrency_t;
+
 // This is the callback handler that the plugin registers with IPMID. IPMI
 // function router will then make a call to this callback handler with the
 // necessary arguments of netfn, cmd, request, response, size and context.
@@ -75,6 +89,19 @@ typedef ipmi_ret_t (*ipmid_callback_t)(ipmi_netfn_t, ipmi_cmd_t, ipmi_request_t,
 void ipmi_register_callback(ipmi_netfn_t, ipmi_cmd_t, ipmi_context_t, ipmid_callback_t,
                             ipmi_cmd_privilege_t);
 
+// Same as ipmi_register_callback, additionally declaring where the handler
+// may run. See CommandConcurrency.
+void ipmi_register_callback_concurrency(ipmi_netfn_t, ipmi_cmd_t, ipmi_context_t,
+                                        ipmid_callback_t, ipmi_cmd_privilege_t,
+                                        ipmi_cmd_concurrency_t);
+
+// Declares the handler registered for a command as read only: it changes
+// nothing and its response only depends on the request. A request that
+// comes in while an identical one is being handled, by an asynchronous
+// handler or on a worker thread, gets the same response instead of being
+// handled again. Call it right after registering the handler.
+void ipmi_register_read_only(ipmi_netfn_t, ipmi_cmd_t);
+
 
 unsigned short get_sel_reserve_id(void);
 
@@ -111,7 +138,9 @@ enum ipmi_return_codes
 {
     IPMI_CC_OK = 0x00,
     IPMI_DCMI_CC_NO_ACTIVE_POWER_LIMIT = 0x80,
+    IPMI_CC_BUSY = 0xC0,
     IPMI_CC_INVALID = 0xC1,
+    IPMI_CC_TIMEOUT = 0xC3,
     IPMI_CC_INVALID_RESERVATION_ID = 0xC5,
     IPMI_CC_REQ_DATA_LEN_INVALID = 0xC7,
     IPMI_CC_PARM_OUT_OF_RANGE = 0xC9,
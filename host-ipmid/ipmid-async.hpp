@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <stdint.h>
+#include "ipmid-api.h"
+
+// Sends the response of a deferred command: the completion code and the
+// response data that follows it. It must be called once, from the sd_event
+// loop. If it is destroyed without being called, the host gets an
+// IPMI_CC_UNSPECIFIED_ERROR response.
+using ipmid_responder_t =
+    std::function<void(ipmi_ret_t, const std::vector<uint8_t>&)>;
+
+// This is the callback handler of a command that can complete after it has
+// returned. The request buffer is only valid during the call, so anything
+// needed later has to be copied. The handler either calls the responder
+// right away or keeps it until its work completes on the sd_event loop.
+typedef void (*ipmid_async_callback_t)(ipmi_netfn_t, ipmi_cmd_t,
+                                       ipmi_request_t, size_t,
+                                       ipmid_responder_t, ipmi_context_t);
+
+// Registers a deferred response handler. Otherwise, this behaves the same as
+// ipmi_register_callback.
+void ipmi_register_async_callback(ipmi_netfn_t, ipmi_cmd_t, ipmi_context_t,
+                                  ipmid_async_callback_t,
+                                  ipmi_cmd_privilege_t);
+
+// Runs the work on a later iteration of the sd_event loop. This lets a
+// long running handler split its work into steps, so other requests are
+// processed between the steps.
+void ipmid_post(std::function<void()>&& work);
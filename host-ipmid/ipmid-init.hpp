@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+namespace ipmi
+{
+namespace init
+{
+
+/** @brief Completion of an initialization
+ *
+ *  @param[in] result - 0, or a negative errno if it failed.
+ */
+using Done = std::function<void(int result)>;
+
+/** @brief Initialization of provider state. It runs on the sd_event loop
+ *         and must not wait for D-Bus replies: it sends its calls
+ *         asynchronously and calls done once the last reply came in.
+ */
+using Start = std::function<void(Done&& done)>;
+
+/** @class Once
+ *  @brief Provider state built once the event loop runs, rather than while
+ *         the provider is being loaded.
+ *
+ *  ipmid starts every Once together once the providers are loaded, so their
+ *  D-Bus queries are in flight at the same time. Handlers check ready() and
+ *  answer IPMI_CC_BUSY until the state is built. A failed initialization is
+ *  started again by the next ready().
+ *
+ *  Meant for objects of static storage duration, the initialization can
+ *  complete at any time until the process exits.
+ */
+class Once
+{
+    public:
+        /** @brief Registers an initialization, started by startAll()
+         *
+         *  @param[in] name - What is being initialized, for the journal.
+         *  @param[in] start - The initialization.
+         */
+        Once(const char* name, Start&& start);
+        ~Once();
+        Once(const Once&) = delete;
+        Once& operator=(const Once&) = delete;
+        Once(Once&&) = delete;
+        Once& operator=(Once&&) = delete;
+
+        /** @brief Whether the state is built, starting its initialization
+         *         if it is neither built nor being built
+         *
+         *  Can be called from the worker threads, the initialization always
+         *  starts on the event loop.
+         */
+        bool ready();
+
+    private:
+        enum class State
+        {
+            idle,
+            running,
+            done,
+        };
+
+        /** @brief Runs the initialization, on the event loop */
+        void run();
+
+        /** @brief Completion of the initialization */
+        void complete(int result);
+
+        const char* name;
+        Start start;
+        std::atomic<State> state{State::idle};
+        std::chrono::steady_clock::time_point started;
+};
+
+/** @brief Starts the initialization of every Once, and of those of the
+ *         providers loaded later on as soon as they are constructed
+ *
+ *  Called by ipmid once its bus is attached to the event loop.
+ */
+void startAll();
+
+} // namespace init
+} // namespace ipmi
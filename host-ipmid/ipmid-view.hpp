@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <stdint.h>
+#include "ipmid-api.h"
+
+namespace ipmi
+{
+
+/** @brief Space for response data, after the completion code */
+constexpr size_t maxResponseData = 64 - IPMI_CC_LEN;
+
+/** @class RequestView
+ *  @brief Bounded, read-only view of the request data of a command.
+ *
+ *  Every accessor checks the length of the request, so handlers never read
+ *  past the data that the host actually sent.
+ */
+class RequestView
+{
+    public:
+        RequestView() = delete;
+
+        /** @brief Constructs a view of the request data
+         *
+         *  @param[in] data - Request data, as passed to the handler.
+         *  @param[in] size - Request length, i.e. *data_len on entry.
+         */
+        RequestView(ipmi_request_t data, size_t size) :
+            ptr(static_cast<const uint8_t*>(data)), len(size)
+        {
+        }
+
+        inline const uint8_t* data() const
+        {
+            return ptr;
+        }
+
+        inline size_t size() const
+        {
+            return len;
+        }
+
+        /** @brief Views the request as a packed struct, in place
+         *
+         *  @return The request, or nullptr if it is shorter than T.
+         */
+        template <typename T>
+        const T* get() const
+        {
+            static_assert(alignof(T) == 1,
+                          "Only packed structs can be viewed in place");
+            return len >= sizeof(T) ? reinterpret_cast<const T*>(ptr) :
+                   nullptr;
+        }
+
+        /** @brief Copies the start of the request into value
+         *
+         *  @param[out] value - Unpacked value.
+         *
+         *  @return false if the request is shorter than T.
+         */
+        template <typename T>
+        bool unpack(T& value) const
+        {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "Only trivially copyable types can be unpacked");
+            if (len < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&value, ptr, sizeof(T));
+            return true;
+        }
+
+    private:
+        const uint8_t* ptr;
+        size_t len;
+};
+
+/** @class ResponseView
+ *  @brief Bounded view of the response buffer of a command.
+ *
+ *  The response starts out empty, and the length reported to the router
+ *  follows whatever is appended, so an early return reports no data.
+ */
+class ResponseView
+{
+    public:
+        ResponseView() = delete;
+
+        /** @brief Constructs an empty response
+         *
+         *  Views over the same data_len as a RequestView must be created
+         *  after it, as the request length is reset here.
+         *
+         *  @param[in] data - Response buffer, as passed to the handler.
+         *  @param[in] dataLen - Response length, as passed to the handler.
+         *  @param[in] capacity - Size of the response buffer.
+         */
+        ResponseView(ipmi_response_t data, ipmi_data_len_t dataLen,
+                     size_t capacity = maxResponseData) :
+            ptr(static_cast<uint8_t*>(data)), len(dataLen), cap(capacity)
+        {
+            *len = 0;
+        }
+
+        inline size_t size() const
+        {
+            return *len;
+        }
+
+        inline size_t capacity() const
+        {
+            return cap;
+        }
+
+        /** @brief Appends raw bytes
+         *
+         *  @return false, without appending anything, if they do not fit.
+         */
+        bool append(const void* data, size_t size)
+        {
+            if (size > cap - *len)
+            {
+                return false;
+            }
+            std::memcpy(ptr + *len, data, size);
+            *len += size;
+            return true;
+        }
+
+        /** @brief Appends a value, typically a packed struct
+         *
+         *  @return false, without appending anything, if it does not fit.
+         */
+        template <typename T>
+        bool pack(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "Only trivially copyable types can be packed");
+            return append(&value, sizeof(T));
+        }
+
+        /** @brief Discards the response data */
+        inline void clear()
+        {
+            *len = 0;
+        }
+
+    private:
+        uint8_t* ptr;
+        ipmi_data_len_t len;
+        size_t cap;
+};
+
+} // namespace ipmi
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <vector>
+#include <phosphor-logging/log.hpp>
+#include <host-ipmid/ipmid-async.hpp>
+#include <host-ipmid/ipmid-init.hpp>
+
+namespace ipmi
+{
+namespace init
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+/** @brief Every Once, only touched from the event loop */
+std::vector<Once*>& registry()
+{
+    // Constructed on first use, the providers' Once can be constructed
+    // before the statics of this file.
+    static std::vector<Once*> onces;
+    return onces;
+}
+
+/** @brief Set by startAll() */
+bool startedAll = false;
+
+} // namespace
+
+Once::Once(const char* name, Start&& start) :
+    name(name), start(std::move(start))
+{
+    registry().push_back(this);
+    if (startedAll)
+    {
+        ready();
+    }
+}
+
+Once::~Once()
+{
+    auto& onces = registry();
+    onces.erase(std::remove(onces.begin(), onces.end(), this), onces.end());
+}
+
+bool Once::ready()
+{
+    auto current = State::idle;
+    if (state.compare_exchange_strong(current, State::running))
+    {
+        ipmid_post([this]()
+                   {
+                       run();
+                   });
+        return false;
+    }
+    return current == State::done;
+}
+
+void Once::run()
+{
+    started = std::chrono::steady_clock::now();
+    try
+    {
+        start([this](int result)
+              {
+                  complete(result);
+              });
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Failed to start an initialization",
+                        entry("NAME=%s", name),
+                        entry("ERROR=%s", e.what()));
+        complete(-EIO);
+    }
+}
+
+void Once::complete(int result)
+{
+    if (state.load() != State::running)
+    {
+        return;
+    }
+
+    if (result < 0)
+    {
+        log<level::ERR>("Initialization failed, will retry on next use",
+                        entry("NAME=%s", name),
+                        entry("ERROR=%s", strerror(-result)));
+        state = State::idle;
+        return;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - started);
+    log<level::INFO>("Initialization complete",
+                     entry("NAME=%s", name),
+                     entry("ELAPSED_MS=%lld",
+                           static_cast<long long>(elapsed.count())));
+    state = State::done;
+}
+
+void startAll()
+{
+    startedAll = true;
+    for (auto once : registry())
+    {
+        once->ready();
+    }
+}
+
+} // namespace init
+} // namespace ipmi
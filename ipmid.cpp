@@ -8,9 +8,11 @@
 #include <string.h>
 #include <stdlib.h>
 #include <map>
+#include <tuple>
 #include <memory>
 #include <phosphor-logging/log.hpp>
 #include <sys/time.h>
+#include <inttypes.h>
 #include <errno.h>
 #include <mapper.h>
 #include "sensorhandler.h"
@@ -23,7 +25,17 @@
 #include <xyz/openbmc_project/Control/Security/RestrictionMode/server.hpp>
 #include "sensorhandler.h"
 #include "ipmid.hpp"
+#include "dispatch.hpp"
+#include "providers.hpp"
+#include "retransmit.hpp"
+#include "worker-pool.hpp"
+#include "trace.hpp"
+#include "stats.hpp"
+#include <host-ipmid/ipmid-async.hpp>
+#include <host-ipmid/ipmid-init.hpp>
+#include <host-ipmid/ipmid-view.hpp>
 #include "settings.hpp"
+#include "utils.hpp"
 #include <host-cmd-manager.hpp>
 #include <host-ipmid/ipmid-host-cmd.hpp>
 #include <timer.hpp>
@@ -46,28 +58,62 @@ cmdManagerPtr cmdManager;
 // into host message queue
 using CommandHandler = phosphor::host::command::CommandHandler;
 
+// Runs the handlers that may run off the event loop, if enabled with -w
+std::unique_ptr<ipmi::worker::Pool> workerPool;
+
 // Initialise restricted mode to true
 bool restricted_mode = true;
 
 FILE *ipmiio, *ipmidbus, *ipmicmddetails;
 
 void print_usage(void) {
-  fprintf(stderr, "Options:  [-d mask]\n");
-  fprintf(stderr, "    mask : 0x01 - Print ipmi packets\n");
+  fprintf(stderr, "Options:  [-d mask] [-w threads] [-s seconds] [-c file] "
+          "[-t [interface=]ms]... [-m manifest | -g manifest]\n");
+  fprintf(stderr, "    mask : 0x01 - Trace ipmi packets to %s\n",
+          ipmi::trace::ringPath);
   fprintf(stderr, "    mask : 0x02 - Print DBUS operations\n");
+  fprintf(stderr, "    threads : Worker threads for the handlers that allow it\n");
+  fprintf(stderr, "    seconds : Period of the command statistics dump to %s\n",
+          ipmi::stats::dumpPath);
+  fprintf(stderr, "    file : Capture every request to file, for ipmid-replay\n");
+  fprintf(stderr, "    ms : Timeout of the D-Bus calls to interface, or to "
+          "any interface\n");
+  fprintf(stderr, "    -m manifest : Load the providers on first use of "
+          "their commands, as per manifest\n");
+  fprintf(stderr, "    -g manifest : Load every provider, write the manifest "
+          "of what they register and exit\n");
   fprintf(stderr, "    mask : 0x04 - Print ipmi command details\n");
   fprintf(stderr, "    mask : 0xFF - Print all trace\n");
 }
 
-const char * DBUS_INTF = "org.openbmc.HostIpmi";
+// Parses a -t option, "interface=ms" or "ms" for the interfaces without a
+// budget of their own.
+static bool set_call_budget(const std::string& option)
+{
+    auto equal = option.rfind('=');
+    auto value = option.substr(equal == std::string::npos ? 0 : equal + 1);
+    char* end = nullptr;
+    auto ms = strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || ms == 0)
+    {
+        return false;
+    }
 
-const char * FILTER = "type='signal',interface='org.openbmc.HostIpmi',member='ReceivedMessage'";
+    auto budget = std::chrono::milliseconds(ms);
+    if (equal == std::string::npos)
+    {
+        ipmi::timeout::setDefaultBudget(budget);
+    }
+    else
+    {
+        ipmi::timeout::setBudget(option.substr(0, equal), budget);
+    }
+    return true;
+}
 
-typedef std::pair<ipmi_netfn_t, ipmi_cmd_t> ipmi_fn_cmd_t;
-typedef std::pair<ipmid_callback_t, ipmi_context_t> ipmi_fn_context_t;
+const char * DBUS_INTF = "org.openbmc.HostIpmi";
 
-// Global data structure that contains the IPMI command handler's registrations.
-std::map<ipmi_fn_cmd_t, ipmi_fn_context_t> g_ipmid_router_map;
+const char * FILTER = "type='signal',interface='org.openbmc.HostIpmi',member='ReceivedMessage'";
 
 // IPMI Spec, shared Reservation ID.
 unsigned short g_sel_reserve = 0xFFFF;
@@ -91,145 +137,95 @@ std::unique_ptr<settings::Objects> objects = nullptr;
 } // namespace cache
 } // namespace internal
 
-#ifndef HEXDUMP_COLS
-#define HEXDUMP_COLS 16
-#endif
-
-void hexdump(FILE *s, void *mem, size_t len)
-{
-        unsigned int i, j;
-
-        for(i = 0; i < len + ((len % HEXDUMP_COLS) ? (HEXDUMP_COLS - len % HEXDUMP_COLS) : 0); i++)
-        {
-                /* print offset */
-                if(i % HEXDUMP_COLS == 0)
-                {
-                        fprintf(s,"0x%06x: ", i);
-                }
-
-                /* print hex data */
-                if(i < len)
-                {
-                        fprintf(s,"%02x ", 0xFF & ((char*)mem)[i]);
-                }
-                else /* end of block, just aligning for ASCII dump */
-                {
-                        fprintf(s,"   ");
-                }
-
-                /* print ASCII dump */
-                if(i % HEXDUMP_COLS == (HEXDUMP_COLS - 1))
-                {
-                        for(j = i - (HEXDUMP_COLS - 1); j <= i; j++)
-                        {
-                                if(j >= len) /* end of block, not really printing */
-                                {
-                                        fputc(' ', s);
-                                }
-                                else if(isprint(((char*)mem)[j])) /* printable char */
-                                {
-                                        fputc(0xFF & ((char*)mem)[j], s);
-                                }
-                                else /* other char */
-                                {
-                                        fputc('.',s);
-                                }
-                        }
-                        fputc('\n',s);
-                }
-        }
-}
-
-
 // Method that gets called by shared libraries to get their command handlers registered
 void ipmi_register_callback(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_context_t context,
                             ipmid_callback_t handler, ipmi_cmd_privilege_t priv)
 {
-    // Pack NetFn and Command in one.
-    auto netfn_and_cmd = std::make_pair(netfn, cmd);
+    ipmi::dispatch::table().add(netfn, cmd, context, handler, priv);
+    return;
+}
 
-    // Pack Function handler and Data in another.
-    auto handler_and_context = std::make_pair(handler, context);
+// Same as above, for handlers that may run on a worker thread.
+void ipmi_register_callback_concurrency(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                                        ipmi_context_t context,
+                                        ipmid_callback_t handler,
+                                        ipmi_cmd_privilege_t priv,
+                                        ipmi_cmd_concurrency_t concurrency)
+{
+    ipmi::dispatch::table().add(netfn, cmd, context, handler, priv,
+                                concurrency);
+    return;
+}
 
-    // Check if the registration has already been made..
-    auto iter = g_ipmid_router_map.find(netfn_and_cmd);
-    if(iter != g_ipmid_router_map.end())
-    {
-        fprintf(stderr,"ERROR : Duplicate registration for NetFn [0x%X], Cmd:[0x%X]\n",netfn, cmd);
-    }
-    else
-    {
-        // This is a fresh registration.. Add it to the map.
-        g_ipmid_router_map.emplace(netfn_and_cmd, handler_and_context);
-    }
+// Same as above, for handlers that send their response once they complete.
+void ipmi_register_async_callback(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                                  ipmi_context_t context,
+                                  ipmid_async_callback_t handler,
+                                  ipmi_cmd_privilege_t priv)
+{
+    ipmi::dispatch::table().add(netfn, cmd, context, handler, priv);
+    return;
+}
 
+void ipmi_register_read_only(ipmi_netfn_t netfn, ipmi_cmd_t cmd)
+{
+    ipmi::dispatch::table().markReadOnly(netfn, cmd);
     return;
 }
 
-// Looks at the map and calls corresponding handler functions.
+// Whether the command of this slot can be executed in the current mode.
+static inline bool ipmi_cmd_allowed(const ipmi::dispatch::Slot& slot)
+{
+    return !restricted_mode || slot.whitelisted;
+}
+
+// Looks up the dispatch table and calls corresponding handler functions.
 ipmi_ret_t ipmi_netfn_router(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_request_t request,
                       ipmi_response_t response, ipmi_data_len_t data_len)
 {
     // return from the Command handlers.
     ipmi_ret_t rc = IPMI_CC_INVALID;
 
+    // The slot already carries the NetFn wildcard handler when there is no
+    // registration for this exact command, and whether the command is
+    // whitelisted.
+    const auto& slot = ipmi::dispatch::table().find(netfn, cmd);
+
     // If restricted mode is true and command is not whitelisted, don't
     // execute the command
-    if(restricted_mode)
+    if(!ipmi_cmd_allowed(slot))
     {
-        if (!std::binary_search(whitelist.cbegin(), whitelist.cend(),
-                                        std::make_pair(netfn, cmd)))
-        {
-            printf("Net function:[0x%X], Command:[0x%X] is not whitelisted\n",
-                                         netfn, cmd);
-            rc = IPMI_CC_INSUFFICIENT_PRIVILEGE;
-            memcpy(response, &rc, IPMI_CC_LEN);
-            *data_len = IPMI_CC_LEN;
-            return rc;
-        }
+        printf("Net function:[0x%X], Command:[0x%X] is not whitelisted\n",
+                                     netfn, cmd);
+        rc = IPMI_CC_INSUFFICIENT_PRIVILEGE;
+        memcpy(response, &rc, IPMI_CC_LEN);
+        *data_len = IPMI_CC_LEN;
+        return rc;
     }
 
-    // Walk the map that has the registered handlers and invoke the approprite
-    // handlers for matching commands.
-    auto iter = g_ipmid_router_map.find(std::make_pair(netfn, cmd));
-    if(iter == g_ipmid_router_map.end())
+    if(!slot.registered())
     {
-        /* By default should only print on failure to find wildcard command. */
-#ifdef __IPMI_DEBUG__
-        fprintf(stderr, "No registered handlers for NetFn:[0x%X], Cmd:[0x%X]"
-               " trying Wilcard implementation \n",netfn, cmd);
-#endif
+        fprintf(stderr, "No Registered handlers for NetFn:[0x%X],Cmd:[0x%X]\n",netfn, cmd);
 
-        // Now that we did not find any specific [NetFn,Cmd], tuple, check for
-        // NetFn, WildCard command present.
-        iter = g_ipmid_router_map.find(std::make_pair(netfn, IPMI_CMD_WILDCARD));
-        if(iter == g_ipmid_router_map.end())
-        {
-            fprintf(stderr, "No Registered handlers for NetFn:[0x%X],Cmd:[0x%X]\n",netfn, IPMI_CMD_WILDCARD);
-
-            // Respond with a 0xC1
-            memcpy(response, &rc, IPMI_CC_LEN);
-            *data_len = IPMI_CC_LEN;
-            return rc;
-        }
+        // Respond with a 0xC1
+        memcpy(response, &rc, IPMI_CC_LEN);
+        *data_len = IPMI_CC_LEN;
+        return rc;
     }
 
 #ifdef __IPMI_DEBUG__
     // We have either a perfect match -OR- a wild card atleast,
-    printf("Calling Net function:[0x%X], Command:[0x%X]\n", netfn, cmd);
+    printf("Calling Net function:[0x%X], Command:[0x%X]%s\n", netfn, cmd,
+           slot.exact ? "" : " via wildcard");
 #endif
 
-    // Extract the map data onto appropriate containers
-    auto handler_and_context = iter->second;
-
     // Creating a pointer type casted to char* to make sure we advance 1 byte
     // when we advance pointer to next's address. advancing void * would not
     // make sense.
     char *respo = &((char *)response)[IPMI_CC_LEN];
 
     // Response message from the plugin goes into a byte post the base response
-    rc = (handler_and_context.first) (netfn, cmd, request, respo,
-                                      data_len, handler_and_context.second);
+    rc = (slot.handler) (netfn, cmd, request, respo, data_len, slot.context);
 
     // Now copy the return code that we got from handler and pack it in first
     // byte.
@@ -244,12 +240,63 @@ ipmi_ret_t ipmi_netfn_router(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_request_t
 
 
 
+namespace internal
+{
+
+/** @struct BridgeStats
+ *  @brief Delivery accounting of the responses sent to a bridge.
+ */
+struct BridgeStats
+{
+    uint64_t sent;      //!< Responses handed to the bridge.
+    uint64_t failed;    //!< Responses the bridge failed to deliver.
+};
+
+/** @brief Per bridge statistics, keyed by the bridge's bus name */
+std::map<std::string, BridgeStats> bridgeStats;
+
+} // namespace internal
+
+// Called when the bridge replies to a sendMessage call.
+static int send_ipmi_message_reply(sd_bus_message *reply, void *userdata,
+                                   sd_bus_error *ret_error)
+{
+    auto stats = static_cast<internal::BridgeStats*>(userdata);
+    const char *dest = sd_bus_message_get_sender(reply);
+    int64_t pty = 0;
+    int r;
+
+    if (sd_bus_message_is_method_error(reply, NULL)) {
+        ++stats->failed;
+        fprintf(stderr, "Failed to call the method: %s\n",
+                sd_bus_message_get_error(reply)->message);
+        fprintf(stderr, "Dest: %s, failed responses: %" PRIu64 "/%" PRIu64 "\n",
+                dest ? dest : "", stats->failed, stats->sent);
+        return 0;
+    }
+
+    r = sd_bus_message_read(reply, "x", &pty);
+    if (r < 0) {
+        ++stats->failed;
+        fprintf(stderr, "Failed to get a rc from the method: %s\n", strerror(-r));
+    }
+    else if (pty != 0) {
+        ++stats->failed;
+        fprintf(stderr, "Bridge %s failed to send the response: %" PRId64
+                ", failed responses: %" PRIu64 "/%" PRIu64 "\n",
+                dest ? dest : "", pty, stats->failed, stats->sent);
+    }
+
+    return 0;
+}
+
+// Sends the response to the bridge without waiting for its reply, which is
+// checked by send_ipmi_message_reply() once it arrives.
 static int send_ipmi_message(sd_bus_message *req, unsigned char seq, unsigned char netfn, unsigned char lun, unsigned char cmd, unsigned char cc, unsigned char *buf, unsigned char len) {
 
-    sd_bus_error error = SD_BUS_ERROR_NULL;
-    sd_bus_message *reply = NULL, *m=NULL;
+    sd_bus_message *m=NULL;
     const char *dest, *path;
-    int r, pty;
+    int r;
 
     dest = sd_bus_message_get_sender(req);
     path = sd_bus_message_get_path(req);
@@ -280,27 +327,356 @@ static int send_ipmi_message(sd_bus_message *req, unsigned char seq, unsigned ch
         goto final;
     }
 
+    {
+        // std::map nodes are stable, the reply handler can keep the pointer.
+        auto& stats = internal::bridgeStats[dest ? dest : ""];
+
+        // Call the IPMI responder on the bus so the message can be sent to
+        // the CEC. The reply is handled from the event loop.
+        r = sd_bus_call_async(bus, NULL, m, send_ipmi_message_reply, &stats, 0);
+        if (r < 0) {
+            ++stats.failed;
+            fprintf(stderr, "Failed to call the method: %s\n", strerror(-r));
+            fprintf(stderr, "Dest: %s, Path: %s\n", dest, path);
+            goto final;
+        }
+        ++stats.sent;
+    }
 
+final:
+    m = sd_bus_message_unref(m);
 
-    // Call the IPMI responder on the bus so the message can be sent to the CEC
-    r = sd_bus_call(bus, m, 0, &error, &reply);
-    if (r < 0) {
-        fprintf(stderr, "Failed to call the method: %s\n", strerror(-r));
-        fprintf(stderr, "Dest: %s, Path: %s\n", dest, path);
-        goto final;
+    return r < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+namespace internal
+{
+
+/** @brief NetFn, LUN, command and data of a request */
+using CoalesceKey =
+    std::tuple<uint8_t, uint8_t, uint8_t, std::vector<uint8_t>>;
+
+/** @class DeferredResponse
+ *  @brief Response to a request served by an asynchronous handler.
+ *
+ *  Keeps a reference to the request message, which carries the bridge's
+ *  address, until the handler completes.
+ */
+class DeferredResponse
+{
+    public:
+        DeferredResponse() = delete;
+        DeferredResponse(const DeferredResponse&) = delete;
+        DeferredResponse& operator=(const DeferredResponse&) = delete;
+        DeferredResponse(DeferredResponse&&) = delete;
+        DeferredResponse& operator=(DeferredResponse&&) = delete;
+
+        DeferredResponse(sd_bus_message* req, unsigned char seq,
+                         unsigned char netfn, unsigned char lun,
+                         unsigned char cmd, const void* request,
+                         size_t sz) :
+            req(sd_bus_message_ref(req)),
+            seq(seq), netfn(netfn), lun(lun), cmd(cmd),
+            hash(ipmi::retransmit::hash(request, sz)),
+            start(ipmi::trace::now())
+        {
+        }
+
+        /** @brief The handler dropped the responder without calling it */
+        ~DeferredResponse()
+        {
+            if (!sent)
+            {
+                fprintf(stderr, "No response from handler for NetFn:[0x%X], "
+                        "Cmd:[0x%X]\n", netfn, cmd);
+                send(IPMI_CC_UNSPECIFIED_ERROR, {});
+            }
+            sd_bus_message_unref(req);
+        }
+
+        void send(ipmi_ret_t cc, const std::vector<uint8_t>& data);
+
+        /** @brief Makes the identical requests that come in until the
+         *         response is sent wait for it, see coalesce().
+         */
+        void lead(CoalesceKey&& key);
+
+        /** @brief Gives up the request without a response, it is handled
+         *         on the event loop instead.
+         */
+        void abandon();
+
+    private:
+        sd_bus_message* req;
+        unsigned char seq;
+        unsigned char netfn;
+        unsigned char lun;
+        unsigned char cmd;
+        uint64_t hash;      //!< Of the request data, see retransmit::hash.
+        uint64_t start;     //!< When the request came in, see trace::now.
+        bool sent = false;
+
+        /** @brief Set while identical requests wait for the response */
+        std::unique_ptr<CoalesceKey> leading;
+};
+
+/** @brief Requests to read only commands being handled, with the identical
+ *         requests waiting for their response.
+ */
+std::map<CoalesceKey, std::vector<std::shared_ptr<DeferredResponse>>>
+    inFlight;
+
+CoalesceKey coalesceKey(unsigned char netfn, unsigned char lun,
+                        unsigned char cmd, const void* request, size_t sz)
+{
+    auto data = static_cast<const uint8_t*>(request);
+    return CoalesceKey(netfn, lun, cmd,
+                       std::vector<uint8_t>(data, data + sz));
+}
+
+void DeferredResponse::send(ipmi_ret_t cc, const std::vector<uint8_t>& data)
+{
+    if (sent)
+    {
+        fprintf(stderr, "ERROR: Response already sent for "
+                "NetFn:[0x%X], Cmd:[0x%X]\n", netfn, cmd);
+        return;
     }
+    sent = true;
 
-    r = sd_bus_message_read(reply, "x", &pty);
-    if (r < 0) {
-       fprintf(stderr, "Failed to get a rc from the method: %s\n", strerror(-r));
+    if (leading)
+    {
+        auto found = inFlight.find(*leading);
+        if (found != inFlight.end())
+        {
+            auto waiting = std::move(found->second);
+            inFlight.erase(found);
+            for (auto& waiter : waiting)
+            {
+                waiter->send(cc, data);
+            }
+        }
+        leading.reset();
     }
 
-final:
-    sd_bus_error_free(&error);
-    m = sd_bus_message_unref(m);
-    reply = sd_bus_message_unref(reply);
+    auto payload = (unsigned char*)data.data();
+    auto len = data.size();
+    if (len > MAX_IPMI_BUFFER - IPMI_CC_LEN)
+    {
+        fprintf(stderr, "ERROR: Response too long for NetFn:[0x%X], "
+                "Cmd:[0x%X]\n", netfn, cmd);
+        cc = IPMI_CC_RESPONSE_ERROR;
+        payload = nullptr;
+        len = 0;
+    }
 
-    return r < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    auto latency = ipmi::trace::now() - start;
+    ipmi::stats::record(netfn, cmd, cc, latency);
+    if (ipmi::trace::enabled())
+    {
+        ipmi::trace::response(seq, netfn, lun, cmd, cc, payload, len,
+                              latency);
+    }
+
+    // Retries of the request that come in from now on get this
+    // response.
+    const char* sender = sd_bus_message_get_sender(req);
+    ipmi::retransmit::cache().response(sender ? sender : "",
+                                       {seq, netfn, lun, cmd, hash},
+                                       cc, payload, len);
+
+    auto r = send_ipmi_message(req, seq, netfn, lun, cmd, cc,
+                               payload, len);
+    if (r != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "Failed to send the response message\n");
+    }
+}
+
+void DeferredResponse::lead(CoalesceKey&& key)
+{
+    inFlight.emplace(key, std::vector<std::shared_ptr<DeferredResponse>>());
+    leading = std::make_unique<CoalesceKey>(std::move(key));
+}
+
+void DeferredResponse::abandon()
+{
+    sent = true;
+    if (leading)
+    {
+        // Nothing could come in and wait yet, the request is still being
+        // read.
+        inFlight.erase(*leading);
+        leading.reset();
+    }
+}
+
+// Makes a request to a read only command wait for the response to an
+// identical request being handled. Returns false if there is none.
+bool coalesce(sd_bus_message *m, unsigned char seq, unsigned char netfn,
+              unsigned char lun, unsigned char cmd, const void *request,
+              size_t sz)
+{
+    auto found = inFlight.find(coalesceKey(netfn, lun, cmd, request, sz));
+    if (found == inFlight.end())
+    {
+        return false;
+    }
+
+    found->second.emplace_back(std::make_shared<DeferredResponse>(
+                                   m, seq, netfn, lun, cmd, request, sz));
+    return true;
+}
+
+} // namespace internal
+
+// Hands the request to an asynchronous handler, the response is sent
+// whenever the handler calls the responder.
+static void ipmi_async_router(const ipmi::dispatch::Slot& slot,
+                              sd_bus_message *m, unsigned char seq,
+                              unsigned char netfn, unsigned char lun,
+                              unsigned char cmd, const void *request,
+                              size_t sz)
+{
+    auto pending = std::make_shared<internal::DeferredResponse>(
+                       m, seq, netfn, lun, cmd, request, sz);
+    if (slot.readOnly)
+    {
+        pending->lead(internal::coalesceKey(netfn, lun, cmd, request, sz));
+    }
+    ipmid_responder_t responder =
+        [pending](ipmi_ret_t cc, const std::vector<uint8_t>& data)
+        {
+            pending->send(cc, data);
+        };
+
+    try
+    {
+        slot.asyncHandler(netfn, cmd, (ipmi_request_t)request, sz,
+                          std::move(responder), slot.context);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Exception in asynchronous handler",
+                        entry("NETFN=0x%X", netfn),
+                        entry("CMD=0x%X", cmd),
+                        entry("EXCEPTION=%s", e.what()));
+        pending->send(IPMI_CC_UNSPECIFIED_ERROR, {});
+    }
+}
+
+// Hands the request to a worker thread if the handler allows it, the
+// response is sent from the event loop once the handler returns. Returns
+// false if the request has to be handled on the event loop.
+static bool ipmi_worker_router(const ipmi::dispatch::Slot& slot,
+                               sd_bus_message *m, unsigned char seq,
+                               unsigned char netfn, unsigned char lun,
+                               unsigned char cmd, const void *request,
+                               size_t sz)
+{
+    if (!workerPool || slot.handler == nullptr ||
+        slot.concurrency == CONCURRENCY_EVENT_LOOP)
+    {
+        return false;
+    }
+
+    struct Job
+    {
+        std::vector<uint8_t> request;
+        std::vector<uint8_t> response;
+        size_t len;
+        ipmi_ret_t cc;
+    };
+
+    auto job = std::make_shared<Job>();
+    job->request.assign((const uint8_t*)request, (const uint8_t*)request + sz);
+    job->response.resize(MAX_IPMI_BUFFER - IPMI_CC_LEN);
+    job->len = sz;
+    job->cc = IPMI_CC_UNSPECIFIED_ERROR;
+
+    auto pending = std::make_shared<internal::DeferredResponse>(
+                       m, seq, netfn, lun, cmd, request, sz);
+    if (slot.readOnly)
+    {
+        pending->lead(internal::coalesceKey(netfn, lun, cmd, request, sz));
+    }
+    auto handler = slot.handler;
+    auto context = slot.context;
+
+    auto deadline = ipmi::timeout::deadline();
+    auto work = [job, handler, context, netfn, cmd, deadline]()
+    {
+        // The bridge gave up on requests that queued past their deadline
+        if (ipmi::timeout::Clock::now() >= deadline)
+        {
+            ipmi::timeout::abandoned();
+            job->cc = IPMI_CC_TIMEOUT;
+            job->len = 0;
+            return;
+        }
+
+        ipmi::timeout::Scope scope(deadline);
+        try
+        {
+            job->cc = handler(netfn, cmd, job->request.data(),
+                              job->response.data(), &job->len, context);
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "ERROR: Exception in handler for NetFn:[0x%X], "
+                    "Cmd:[0x%X]: %s\n", netfn, cmd, e.what());
+            job->cc = IPMI_CC_UNSPECIFIED_ERROR;
+            job->len = 0;
+        }
+    };
+    auto done = [job, pending]()
+    {
+        job->response.resize(std::min(job->len, job->response.size()));
+        pending->send(job->cc, job->response);
+    };
+
+    auto key = slot.concurrency == CONCURRENCY_SERIAL_NETFN ?
+               static_cast<int>(netfn) : ipmi::worker::Pool::parallel;
+    if (!workerPool->submit(key, std::move(work), std::move(done)))
+    {
+        pending->abandon();
+        return false;
+    }
+    return true;
+}
+
+static int run_posted_work(sd_event_source *source, void *userdata)
+{
+    std::unique_ptr<std::function<void()>> work(
+        static_cast<std::function<void()>*>(userdata));
+    sd_event_source_unref(source);
+
+    try
+    {
+        (*work)();
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Exception in posted work",
+                        entry("EXCEPTION=%s", e.what()));
+    }
+    return 0;
+}
+
+void ipmid_post(std::function<void()>&& work)
+{
+    auto data = new std::function<void()>(std::move(work));
+    sd_event_source *source = nullptr;
+
+    auto r = sd_event_add_defer(events, &source, run_posted_work, data);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to post work to the event loop",
+                        entry("ERROR=%s", strerror(-r)));
+        // Do not lose the work, whoever posted it may hold a responder.
+        std::unique_ptr<std::function<void()>> inlineWork(data);
+        (*inlineWork)();
+    }
 }
 
 void cache_restricted_mode()
@@ -319,7 +695,7 @@ void cache_restricted_mode()
                       "org.freedesktop.DBus.Properties",
                       "Get");
     method.append(restrictionModeIntf, "RestrictionMode");
-    auto resp = dbus.call(method);
+    auto resp = ipmi::call(dbus, method);
     if (resp.is_method_error())
     {
         log<level::ERR>("Error in RestrictionMode Get");
@@ -344,6 +720,79 @@ static int handle_restricted_mode_change(sd_bus_message *m, void *user_data,
     return 0;
 }
 
+namespace internal
+{
+
+// Watches restricted mode changes once the setting is found.
+std::unique_ptr<sdbusplus::bus::match_t> restrictedModeMatch;
+
+// Restricted mode is assumed until the setting is read. Meanwhile the
+// commands it rejects are answered busy rather than refused.
+ipmi::init::Once restrictionMode(
+    "RestrictionMode setting",
+    [](ipmi::init::Done&& done)
+    {
+        settings::Objects::fetch(
+            *sdbusp,
+            {restrictionModeIntf},
+            [done](std::unique_ptr<settings::Objects>&& found)
+            {
+                if (!found)
+                {
+                    done(-ENOENT);
+                    return;
+                }
+
+                cache::objects = std::move(found);
+                // Initialize restricted mode
+                cache_restricted_mode();
+                // Wait for changes on Restricted mode
+                const auto& setting =
+                    cache::objects->map.at(restrictionModeIntf).front();
+                restrictedModeMatch =
+                    std::make_unique<sdbusplus::bus::match_t>(
+                        *sdbusp,
+                        sdbusRule::propertiesChanged(setting,
+                                                     restrictionModeIntf),
+                        handle_restricted_mode_change);
+                done(0);
+            });
+    });
+
+} // namespace internal
+
+// Turns the packet trace on or off, see ipmi::trace::controlMember.
+static int handle_trace_control(sd_bus_message *m, void *user_data,
+                                sd_bus_error *ret_error)
+{
+    int enable = 0;
+    auto r = sd_bus_message_read(m, "b", &enable);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to read the trace control signal",
+                        entry("ERROR=%s", strerror(-r)));
+        return 0;
+    }
+
+    if (enable)
+    {
+        if (ipmi::trace::enable())
+        {
+            log<level::INFO>("IPMI packet trace enabled",
+                             entry("PATH=%s", ipmi::trace::ringPath));
+        }
+    }
+    else
+    {
+        ipmi::trace::disable();
+        log<level::INFO>("IPMI packet trace disabled");
+    }
+    return 0;
+}
+
+static_assert(ipmi::maxResponseData == MAX_IPMI_BUFFER - IPMI_CC_LEN,
+              "Response views must match the router's response buffer");
+
 static int handle_ipmi_command(sd_bus_message *m, void *user_data, sd_bus_error
                          *ret_error) {
     int r = 0;
@@ -351,10 +800,9 @@ static int handle_ipmi_command(sd_bus_message *m, void *user_data, sd_bus_error
     const void *request;
     size_t sz;
     size_t resplen =MAX_IPMI_BUFFER;
+    // Not cleared, handlers only report the bytes they wrote.
     unsigned char response[MAX_IPMI_BUFFER];
 
-    memset(response, 0, MAX_IPMI_BUFFER);
-
     r = sd_bus_message_read(m, "yyyy",  &sequence, &netfn, &lun, &cmd);
     if (r < 0) {
         fprintf(stderr, "Failed to parse signal message: %s\n", strerror(-r));
@@ -367,27 +815,114 @@ static int handle_ipmi_command(sd_bus_message *m, void *user_data, sd_bus_error
         return -1;
     }
 
-    fprintf(ipmiio, "IPMI Incoming: Seq 0x%02x, NetFn 0x%02x, CMD: 0x%02x \n", sequence, netfn, cmd);
-    hexdump(ipmiio, (void*)request, sz);
+    auto start = ipmi::trace::now();
+    if (ipmi::trace::enabled())
+    {
+        ipmi::trace::request(sequence, netfn, lun, cmd, request, sz);
+    }
+
+    // The bridge sends a request again, with the same sequence number, when
+    // the response does not come in time. The handler is not run again.
+    const char* sender = sd_bus_message_get_sender(m);
+    ipmi::retransmit::Request key{sequence, netfn, lun, cmd,
+                                  ipmi::retransmit::hash(request, sz)};
+    {
+        uint8_t cc = 0;
+        std::vector<uint8_t> data;
+        switch (ipmi::retransmit::cache().request(sender ? sender : "", key,
+                                                  cc, data))
+        {
+            case ipmi::retransmit::Match::inProgress:
+                // The response to the request answers the retry too.
+                return 0;
+            case ipmi::retransmit::Match::answered:
+                if (ipmi::trace::enabled())
+                {
+                    ipmi::trace::response(sequence, netfn, lun, cmd, cc,
+                                          data.data(), data.size(),
+                                          ipmi::trace::now() - start);
+                }
+                r = send_ipmi_message(m, sequence, netfn, lun, cmd, cc,
+                                      data.data(), data.size());
+                if (r != EXIT_SUCCESS) {
+                    fprintf(stderr, "Failed to send the response message\n");
+                }
+                return 0;
+            case ipmi::retransmit::Match::first:
+                break;
+        }
+    }
+
+    // Bounds the D-Bus calls of the handler, see ipmi::call().
+    ipmi::timeout::Scope deadline(ipmi::timeout::Clock::now() +
+                                  ipmi::timeout::requestBudget);
+
+    // Providers deferred by the manifest are loaded on first use.
+    ipmi::providers::loader().load(netfn, cmd);
+
+    const auto& slot = ipmi::dispatch::table().find(netfn, cmd);
+
+    // Requests to read only commands identical to one being handled get its
+    // response, rather than fetching the same data again.
+    if (slot.readOnly && ipmi_cmd_allowed(slot) &&
+        internal::coalesce(m, sequence, netfn, lun, cmd, request, sz))
+    {
+        return 0;
+    }
+
+    // Handlers with deferred responses send the response themselves.
+    if (slot.asyncHandler != nullptr && ipmi_cmd_allowed(slot))
+    {
+        ipmi_async_router(slot, m, sequence, netfn, lun, cmd, request, sz);
+        return 0;
+    }
+
+    if (ipmi_cmd_allowed(slot) &&
+        ipmi_worker_router(slot, m, sequence, netfn, lun, cmd, request, sz))
+    {
+        return 0;
+    }
 
     // Allow the length field to be used for both input and output of the
     // ipmi call
     resplen = sz;
 
-    // Now that we have parsed the entire byte array from the caller
-    // we can call the ipmi router to do the work...
-    r = ipmi_netfn_router(netfn, cmd, (void *)request, (void *)response, &resplen);
-    if(r != 0)
+    if (!ipmi_cmd_allowed(slot) && !internal::restrictionMode.ready())
+    {
+        response[0] = IPMI_CC_BUSY;
+        resplen = IPMI_CC_LEN;
+    }
+    else
     {
-        fprintf(stderr,"ERROR:[0x%X] handling NetFn:[0x%X], Cmd:[0x%X]\n",r, netfn, cmd);
+        // Now that we have parsed the entire byte array from the caller
+        // we can call the ipmi router to do the work...
+        r = ipmi_netfn_router(netfn, cmd, (void *)request, (void *)response, &resplen);
+        if(r != 0)
+        {
+            fprintf(stderr,"ERROR:[0x%X] handling NetFn:[0x%X], Cmd:[0x%X]\n",r, netfn, cmd);
 
-        if(r < 0) {
-           response[0] = IPMI_CC_UNSPECIFIED_ERROR;
+            if(r < 0) {
+               response[0] = IPMI_CC_UNSPECIFIED_ERROR;
+            }
+        }
+        if (resplen > MAX_IPMI_BUFFER)
+        {
+            fprintf(stderr, "ERROR: Response too long for NetFn:[0x%X], "
+                    "Cmd:[0x%X]\n", netfn, cmd);
+            response[0] = IPMI_CC_RESPONSE_ERROR;
+            resplen = IPMI_CC_LEN;
         }
     }
 
-    fprintf(ipmiio, "IPMI Response:\n");
-    hexdump(ipmiio,  (void*)response, resplen);
+    auto latency = ipmi::trace::now() - start;
+    ipmi::stats::record(netfn, cmd, response[0], latency);
+    if (ipmi::trace::enabled())
+    {
+        ipmi::trace::response(sequence, netfn, lun, cmd, response[0],
+                              response + 1, resplen - 1, latency);
+    }
+    ipmi::retransmit::cache().response(sender ? sender : "", key, response[0],
+                                       response + 1, resplen - 1);
 
     // Send the response buffer from the ipmi command
     r = send_ipmi_message(m, sequence, netfn, lun, cmd, response[0],
@@ -402,94 +937,17 @@ static int handle_ipmi_command(sd_bus_message *m, void *user_data, sd_bus_error
 }
 
 
-//----------------------------------------------------------------------
-// handler_select
-// Select all the files ending with with .so. in the given diretcory
-// @d: dirent structure containing the file name
-//----------------------------------------------------------------------
-int handler_select(const struct dirent *entry)
-{
-    // To hold ".so" from entry->d_name;
-    char dname_copy[4] = {0};
-
-    // We want to avoid checking for everything and isolate to the ones having
-    // .so.* or .so in them.
-    // Check for versioned libraries .so.*
-    if(strstr(entry->d_name, IPMI_PLUGIN_SONAME_EXTN))
-    {
-        return 1;
-    }
-    // Check for non versioned libraries .so
-    else if(strstr(entry->d_name, IPMI_PLUGIN_EXTN))
-    {
-        // It is possible that .so could be anywhere in the string but unlikely
-        // But being careful here. Get the base address of the string, move
-        // until end and come back 3 steps and that gets what we need.
-        strcpy(dname_copy, (entry->d_name + strlen(entry->d_name)-strlen(IPMI_PLUGIN_EXTN)));
-        if(strcmp(dname_copy, IPMI_PLUGIN_EXTN) == 0)
-        {
-            return 1;
-        }
-    }
-    return 0;
-}
-
 // This will do a dlopen of every .so in ipmi_lib_path and will dlopen everything so that they will
 // register a callback handler
 void ipmi_register_callback_handlers(const char* ipmi_lib_path)
 {
-    // For walking the ipmi_lib_path
-    struct dirent **handler_list;
-    int num_handlers = 0;
-
-    // This is used to check and abort if someone tries to register a bad one.
-    void *lib_handler = NULL;
-
     if(ipmi_lib_path == NULL)
     {
         fprintf(stderr,"ERROR; No handlers to be registered for ipmi.. Aborting\n");
         assert(0);
     }
-    else
-    {
-        // 1: Open ipmi_lib_path. Its usually "/usr/lib/phosphor-host-ipmid"
-        // 2: Scan the directory for the files that end with .so
-        // 3: For each one of them, just do a 'dlopen' so that they register
-        //    the handlers for callback routines.
-
-        std::string handler_fqdn = ipmi_lib_path;
-
-        // Append a "/" since we need to add the name of the .so. If there is
-        // already a .so, adding one more is not any harm.
-        handler_fqdn += "/";
-
-        num_handlers = scandir(ipmi_lib_path, &handler_list, handler_select, alphasort);
-        if (num_handlers < 0)
-            return;
-
-        while(num_handlers--)
-        {
-            handler_fqdn = ipmi_lib_path;
-            handler_fqdn += handler_list[num_handlers]->d_name;
-            printf("Registering handler:[%s]\n",handler_fqdn.c_str());
-
-            lib_handler = dlopen(handler_fqdn.c_str(), RTLD_NOW);
-
-            if(lib_handler == NULL)
-            {
-                fprintf(stderr,"ERROR opening [%s]: %s\n",
-                        handler_fqdn.c_str(), dlerror());
-            }
-            // Wipe the memory allocated for this particular entry.
-            free(handler_list[num_handlers]);
-        }
-
-        // Done with all registration.
-        free(handler_list);
-    }
 
-    // TODO : What to be done on the memory that is given by dlopen ?.
-    return;
+    ipmi::providers::loader().loadAll(ipmi_lib_path);
 }
 
 sd_bus *ipmid_get_sd_bus_connection(void) {
@@ -514,27 +972,48 @@ cmdManagerPtr& ipmid_get_host_cmd_manager() {
 }
 
 sdbusPtr& ipmid_get_sdbus_plus_handler() {
+     // Providers asking for it serve objects of their own, they cannot
+     // wait for the first use of one of their commands to be loaded.
+     ipmi::providers::loader().markEager();
      return sdbusp;
 }
 
+// Handles the requests the bridge signals on bus, from the event loop.
+int watch_ipmi_requests(void) {
+    auto r = sd_bus_add_match(bus, &ipmid_slot, FILTER, handle_ipmi_command, NULL);
+    if (r < 0) {
+        fprintf(stderr, "Failed: sd_bus_add_match: %s : %s\n", strerror(-r), FILTER);
+    }
+    return r;
+}
+
+// ipmid-replay and the router tests link everything above and bring their
+// own main.
+#ifndef IPMID_REPLAY
 int main(int argc, char *argv[])
 {
     int r;
     unsigned long tvalue;
     int c;
-
+    unsigned long threads = 0;
+    bool trace_at_start = false;
+    unsigned long stats_period = 0;
+    const char* capture_path = nullptr;
+    const char* manifest_path = nullptr;
+    bool write_manifest = false;
 
 
     // This file and subsequient switch is for turning on levels
     // of trace
     ipmicmddetails = ipmiio = ipmidbus =  fopen("/dev/null", "w");
 
-    while ((c = getopt (argc, argv, "h:d:")) != -1)
+    while ((c = getopt (argc, argv, "h:d:w:s:c:t:m:g:")) != -1)
         switch (c) {
             case 'd':
                 tvalue =  strtoul(optarg, NULL, 16);
                 if (1&tvalue) {
                     ipmiio = stdout;
+                    trace_at_start = true;
                 }
                 if (2&tvalue) {
                     ipmidbus = stdout;
@@ -543,6 +1022,26 @@ int main(int argc, char *argv[])
                     ipmicmddetails = stdout;
                 }
                 break;
+            case 'w':
+                threads = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                stats_period = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                capture_path = optarg;
+                break;
+            case 't':
+                if (!set_call_budget(optarg)) {
+                    print_usage();
+                    return 1;
+                }
+                break;
+            case 'm':
+            case 'g':
+                manifest_path = optarg;
+                write_manifest = c == 'g';
+                break;
           case 'h':
           case '?':
                 print_usage();
@@ -567,6 +1066,20 @@ int main(int argc, char *argv[])
         goto finish;
     }
 
+    if (threads > 0)
+    {
+        try
+        {
+            workerPool = std::make_unique<ipmi::worker::Pool>(events, threads);
+        }
+        catch (const std::exception& e)
+        {
+            log<level::ERR>("Failed to start the worker threads, handling "
+                            "every command on the event loop",
+                            entry("ERROR=%s", e.what()));
+        }
+    }
+
     // Now create the Host Bound Command manager. Need sdbusplus
     // to use the generated bindings
     sdbusp = std::make_unique<sdbusplus::bus::bus>(bus);
@@ -574,34 +1087,82 @@ int main(int argc, char *argv[])
                             *sdbusp, events);
 
     // Register all the handlers that provider implementation to IPMI commands.
-    ipmi_register_callback_handlers(HOST_IPMI_LIB_PATH);
+    // With a manifest, only the providers it cannot defer are loaded now.
+    {
+        ipmi::providers::Manifest manifest;
+        if (manifest_path != nullptr && !write_manifest &&
+            ipmi::providers::readManifest(manifest_path, manifest))
+        {
+            ipmi::providers::loader().loadEager(HOST_IPMI_LIB_PATH, manifest);
+        }
+        else
+        {
+            ipmi_register_callback_handlers(HOST_IPMI_LIB_PATH);
+        }
+    }
+
+    if (write_manifest)
+    {
+        r = ipmi::providers::writeManifest(
+                manifest_path, ipmi::providers::loader().manifest()) ?
+            0 : -EIO;
+        goto finish;
+    }
+
+    // Every provider is loaded, no more registrations are expected but from
+    // those deferred, for which the loader thaws the table.
+    ipmi::dispatch::table().freeze();
+
+    // Fold the whitelist into the dispatch slots.
+    for (unsigned int netfn = 0; netfn < ipmi::dispatch::maxNetFn; ++netfn)
+    {
+        for (unsigned int cmd = 0; cmd < ipmi::dispatch::maxCmd; ++cmd)
+        {
+            if (whitelist_bitmap.test(netfn, cmd))
+            {
+                ipmi::dispatch::table().allow(netfn, cmd);
+            }
+        }
+    }
 
 	// Watch for BT messages
-    r = sd_bus_add_match(bus, &ipmid_slot, FILTER, handle_ipmi_command, NULL);
+    r = watch_ipmi_requests();
     if (r < 0) {
-        fprintf(stderr, "Failed: sd_bus_add_match: %s : %s\n", strerror(-r), FILTER);
         goto finish;
     }
 
     // Attach the bus to sd_event to service user requests
     sd_bus_attach_event(bus, events, SD_EVENT_PRIORITY_NORMAL);
 
+    if (trace_at_start)
+    {
+        ipmi::trace::enable();
+    }
+    if (capture_path != nullptr)
+    {
+        ipmi::trace::startCapture(capture_path);
+    }
+
+    // Failures are logged, ipmid works without the statistics.
+    ipmi::stats::exportObject(bus);
+    if (stats_period > 0)
+    {
+        ipmi::stats::startPeriodicDump(events, stats_period);
+    }
+
+    // The state of ipmid and of the providers that is looked up on D-Bus
+    // is built from the event loop, the lookups running concurrently.
+    ipmi::init::startAll();
+
     {
-        using namespace internal;
-        using namespace internal::cache;
         sdbusplus::bus::bus dbus{bus};
-        objects = std::make_unique<settings::Objects>(
-                      dbus,
-                      std::vector<settings::Interface>({restrictionModeIntf}));
-        // Initialize restricted mode
-        cache_restricted_mode();
-        // Wait for changes on Restricted mode
-        sdbusplus::bus::match_t restrictedModeMatch(
+        // Wait for requests to turn the packet trace on or off
+        sdbusplus::bus::match_t traceMatch(
             dbus,
-            sdbusRule::propertiesChanged(
-                objects->map.at(restrictionModeIntf).front(),
-                restrictionModeIntf),
-            handle_restricted_mode_change);
+            sdbusRule::type::signal() +
+                sdbusRule::interface(ipmi::trace::controlInterface) +
+                sdbusRule::member(ipmi::trace::controlMember),
+            handle_trace_control);
 
         for (;;) {
             /* Process requests */
@@ -616,6 +1177,8 @@ int main(int argc, char *argv[])
     }
 
 finish:
+    ipmi::trace::stopCapture();
+    workerPool.reset();
     sd_event_unref(events);
     sd_bus_detach_event(bus);
     sd_bus_slot_unref(ipmid_slot);
@@ -623,3 +1186,4 @@ finish:
     return r < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 
 }
+#endif
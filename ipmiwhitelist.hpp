@@ -1,11 +1,43 @@
 #ifndef __HOST_IPMID_IPMI_WHITELIST_H__
 #define __HOST_IPMID_IPMI_WHITELIST_H_
 
+#include <initializer_list>
 #include <vector>
 #include <utility>
+#include <stdint.h>
 
 using netfncmd_pair = std::pair<unsigned char, unsigned char>;
 
 extern const std::vector<netfncmd_pair> whitelist;
 
+// One bit per [NetFn, Cmd], for the 64 possible NetFns and 256 commands each.
+struct whitelist_bitmap_t
+{
+    uint64_t words[(64 * 256) / 64];
+
+    constexpr bool test(unsigned char netfn, unsigned char cmd) const
+    {
+        return netfn < 64 &&
+               ((words[((netfn << 8) | cmd) >> 6] >> (cmd & 0x3F)) & 1);
+    }
+};
+
+// Builds the bitmap at compile time from the list of whitelisted commands.
+constexpr whitelist_bitmap_t
+    make_whitelist_bitmap(std::initializer_list<netfncmd_pair> pairs)
+{
+    whitelist_bitmap_t bitmap{};
+    for (const auto& pair : pairs)
+    {
+        if (pair.first < 64)
+        {
+            bitmap.words[((pair.first << 8) | pair.second) >> 6] |=
+                uint64_t(1) << (pair.second & 0x3F);
+        }
+    }
+    return bitmap;
+}
+
+extern const whitelist_bitmap_t whitelist_bitmap;
+
 #endif
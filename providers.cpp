@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <phosphor-logging/log.hpp>
+#include "ipmid.hpp"
+#include "providers.hpp"
+
+//----------------------------------------------------------------------
+// handler_select
+// Select all the files ending with with .so. in the given diretcory
+// @d: dirent structure containing the file name
+//----------------------------------------------------------------------
+int handler_select(const struct dirent *entry)
+{
+    // To hold ".so" from entry->d_name;
+    char dname_copy[4] = {0};
+
+    // We want to avoid checking for everything and isolate to the ones having
+    // .so.* or .so in them.
+    // Check for versioned libraries .so.*
+    if(strstr(entry->d_name, IPMI_PLUGIN_SONAME_EXTN))
+    {
+        return 1;
+    }
+    // Check for non versioned libraries .so
+    else if(strstr(entry->d_name, IPMI_PLUGIN_EXTN))
+    {
+        // It is possible that .so could be anywhere in the string but unlikely
+        // But being careful here. Get the base address of the string, move
+        // until end and come back 3 steps and that gets what we need.
+        strcpy(dname_copy, (entry->d_name + strlen(entry->d_name)-strlen(IPMI_PLUGIN_EXTN)));
+        if(strcmp(dname_copy, IPMI_PLUGIN_EXTN) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+namespace ipmi
+{
+namespace providers
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+constexpr auto eagerKeyword = "eager";
+
+Loader providerLoader;
+
+/** @brief The providers of a directory, in the order ipmid loads them */
+std::vector<std::string> scan(const std::string& directory)
+{
+    std::vector<std::string> names;
+    struct dirent** list = nullptr;
+    auto count = scandir(directory.c_str(), &list, handler_select, alphasort);
+    if (count < 0)
+    {
+        log<level::ERR>("Failed to read the providers directory",
+                        entry("PATH=%s", directory.c_str()),
+                        entry("ERROR=%s", strerror(errno)));
+        return names;
+    }
+
+    // ipmid has always loaded them in reverse alphabetical order.
+    while (count--)
+    {
+        names.emplace_back(list[count]->d_name);
+        free(list[count]);
+    }
+    free(list);
+    return names;
+}
+
+/** @brief Parses a NetFn:Cmd pair, in hex */
+bool parseCommand(const std::string& word, std::pair<uint8_t, uint8_t>& cmd)
+{
+    const char* text = word.c_str();
+    char* end = nullptr;
+    errno = 0;
+    auto netfn = strtoul(text, &end, 16);
+    if (end == text || *end != ':' || errno != 0 ||
+        netfn >= dispatch::maxNetFn)
+    {
+        return false;
+    }
+    text = end + 1;
+    auto command = strtoul(text, &end, 16);
+    if (end == text || *end != '\0' || errno != 0 ||
+        command >= dispatch::maxCmd)
+    {
+        return false;
+    }
+    cmd = std::make_pair(netfn, command);
+    return true;
+}
+
+inline size_t slotIndex(size_t netfn, size_t cmd)
+{
+    return (netfn * dispatch::maxCmd) + cmd;
+}
+
+} // namespace
+
+bool readManifest(const std::string& path, Manifest& manifest)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        log<level::ERR>("Failed to open the providers manifest",
+                        entry("PATH=%s", path.c_str()));
+        return false;
+    }
+
+    Manifest libraries;
+    std::string line;
+    size_t number = 0;
+    while (std::getline(file, line))
+    {
+        ++number;
+        std::istringstream words(line);
+        std::string word;
+        if (!(words >> word) || word[0] == '#')
+        {
+            continue;
+        }
+
+        Library library;
+        library.name = word;
+        while (words >> word)
+        {
+            std::pair<uint8_t, uint8_t> cmd;
+            if (word == eagerKeyword)
+            {
+                library.eager = true;
+            }
+            else if (parseCommand(word, cmd))
+            {
+                library.commands.push_back(cmd);
+            }
+            else
+            {
+                log<level::ERR>("Malformed providers manifest",
+                                entry("PATH=%s", path.c_str()),
+                                entry("LINE=%zu", number),
+                                entry("WORD=%s", word.c_str()));
+                return false;
+            }
+        }
+        libraries.push_back(std::move(library));
+    }
+    if (file.bad())
+    {
+        log<level::ERR>("Failed to read the providers manifest",
+                        entry("PATH=%s", path.c_str()));
+        return false;
+    }
+
+    manifest = std::move(libraries);
+    return true;
+}
+
+bool writeManifest(const std::string& path, const Manifest& manifest)
+{
+    auto temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "w");
+    if (file == nullptr)
+    {
+        log<level::ERR>("Failed to create the providers manifest",
+                        entry("PATH=%s", temporary.c_str()),
+                        entry("ERROR=%s", strerror(errno)));
+        return false;
+    }
+
+    fprintf(file, "# Providers of the IPMI commands, as NetFn:Cmd, "
+            "written by ipmid -g\n");
+    for (const auto& library : manifest)
+    {
+        fprintf(file, "%s", library.name.c_str());
+        if (library.eager)
+        {
+            fprintf(file, " %s", eagerKeyword);
+        }
+        for (const auto& cmd : library.commands)
+        {
+            fprintf(file, " 0x%02x:0x%02x", cmd.first, cmd.second);
+        }
+        fprintf(file, "\n");
+    }
+
+    auto failed = ferror(file);
+    if (fclose(file) != 0 || failed)
+    {
+        log<level::ERR>("Failed to write the providers manifest",
+                        entry("PATH=%s", temporary.c_str()));
+        unlink(temporary.c_str());
+        return false;
+    }
+    if (rename(temporary.c_str(), path.c_str()) < 0)
+    {
+        log<level::ERR>("Failed to rename the providers manifest",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", strerror(errno)));
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Loader::loadAll(const std::string& directory)
+{
+    this->directory = directory;
+    for (const auto& name : scan(directory))
+    {
+        open(name);
+    }
+    report(0);
+}
+
+void Loader::loadEager(const std::string& directory, const Manifest& manifest)
+{
+    this->directory = directory;
+
+    std::map<std::string, const Library*> known;
+    for (const auto& library : manifest)
+    {
+        known.emplace(library.name, &library);
+    }
+
+    size_t deferredLibraries = 0;
+    for (const auto& name : scan(directory))
+    {
+        auto it = known.find(name);
+
+        // Providers the manifest does not know, or that do something at
+        // load time besides registering commands, are loaded now.
+        if (it == known.end() || it->second->eager ||
+            it->second->commands.empty())
+        {
+            open(name);
+            continue;
+        }
+
+        for (const auto& cmd : it->second->commands)
+        {
+            auto index = slotIndex(cmd.first, cmd.second);
+            deferred.set(index);
+            owners.emplace(index, name);
+        }
+        ++deferredLibraries;
+    }
+    report(deferredLibraries);
+}
+
+bool Loader::load(uint8_t netfn, uint8_t cmd)
+{
+    if (netfn >= dispatch::maxNetFn ||
+        dispatch::table().find(netfn, cmd).exact)
+    {
+        return false;
+    }
+
+    // The exact command first, as the table would route it.
+    auto index = slotIndex(netfn, cmd);
+    if (!deferred.test(index))
+    {
+        index = slotIndex(netfn, IPMI_CMD_WILDCARD);
+        if (!deferred.test(index))
+        {
+            return false;
+        }
+    }
+
+    auto name = owners[index];
+
+    // Every command of the provider is served from now on, loaded or not.
+    for (auto it = owners.begin(); it != owners.end();)
+    {
+        if (it->second == name)
+        {
+            deferred.reset(it->first);
+            it = owners.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    auto& table = dispatch::table();
+    auto frozen = table.isFrozen();
+    table.thaw();
+    auto loadedNow = open(name);
+    if (frozen)
+    {
+        table.freeze();
+    }
+
+    if (loadedNow)
+    {
+        log<level::INFO>("Loaded a provider on first use",
+                         entry("PROVIDER=%s", name.c_str()),
+                         entry("NETFN=0x%X", netfn),
+                         entry("CMD=0x%X", cmd),
+                         entry("LOAD_US=%lld",
+                               static_cast<long long>(
+                                   loadTimes.back().count())));
+    }
+    return loadedNow;
+}
+
+void Loader::markEager()
+{
+    auto library = loading.load();
+    if (library != nullptr)
+    {
+        library->eager = true;
+    }
+}
+
+bool Loader::open(const std::string& name)
+{
+    auto path = directory + name;
+    printf("Registering handler:[%s]\n", path.c_str());
+
+    Library library;
+    library.name = name;
+    loaded.push_back(std::move(library));
+    loading = &loaded.back();
+
+    auto start = std::chrono::steady_clock::now();
+    auto handle = dlopen(path.c_str(), RTLD_NOW);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start);
+    loading = nullptr;
+
+    if (handle == nullptr)
+    {
+        fprintf(stderr, "ERROR opening [%s]: %s\n", path.c_str(), dlerror());
+        loaded.pop_back();
+        return false;
+    }
+    loadTimes.push_back(elapsed);
+
+    // What the provider registered are the exact slots that were not there
+    // before, a wildcard being the exact slot of IPMI_CMD_WILDCARD.
+    const auto& table = dispatch::table();
+    auto& commands = loaded.back().commands;
+    for (size_t netfn = 0; netfn < dispatch::maxNetFn; ++netfn)
+    {
+        for (size_t cmd = 0; cmd < dispatch::maxCmd; ++cmd)
+        {
+            auto index = slotIndex(netfn, cmd);
+            if (!registered.test(index) && table.find(netfn, cmd).exact)
+            {
+                registered.set(index);
+                commands.emplace_back(netfn, cmd);
+            }
+        }
+    }
+    return true;
+}
+
+void Loader::report(size_t deferredLibraries) const
+{
+    std::chrono::microseconds total{0};
+    for (size_t i = 0; i < loaded.size(); ++i)
+    {
+        log<level::DEBUG>("Loaded a provider",
+                          entry("PROVIDER=%s", loaded[i].name.c_str()),
+                          entry("COMMANDS=%zu", loaded[i].commands.size()),
+                          entry("LOAD_US=%lld",
+                                static_cast<long long>(
+                                    loadTimes[i].count())),
+                          entry("EAGER=%d", loaded[i].eager ? 1 : 0));
+        total += loadTimes[i];
+    }
+
+    log<level::INFO>("Loaded the IPMI providers",
+                     entry("LOADED=%zu", loaded.size()),
+                     entry("DEFERRED=%zu", deferredLibraries),
+                     entry("LOAD_US=%lld",
+                           static_cast<long long>(total.count())));
+}
+
+Loader& loader()
+{
+    return providerLoader;
+}
+
+} // namespace providers
+} // namespace ipmi
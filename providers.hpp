@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "dispatch.hpp"
+
+namespace ipmi
+{
+namespace providers
+{
+
+/** @struct Library
+ *  @brief A provider library and the commands it registers.
+ */
+struct Library
+{
+    std::string name;   //!< File name, in the providers directory.
+    bool eager = false; //!< Loaded at startup whatever the commands.
+
+    /** @brief [NetFn, Cmd] pairs, Cmd IPMI_CMD_WILDCARD for a wildcard */
+    std::vector<std::pair<uint8_t, uint8_t>> commands;
+};
+
+/** @brief Providers of the IPMI commands
+ *
+ *  In a file, a line per library: its name, "eager" if it has to be loaded
+ *  at startup, then its commands as NetFn:Cmd in hex. Lines starting with
+ *  '#' are comments. e.g.
+ *
+ *      libapphandler.so 0x06:0x01 0x06:0x22
+ *      libsysintfcmds.so eager 0x06:0x31
+ */
+using Manifest = std::vector<Library>;
+
+/** @brief Reads a manifest
+ *
+ *  @return false if the file cannot be read or is malformed.
+ */
+bool readManifest(const std::string& path, Manifest& manifest);
+
+/** @brief Writes a manifest, through a rename
+ *
+ *  @return false on failure.
+ */
+bool writeManifest(const std::string& path, const Manifest& manifest);
+
+/** @class Loader
+ *  @brief Loads the provider libraries, at startup or, as per a manifest,
+ *         on first use of one of their commands.
+ *
+ *  Only used from the event loop.
+ */
+class Loader
+{
+    public:
+        Loader() = default;
+        ~Loader() = default;
+        Loader(const Loader&) = delete;
+        Loader& operator=(const Loader&) = delete;
+        Loader(Loader&&) = delete;
+        Loader& operator=(Loader&&) = delete;
+
+        /** @brief Loads every provider of a directory, recording what each
+         *         registers, see manifest().
+         *
+         *  @param[in] directory - Providers directory, ending with '/'.
+         */
+        void loadAll(const std::string& directory);
+
+        /** @brief Loads the providers of a directory the manifest marks as
+         *         eager or does not know. The others are deferred to the
+         *         first use of one of their commands, see load().
+         *
+         *  @param[in] directory - Providers directory, ending with '/'.
+         *  @param[in] manifest - Providers of the commands.
+         */
+        void loadEager(const std::string& directory, const Manifest& manifest);
+
+        /** @brief Loads the deferred provider of a command, if any
+         *
+         *  A single bit test for the commands without one. The dispatch
+         *  table is thawed for the registrations of the provider.
+         *
+         *  @return true if a provider was loaded.
+         */
+        bool load(uint8_t netfn, uint8_t cmd);
+
+        /** @brief Marks the provider being loaded as eager, for the
+         *         ipmid functions handing out what providers need to serve
+         *         D-Bus objects of their own.
+         */
+        void markEager();
+
+        /** @brief The providers loaded and what they registered */
+        const Manifest& manifest() const
+        {
+            return loaded;
+        }
+
+    private:
+        /** @brief dlopen()s a provider, recording its registrations and
+         *         load time
+         *
+         *  @return false if it could not be loaded.
+         */
+        bool open(const std::string& name);
+
+        /** @brief Logs the load times of the startup */
+        void report(size_t deferred) const;
+
+        using Slots = std::bitset<dispatch::maxNetFn * dispatch::maxCmd>;
+
+        std::string directory;
+
+        Manifest loaded;
+
+        /** @brief Load time of every library of loaded */
+        std::vector<std::chrono::microseconds> loadTimes;
+
+        /** @brief Library being loaded, in loaded, or nullptr. Handlers on
+         *         the worker threads may call markEager() too.
+         */
+        std::atomic<Library*> loading{nullptr};
+
+        /** @brief Exact registrations seen so far */
+        Slots registered;
+
+        /** @brief Commands of deferred libraries */
+        Slots deferred;
+
+        /** @brief Deferred library of a command, by slot index */
+        std::map<size_t, std::string> owners;
+};
+
+/** @brief Get the process wide loader */
+Loader& loader();
+
+} // namespace providers
+} // namespace ipmi
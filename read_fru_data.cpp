@@ -30,39 +30,6 @@ namespace cache
     //is a change in FRU properties.
     FRUAreaMap fruMap;
 }
-/**
- * @brief Read all the property value's for the specified interface
- *  from Inventory.
- *
- * @param[in] intf Interface
- * @param[in] path Object path
- * @return map of properties
- */
-ipmi::PropertyMap readAllProperties(const std::string& intf,
-                                  const std::string& path)
-{
-    ipmi::PropertyMap properties;
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-    auto service = ipmi::getService(bus, INV_INTF, OBJ_PATH);
-    std::string objPath = OBJ_PATH + path;
-    auto method = bus.new_method_call(service.c_str(),
-                                      objPath.c_str(),
-                                      PROP_INTF,
-                                      "GetAll");
-    method.append(intf);
-    auto reply = bus.call(method);
-    if (reply.is_method_error())
-    {
-        //If property is not found simply return empty value
-        log<level::ERR>("Error in reading property values from inventory",
-                        entry("INTERFACE=%s", intf),
-                        entry("PATH=%s", objPath));
-        return properties;
-    }
-    reply.read(properties);
-    return properties;
-}
-
 void processFruPropChange(sdbusplus::message::message& msg)
 {
     if(cache::fruMap.empty())
@@ -129,21 +96,36 @@ FruInventoryData readDataFromInventory(const FRUId& fruNum)
         elog<InternalFailure>();
     }
 
+    // Read the whole inventory at once, rather than every interface of
+    // every instance.
+    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+    auto service = ipmi::getService(bus, INV_INTF, OBJ_PATH);
+    auto inventory = ipmi::getManagedObjects(bus, service, OBJ_PATH);
+
     FruInventoryData data;
     auto& instanceList = iter->second;
     for (auto& instance : instanceList)
     {
+        std::string objPath = OBJ_PATH + instance.first;
         for (auto& intf : instance.second)
         {
-            ipmi::PropertyMap allProp = readAllProperties(
-                    intf.first, instance.first);
+            auto allProp = inventory.find(objPath, intf.first);
+            if (allProp == nullptr)
+            {
+                //If property is not found simply return empty value
+                log<level::ERR>("Error in reading property values from "
+                                "inventory",
+                                entry("INTERFACE=%s", intf.first.c_str()),
+                                entry("PATH=%s", objPath.c_str()));
+                continue;
+            }
             for (auto& properties : intf.second)
             {
-                auto iter = allProp.find(properties.first);
-                if (iter != allProp.end())
+                auto iter = allProp->find(properties.first);
+                if (iter != allProp->end())
                 {
                     data[properties.second.section].emplace(properties.first,
-                        std::move(allProp[properties.first].get<std::string>()));
+                        iter->second.get<std::string>());
                 }
             }
         }
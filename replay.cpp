@@ -0,0 +1,288 @@
+#include <inttypes.h>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include <ipmiwhitelist.hpp>
+#include <sdbusplus/bus.hpp>
+#include <host-cmd-manager.hpp>
+#include <host-ipmid/ipmid-async.hpp>
+#include <host-ipmid/ipmid-host-cmd.hpp>
+#include "ipmid.hpp"
+#include "dispatch.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+
+// Replays a capture taken with 'ipmid -c' through the handlers of the
+// providers, as fast as they answer. The responses go nowhere, there is no
+// bridge. The handlers still use the system bus, DBUS_SYSTEM_BUS_ADDRESS can
+// point it at a private bus running stub services.
+
+// Defined by ipmid.cpp, set up here the way ipmid's main does.
+extern sd_bus *bus;
+extern sd_event *events;
+extern sdbusPtr sdbusp;
+extern std::unique_ptr<phosphor::host::command::Manager> cmdManager;
+extern bool restricted_mode;
+void ipmi_register_callback_handlers(const char* ipmi_lib_path);
+
+namespace
+{
+
+/** @brief Longest wait for an asynchronous handler to respond */
+constexpr uint64_t responseTimeoutUs = 5000000;
+
+/** @struct Response
+ *  @brief Completion code of an asynchronous handler.
+ */
+struct Response
+{
+    ipmi_ret_t cc = IPMI_CC_UNSPECIFIED_ERROR;
+    bool answered = false;
+};
+
+/** @struct Guard
+ *  @brief Held by the responder, answers with an error if the handler drops
+ *         the responder without calling it.
+ */
+struct Guard
+{
+    ~Guard()
+    {
+        response->answered = true;
+    }
+
+    std::shared_ptr<Response> response;
+};
+
+void print_usage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [-l directory] [-n passes] [-r] capture\n",
+            name);
+    fprintf(stderr, "    directory : Providers to load, default %s\n",
+            HOST_IPMI_LIB_PATH);
+    fprintf(stderr, "    passes : Times the capture is replayed, default 1\n");
+    fprintf(stderr, "    -r : Only run whitelisted commands, as in "
+            "restricted mode\n");
+}
+
+/** @brief Runs the events that are ready, such as signals the handlers
+ *         subscribed to, outside of the measured time.
+ */
+void drain_events()
+{
+    while (sd_event_run(events, 0) > 0)
+    {
+    }
+}
+
+/** @brief Runs a request through the handler of its command
+ *
+ *  @return The completion code.
+ */
+ipmi_ret_t replay(const ipmi::trace::Record& record)
+{
+    unsigned char request[MAX_IPMI_BUFFER] = {};
+    unsigned char response[MAX_IPMI_BUFFER];
+    size_t len = std::min<size_t>(record.len, ipmi::trace::maxPayload);
+    memcpy(request, record.payload, len);
+
+    // As ipmid bounds the D-Bus calls of the handlers
+    ipmi::timeout::Scope deadline(ipmi::timeout::Clock::now() +
+                                  ipmi::timeout::requestBudget);
+
+    const auto& slot = ipmi::dispatch::table().find(record.netfn, record.cmd);
+    if (slot.asyncHandler != nullptr &&
+        (!restricted_mode || slot.whitelisted))
+    {
+        auto pending = std::make_shared<Response>();
+        auto guard = std::make_shared<Guard>();
+        guard->response = pending;
+        ipmid_responder_t responder =
+            [guard](ipmi_ret_t cc, const std::vector<uint8_t>& data)
+            {
+                guard->response->cc = cc;
+                guard->response->answered = true;
+            };
+        guard.reset();
+
+        try
+        {
+            slot.asyncHandler(record.netfn, record.cmd, request, len,
+                              std::move(responder), slot.context);
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "Exception in handler for NetFn:[0x%X], "
+                    "Cmd:[0x%X]: %s\n", record.netfn, record.cmd, e.what());
+            return IPMI_CC_UNSPECIFIED_ERROR;
+        }
+
+        while (!pending->answered)
+        {
+            if (sd_event_run(events, responseTimeoutUs) <= 0)
+            {
+                fprintf(stderr, "No response for NetFn:[0x%X], "
+                        "Cmd:[0x%X]\n", record.netfn, record.cmd);
+                return IPMI_CC_TIMEOUT;
+            }
+        }
+        return pending->cc;
+    }
+
+    auto r = ipmi_netfn_router(record.netfn, record.cmd, request, response,
+                               &len);
+    return r < 0 ? IPMI_CC_UNSPECIFIED_ERROR : response[0];
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string lib_path = HOST_IPMI_LIB_PATH;
+    unsigned long passes = 1;
+    bool restricted = false;
+    int c;
+
+    while ((c = getopt(argc, argv, "hl:n:r")) != -1)
+    {
+        switch (c)
+        {
+            case 'l':
+                lib_path = optarg;
+                break;
+            case 'n':
+                passes = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                restricted = true;
+                break;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind + 1 != argc)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ipmi::trace::Reader capture;
+    if (!capture.load(argv[optind]))
+    {
+        return EXIT_FAILURE;
+    }
+
+    ipmicmddetails = ipmiio = ipmidbus = fopen("/dev/null", "w");
+
+    auto r = sd_bus_open_system(&bus);
+    if (r < 0)
+    {
+        fprintf(stderr, "Failed to connect to system bus: %s\n",
+                strerror(-r));
+        return EXIT_FAILURE;
+    }
+    r = sd_event_default(&events);
+    if (r < 0)
+    {
+        fprintf(stderr, "Failed to create the event loop: %s\n",
+                strerror(-r));
+        return EXIT_FAILURE;
+    }
+    sd_bus_attach_event(bus, events, SD_EVENT_PRIORITY_NORMAL);
+
+    sdbusp = std::make_unique<sdbusplus::bus::bus>(bus);
+    cmdManager = std::make_unique<phosphor::host::command::Manager>(
+                     *sdbusp, events);
+
+    // The loader appends the file names to the path as is.
+    if (lib_path.empty() || lib_path.back() != '/')
+    {
+        lib_path += '/';
+    }
+    ipmi_register_callback_handlers(lib_path.c_str());
+    ipmi::dispatch::table().freeze();
+    for (unsigned int netfn = 0; netfn < ipmi::dispatch::maxNetFn; ++netfn)
+    {
+        for (unsigned int cmd = 0; cmd < ipmi::dispatch::maxCmd; ++cmd)
+        {
+            if (whitelist_bitmap.test(netfn, cmd))
+            {
+                ipmi::dispatch::table().allow(netfn, cmd);
+            }
+        }
+    }
+    restricted_mode = restricted;
+    ipmi::resetServiceCacheStats();
+    ipmi::propertyCache().resetStats();
+    ipmi::timeout::resetStats();
+
+    std::map<std::pair<uint8_t, uint8_t>, ipmi::stats::Command> commands;
+    uint64_t requests = 0;
+    uint64_t elapsed = 0;
+
+    for (unsigned long pass = 0; pass < passes; ++pass)
+    {
+        for (const auto& entry : capture.records())
+        {
+            const auto& record = *entry.second;
+            if (record.direction != ipmi::trace::Direction::request)
+            {
+                continue;
+            }
+
+            drain_events();
+
+            auto start = ipmi::trace::now();
+            auto cc = replay(record);
+            auto latency = ipmi::trace::now() - start;
+
+            auto& command = commands[std::make_pair(record.netfn, record.cmd)];
+            command.latency.record(latency);
+            ++command.completionCodes[cc];
+            elapsed += latency;
+            ++requests;
+        }
+    }
+
+    printf("%" PRIu64 " requests in %" PRIu64 " us, %.0f requests/s\n",
+           requests, elapsed,
+           elapsed > 0 ? requests * 1000000.0 / elapsed : 0.0);
+    printf("netfn cmd count p50_us p99_us max_us completion_codes\n");
+    for (const auto& entry : commands)
+    {
+        const auto& latency = entry.second.latency;
+        printf("0x%02x 0x%02x %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64,
+               entry.first.first, entry.first.second, latency.count(),
+               latency.percentile(50), latency.percentile(99),
+               latency.max());
+        for (const auto& cc : entry.second.completionCodes)
+        {
+            printf(" %02x:%" PRIu64, cc.first, cc.second);
+        }
+        printf("\n");
+    }
+    auto cache = ipmi::getServiceCacheStats();
+    printf("mapper service cache: %" PRIu64 " hits, %" PRIu64 " misses\n",
+           cache.hits, cache.misses);
+    cache = ipmi::propertyCache().stats();
+    printf("property cache: %" PRIu64 " hits, %" PRIu64 " misses\n",
+           cache.hits, cache.misses);
+    auto timeouts = ipmi::timeout::stats();
+    printf("D-Bus calls: %" PRIu64 " timed out, %" PRIu64 " abandoned\n",
+           timeouts.timedOut, timeouts.abandoned);
+
+    cmdManager.reset();
+    sdbusp.reset();
+    sd_bus_detach_event(bus);
+    sd_event_unref(events);
+    sd_bus_unref(bus);
+    return EXIT_SUCCESS;
+}
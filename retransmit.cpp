@@ -0,0 +1,114 @@
+#include "host-ipmid/ipmid-api.h"
+#include "retransmit.hpp"
+
+namespace ipmi
+{
+namespace retransmit
+{
+
+namespace
+{
+
+constexpr uint64_t fnvOffsetBasis = 0xcbf29ce484222325ull;
+constexpr uint64_t fnvPrime = 0x100000001b3ull;
+
+Cache retransmitCache;
+
+inline bool same(const Request& a, const Request& b)
+{
+    return a.seq == b.seq && a.netfn == b.netfn && a.lun == b.lun &&
+           a.cmd == b.cmd && a.hash == b.hash;
+}
+
+} // namespace
+
+uint64_t hash(const void* data, size_t len)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    uint64_t value = fnvOffsetBasis;
+    for (size_t i = 0; i < len; ++i)
+    {
+        value ^= bytes[i];
+        value *= fnvPrime;
+    }
+    return value;
+}
+
+Cache::Entry* Cache::find(Ring& ring, const Request& request,
+                          Clock::time_point now)
+{
+    for (auto& entry : ring.entries)
+    {
+        if (entry.used && same(entry.request, request) &&
+            now - entry.time <= maxAge)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+Match Cache::request(const std::string& sender, const Request& request,
+                     uint8_t& cc, std::vector<uint8_t>& data)
+{
+    auto now = Clock::now();
+    auto& ring = rings[sender];
+
+    auto entry = find(ring, request, now);
+    if (entry != nullptr)
+    {
+        if (!entry->answered)
+        {
+            ++counters.inProgress;
+            return Match::inProgress;
+        }
+        ++counters.answered;
+        cc = entry->cc;
+        data = entry->data;
+        return Match::answered;
+    }
+
+    auto& oldest = ring.entries[ring.next];
+    ring.next = (ring.next + 1) % ring.entries.size();
+    oldest.request = request;
+    oldest.time = now;
+    oldest.used = true;
+    oldest.answered = false;
+    oldest.data.clear();
+    return Match::first;
+}
+
+void Cache::response(const std::string& sender, const Request& request,
+                     uint8_t cc, const uint8_t* data, size_t len)
+{
+    auto found = rings.find(sender);
+    if (found == rings.end())
+    {
+        return;
+    }
+
+    // Not older than maxAge either, the request came in with the entry.
+    auto entry = find(found->second, request, Clock::now());
+    if (entry == nullptr || entry->answered)
+    {
+        return;
+    }
+
+    if (cc == IPMI_CC_BUSY)
+    {
+        entry->used = false;
+        return;
+    }
+
+    entry->answered = true;
+    entry->cc = cc;
+    entry->data.assign(data, data + len);
+}
+
+Cache& cache()
+{
+    return retransmitCache;
+}
+
+} // namespace retransmit
+} // namespace ipmi
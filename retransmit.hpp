@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ipmi
+{
+namespace retransmit
+{
+
+/** @brief Requests remembered per bridge
+ *
+ *  Well below the 256 sequence numbers of a bridge, so an entry is gone
+ *  long before its sequence number is used again for another request.
+ */
+constexpr size_t ringSize = 16;
+
+/** @brief Age past which a response no longer answers a retry */
+constexpr auto defaultMaxAge = std::chrono::seconds(5);
+
+/** @struct Request
+ *  @brief What tells a request of a bridge from the other ones.
+ */
+struct Request
+{
+    uint8_t seq;
+    uint8_t netfn;
+    uint8_t lun;
+    uint8_t cmd;
+    uint64_t hash; //!< Of the request data, see hash().
+};
+
+/** @brief FNV-1a hash of the request data */
+uint64_t hash(const void* data, size_t len);
+
+/** @brief What Cache::request() found */
+enum class Match
+{
+    first,      //!< A new request, to be handled.
+    inProgress, //!< A retry of a request still being handled.
+    answered,   //!< A retry of a request already answered.
+};
+
+/** @struct Stats
+ *  @brief Retries not handled again.
+ */
+struct Stats
+{
+    uint64_t answered;   //!< Answered with the response to the request.
+    uint64_t inProgress; //!< Dropped, the request was still being handled.
+};
+
+/** @class Cache
+ *  @brief Recent requests of every bridge and their responses.
+ *
+ *  A bridge that gets no response in time sends the request again, with
+ *  the same sequence number. Handlers with side effects, e.g. Add SEL Entry
+ *  or Chassis Control, must not run twice: the retry is answered with the
+ *  response to the request instead, or dropped if the response is not sent
+ *  yet, the bridge then gets that one.
+ *
+ *  Only used from the event loop.
+ */
+class Cache
+{
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /** @param[in] maxAge - Age past which a response no longer answers
+         *                      a retry.
+         */
+        explicit Cache(Clock::duration maxAge = defaultMaxAge) :
+            maxAge(maxAge)
+        {
+        }
+        ~Cache() = default;
+        Cache(const Cache&) = delete;
+        Cache& operator=(const Cache&) = delete;
+        Cache(Cache&&) = delete;
+        Cache& operator=(Cache&&) = delete;
+
+        /** @brief Looks up a request, remembering it if it is a new one
+         *
+         *  @param[in] sender - Bus name of the bridge.
+         *  @param[in] request - The request.
+         *  @param[out] cc - Completion code of the response, if answered.
+         *  @param[out] data - Response data, if answered.
+         */
+        Match request(const std::string& sender, const Request& request,
+                      uint8_t& cc, std::vector<uint8_t>& data);
+
+        /** @brief Remembers the response to a request
+         *
+         *  IPMI_CC_BUSY responses are not, a retry runs the handler.
+         */
+        void response(const std::string& sender, const Request& request,
+                      uint8_t cc, const uint8_t* data, size_t len);
+
+        Stats stats() const
+        {
+            return counters;
+        }
+
+        /** @brief Zeroes the counters */
+        void resetStats()
+        {
+            counters = Stats{};
+        }
+
+    private:
+        /** @struct Entry
+         *  @brief A recent request of a bridge.
+         */
+        struct Entry
+        {
+            Request request;
+            Clock::time_point time;
+            bool used = false;
+            bool answered = false;
+            uint8_t cc = 0;
+            std::vector<uint8_t> data;
+        };
+
+        /** @struct Ring
+         *  @brief The recent requests of a bridge, the oldest replaced.
+         */
+        struct Ring
+        {
+            std::array<Entry, ringSize> entries;
+            size_t next = 0;
+        };
+
+        /** @brief Entry of a request not older than maxAge, or nullptr */
+        Entry* find(Ring& ring, const Request& request, Clock::time_point now);
+
+        Clock::duration maxAge;
+        std::map<std::string, Ring> rings;
+        Stats counters{};
+};
+
+/** @brief The process wide cache */
+Cache& cache();
+
+} // namespace retransmit
+} // namespace ipmi
@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <array>
+#include <errno.h>
+#include <iterator>
+#include <stdlib.h>
+#include <string.h>
+#include <phosphor-logging/log.hpp>
+#include "selindex.hpp"
+#include "selutility.hpp"
+#include "utils.hpp"
+
+namespace ipmi
+{
+
+namespace sel
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+// The log entries are added and removed through the ObjectManager of the
+// logging service.
+constexpr auto interfacesAddedRule =
+    "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+    "member='InterfacesAdded',"
+    "path_namespace='/xyz/openbmc_project/logging'";
+constexpr auto interfacesRemovedRule =
+    "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+    "member='InterfacesRemoved',"
+    "path_namespace='/xyz/openbmc_project/logging'";
+constexpr auto propertiesChangedRule =
+    "type='signal',interface='org.freedesktop.DBus.Properties',"
+    "member='PropertiesChanged',"
+    "path_namespace='/xyz/openbmc_project/logging/entry'";
+
+constexpr auto propResolved = "Resolved";
+
+// What the mapper answers when there are no log entries at all.
+constexpr auto resourceNotFound =
+    "xyz.openbmc_project.Common.Error.ResourceNotFound";
+constexpr auto fileNotFound = "org.freedesktop.DBus.Error.FileNotFound";
+
+Index entries;
+
+/** @class Follower
+ *  @brief Reads the log entries into the index and follows the signals of
+ *         the logging service.
+ *
+ *  Like the index, it follows the connection it is used with, a call on
+ *  another connection reads the entries again.
+ */
+class Follower
+{
+    public:
+        Follower() = default;
+        ~Follower()
+        {
+            unwatch();
+        }
+        Follower(const Follower&) = delete;
+        Follower& operator=(const Follower&) = delete;
+        Follower(Follower&&) = delete;
+        Follower& operator=(Follower&&) = delete;
+
+        bool watch(sd_bus* bus)
+        {
+            // The slots keep a reference on their connection, its address
+            // can't be reused while it is watched.
+            if (slots[0] != nullptr && sd_bus_slot_get_bus(slots[0]) == bus)
+            {
+                return true;
+            }
+            unwatch();
+
+            // Subscribed before the entries are read, the ones added or
+            // removed meanwhile are seen once the event loop runs again.
+            const std::array<std::pair<const char*,
+                                       sd_bus_message_handler_t>, 3> matches =
+            {
+                std::make_pair(interfacesAddedRule, onInterfacesAdded),
+                std::make_pair(interfacesRemovedRule, onInterfacesRemoved),
+                std::make_pair(propertiesChangedRule, onPropertiesChanged),
+            };
+            for (size_t i = 0; i < matches.size(); ++i)
+            {
+                auto r = sd_bus_add_match(bus, &slots[i], matches[i].first,
+                                          matches[i].second, this);
+                if (r < 0)
+                {
+                    log<level::ERR>("Failed to watch the log entries",
+                                    entry("ERROR=%s", strerror(-r)));
+                    unwatch();
+                    return false;
+                }
+            }
+
+            if (!read(bus))
+            {
+                unwatch();
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        bool read(sd_bus* bus)
+        {
+            sd_bus_error error = SD_BUS_ERROR_NULL;
+            sd_bus_message* reply = nullptr;
+            auto r = callMethod(bus, mapperBusName, mapperObjPath, mapperIntf,
+                                "GetSubTreePaths", &error, &reply, "sias",
+                                logBasePath, 0, 1, logEntryIntf);
+            if (r < 0)
+            {
+                auto empty = sd_bus_error_has_name(&error, resourceNotFound) ||
+                             sd_bus_error_has_name(&error, fileNotFound);
+                if (!empty)
+                {
+                    log<level::ERR>("Error in reading logging entry object "
+                                    "paths",
+                                    entry("ERROR=%s", strerror(-r)));
+                }
+                sd_bus_error_free(&error);
+                entries.clear();
+                return empty;
+            }
+
+            std::vector<EntryId> ids;
+            r = visitSubTreePaths(reply,
+                                  [&ids](const char* path)
+                                  {
+                                      EntryId id = 0;
+                                      if (parseEntryPath(path, id))
+                                      {
+                                          ids.push_back(id);
+                                      }
+                                      return false;
+                                  });
+            sd_bus_message_unref(reply);
+            if (r < 0)
+            {
+                log<level::ERR>("Error in reading logging entry object paths",
+                                entry("ERROR=%s", strerror(-r)));
+                return false;
+            }
+
+            std::sort(ids.begin(), ids.end());
+            entries.assign(ids);
+            return true;
+        }
+
+        void unwatch()
+        {
+            for (auto& slot : slots)
+            {
+                slot = sd_bus_slot_unref(slot);
+            }
+            entries.clear();
+        }
+
+        static int onInterfacesAdded(sd_bus_message* m, void* userData,
+                                     sd_bus_error* error)
+        {
+            const char* path = nullptr;
+            EntryId id = 0;
+            auto r = sd_bus_message_read(m, "o", &path);
+            if (r < 0 || !parseEntryPath(path, id))
+            {
+                return 0;
+            }
+
+            r = sd_bus_message_enter_container(m, 'a', "{sa{sv}}");
+            while (r > 0 &&
+                   (r = sd_bus_message_enter_container(m, 'e',
+                                                       "sa{sv}")) > 0)
+            {
+                const char* interface = nullptr;
+                r = sd_bus_message_read(m, "s", &interface);
+                if (r >= 0 && strcmp(interface, logEntryIntf) == 0)
+                {
+                    entries.insert(id);
+                    return 0;
+                }
+                if (r >= 0)
+                {
+                    r = sd_bus_message_skip(m, "a{sv}");
+                }
+                if (r >= 0)
+                {
+                    r = sd_bus_message_exit_container(m);
+                }
+            }
+            return 0;
+        }
+
+        static int onInterfacesRemoved(sd_bus_message* m, void* userData,
+                                       sd_bus_error* error)
+        {
+            const char* path = nullptr;
+            EntryId id = 0;
+            auto r = sd_bus_message_read(m, "o", &path);
+            if (r < 0 || !parseEntryPath(path, id))
+            {
+                return 0;
+            }
+
+            r = sd_bus_message_enter_container(m, 'a', "s");
+            const char* interface = nullptr;
+            while (r > 0 && (r = sd_bus_message_read(m, "s", &interface)) > 0)
+            {
+                if (strcmp(interface, logEntryIntf) == 0)
+                {
+                    entries.erase(id);
+                    return 0;
+                }
+            }
+            return 0;
+        }
+
+        static int onPropertiesChanged(sd_bus_message* m, void* userData,
+                                       sd_bus_error* error)
+        {
+            EntryId id = 0;
+            if (!parseEntryPath(sd_bus_message_get_path(m), id))
+            {
+                return 0;
+            }
+
+            // Only Resolved has its own update, the record is converted
+            // again for any other change, e.g. of the callouts.
+            const char* interface = nullptr;
+            auto r = sd_bus_message_read(m, "s", &interface);
+            if (r < 0 || strcmp(interface, logEntryIntf) != 0)
+            {
+                entries.forget(id);
+                return 0;
+            }
+
+            r = sd_bus_message_enter_container(m, 'a', "{sv}");
+            while (r > 0 &&
+                   (r = sd_bus_message_enter_container(m, 'e', "sv")) > 0)
+            {
+                const char* property = nullptr;
+                r = sd_bus_message_read(m, "s", &property);
+                if (r >= 0 && strcmp(property, propResolved) != 0)
+                {
+                    entries.forget(id);
+                    return 0;
+                }
+
+                int resolved = 0;
+                if (r >= 0)
+                {
+                    r = sd_bus_message_read(m, "v", "b", &resolved);
+                }
+                if (r < 0)
+                {
+                    entries.forget(id);
+                    return 0;
+                }
+                entries.resolve(id, resolved);
+
+                r = sd_bus_message_exit_container(m);
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_exit_container(m);
+            }
+
+            // Nor are the invalidated properties read.
+            if (r >= 0)
+            {
+                r = sd_bus_message_enter_container(m, 'a', "s");
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_at_end(m, 0);
+            }
+            if (r <= 0)
+            {
+                entries.forget(id);
+            }
+            return 0;
+        }
+
+        std::array<sd_bus_slot*, 3> slots{};
+};
+
+Follower follower;
+
+} // namespace
+
+std::string entryPath(EntryId id)
+{
+    return std::string(logBasePath) + "/" + std::to_string(id);
+}
+
+bool parseEntryPath(const char* path, EntryId& id)
+{
+    auto prefix = strlen(logBasePath);
+    if (strncmp(path, logBasePath, prefix) != 0 || path[prefix] != '/')
+    {
+        return false;
+    }
+
+    auto digits = path + prefix + 1;
+    if (*digits < '0' || *digits > '9')
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    auto value = strtoul(digits, &end, 10);
+    if (*end != '\0' || errno != 0 || value > UINT32_MAX)
+    {
+        return false;
+    }
+    id = static_cast<EntryId>(value);
+    return true;
+}
+
+void Index::assign(const std::vector<EntryId>& ids)
+{
+    clear();
+    byId.reserve(ids.size());
+    for (auto id : ids)
+    {
+        insert(id);
+    }
+}
+
+bool Index::insert(EntryId id)
+{
+    if (contains(id))
+    {
+        return false;
+    }
+
+    // New entries have the highest ID, the hint makes their insertion
+    // constant time.
+    Entry entry{};
+    entry.position = ordered.emplace_hint(ordered.end(), id);
+    byId.emplace(id, entry);
+    return true;
+}
+
+bool Index::erase(EntryId id)
+{
+    auto found = byId.find(id);
+    if (found == byId.end())
+    {
+        return false;
+    }
+
+    ordered.erase(found->second.position);
+    byId.erase(found);
+    return true;
+}
+
+void Index::clear()
+{
+    ordered.clear();
+    byId.clear();
+}
+
+bool Index::next(EntryId id, EntryId& following) const
+{
+    auto found = byId.find(id);
+    if (found == byId.end())
+    {
+        return false;
+    }
+
+    auto iter = std::next(found->second.position);
+    if (iter == ordered.end())
+    {
+        return false;
+    }
+    following = *iter;
+    return true;
+}
+
+bool Index::after(EntryId id, EntryId& following) const
+{
+    auto iter = ordered.upper_bound(id);
+    if (iter == ordered.end())
+    {
+        return false;
+    }
+    following = *iter;
+    return true;
+}
+
+std::vector<EntryId> Index::ids() const
+{
+    return std::vector<EntryId>(ordered.begin(), ordered.end());
+}
+
+bool Index::record(EntryId id, GetSELEntryResponse& record) const
+{
+    auto found = byId.find(id);
+    if (found == byId.end() || !found->second.converted)
+    {
+        return false;
+    }
+    record = found->second.record;
+    return true;
+}
+
+bool Index::keep(EntryId id, const GetSELEntryResponse& record)
+{
+    auto found = byId.find(id);
+    if (found == byId.end())
+    {
+        return false;
+    }
+    found->second.converted = true;
+    found->second.record = record;
+    return true;
+}
+
+void Index::resolve(EntryId id, bool resolved)
+{
+    auto found = byId.find(id);
+    if (found == byId.end() || !found->second.converted)
+    {
+        return;
+    }
+
+    auto& eventType = found->second.record.eventType;
+    if (resolved)
+    {
+        eventType |= deassertEvent;
+    }
+    else
+    {
+        eventType &= ~deassertEvent;
+    }
+}
+
+void Index::forget(EntryId id)
+{
+    auto found = byId.find(id);
+    if (found != byId.end())
+    {
+        found->second.converted = false;
+    }
+}
+
+Index& index()
+{
+    return entries;
+}
+
+bool watchIndex(sd_bus* bus)
+{
+    return follower.watch(bus);
+}
+
+} // namespace sel
+
+} // namespace ipmi
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <systemd/sd-bus.h>
+#include <unordered_map>
+#include <vector>
+#include "selutility.hpp"
+
+namespace ipmi
+{
+
+namespace sel
+{
+
+/** @brief ID of a log entry, the last element of its object path */
+using EntryId = uint32_t;
+
+/** @brief Object path of a log entry */
+std::string entryPath(EntryId id);
+
+/** @brief Parses the ID of a log entry out of its object path
+ *
+ *  @param[in] path - Object path.
+ *  @param[out] id - ID of the log entry.
+ *
+ *  @return false if path is not the one of a log entry.
+ */
+bool parseEntryPath(const char* path, EntryId& id);
+
+/** @class Index
+ *  @brief The log entries the SEL is made of, in the order of their IDs.
+ *
+ *  An entry is looked up by ID in constant time, and so is the entry after
+ *  it. The SEL record an entry converts to is kept along with it, so that
+ *  it is read from the logging service once. Not thread safe, only used
+ *  from the event loop.
+ */
+class Index
+{
+    public:
+        Index() = default;
+        ~Index() = default;
+        Index(const Index&) = delete;
+        Index& operator=(const Index&) = delete;
+        Index(Index&&) = delete;
+        Index& operator=(Index&&) = delete;
+
+        /** @brief Replaces the entries */
+        void assign(const std::vector<EntryId>& ids);
+
+        /** @return false if the entry was already there */
+        bool insert(EntryId id);
+
+        /** @return false if there was no such entry */
+        bool erase(EntryId id);
+
+        void clear();
+
+        size_t size() const
+        {
+            return ordered.size();
+        }
+
+        bool empty() const
+        {
+            return ordered.empty();
+        }
+
+        bool contains(EntryId id) const
+        {
+            return byId.find(id) != byId.end();
+        }
+
+        /** @brief Lowest ID, the index must not be empty */
+        EntryId first() const
+        {
+            return *ordered.begin();
+        }
+
+        /** @brief Highest ID, the index must not be empty */
+        EntryId last() const
+        {
+            return *ordered.rbegin();
+        }
+
+        /** @brief Looks up the entry after an entry
+         *
+         *  @param[in] id - ID of an entry of the index.
+         *  @param[out] following - ID of the entry after it.
+         *
+         *  @return false if id is the last entry or not in the index.
+         */
+        bool next(EntryId id, EntryId& following) const;
+
+        /** @brief Looks up the entry after an ID, of an entry or not
+         *
+         *  @return false if there is none.
+         */
+        bool after(EntryId id, EntryId& following) const;
+
+        /** @brief Every ID, in order */
+        std::vector<EntryId> ids() const;
+
+        /** @brief Looks up the SEL record an entry converted to
+         *
+         *  @param[in] id - ID of the entry.
+         *  @param[out] record - The record, its nextRecordID is not set.
+         *
+         *  @return false if the entry was not converted yet.
+         */
+        bool record(EntryId id, GetSELEntryResponse& record) const;
+
+        /** @brief Keeps the SEL record an entry converted to
+         *
+         *  @return false if the entry is not in the index.
+         */
+        bool keep(EntryId id, const GetSELEntryResponse& record);
+
+        /** @brief Updates the event direction of the record of an entry,
+         *         after its Resolved property changed.
+         */
+        void resolve(EntryId id, bool resolved);
+
+        /** @brief Drops the record of an entry, it is converted again */
+        void forget(EntryId id);
+
+    private:
+        using Ordered = std::set<EntryId>;
+
+        /** @struct Entry
+         *  @brief A log entry of the index.
+         */
+        struct Entry
+        {
+            Ordered::const_iterator position;
+            bool converted;
+            GetSELEntryResponse record;
+        };
+
+        Ordered ordered;
+        std::unordered_map<EntryId, Entry> byId;
+};
+
+/** @brief The process wide index of the log entries, see watchIndex() */
+Index& index();
+
+/** @brief Keeps index() up to date with the logging service on bus
+ *
+ *  The index is read from the mapper on the first call for a connection,
+ *  then follows the InterfacesAdded, InterfacesRemoved and PropertiesChanged
+ *  signals of the logging service. The signals are dispatched by the event
+ *  loop; a handler that deletes an entry itself also erases it from the
+ *  index.
+ *
+ *  @param[in] bus - Connection the logging service is reached on.
+ *
+ *  @return false if the index could not be read, it is empty then and read
+ *          again on the next call.
+ */
+bool watchIndex(sd_bus* bus);
+
+} // namespace sel
+
+} // namespace ipmi
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <phosphor-logging/log.hpp>
+#include "config.h"
+#include "selreadahead.hpp"
+#include "selutility.hpp"
+#include "utils.hpp"
+
+namespace ipmi
+{
+
+namespace sel
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+/** @brief Entries converted ahead at the start of a walk */
+constexpr size_t initialDepth = 2;
+
+ReadAhead instance(SEL_READ_AHEAD);
+
+} // namespace
+
+ReadAhead::Conversion::Conversion(ReadAhead& owner, EntryId id) :
+    owner(owner), id(id)
+{
+    for (auto& call : calls)
+    {
+        call = Call{this, nullptr, nullptr};
+    }
+}
+
+ReadAhead::Conversion::~Conversion()
+{
+    // Unreferencing the slot of a call in flight cancels it.
+    for (auto& call : calls)
+    {
+        sd_bus_slot_unref(call.slot);
+        sd_bus_message_unref(call.reply);
+    }
+}
+
+void ReadAhead::setMaxDepth(size_t depth)
+{
+    maxDepth = depth;
+    walkDepth = std::min(walkDepth, maxDepth);
+}
+
+void ReadAhead::follow(sd_bus* bus)
+{
+    if (bus == current)
+    {
+        return;
+    }
+
+    inFlight.clear();
+    ahead.clear();
+    service.clear();
+    walking = false;
+    current = bus;
+}
+
+void ReadAhead::served(sd_bus* bus, EntryId id, bool converted)
+{
+    if (maxDepth == 0)
+    {
+        return;
+    }
+    follow(bus);
+
+    auto wasAhead = ahead.erase(id) != 0;
+    if (walking && id == expected)
+    {
+        if (wasAhead)
+        {
+            ++counters.hits;
+            ++walkCounters.hits;
+        }
+        else if (converted)
+        {
+            // The host caught up with the conversions.
+            ++counters.misses;
+            ++walkCounters.misses;
+            walkDepth = std::min(walkDepth * 2, maxDepth);
+        }
+    }
+    else
+    {
+        // The entries the last walk left converted ahead were for nothing,
+        // it went deeper than the host reads.
+        auto floor = std::min(initialDepth, maxDepth);
+        if (!ahead.empty())
+        {
+            counters.wasted += ahead.size();
+            walkDepth /= 2;
+            ahead.clear();
+        }
+        walkCounters = ReadAheadStats{};
+        walkDepth = std::max(walkDepth, floor);
+    }
+
+    const auto& entries = index();
+    walking = entries.next(id, expected);
+    if (!walking)
+    {
+        if (walkCounters.hits + walkCounters.misses != 0)
+        {
+            log<level::INFO>("SEL walk read ahead",
+                             entry("HITS=%llu",
+                                   static_cast<unsigned long long>(
+                                       walkCounters.hits)),
+                             entry("MISSES=%llu",
+                                   static_cast<unsigned long long>(
+                                       walkCounters.misses)),
+                             entry("DEPTH=%zu", walkDepth));
+        }
+        walkCounters = ReadAheadStats{};
+        return;
+    }
+
+    auto next = id;
+    for (size_t i = 0; i < walkDepth && entries.next(next, next); ++i)
+    {
+        GetSELEntryResponse record{};
+        if (inFlight.count(next) == 0 && !entries.record(next, record))
+        {
+            start(bus, next);
+        }
+    }
+}
+
+void ReadAhead::start(sd_bus* bus, EntryId id)
+{
+    auto path = entryPath(id);
+    if (service.empty())
+    {
+        // The logging service serves every log entry, with both the
+        // interfaces read.
+        try
+        {
+            sdbusplus::bus::bus dbus{bus};
+            service = ipmi::getService(dbus, logEntryIntf, path);
+        }
+        catch (const std::exception& e)
+        {
+            return;
+        }
+    }
+
+    std::unique_ptr<Conversion> conversion(new Conversion(*this, id));
+    auto timeout = ipmi::timeout::get(logEntryIntf);
+    for (size_t i = 0; i < conversion->calls.size(); ++i)
+    {
+        auto& call = conversion->calls[i];
+        sd_bus_message* m = nullptr;
+        auto r = sd_bus_message_new_method_call(bus, &m, service.c_str(),
+                                                path.c_str(), propIntf,
+                                                i == 0 ? "Get" : "GetAll");
+        if (r >= 0)
+        {
+            r = i == 0 ?
+                sd_bus_message_append(m, "ss", assocIntf, assocProp) :
+                sd_bus_message_append(m, "s", logEntryIntf);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_call_async(bus, &call.slot, m, onReply, &call,
+                                  timeout);
+        }
+        sd_bus_message_unref(m);
+        if (r < 0)
+        {
+            log<level::ERR>("Failed to read a log entry ahead",
+                            entry("PATH=%s", path.c_str()),
+                            entry("ERROR=%s", strerror(-r)));
+            return;
+        }
+        ++conversion->pending;
+    }
+
+    inFlight.emplace(id, std::move(conversion));
+}
+
+int ReadAhead::onReply(sd_bus_message* m, void* userData,
+                       sd_bus_error* error)
+{
+    auto call = static_cast<Conversion::Call*>(userData);
+    auto& conversion = *call->conversion;
+
+    if (sd_bus_message_is_method_error(m, nullptr))
+    {
+        conversion.owner.complete(conversion, false);
+        return 0;
+    }
+
+    call->reply = sd_bus_message_ref(m);
+    if (--conversion.pending == 0)
+    {
+        conversion.owner.complete(conversion, true);
+    }
+    return 0;
+}
+
+void ReadAhead::complete(Conversion& conversion, bool answered)
+{
+    auto id = conversion.id;
+    auto& entries = index();
+
+    // Not if the walk got there first and converted the entry itself.
+    GetSELEntryResponse record{};
+    if (answered && entries.contains(id) && !entries.record(id, record))
+    {
+        try
+        {
+            sdbusplus::message::message assocReply(
+                conversion.calls[0].reply);
+            sdbusplus::message::variant<AssociationList> list;
+            assocReply.read(list);
+
+            sdbusplus::message::message entryReply(
+                conversion.calls[1].reply);
+            EntryProperties entryData;
+            entryReply.read(entryData);
+
+            record = convertLogEntrytoSEL(
+                sdbusplus::message::variant_ns::get<AssociationList>(list),
+                entryData);
+            entries.keep(id, record);
+            ahead.insert(id);
+            ++counters.converted;
+        }
+        catch (const std::exception& e)
+        {
+            // Converted by Get SEL Entry, which reports the error.
+        }
+    }
+    else if (!answered)
+    {
+        // Looked up again, in case the service went away.
+        service.clear();
+    }
+
+    inFlight.erase(id);
+}
+
+ReadAhead& readAhead()
+{
+    return instance;
+}
+
+} // namespace sel
+
+} // namespace ipmi
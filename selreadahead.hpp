@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <systemd/sd-bus.h>
+#include <unordered_set>
+#include "selindex.hpp"
+
+namespace ipmi
+{
+
+namespace sel
+{
+
+/** @struct ReadAheadStats
+ *  @brief Counters of the SEL read ahead.
+ */
+struct ReadAheadStats
+{
+    uint64_t converted; //!< Entries converted ahead of a walk.
+    uint64_t hits;      //!< Walk steps served from a record converted ahead.
+    uint64_t misses;    //!< Walk steps that had to convert the entry.
+    uint64_t wasted;    //!< Entries converted ahead and never read.
+};
+
+/** @class ReadAhead
+ *  @brief Converts the log entries a SEL walk is about to read.
+ *
+ *  Hosts and ipmitool read the SEL one Get SEL Entry at a time, each for
+ *  the nextRecordID of the previous one. Once a request follows that
+ *  order, the records of the entries after it are converted on the event
+ *  loop while the host is busy with the response, with the two D-Bus calls
+ *  of every entry in flight together. The next request then finds its
+ *  record in the SEL index.
+ *
+ *  The first walk starts with two entries converted ahead. Every step that
+ *  still has to convert its entry, the host being faster than the
+ *  conversions, doubles that up to the most allowed. A request out of order
+ *  starts a new walk as deep as the last one, or half as deep, down to two,
+ *  when entries converted ahead were never read. Not thread safe, only used
+ *  from the event loop.
+ */
+class ReadAhead
+{
+    public:
+        /** @param[in] maxDepth - Most entries converted ahead, 0 to
+         *                        disable.
+         */
+        explicit ReadAhead(size_t maxDepth) : maxDepth(maxDepth)
+        {
+        }
+        ~ReadAhead() = default;
+        ReadAhead(const ReadAhead&) = delete;
+        ReadAhead& operator=(const ReadAhead&) = delete;
+        ReadAhead(ReadAhead&&) = delete;
+        ReadAhead& operator=(ReadAhead&&) = delete;
+
+        /** @brief Follows the walk after Get SEL Entry served an entry,
+         *         converting the ones after it
+         *
+         *  @param[in] bus - Connection the logging service is reached on.
+         *  @param[in] id - ID of the entry served, in index().
+         *  @param[in] converted - Whether serving it had to convert it.
+         */
+        void served(sd_bus* bus, EntryId id, bool converted);
+
+        /** @brief Sets the most entries converted ahead, 0 to disable */
+        void setMaxDepth(size_t depth);
+
+        /** @brief Entries the walk currently has converted ahead */
+        size_t depth() const
+        {
+            return walkDepth;
+        }
+
+        /** @brief Whether no conversion is in flight */
+        bool idle() const
+        {
+            return inFlight.empty();
+        }
+
+        ReadAheadStats stats() const
+        {
+            return counters;
+        }
+
+        void resetStats()
+        {
+            counters = ReadAheadStats{};
+        }
+
+    private:
+        /** @struct Conversion
+         *  @brief The calls in flight for an entry.
+         */
+        struct Conversion
+        {
+            /** @struct Call
+             *  @brief A call of the conversion, what its reply comes with.
+             */
+            struct Call
+            {
+                Conversion* conversion;
+                sd_bus_slot* slot;
+                sd_bus_message* reply;
+            };
+
+            Conversion(ReadAhead& owner, EntryId id);
+            ~Conversion();
+            Conversion(const Conversion&) = delete;
+            Conversion& operator=(const Conversion&) = delete;
+
+            ReadAhead& owner;
+            EntryId id;
+            std::array<Call, 2> calls; //!< Associations, then Entry.
+            size_t pending = 0;
+        };
+
+        /** @brief Drops the conversions of another connection */
+        void follow(sd_bus* bus);
+
+        /** @brief Sends the calls converting an entry */
+        void start(sd_bus* bus, EntryId id);
+
+        /** @brief Keeps the record of a conversion and forgets it */
+        void complete(Conversion& conversion, bool answered);
+
+        static int onReply(sd_bus_message* m, void* userData,
+                           sd_bus_error* error);
+
+        size_t maxDepth;
+        size_t walkDepth = 0;
+
+        /** @brief Whether the requests follow the walk so far */
+        bool walking = false;
+
+        /** @brief ID of the next entry of the walk */
+        EntryId expected = 0;
+
+        /** @brief Bus the conversions are in flight on */
+        sd_bus* current = nullptr;
+
+        /** @brief Logging service, looked up once per connection */
+        std::string service;
+
+        std::map<EntryId, std::unique_ptr<Conversion>> inFlight;
+
+        /** @brief Entries converted ahead, not served yet */
+        std::unordered_set<EntryId> ahead;
+
+        ReadAheadStats counters{};
+        ReadAheadStats walkCounters{};
+};
+
+/** @brief The process wide read ahead, with SEL_READ_AHEAD entries at most
+ *         converted ahead.
+ */
+ReadAhead& readAhead();
+
+} // namespace sel
+
+} // namespace ipmi
@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <phosphor-logging/log.hpp>
+#include "config.h"
+#include "selstore.hpp"
+
+namespace ipmi
+{
+
+namespace sel
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+Store instance(SEL_STORE_PATH, SEL_STORE_RECORDS);
+
+/** @brief FNV-1a hash of the sequence and the record of a slot */
+uint32_t checksum(const StoreSlot& slot)
+{
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const uint8_t* data, size_t len)
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+    };
+    mix(reinterpret_cast<const uint8_t*>(&slot.sequence),
+        sizeof(slot.sequence));
+    mix(slot.record, sizeof(slot.record));
+    return hash;
+}
+
+void unpack(const StoreSlot& slot, GetSELEntryResponse& record)
+{
+    memcpy(reinterpret_cast<uint8_t*>(&record.recordID), slot.record,
+           sizeof(slot.record));
+}
+
+uint16_t followingId(uint16_t id)
+{
+    return id >= lastStoreId ? firstStoreId : id + 1;
+}
+
+} // namespace
+
+Store::Store(const std::string& path, size_t capacity) :
+    path(path),
+    slotCount(std::min<size_t>(capacity, lastStoreId - firstStoreId + 1)),
+    fileSize(sizeof(StoreHeader) + slotCount * sizeof(StoreSlot))
+{
+}
+
+Store::~Store()
+{
+    close();
+}
+
+bool Store::relocate(const std::string& path)
+{
+    close();
+    this->path = path;
+    return open();
+}
+
+bool Store::open()
+{
+    if (header != nullptr)
+    {
+        return true;
+    }
+    if (slotCount == 0)
+    {
+        return false;
+    }
+
+    auto slash = path.rfind('/');
+    if (slash != std::string::npos && slash != 0)
+    {
+        // Fails with EEXIST but for the first time.
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+
+    auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        log<level::ERR>("Failed to open the SEL store",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", strerror(errno)));
+        return false;
+    }
+
+    struct stat st{};
+    StoreHeader current{};
+    auto valid = fstat(fd, &st) == 0 &&
+                 static_cast<size_t>(st.st_size) == fileSize &&
+                 pread(fd, &current, sizeof(current), 0) ==
+                     sizeof(current) &&
+                 current.magic == storeMagic &&
+                 current.version == storeVersion &&
+                 current.capacity == slotCount &&
+                 current.slotSize == sizeof(StoreSlot);
+    if (!valid)
+    {
+        if (st.st_size != 0)
+        {
+            log<level::INFO>("SEL store of another layout, made anew",
+                             entry("PATH=%s", path.c_str()));
+        }
+        if (!format(fd))
+        {
+            ::close(fd);
+            return false;
+        }
+    }
+
+    auto file = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd, 0);
+    auto error = errno;
+    ::close(fd);
+    if (file == MAP_FAILED)
+    {
+        log<level::ERR>("Failed to map the SEL store",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", strerror(error)));
+        return false;
+    }
+
+    header = static_cast<StoreHeader*>(file);
+    slots = reinterpret_cast<StoreSlot*>(header + 1);
+    scan();
+    return true;
+}
+
+bool Store::format(int fd)
+{
+    StoreHeader fresh{storeMagic, storeVersion,
+                      static_cast<uint32_t>(slotCount), sizeof(StoreSlot)};
+
+    // Truncated first, the slots are read back as zeroes, free.
+    if (ftruncate(fd, 0) != 0 ||
+        ftruncate(fd, fileSize) != 0 ||
+        pwrite(fd, &fresh, sizeof(fresh), 0) != sizeof(fresh) ||
+        fsync(fd) != 0)
+    {
+        log<level::ERR>("Failed to make the SEL store",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+void Store::scan()
+{
+    ids.clear();
+    head = 0;
+    nextSequence = 1;
+    nextId = firstStoreId;
+    lastAdd = invalidTimeStamp;
+
+    uint32_t newest = 0;
+    for (size_t i = 0; i < slotCount; ++i)
+    {
+        const auto& slot = slots[i];
+        if (slot.sequence == 0 || slot.checksum != checksum(slot))
+        {
+            continue;
+        }
+
+        GetSELEntryResponse record{};
+        unpack(slot, record);
+        uint16_t id = record.recordID;
+        if (id < firstStoreId || id > lastStoreId)
+        {
+            continue;
+        }
+
+        // Of two records with the same ID, the one added last.
+        auto found = ids.find(id);
+        if (found != ids.end() &&
+            slots[found->second].sequence > slot.sequence)
+        {
+            continue;
+        }
+        ids[id] = i;
+
+        if (slot.sequence > newest)
+        {
+            newest = slot.sequence;
+            head = (i + 1) % slotCount;
+            nextId = followingId(id);
+            lastAdd = record.timeStamp;
+        }
+    }
+    nextSequence = newest + 1;
+}
+
+void Store::sync(const StoreSlot& slot)
+{
+    static const auto pageSize = static_cast<uintptr_t>(
+        sysconf(_SC_PAGESIZE));
+    auto start = reinterpret_cast<uintptr_t>(&slot) & ~(pageSize - 1);
+    auto end = reinterpret_cast<uintptr_t>(&slot + 1);
+    if (msync(reinterpret_cast<void*>(start), end - start, MS_SYNC) != 0)
+    {
+        log<level::ERR>("Failed to write the SEL store",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", strerror(errno)));
+    }
+}
+
+void Store::close()
+{
+    if (header != nullptr)
+    {
+        munmap(header, fileSize);
+    }
+    header = nullptr;
+    slots = nullptr;
+    ids.clear();
+}
+
+bool Store::add(GetSELEntryResponse& record, const Taken& taken)
+{
+    if (!open())
+    {
+        return false;
+    }
+
+    size_t slot = slotCount;
+    if (ids.size() < slotCount)
+    {
+        for (size_t i = 0; i < slotCount; ++i)
+        {
+            auto candidate = (head + i) % slotCount;
+            if (!used(candidate))
+            {
+                slot = candidate;
+                break;
+            }
+        }
+    }
+
+    // Full, the oldest record makes way. After erases it is not
+    // necessarily the one of the next slot.
+    auto oldest = ids.end();
+    if (slot == slotCount)
+    {
+        for (auto it = ids.begin(); it != ids.end(); ++it)
+        {
+            if (oldest == ids.end() ||
+                slots[it->second].sequence < slots[oldest->second].sequence)
+            {
+                oldest = it;
+            }
+        }
+        if (oldest == ids.end())
+        {
+            return false;
+        }
+        slot = oldest->second;
+    }
+
+    uint16_t id = 0;
+    if (!freeId(taken, id))
+    {
+        if (oldest == ids.end() || (taken && taken(oldest->first)))
+        {
+            log<level::ERR>("No record ID left for the SEL store");
+            return false;
+        }
+        id = oldest->first;
+    }
+    if (oldest != ids.end())
+    {
+        ids.erase(oldest);
+    }
+
+    record.recordID = id;
+    record.timeStamp = static_cast<uint32_t>(time(nullptr));
+    write(slot, record, nextSequence++);
+
+    ids[id] = slot;
+    head = (slot + 1) % slotCount;
+    nextId = followingId(id);
+    lastAdd = record.timeStamp;
+    return true;
+}
+
+size_t Store::yield(const Taken& taken)
+{
+    std::vector<uint16_t> shadowed;
+    for (const auto& id : ids)
+    {
+        if (taken(id.first))
+        {
+            shadowed.push_back(id.first);
+        }
+    }
+
+    size_t moved = 0;
+    for (auto id : shadowed)
+    {
+        uint16_t free = 0;
+        if (!freeId(taken, free))
+        {
+            log<level::ERR>("No record ID left for the SEL store");
+            break;
+        }
+
+        auto slot = ids[id];
+        GetSELEntryResponse record{};
+        unpack(slots[slot], record);
+        record.recordID = free;
+        write(slot, record, slots[slot].sequence);
+
+        ids.erase(id);
+        ids[free] = slot;
+        nextId = followingId(free);
+        ++moved;
+
+        log<level::INFO>("SEL store record moved off a log entry's ID",
+                         entry("FROM=0x%04X", id),
+                         entry("TO=0x%04X", free));
+    }
+    return moved;
+}
+
+void Store::write(size_t slot, const GetSELEntryResponse& record,
+                  uint32_t sequence)
+{
+    auto& target = slots[slot];
+    target.sequence = 0;
+    memcpy(target.record, reinterpret_cast<const uint8_t*>(&record.recordID),
+           sizeof(target.record));
+    memset(target.reserved, 0, sizeof(target.reserved));
+    target.sequence = sequence;
+    target.checksum = checksum(target);
+    sync(target);
+}
+
+bool Store::used(size_t slot) const
+{
+    if (slots[slot].sequence == 0)
+    {
+        return false;
+    }
+    uint16_t id = 0;
+    memcpy(&id, slots[slot].record, sizeof(id));
+    auto found = ids.find(id);
+    return found != ids.end() && found->second == slot;
+}
+
+bool Store::freeId(const Taken& taken, uint16_t& id) const
+{
+    auto candidate = nextId;
+    for (size_t i = 0; i <= lastStoreId - firstStoreId; ++i)
+    {
+        if (!contains(candidate) && !(taken && taken(candidate)))
+        {
+            id = candidate;
+            return true;
+        }
+        candidate = followingId(candidate);
+    }
+    return false;
+}
+
+bool Store::get(uint16_t id, GetSELEntryResponse& record) const
+{
+    auto found = ids.find(id);
+    if (found == ids.end())
+    {
+        return false;
+    }
+    unpack(slots[found->second], record);
+    return true;
+}
+
+bool Store::erase(uint16_t id)
+{
+    auto found = ids.find(id);
+    if (found == ids.end())
+    {
+        return false;
+    }
+
+    auto& slot = slots[found->second];
+    slot.sequence = 0;
+    slot.checksum = 0;
+    sync(slot);
+    ids.erase(found);
+    return true;
+}
+
+void Store::clear()
+{
+    if (!open())
+    {
+        return;
+    }
+
+    memset(static_cast<void*>(slots), 0, slotCount * sizeof(StoreSlot));
+    if (msync(header, fileSize, MS_SYNC) != 0)
+    {
+        log<level::ERR>("Failed to write the SEL store",
+                        entry("PATH=%s", path.c_str()),
+                        entry("ERROR=%s", strerror(errno)));
+    }
+    ids.clear();
+    head = 0;
+}
+
+bool Store::after(uint16_t id, uint16_t& following) const
+{
+    auto found = ids.upper_bound(id);
+    if (found == ids.end())
+    {
+        return false;
+    }
+    following = found->first;
+    return true;
+}
+
+Store& store()
+{
+    return instance;
+}
+
+} // namespace sel
+
+} // namespace ipmi
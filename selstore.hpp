@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include "selutility.hpp"
+
+namespace ipmi
+{
+
+namespace sel
+{
+
+/** @brief Record IDs of the records of the store, apart from the log
+ *         entries' whose IDs count up from 1.
+ */
+static constexpr uint16_t firstStoreId = 0x8000;
+static constexpr uint16_t lastStoreId = 0xFFFE;
+
+/** @brief Identifies a SEL store file, "IPMS" */
+static constexpr uint32_t storeMagic = 0x534D5049;
+
+/** @brief Layout version of the SEL store file */
+static constexpr uint32_t storeVersion = 1;
+
+/** @struct StoreHeader
+ *  @brief Start of the SEL store file.
+ */
+struct StoreHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slotSize;
+};
+
+/** @struct StoreSlot
+ *  @brief A record of the SEL store file.
+ *
+ *  sequence is 0 for a free slot, else the 1-based position of the record
+ *  in the order the records were added. checksum covers the sequence and the
+ *  record, a slot torn by a crash or power loss while it was written is free
+ *  when the file is opened again.
+ */
+struct StoreSlot
+{
+    uint32_t sequence;
+    uint32_t checksum;
+    uint8_t record[selRecordSize]; //!< As in Get SEL Entry, from the ID.
+    uint8_t reserved[8];
+};
+
+/** @class Store
+ *  @brief SEL records added through IPMI, in a memory mapped ring file.
+ *
+ *  Unlike the records of the log entries, which are converted from the
+ *  logging service, these are kept as the 16 bytes Get SEL Entry returns.
+ *  A record added takes a free slot, or once full the place of the oldest
+ *  record. Every
+ *  change is synced to the file before the call returns. The file is
+ *  opened on first use, and made anew if it is not a store of the same
+ *  capacity. Not thread safe, only used from the event loop.
+ */
+class Store
+{
+    public:
+        /** @brief Tells whether a record ID is taken outside of the store */
+        using Taken = std::function<bool(uint16_t)>;
+
+        /** @param[in] path - Store file, its directory is created if
+         *                    missing.
+         *  @param[in] capacity - Number of records of the ring.
+         */
+        Store(const std::string& path, size_t capacity);
+        ~Store();
+        Store(const Store&) = delete;
+        Store& operator=(const Store&) = delete;
+        Store(Store&&) = delete;
+        Store& operator=(Store&&) = delete;
+
+        /** @brief Uses another file, e.g. in tests, and opens it */
+        bool relocate(const std::string& path);
+
+        /** @brief Opens the file, if not already
+         *
+         *  @return false if it can't be used, the store is empty then.
+         */
+        bool open();
+
+        /** @brief Adds a record
+         *
+         *  @param[in,out] record - The record, its record ID and timestamp
+         *                          are set.
+         *  @param[in] taken - IDs the record must not get, if set.
+         *
+         *  @return false if the record could not be stored.
+         */
+        bool add(GetSELEntryResponse& record, const Taken& taken = Taken());
+
+        /** @brief Moves the records whose ID is taken outside of the store
+         *         to IDs that are not.
+         *
+         *  @return Number of records moved.
+         */
+        size_t yield(const Taken& taken);
+
+        /** @brief Looks a record up
+         *
+         *  @param[in] id - Record ID.
+         *  @param[out] record - The record, its nextRecordID is not set.
+         *
+         *  @return false if there is no such record.
+         */
+        bool get(uint16_t id, GetSELEntryResponse& record) const;
+
+        /** @return false if there was no such record */
+        bool erase(uint16_t id);
+
+        void clear();
+
+        size_t size() const
+        {
+            return ids.size();
+        }
+
+        bool empty() const
+        {
+            return ids.empty();
+        }
+
+        size_t capacity() const
+        {
+            return slotCount;
+        }
+
+        bool contains(uint16_t id) const
+        {
+            return ids.find(id) != ids.end();
+        }
+
+        /** @brief Lowest record ID, the store must not be empty */
+        uint16_t first() const
+        {
+            return ids.begin()->first;
+        }
+
+        /** @brief Highest record ID, the store must not be empty */
+        uint16_t last() const
+        {
+            return ids.rbegin()->first;
+        }
+
+        /** @brief Looks up the record after a record ID, of the store or not
+         *
+         *  @return false if there is none.
+         */
+        bool after(uint16_t id, uint16_t& following) const;
+
+        /** @brief Timestamp of the last record added, or invalidTimeStamp */
+        uint32_t addTimeStamp() const
+        {
+            return lastAdd;
+        }
+
+    private:
+        /** @brief Makes a store file of the capacity anew */
+        bool format(int fd);
+
+        /** @brief Reads the valid records of the file */
+        void scan();
+
+        /** @brief Writes a slot to the file */
+        void sync(const StoreSlot& slot);
+
+        /** @brief Fills a slot and writes it to the file */
+        void write(size_t slot, const GetSELEntryResponse& record,
+                   uint32_t sequence);
+
+        /** @return false if a slot is free */
+        bool used(size_t slot) const;
+
+        /** @brief Looks up a record ID of neither the store nor taken
+         *
+         *  @return false if there is none.
+         */
+        bool freeId(const Taken& taken, uint16_t& id) const;
+
+        void close();
+
+        std::string path;
+        size_t slotCount;
+        size_t fileSize;
+
+        StoreHeader* header = nullptr;
+        StoreSlot* slots = nullptr;
+
+        /** @brief Slot of every record, by record ID */
+        std::map<uint16_t, size_t> ids;
+
+        /** @brief Slot the search for a free slot starts from */
+        size_t head = 0;
+
+        uint32_t nextSequence = 1;
+        uint16_t nextId = firstStoreId;
+        uint32_t lastAdd = invalidTimeStamp;
+};
+
+/** @brief The process wide store, SEL_STORE_RECORDS records in
+ *         SEL_STORE_PATH.
+ */
+Store& store();
+
+} // namespace sel
+
+} // namespace ipmi
@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <chrono>
+#include <stdlib.h>
+#include <string.h>
 #include <vector>
-#include <experimental/filesystem>
 #include <phosphor-logging/elog-errors.hpp>
 #include "host-ipmid/ipmid-api.h"
 #include "xyz/openbmc_project/Common/error.hpp"
@@ -27,8 +29,6 @@ GetSELEntryResponse prepareSELEntry(
         const std::string& objPath,
         ipmi::sensor::InvObjectIDMap::const_iterator iter)
 {
-    GetSELEntryResponse record {};
-
     sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
     auto service = ipmi::getService(bus, logEntryIntf, objPath);
 
@@ -39,16 +39,25 @@ GetSELEntryResponse prepareSELEntry(
                                           "GetAll");
     methodCall.append(logEntryIntf);
 
-    auto reply = bus.call(methodCall);
+    auto reply = ipmi::call(bus, methodCall);
     if (reply.is_method_error())
     {
         log<level::ERR>("Error in reading logging property entries");
         elog<InternalFailure>();
     }
 
-    std::map<PropertyName, PropertyType> entryData;
+    EntryProperties entryData;
     reply.read(entryData);
 
+    return prepareSELEntry(entryData, iter);
+}
+
+GetSELEntryResponse prepareSELEntry(
+        const EntryProperties& entryData,
+        ipmi::sensor::InvObjectIDMap::const_iterator iter)
+{
+    GetSELEntryResponse record {};
+
     // Read Id from the log entry.
     static constexpr auto propId = "Id";
     auto iterId = entryData.find(propId);
@@ -97,8 +106,6 @@ GetSELEntryResponse prepareSELEntry(
         elog<InternalFailure>();
     }
 
-    static constexpr auto deassertEvent = 0x80;
-
     // Evaluate if the event is assertion or deassertion event
     if (sdbusplus::message::variant_ns::get<bool>(iterResolved->second))
     {
@@ -112,41 +119,9 @@ GetSELEntryResponse prepareSELEntry(
     return record;
 }
 
-} // namespace internal
-
-GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
+ipmi::sensor::InvObjectIDMap::const_iterator findSensor(
+        const AssociationList& assocs)
 {
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-
-    static constexpr auto assocIntf = "org.openbmc.Associations";
-    static constexpr auto assocProp = "associations";
-
-    auto service = ipmi::getService(bus, assocIntf, objPath);
-
-    // Read the Associations interface.
-    auto methodCall = bus.new_method_call(service.c_str(),
-                                          objPath.c_str(),
-                                          propIntf,
-                                          "Get");
-    methodCall.append(assocIntf);
-    methodCall.append(assocProp);
-
-    auto reply = bus.call(methodCall);
-    if (reply.is_method_error())
-    {
-        log<level::ERR>("Error in reading Associations interface");
-        elog<InternalFailure>();
-    }
-
-    using AssociationList = std::vector<std::tuple<
-                            std::string, std::string, std::string>>;
-
-    sdbusplus::message::variant<AssociationList> list;
-    reply.read(list);
-
-    auto& assocs = sdbusplus::message::variant_ns::get<AssociationList>
-         (list);
-
     /*
      * Check if the log entry has any callout associations, if there is a
      * callout association try to match the inventory path to the corresponding
@@ -167,7 +142,7 @@ GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
                  }
              }
 
-             return internal::prepareSELEntry(objPath, iter);
+             return iter;
         }
     }
 
@@ -180,7 +155,45 @@ GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
         elog<InternalFailure>();
     }
 
-    return internal::prepareSELEntry(objPath, iter);
+    return iter;
+}
+
+} // namespace internal
+
+GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath)
+{
+    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
+
+    auto service = ipmi::getService(bus, assocIntf, objPath);
+
+    // Read the Associations interface.
+    auto methodCall = bus.new_method_call(service.c_str(),
+                                          objPath.c_str(),
+                                          propIntf,
+                                          "Get");
+    methodCall.append(assocIntf);
+    methodCall.append(assocProp);
+
+    auto reply = ipmi::call(bus, methodCall);
+    if (reply.is_method_error())
+    {
+        log<level::ERR>("Error in reading Associations interface");
+        elog<InternalFailure>();
+    }
+
+    sdbusplus::message::variant<AssociationList> list;
+    reply.read(list);
+
+    auto& assocs = sdbusplus::message::variant_ns::get<AssociationList>
+         (list);
+
+    return internal::prepareSELEntry(objPath, internal::findSensor(assocs));
+}
+
+GetSELEntryResponse convertLogEntrytoSEL(const AssociationList& assocs,
+                                         const EntryProperties& entryData)
+{
+    return internal::prepareSELEntry(entryData, internal::findSensor(assocs));
 }
 
 std::chrono::seconds getEntryTimeStamp(const std::string& objPath)
@@ -199,7 +212,7 @@ std::chrono::seconds getEntryTimeStamp(const std::string& objPath)
     methodCall.append(logEntryIntf);
     methodCall.append(propTimeStamp);
 
-    auto reply = bus.call(methodCall);
+    auto reply = ipmi::call(bus, methodCall);
     if (reply.is_method_error())
     {
         log<level::ERR>("Error in reading Timestamp from Entry interface");
@@ -215,43 +228,6 @@ std::chrono::seconds getEntryTimeStamp(const std::string& objPath)
     return std::chrono::duration_cast<std::chrono::seconds>(chronoTimeStamp);
 }
 
-void readLoggingObjectPaths(ObjectPaths& paths)
-{
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-    auto depth = 0;
-    paths.clear();
-
-    auto mapperCall = bus.new_method_call(mapperBusName,
-                                          mapperObjPath,
-                                          mapperIntf,
-                                          "GetSubTreePaths");
-    mapperCall.append(logBasePath);
-    mapperCall.append(depth);
-    mapperCall.append(ObjectPaths({logEntryIntf}));
-
-    auto reply = bus.call(mapperCall);
-    if (reply.is_method_error())
-    {
-        log<level::INFO>("Error in reading logging entry object paths");
-    }
-    else
-    {
-        reply.read(paths);
-
-        std::sort(paths.begin(), paths.end(), [](const std::string& a,
-                                                 const std::string& b)
-        {
-            namespace fs = std::experimental::filesystem;
-            fs::path pathA(a);
-            fs::path pathB(b);
-            auto idA = std::stoul(pathA.filename().string());
-            auto idB = std::stoul(pathB.filename().string());
-
-            return idA < idB;
-        });
-    }
-}
-
 } // namespace sel
 
 } // namespace ipmi
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
 #include <sdbusplus/server.hpp>
+#include <tuple>
 #include "types.hpp"
 
 namespace ipmi
@@ -17,6 +19,9 @@ static constexpr auto mapperIntf = "xyz.openbmc_project.ObjectMapper";
 static constexpr auto logBasePath = "/xyz/openbmc_project/logging/entry";
 static constexpr auto logEntryIntf = "xyz.openbmc_project.Logging.Entry";
 static constexpr auto logDeleteIntf = "xyz.openbmc_project.Object.Delete";
+static constexpr auto logObjPath = "/xyz/openbmc_project/logging";
+static constexpr auto logDeleteAllIntf =
+    "xyz.openbmc_project.Collection.DeleteAll";
 
 static constexpr auto propIntf = "org.freedesktop.DBus.Properties";
 
@@ -29,6 +34,12 @@ using Message = std::string;
 using AdditionalData = std::vector<std::string>;
 using PropertyType = sdbusplus::message::variant<Resolved, Id, Timestamp,
                      Message, AdditionalData>;
+using EntryProperties = std::map<PropertyName, PropertyType>;
+using AssociationList =
+    std::vector<std::tuple<std::string, std::string, std::string>>;
+
+static constexpr auto assocIntf = "org.openbmc.Associations";
+static constexpr auto assocProp = "associations";
 
 static constexpr auto selVersion = 0x51;
 static constexpr auto invalidTimeStamp = 0xFFFFFFFF;
@@ -48,6 +59,14 @@ struct GetSELInfoResponse
     uint8_t operationSupport;       //!< Operation support.
 } __attribute__((packed));
 
+/** @brief Event direction bit of GetSELEntryResponse::eventType, set once
+ *         the log entry is resolved.
+ */
+static constexpr uint8_t deassertEvent = 0x80;
+
+/** @brief Record type of the standard SEL records */
+static constexpr uint8_t systemEventRecord = 0x02;
+
 static constexpr auto firstEntry = 0x0000;
 static constexpr auto lastEntry = 0xFFFF;
 static constexpr auto entireRecord = 0xFF;
@@ -97,6 +116,7 @@ struct DeleteSELEntryRequest
 
 static constexpr auto initiateErase = 0xAA;
 static constexpr auto getEraseStatus = 0x00;
+static constexpr auto eraseInProgress = 0x00;
 static constexpr auto eraseComplete = 0x01;
 
 /** @struct ClearSELRequest
@@ -120,6 +140,17 @@ struct ClearSELRequest
  */
 GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath);
 
+/** @brief Convert logging entry to SEL, from properties already read
+ *
+ *  @param[in] assocs - Associations of the logging entry.
+ *  @param[in] entryData - Properties of its Entry interface.
+ *
+ *  @return On success return the response of Get SEL entry command, throw
+ *          an exception in case of failure.
+ */
+GetSELEntryResponse convertLogEntrytoSEL(const AssociationList& assocs,
+                                         const EntryProperties& entryData);
+
 /** @brief Get the timestamp of the log entry
  *
  *  @param[in] objPath - DBUS object path of the logging entry.
@@ -129,21 +160,6 @@ GetSELEntryResponse convertLogEntrytoSEL(const std::string& objPath);
  */
 std::chrono::seconds getEntryTimeStamp(const std::string& objPath);
 
-/** @brief Read the logging entry object paths
- *
- *  This API would read the logging dbus logging entry object paths and sorting
- *  the filename in the numeric order. The paths is cleared before populating
- *  the object paths.
- *
- *  @param[in,out] paths - sorted list of logging entry object paths.
- *
- *  @note This function is invoked when the Get SEL Info command or the Delete
- *        SEL entry command is invoked. The Get SEL Entry command is preceded
- *        typically by Get SEL Info command, so readLoggingObjectPaths is not
- *        invoked before each Get SEL entry command.
- */
-void readLoggingObjectPaths(ObjectPaths& paths);
-
 namespace internal
 {
 
@@ -160,6 +176,31 @@ GetSELEntryResponse prepareSELEntry(
         const std::string& objPath,
         ipmi::sensor::InvObjectIDMap::const_iterator iter);
 
+/** @brief Convert the properties of a logging entry to SEL event record
+ *
+ *  @param[in] entryData - Properties of the Entry interface of the logging
+ *                         entry.
+ *  @param[in] iter - Iterator to the sensor data corresponding to the logging
+ *                    entry
+ *
+ *  @return On success return the SEL event record, throw an exception in case
+ *          of failure.
+ */
+GetSELEntryResponse prepareSELEntry(
+        const EntryProperties& entryData,
+        ipmi::sensor::InvObjectIDMap::const_iterator iter);
+
+/** @brief Find the sensor a logging entry is reported against
+ *
+ *  @param[in] assocs - Associations of the logging entry.
+ *
+ *  @return Iterator to the sensor data of the first callout, or of the
+ *          system event sensor without callouts. Throws an exception if
+ *          the sensor is not found.
+ */
+ipmi::sensor::InvObjectIDMap::const_iterator findSensor(
+        const AssociationList& assocs);
+
 }
 
 } // namespace sel
@@ -31,6 +31,24 @@ ServicePath getServiceAndPath(sdbusplus::bus::bus& bus,
                               const std::string& interface,
                               const std::string& path)
 {
+    if (!path.empty())
+    {
+        // Only the object itself, through the service cache
+        try
+        {
+            return std::make_pair(path,
+                                  ipmi::getService(bus, interface, path));
+        }
+        catch (const std::runtime_error& e)
+        {
+            log<level::ERR>("Coudn't find d-bus path",
+                            entry("PATH=%s", path.c_str()),
+                            entry("INTERFACE=%s", interface.c_str()),
+                            entry("ERROR=%s", e.what()));
+            elog<InternalFailure>();
+        }
+    }
+
     auto depth = 0;
     auto mapperCall = bus.new_method_call(MAPPER_BUSNAME,
                                           MAPPER_PATH,
@@ -40,40 +58,31 @@ ServicePath getServiceAndPath(sdbusplus::bus::bus& bus,
     mapperCall.append(depth);
     mapperCall.append(std::vector<Interface>({interface}));
 
-    auto mapperResponseMsg = bus.call(mapperCall);
+    auto mapperResponseMsg = ipmi::call(bus, mapperCall);
     if (mapperResponseMsg.is_method_error())
     {
         log<level::ERR>("Mapper GetSubTree failed",
-                        entry("PATH=%s", path),
-                        entry("INTERFACE=%s", interface));
+                        entry("INTERFACE=%s", interface.c_str()));
         elog<InternalFailure>();
     }
 
-    MapperResponseType mapperResponse;
-    mapperResponseMsg.read(mapperResponse);
-    if (mapperResponse.empty())
+    // The first object implementing the interface
+    ServicePath first;
+    auto r = ipmi::visitSubTree(mapperResponseMsg.get(),
+                                [&first](const char* path,
+                                         const char* service,
+                                         const std::vector<const char*>&)
+                                {
+                                    first = std::make_pair(path, service);
+                                    return true;
+                                });
+    if (r < 0 || first.first.empty())
     {
         log<level::ERR>("Invalid mapper response",
-                        entry("PATH=%s", path),
-                        entry("INTERFACE=%s", interface));
-        elog<InternalFailure>();
-    }
-
-    if (path.empty())
-    {
-        //Get the first one if the path is not in list.
-        return std::make_pair(mapperResponse.begin()->first,
-                              mapperResponse.begin()->second.begin()->first);
-    }
-    const auto& iter = mapperResponse.find(path);
-    if (iter == mapperResponse.end())
-    {
-        log<level::ERR>("Coudn't find d-bus path",
-                        entry("PATH=%s", path),
-                        entry("INTERFACE=%s", interface));
+                        entry("INTERFACE=%s", interface.c_str()));
         elog<InternalFailure>();
     }
-    return std::make_pair(iter->first, iter->second.begin()->first);
+    return first;
 }
 
 AssertionSet getAssertionSet(const SetSensorReadingReq& cmdData)
@@ -92,7 +101,7 @@ ipmi_ret_t updateToDbus(IpmiUpdateData& msg)
     sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
     try
     {
-        auto serviceResponseMsg = bus.call(msg);
+        auto serviceResponseMsg = ipmi::call(bus, msg);
         if (serviceResponseMsg.is_method_error())
         {
             log<level::ERR>("Error in D-Bus call");
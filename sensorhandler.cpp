@@ -1,12 +1,16 @@
-#include <mapper.h>
 #include <math.h>
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <memory>
 #include <set>
 #include <bitset>
 #include <xyz/openbmc_project/Sensor/Value/server.hpp>
 #include <systemd/sd-bus.h>
 #include "host-ipmid/ipmid-api.h"
+#include "host-ipmid/ipmid-async.hpp"
+#include "host-ipmid/ipmid-view.hpp"
 #include <phosphor-logging/log.hpp>
 #include <phosphor-logging/elog-errors.hpp>
 #include "ipmid.hpp"
@@ -91,7 +95,7 @@ int find_interface_property_fru_type(dbus_interface_t *interface, const char *pr
         goto final;
     }
 
-    r = sd_bus_call(bus, m, 0, &error, &reply);
+    r = ipmi::call(bus, m, &error, &reply);
     if (r < 0) {
         fprintf(stderr, "Failed to call the method: %s", strerror(-r));
         goto final;
@@ -115,7 +119,7 @@ final:
 }
 
 int get_bus_for_path(const char *path, char **busname) {
-    return mapper_get_service(bus, path, busname);
+    return ipmi::getService(bus, path, busname);
 }
 
 int legacy_dbus_openbmc_path(const char *type, const uint8_t num, dbus_interface_t *interface) {
@@ -135,8 +139,8 @@ int legacy_dbus_openbmc_path(const char *type, const uint8_t num, dbus_interface
         goto final;
     }
 
-    r = sd_bus_call_method(bus,busname,objname,iface, "getObjectFromByteId",
-                           &error, &reply, "sy", type, num);
+    r = ipmi::callMethod(bus,busname,objname,iface, "getObjectFromByteId",
+                         &error, &reply, "sy", type, num);
     if (r < 0) {
         fprintf(stderr, "Failed to create a method call: %s", strerror(-r));
         goto final;
@@ -251,7 +255,7 @@ int set_sensor_dbus_state_s(uint8_t number, const char *method, const char *valu
     }
 
 
-    r = sd_bus_call(bus, m, 0, &error, NULL);
+    r = ipmi::call(bus, m, &error, NULL);
     if (r < 0) {
         fprintf(stderr, "Failed to call the method: %s", strerror(-r));
     }
@@ -293,7 +297,7 @@ int set_sensor_dbus_state_y(uint8_t number, const char *method, const uint8_t va
     }
 
 
-    r = sd_bus_call(bus, m, 0, &error, NULL);
+    r = ipmi::call(bus, m, &error, NULL);
     if (r < 0) {
         fprintf(stderr, "12 Failed to call the method: %s", strerror(-r));
     }
@@ -386,9 +390,16 @@ ipmi_ret_t ipmi_sen_get_sensor_type(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                              ipmi_request_t request, ipmi_response_t response,
                              ipmi_data_len_t data_len, ipmi_context_t context)
 {
-    sensor_data_t *reqptr = (sensor_data_t*)request;
+    ipmi::RequestView req(request, *data_len);
+    ipmi::ResponseView resp(response, data_len);
+    auto reqptr = req.get<sensor_data_t>();
     ipmi_ret_t rc = IPMI_CC_OK;
 
+    if (reqptr == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
+
     printf("IPMI GET_SENSOR_TYPE [0x%02X]\n",reqptr->sennum);
 
     // TODO Not sure what the System-event-sensor is suppose to return
@@ -403,8 +414,7 @@ ipmi_ret_t ipmi_sen_get_sensor_type(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     }
 
 
-    *data_len = sizeof(buf);
-    memcpy(response, &buf, *data_len);
+    resp.pack(buf);
 
     return rc;
 }
@@ -419,10 +429,12 @@ bool isAnalogSensor(const std::string& interface)
     return (analogSensorInterfaces.count(interface));
 }
 
-ipmi_ret_t setSensorReading(void *request)
+ipmi_ret_t setSensorReading(const ipmi::RequestView& request)
 {
-    ipmi::sensor::SetSensorReadingReq cmdData =
-            *(static_cast<ipmi::sensor::SetSensorReadingReq *>(request));
+    // Only the sensor number is mandatory, the fields the host leaves out
+    // read as zero.
+    ipmi::sensor::SetSensorReadingReq cmdData{};
+    memcpy(&cmdData, request.data(), std::min(request.size(), sizeof(cmdData)));
 
     // Check if the Sensor Number is present
     const auto iter = sensors.find(cmdData.number);
@@ -453,7 +465,14 @@ ipmi_ret_t ipmi_sen_set_sensor(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                              ipmi_request_t request, ipmi_response_t response,
                              ipmi_data_len_t data_len, ipmi_context_t context)
 {
-    sensor_data_t *reqptr = (sensor_data_t*)request;
+    ipmi::RequestView req(request, *data_len);
+    auto reqptr = req.get<sensor_data_t>();
+    *data_len=0;
+
+    if (reqptr == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
 
     printf("IPMI SET_SENSOR [0x%02x]\n",reqptr->sennum);
 
@@ -462,7 +481,7 @@ ipmi_ret_t ipmi_sen_set_sensor(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
      * and functional state of Processor, Core & DIMM. For the remaining
      * sensors the existing support is invoked.
      */
-    auto ipmiRC = setSensorReading(request);
+    auto ipmiRC = setSensorReading(req);
 
     if(ipmiRC == IPMI_CC_SENSOR_INVALID)
     {
@@ -470,7 +489,6 @@ ipmi_ret_t ipmi_sen_set_sensor(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         ipmiRC = IPMI_CC_OK;
     }
 
-    *data_len=0;
     return ipmiRC;
 }
 
@@ -479,7 +497,8 @@ ipmi_ret_t ipmi_sen_get_sensor_reading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                              ipmi_request_t request, ipmi_response_t response,
                              ipmi_data_len_t data_len, ipmi_context_t context)
 {
-    sensor_data_t *reqptr = (sensor_data_t*)request;
+    ipmi::RequestView req(request, *data_len);
+    auto reqptr = req.get<sensor_data_t>();
     ipmi_ret_t rc = IPMI_CC_SENSOR_INVALID;
     uint8_t type = 0;
     sensorreadingresp_t *resp = (sensorreadingresp_t*) response;
@@ -489,6 +508,12 @@ ipmi_ret_t ipmi_sen_get_sensor_reading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     sd_bus_message *reply = NULL;
     int reading = 0;
 
+    *data_len=0;
+    if (reqptr == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
+
     printf("IPMI GET_SENSOR_READING [0x%02x]\n",reqptr->sennum);
 
     r = find_openbmc_path(reqptr->sennum, &a);
@@ -509,23 +534,22 @@ ipmi_ret_t ipmi_sen_get_sensor_reading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                         a.interface);
     }
 
-    *data_len=0;
-
     int64_t raw_value;
     ipmi::sensor::Info sensor;
 
     switch(type) {
         case 0xC2:
         case 0xC8:
-            r = sd_bus_get_property(bus,a.bus, a.path, a.interface, "value", NULL, &reply, "i");
+            r = ipmi::callMethod(bus, a.bus, a.path, ipmi::PROP_INTF, "Get",
+                                 NULL, &reply, "ss", a.interface, "value");
             if (r < 0) {
-                fprintf(stderr, "Failed to call sd_bus_get_property:%d,  %s\n", r, strerror(-r));
+                fprintf(stderr, "Failed to get the value property:%d,  %s\n", r, strerror(-r));
                 fprintf(stderr, "Bus: %s, Path: %s, Interface: %s\n",
                         a.bus, a.path, a.interface);
                 break;
             }
 
-            r = sd_bus_message_read(reply, "i", &reading);
+            r = sd_bus_message_read(reply, "v", "i", &reading);
             if (r < 0) {
                 fprintf(stderr, "Failed to read sensor: %s\n", strerror(-r));
                 break;
@@ -564,17 +588,14 @@ ipmi_ret_t ipmi_sen_get_sensor_reading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
 
             // Get value
-            r = sd_bus_get_property_trivial(bus,
-                                            a.bus,
-                                            a.path,
-                                            a.interface,
-                                            "Value",
-                                            NULL,
-                                            'x',
-                                            &raw_value);
+            r = ipmi::callMethod(bus, a.bus, a.path, ipmi::PROP_INTF, "Get",
+                                 NULL, &reply, "ss", a.interface, "Value");
+            if (r >= 0) {
+                r = sd_bus_message_read(reply, "v", "x", &raw_value);
+            }
             if (r < 0) {
                 fprintf(stderr,
-                        "Failed to call sd_bus_get_property:%d,  %s, 'value'\n",
+                        "Failed to get the Value property:%d,  %s\n",
                         r,
                         strerror(-r));
                 fprintf(stderr, "Bus: %s, Path: %s, Interface: %s\n",
@@ -606,8 +627,11 @@ ipmi_ret_t ipmi_sen_get_sensor_reading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
             try
             {
                 auto getResponse =  iter->second.getFunc(iter->second);
-                *data_len = getResponse.size();
-                memcpy(resp, getResponse.data(), *data_len);
+                ipmi::ResponseView view(response, data_len);
+                if (!view.append(getResponse.data(), getResponse.size()))
+                {
+                    return IPMI_CC_RESPONSE_ERROR;
+                }
                 return IPMI_CC_OK;
             }
             catch (InternalFailure& e)
@@ -630,6 +654,145 @@ ipmi_ret_t ipmi_sen_get_sensor_reading(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return rc;
 }
 
+// Sensor types read from the xyz.openbmc_project.Sensor.Value interface.
+static bool isValueSensorType(uint8_t type)
+{
+    switch (type)
+    {
+        case IPMI_SENSOR_TEMP:
+        case IPMI_SENSOR_VOLTAGE:
+        case IPMI_SENSOR_CURRENT:
+        case IPMI_SENSOR_FAN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Conversion data of a Get Sensor Reading waiting for the sensor value.
+struct pending_sensor_reading_t {
+    ipmi::sensor::Multiplier coefficientM;
+    ipmi::sensor::ScaledOffset scaledOffset;
+    ipmid_responder_t responder;
+    std::string path;
+    std::string interface;
+};
+
+static int sensor_value_reply(sd_bus_message *reply, void *userdata,
+                              sd_bus_error *ret_error)
+{
+    std::unique_ptr<pending_sensor_reading_t> pending(
+            static_cast<pending_sensor_reading_t*>(userdata));
+    int64_t raw_value = 0;
+    int r;
+
+    if (sd_bus_message_is_method_error(reply, NULL)) {
+        fprintf(stderr, "Failed to get the sensor value: %s\n",
+                sd_bus_message_get_error(reply)->message);
+        if (sd_bus_message_get_errno(reply) == ETIMEDOUT) {
+            ipmi::timeout::timedOut(pending->path.c_str(),
+                                    pending->interface.c_str(), "Get");
+        }
+        pending->responder(IPMI_CC_SENSOR_INVALID, {});
+        return 0;
+    }
+
+    r = sd_bus_message_read(reply, "v", "x", &raw_value);
+    if (r < 0) {
+        fprintf(stderr, "Failed to read sensor: %s\n", strerror(-r));
+        pending->responder(IPMI_CC_SENSOR_INVALID, {});
+        return 0;
+    }
+
+    // Prevent div0
+    auto coefficientM = pending->coefficientM ? pending->coefficientM : 1;
+
+    sensorreadingresp_t resp {};
+    resp.value = static_cast<uint8_t>(
+            (raw_value - pending->scaledOffset) / coefficientM);
+    resp.operation = 1<<6; // scanning enabled
+    resp.indication[0] = 0; // not a threshold sensor. ignore
+    resp.indication[1] = 0;
+
+    auto data = reinterpret_cast<const uint8_t*>(&resp);
+    pending->responder(IPMI_CC_OK,
+                       std::vector<uint8_t>(data, data + sizeof(resp)));
+    return 0;
+}
+
+// Get Sensor Reading. Sensors behind the Sensor.Value interface are read
+// with an asynchronous property Get, every other sensor is read through the
+// synchronous implementation above.
+void ipmi_sen_get_sensor_reading_async(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                                       ipmi_request_t request, size_t len,
+                                       ipmid_responder_t responder,
+                                       ipmi_context_t context)
+{
+    if (len < sizeof(sensor_data_t)) {
+        responder(IPMI_CC_REQ_DATA_LEN_INVALID, {});
+        return;
+    }
+
+    sensor_data_t *reqptr = (sensor_data_t*)request;
+    sd_bus *bus = ipmid_get_sd_bus_connection();
+    sd_bus_message *m = NULL;
+    dbus_interface_t a;
+    int r;
+
+    const auto iter = sensors.find(reqptr->sennum);
+    if (iter == sensors.end() ||
+        !isValueSensorType(iter->second.sensorType) ||
+        ipmi::sensor::Mutability::Read !=
+            (iter->second.mutability & ipmi::sensor::Mutability::Read) ||
+        find_openbmc_path(reqptr->sennum, &a) < 0)
+    {
+        uint8_t response[MAX_IPMI_BUFFER] = {};
+        size_t data_len = len;
+        auto rc = ipmi_sen_get_sensor_reading(netfn, cmd, request, response,
+                                              &data_len, context);
+        responder(rc, std::vector<uint8_t>(response, response + data_len));
+        return;
+    }
+
+    printf("IPMI GET_SENSOR_READING [0x%02x]\n",reqptr->sennum);
+
+    std::unique_ptr<pending_sensor_reading_t> pending(
+            new pending_sensor_reading_t{iter->second.coefficientM,
+                                         iter->second.scaledOffset,
+                                         std::move(responder),
+                                         a.path,
+                                         a.interface});
+
+    // The budget of the sensor's interface, capped to the request's
+    // deadline as for the synchronous calls.
+    auto timeout = ipmi::timeout::get(a.interface);
+    if (timeout == 0) {
+        ipmi::timeout::abandoned();
+        r = -ETIMEDOUT;
+    } else {
+        r = sd_bus_message_new_method_call(bus, &m, a.bus, a.path,
+                                           ipmi::PROP_INTF, "Get");
+    }
+    if (r >= 0) {
+        r = sd_bus_message_append(m, "ss", a.interface, "Value");
+    }
+    if (r >= 0) {
+        r = sd_bus_call_async(bus, NULL, m, sensor_value_reply,
+                              pending.get(), timeout);
+    }
+    m = sd_bus_message_unref(m);
+
+    if (r < 0) {
+        fprintf(stderr, "Failed to get the value of sensor 0x%02x: %s\n",
+                reqptr->sennum, strerror(-r));
+        pending->responder(IPMI_CC_SENSOR_INVALID, {});
+        return;
+    }
+
+    // Owned by the pending call now.
+    pending.release();
+}
+
 ipmi_ret_t ipmi_sen_wildcard(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                              ipmi_request_t request, ipmi_response_t response,
                              ipmi_data_len_t data_len, ipmi_context_t context)
@@ -648,8 +811,9 @@ ipmi_ret_t ipmi_sen_get_sdr_info(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                  ipmi_data_len_t data_len,
                                  ipmi_context_t context)
 {
+    ipmi::RequestView req(request, *data_len);
     auto resp = static_cast<get_sdr_info::GetSdrInfoResp*>(response);
-    if (request == nullptr ||
+    if (req.size() == 0 ||
         get_sdr_info::request::get_count(request) == false)
     {
         // Get Sensor Count
@@ -681,10 +845,9 @@ ipmi_ret_t ipmi_sen_reserve_sdr(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 {
     // A constant reservation ID is okay until we implement add/remove SDR.
     const uint16_t reservation_id = 1;
-    *(uint16_t*)response = reservation_id;
-    *data_len = sizeof(uint16_t);
+    ipmi::ResponseView(response, data_len).pack(reservation_id);
 
-    printf("Created new IPMI SDR reservation ID %d\n", *(uint16_t*)response);
+    printf("Created new IPMI SDR reservation ID %d\n", reservation_id);
     return IPMI_CC_OK;
 }
 
@@ -699,10 +862,16 @@ void setUnitFieldsForObject(sd_bus *bus,
         std::string result {};
         if (info->unit.empty())
         {
-            char *raw_cstr = NULL;
-            if (0 > sd_bus_get_property_string(bus, iface.bus, iface.path,
-                                               iface.interface, "Unit", NULL,
-                                               &raw_cstr))
+            sd_bus_message *reply = NULL;
+            const char *raw_cstr = NULL;
+            auto r = ipmi::callMethod(bus, iface.bus, iface.path,
+                                      ipmi::PROP_INTF, "Get", NULL, &reply,
+                                      "ss", iface.interface, "Unit");
+            if (r >= 0)
+            {
+                r = sd_bus_message_read(reply, "v", "s", &raw_cstr);
+            }
+            if (r < 0)
             {
                 log<level::WARNING>("Unit interface missing.",
                                     entry("BUS=%s", iface.bus),
@@ -712,7 +881,7 @@ void setUnitFieldsForObject(sd_bus *bus,
             {
                 result = raw_cstr;
             }
-            free(raw_cstr);
+            sd_bus_message_unref(reply);
         }
         else
         {
@@ -771,18 +940,20 @@ int64_t getScaleForObject(sd_bus *bus,
         }
         else
         {
-            if (0 > sd_bus_get_property_trivial(bus,
-                                                iface.bus,
-                                                iface.path,
-                                                iface.interface,
-                                                "Scale",
-                                                NULL,
-                                                'x',
-                                                &result)) {
+            sd_bus_message *reply = NULL;
+            auto r = ipmi::callMethod(bus, iface.bus, iface.path,
+                                      ipmi::PROP_INTF, "Get", NULL, &reply,
+                                      "ss", iface.interface, "Scale");
+            if (r >= 0)
+            {
+                r = sd_bus_message_read(reply, "v", "x", &result);
+            }
+            if (r < 0) {
                 log<level::WARNING>("Scale interface missing.",
                                     entry("BUS=%s", iface.bus),
                                     entry("PATH=%s", iface.path));
             }
+            sd_bus_message_unref(reply);
         }
     }
 
@@ -841,58 +1012,69 @@ ipmi_ret_t ipmi_sen_get_sdr(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                             ipmi_data_len_t data_len, ipmi_context_t context)
 {
     ipmi_ret_t ret = IPMI_CC_OK;
-    get_sdr::GetSdrReq *req = (get_sdr::GetSdrReq*)request;
+    ipmi::RequestView view(request, *data_len);
+    auto req = view.get<get_sdr::GetSdrReq>();
     get_sdr::GetSdrResp *resp = (get_sdr::GetSdrResp*)response;
     get_sdr::SensorDataFullRecord record = {0};
-    if (req != NULL)
+    *data_len = 0;
+    if (req == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
+    if (req->offset > sizeof(record))
     {
-        // Note: we use an iterator so we can provide the next ID at the end of
-        // the call.
-        auto sensor = sensors.begin();
+        return IPMI_CC_PARM_OUT_OF_RANGE;
+    }
 
-        // At the beginning of a scan, the host side will send us id=0.
-        if (get_sdr::request::get_record_id(req) != 0)
-        {
-            sensor = sensors.find(get_sdr::request::get_record_id(req));
-            if(sensor == sensors.end()) {
-                return IPMI_CC_SENSOR_INVALID;
-            }
-        }
+    // Note: we use an iterator so we can provide the next ID at the end of
+    // the call.
+    auto sensor = sensors.begin();
 
-        uint8_t sensor_id = sensor->first;
+    // At the beginning of a scan, the host side will send us id=0.
+    if (get_sdr::request::get_record_id(req) != 0)
+    {
+        sensor = sensors.find(get_sdr::request::get_record_id(req));
+        if(sensor == sensors.end()) {
+            return IPMI_CC_SENSOR_INVALID;
+        }
+    }
 
-        /* Header */
-        get_sdr::header::set_record_id(sensor_id, &(record.header));
-        record.header.sdr_version = 0x51; // Based on IPMI Spec v2.0 rev 1.1
-        record.header.record_type = get_sdr::SENSOR_DATA_FULL_RECORD;
-        record.header.record_length = sizeof(get_sdr::SensorDataFullRecord);
+    uint8_t sensor_id = sensor->first;
 
-        /* Key */
-        record.key.sensor_number = sensor_id;
+    /* Header */
+    get_sdr::header::set_record_id(sensor_id, &(record.header));
+    record.header.sdr_version = 0x51; // Based on IPMI Spec v2.0 rev 1.1
+    record.header.record_type = get_sdr::SENSOR_DATA_FULL_RECORD;
+    record.header.record_length = sizeof(get_sdr::SensorDataFullRecord);
 
-        /* Body */
-        record.body.entity_id = sensor_id;
-        record.body.sensor_type = sensor->second.sensorType;
-        record.body.event_reading_type = sensor->second.sensorReadingType;
+    /* Key */
+    record.key.sensor_number = sensor_id;
 
-        // Set the type-specific details given the DBus interface
-        ret = populate_record_from_dbus(&(record.body), &(sensor->second),
-                                        data_len);
+    /* Body */
+    record.body.entity_id = sensor_id;
+    record.body.sensor_type = sensor->second.sensorType;
+    record.body.event_reading_type = sensor->second.sensorReadingType;
 
-        if (++sensor == sensors.end())
-        {
-            get_sdr::response::set_next_record_id(0xFFFF, resp); // last record
-        }
-        else
-        {
-            get_sdr::response::set_next_record_id(sensor->first, resp);
-        }
+    // Set the type-specific details given the DBus interface
+    ret = populate_record_from_dbus(&(record.body), &(sensor->second),
+                                    data_len);
 
-        *data_len = sizeof(get_sdr::GetSdrResp) - req->offset;
-        memcpy(resp->record_data, (char*)&record + req->offset,
-               sizeof(get_sdr::SensorDataFullRecord) - req->offset);
+    if (++sensor == sensors.end())
+    {
+        get_sdr::response::set_next_record_id(0xFFFF, resp); // last record
+    }
+    else
+    {
+        get_sdr::response::set_next_record_id(sensor->first, resp);
     }
 
+    // The next record ID followed by the record from the offset on.
+    *data_len = sizeof(resp->next_record_id_lsb) +
+                sizeof(resp->next_record_id_msb) +
+                sizeof(record) - req->offset;
+    memcpy(resp->record_data, (char*)&record + req->offset,
+           sizeof(get_sdr::SensorDataFullRecord) - req->offset);
+
     return ret;
 }
 
@@ -923,9 +1105,10 @@ void register_netfn_sen_functions()
     // <Get Sensor Reading>
     printf("Registering NetFn:[0x%X], Cmd:[0x%X]\n",
            NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING);
-    ipmi_register_callback(NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING,
-                           nullptr, ipmi_sen_get_sensor_reading,
-                           PRIVILEGE_USER);
+    ipmi_register_async_callback(NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING,
+                                 nullptr, ipmi_sen_get_sensor_reading_async,
+                                 PRIVILEGE_USER);
+    ipmi_register_read_only(NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING);
 
     // <Reserve SDR>
     printf("Registering NetFn:[0x%X], Cmd:[0x%X]\n",
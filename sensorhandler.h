@@ -103,12 +103,12 @@ struct GetSdrReq
 namespace request
 {
 
-inline uint8_t get_reservation_id(GetSdrReq* req)
+inline uint8_t get_reservation_id(const GetSdrReq* req)
 {
     return (req->reservation_id_lsb + (req->reservation_id_msb << 8));
 };
 
-inline uint8_t get_record_id(GetSdrReq* req)
+inline uint8_t get_record_id(const GetSdrReq* req)
 {
     return (req->record_id_lsb + (req->record_id_msb << 8));
 };
@@ -1,3 +1,4 @@
+#include <string.h>
 #include <phosphor-logging/elog-errors.hpp>
 #include <phosphor-logging/log.hpp>
 #include "xyz/openbmc_project/Common/error.hpp"
@@ -14,81 +15,136 @@ constexpr auto mapperService = "xyz.openbmc_project.ObjectMapper";
 constexpr auto mapperPath = "/xyz/openbmc_project/object_mapper";
 constexpr auto mapperIntf = "xyz.openbmc_project.ObjectMapper";
 
+namespace
+{
+
+/** @struct Fetch
+ *  @brief A pending Objects::fetch()
+ */
+struct Fetch
+{
+    sdbusplus::bus::bus& bus;
+    Objects::Fetched done;
+};
+
+} // namespace
+
 Objects::Objects(sdbusplus::bus::bus& bus,
                  const std::vector<Interface>& filter):
     bus(bus)
 {
-    auto depth = 0;
-
-    auto mapperCall = bus.new_method_call(mapperService,
-                                          mapperPath,
-                                          mapperIntf,
-                                          "GetSubTree");
-    mapperCall.append(root);
-    mapperCall.append(depth);
-    mapperCall.append(filter);
-    auto response = bus.call(mapperCall);
+    auto mapperCall = subTreeCall(bus, filter);
+    auto response = ipmi::call(bus, mapperCall);
     if (response.is_method_error())
     {
         log<level::ERR>("Error in mapper GetSubTree");
         elog<InternalFailure>();
     }
 
-    using Interfaces = std::vector<Interface>;
-    using MapperResponse = std::map<Path, std::map<Service, Interfaces>>;
-    MapperResponse result;
-    response.read(result);
-    if (result.empty())
+    if (!read(response.get()))
     {
         log<level::ERR>("Invalid response from mapper");
         elog<InternalFailure>();
     }
+}
 
-    for (auto& iter : result)
+void Objects::fetch(sdbusplus::bus::bus& bus,
+                    const std::vector<Interface>& filter,
+                    Fetched&& done)
+{
+    auto mapperCall = subTreeCall(bus, filter);
+    auto pending = new Fetch{bus, std::move(done)};
+    auto r = sd_bus_call_async(bus.get(), nullptr, mapperCall.get(),
+                               onSubTree, pending,
+                               ipmi::timeout::get(mapperIntf));
+    if (r < 0)
     {
-        const auto& path = iter.first;
-        for (auto& interface : iter.second.begin()->second)
-        {
-            auto found = map.find(interface);
-            if (map.end() != found)
-            {
-                auto& paths = found->second;
-                paths.push_back(path);
-            }
-            else
-            {
-                map.emplace(std::move(interface), std::vector<Path>({path}));
-            }
-        }
+        log<level::ERR>("Failed to call mapper GetSubTree",
+                        entry("ERROR=%s", strerror(-r)));
+        std::unique_ptr<Fetch> failed(pending);
+        failed->done(nullptr);
     }
 }
 
-Service Objects::service(const Path& path, const Interface& interface) const
+sdbusplus::message::message Objects::subTreeCall(
+    sdbusplus::bus::bus& bus, const std::vector<Interface>& filter)
 {
-    using Interfaces = std::vector<Interface>;
+    auto depth = 0;
+
     auto mapperCall = bus.new_method_call(mapperService,
                                           mapperPath,
                                           mapperIntf,
-                                          "GetObject");
-    mapperCall.append(path);
-    mapperCall.append(Interfaces({interface}));
+                                          "GetSubTree");
+    mapperCall.append(root);
+    mapperCall.append(depth);
+    mapperCall.append(filter);
+    return mapperCall;
+}
 
-    auto response = bus.call(mapperCall);
-    if (response.is_method_error())
+bool Objects::read(sd_bus_message* reply)
+{
+    // The interfaces of the first service of every object
+    std::string previous;
+    auto r = ipmi::visitSubTree(
+                 reply,
+                 [this, &previous](const char* path, const char* service,
+                                   const std::vector<const char*>& interfaces)
+                 {
+                     if (previous == path)
+                     {
+                         return false;
+                     }
+                     previous = path;
+
+                     for (auto interface : interfaces)
+                     {
+                         map[interface].emplace_back(path);
+                     }
+                     return false;
+                 });
+    return r >= 0 && !map.empty();
+}
+
+int Objects::onSubTree(sd_bus_message* reply, void* userData,
+                       sd_bus_error* error)
+{
+    std::unique_ptr<Fetch> pending(static_cast<Fetch*>(userData));
+    std::unique_ptr<Objects> objects(new Objects(pending->bus));
+
+    if (sd_bus_message_is_method_error(reply, nullptr))
     {
-        log<level::ERR>("Error in mapper GetObject");
-        elog<InternalFailure>();
+        auto e = sd_bus_message_get_error(reply);
+        log<level::ERR>("Error in mapper GetSubTree",
+                        entry("ERROR=%s", e->message ? e->message : e->name));
+        objects.reset();
     }
-
-    std::map<Service, Interfaces> result;
-    response.read(result);
-    if (result.empty())
+    else if (!objects->read(reply))
     {
         log<level::ERR>("Invalid response from mapper");
+        objects.reset();
+    }
+
+    pending->done(std::move(objects));
+    return 0;
+}
+
+Service Objects::service(const Path& path, const Interface& interface) const
+{
+    Service result;
+    try
+    {
+        result = ipmi::getService(bus, interface, path);
+    }
+    catch (const std::exception& e)
+    {
+        log<level::ERR>("Error in mapper GetObject",
+                        entry("PATH=%s", path.c_str()),
+                        entry("INTERFACE=%s", interface.c_str()),
+                        entry("ERROR=%s", e.what()));
         elog<InternalFailure>();
     }
 
-    return result.begin()->first;
+    return result;
 }
 
 namespace boot
@@ -125,7 +181,7 @@ std::tuple<Path, OneTimeEnabled> setting(const Objects& objects,
             ipmi::PROP_INTF,
             "Get");
     method.append(enabledIntf, "Enabled");
-    auto reply = objects.bus.call(method);
+    auto reply = ipmi::call(objects.bus, method);
     if (reply.is_method_error())
     {
         log<level::ERR>("Error in getting Enabled property",
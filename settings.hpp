@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <sdbusplus/bus.hpp>
@@ -11,7 +13,8 @@ using Path = std::string;
 using Service = std::string;
 using Interface = std::string;
 
-constexpr auto root = "/";
+/** @brief Where the settings daemon hosts the settings */
+constexpr auto root = "/xyz/openbmc_project/control";
 
 /** @class Objects
  *  @brief Fetch paths of settings d-bus objects of interest, upon construction
@@ -19,6 +22,13 @@ constexpr auto root = "/";
 struct Objects
 {
     public:
+        /** @brief Completion of fetch()
+         *
+         * @param[in] objects - The settings objects, nullptr if they could
+         *            not be fetched.
+         */
+        using Fetched = std::function<void(std::unique_ptr<Objects>&& objects)>;
+
         /** @brief Constructor - fetch settings objects
          *
          * @param[in] bus - The Dbus bus object
@@ -32,9 +42,23 @@ struct Objects
         Objects& operator=(Objects&&) = delete;
         ~Objects() = default;
 
-        /** @brief Fetch d-bus service, given a path and an interface. The
-         *         service can't be cached because mapper returns unique
-         *         service names.
+        /** @brief Fetch settings objects without waiting for the mapper
+         *
+         * The reply is handled from the event loop of the bus, see
+         * ipmi::init::Once.
+         *
+         * @param[in] bus - The Dbus bus object, attached to an event loop.
+         * @param[in] filter - A vector of settings interfaces the caller is
+         *            interested in.
+         * @param[in] done - Completion.
+         */
+        static void fetch(sdbusplus::bus::bus& bus,
+                          const std::vector<Interface>& filter,
+                          Fetched&& done);
+
+        /** @brief Fetch d-bus service, given a path and an interface,
+         *         through ipmi::getService(). Unique service names are
+         *         dropped from its cache when their connection goes away.
          *
          * @param[in] path - The Dbus object
          * @param[in] interface - The Dbus interface
@@ -48,6 +72,23 @@ struct Objects
 
         /** @brief The Dbus bus object */
         sdbusplus::bus::bus& bus;
+
+    private:
+        explicit Objects(sdbusplus::bus::bus& bus) : bus(bus) {}
+
+        /** @brief Mapper GetSubTree call for the settings objects */
+        static sdbusplus::message::message subTreeCall(
+            sdbusplus::bus::bus& bus, const std::vector<Interface>& filter);
+
+        /** @brief Fills map from the mapper's GetSubTree reply
+         *
+         * @return false if the reply is not valid.
+         */
+        bool read(sd_bus_message* reply);
+
+        /** @brief Completion of the GetSubTree call of fetch() */
+        static int onSubTree(sd_bus_message* reply, void* userData,
+                             sd_bus_error* error);
 };
 
 namespace boot
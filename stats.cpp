@@ -0,0 +1,292 @@
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <phosphor-logging/log.hpp>
+#include "dispatch.hpp"
+#include "retransmit.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+namespace ipmi
+{
+namespace stats
+{
+
+using namespace phosphor::logging;
+
+namespace
+{
+
+/** @brief Statistics, indexed like the dispatch table. Allocated on the
+ *         first response to a command.
+ */
+std::array<std::unique_ptr<Command>,
+           dispatch::maxNetFn * dispatch::maxCmd> commands;
+
+sd_bus_slot* objectSlot = nullptr;
+
+sd_event_source* dumpSource = nullptr;
+
+std::chrono::microseconds dumpPeriod;
+
+SELReadAhead selReadAhead;
+
+/** @brief Calls func(netfn, cmd, command) for every command with
+ *         statistics
+ */
+template <typename Func>
+void forEach(Func func)
+{
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        if (commands[i])
+        {
+            func(static_cast<uint8_t>(i / dispatch::maxCmd),
+                 static_cast<uint8_t>(i % dispatch::maxCmd), *commands[i]);
+        }
+    }
+}
+
+int getCommands(sd_bus_message* m, void* userData, sd_bus_error* retError)
+{
+    sd_bus_message* reply = nullptr;
+    auto r = sd_bus_message_new_method_return(m, &reply);
+    if (r < 0)
+    {
+        return r;
+    }
+
+    r = sd_bus_message_open_container(reply, 'a', "(yytttta(yt))");
+    forEach([&r, reply](uint8_t netfn, uint8_t cmd, const Command& command)
+    {
+        if (r < 0)
+        {
+            return;
+        }
+
+        const auto& latency = command.latency;
+        r = sd_bus_message_open_container(reply, 'r', "yytttta(yt)");
+        if (r >= 0)
+        {
+            r = sd_bus_message_append(reply, "yytttt", netfn, cmd,
+                                      latency.count(),
+                                      latency.percentile(50),
+                                      latency.percentile(99),
+                                      latency.max());
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_open_container(reply, 'a', "(yt)");
+        }
+        for (const auto& cc : command.completionCodes)
+        {
+            if (r >= 0)
+            {
+                r = sd_bus_message_append(reply, "(yt)", cc.first, cc.second);
+            }
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_close_container(reply);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_close_container(reply);
+        }
+    });
+    if (r >= 0)
+    {
+        r = sd_bus_message_close_container(reply);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_send(nullptr, reply, nullptr);
+    }
+
+    sd_bus_message_unref(reply);
+    return r;
+}
+
+int resetCommands(sd_bus_message* m, void* userData, sd_bus_error* retError)
+{
+    reset();
+    timeout::resetStats();
+    retransmit::cache().resetStats();
+    if (selReadAhead.reset)
+    {
+        selReadAhead.reset();
+    }
+    return sd_bus_reply_method_return(m, "");
+}
+
+int getCallTimeouts(sd_bus_message* m, void* userData, sd_bus_error* retError)
+{
+    auto timeouts = timeout::stats();
+    return sd_bus_reply_method_return(m, "tt", timeouts.timedOut,
+                                      timeouts.abandoned);
+}
+
+int getRetransmits(sd_bus_message* m, void* userData, sd_bus_error* retError)
+{
+    auto retries = retransmit::cache().stats();
+    return sd_bus_reply_method_return(m, "tt", retries.answered,
+                                      retries.inProgress);
+}
+
+int getSELReadAhead(sd_bus_message* m, void* userData, sd_bus_error* retError)
+{
+    std::array<uint64_t, 4> counters{};
+    if (selReadAhead.get)
+    {
+        counters = selReadAhead.get();
+    }
+    return sd_bus_reply_method_return(m, "tttt", counters[0], counters[1],
+                                      counters[2], counters[3]);
+}
+
+const sd_bus_vtable vtable[] =
+{
+    SD_BUS_VTABLE_START(0),
+    // Returns [NetFn, Cmd, responses, p50 us, p99 us, max us,
+    //          [completion code, responses]] for every command seen.
+    SD_BUS_METHOD("GetCommands", "", "a(yytttta(yt))", getCommands,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    // Returns [D-Bus calls timed out, calls and requests dropped because
+    //          the deadline of their request passed].
+    SD_BUS_METHOD("GetCallTimeouts", "", "tt", getCallTimeouts,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    // Returns [retries answered with the response to their request,
+    //          retries dropped while their request was being handled].
+    SD_BUS_METHOD("GetRetransmits", "", "tt", getRetransmits,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    // Returns [SEL entries converted ahead of a walk, walk steps served
+    //          from them, walk steps that converted their entry, entries
+    //          converted ahead and never read].
+    SD_BUS_METHOD("GetSELReadAhead", "", "tttt", getSELReadAhead,
+                  SD_BUS_VTABLE_UNPRIVILEGED),
+    SD_BUS_METHOD("Reset", "", "", resetCommands, 0),
+    SD_BUS_VTABLE_END
+};
+
+/** @brief Writes the statistics to dumpPath, through a rename so readers
+ *         never see a partial file.
+ */
+void dump()
+{
+    auto tmpPath = std::string(dumpPath) + ".tmp";
+    auto file = fopen(tmpPath.c_str(), "w");
+    if (file == nullptr)
+    {
+        log<level::ERR>("Failed to open the statistics file",
+                        entry("PATH=%s", tmpPath.c_str()));
+        return;
+    }
+
+    fprintf(file, "netfn cmd count p50_us p99_us max_us completion_codes\n");
+    forEach([file](uint8_t netfn, uint8_t cmd, const Command& command)
+    {
+        const auto& latency = command.latency;
+        fprintf(file, "0x%02x 0x%02x %llu %llu %llu %llu", netfn, cmd,
+                static_cast<unsigned long long>(latency.count()),
+                static_cast<unsigned long long>(latency.percentile(50)),
+                static_cast<unsigned long long>(latency.percentile(99)),
+                static_cast<unsigned long long>(latency.max()));
+        for (const auto& cc : command.completionCodes)
+        {
+            fprintf(file, " %02x:%llu", cc.first,
+                    static_cast<unsigned long long>(cc.second));
+        }
+        fprintf(file, "\n");
+    });
+
+    if (fclose(file) != 0 || rename(tmpPath.c_str(), dumpPath) != 0)
+    {
+        log<level::ERR>("Failed to write the statistics file",
+                        entry("PATH=%s", dumpPath));
+    }
+}
+
+int dumpHandler(sd_event_source* source, uint64_t usec, void* userData)
+{
+    dump();
+
+    // Re-arm the timer for the next period
+    auto r = sd_event_source_set_time(source, usec + dumpPeriod.count());
+    if (r >= 0)
+    {
+        r = sd_event_source_set_enabled(source, SD_EVENT_ONESHOT);
+    }
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to re-arm the statistics dump",
+                        entry("ERROR=%s", strerror(-r)));
+    }
+    return 0;
+}
+
+} // namespace
+
+void record(uint8_t netfn, uint8_t cmd, uint8_t cc, uint64_t latencyUs)
+{
+    if (netfn >= dispatch::maxNetFn)
+    {
+        return;
+    }
+
+    auto& command = commands[(netfn * dispatch::maxCmd) + cmd];
+    if (!command)
+    {
+        command = std::make_unique<Command>();
+    }
+
+    command->latency.record(latencyUs);
+    ++command->completionCodes[cc];
+}
+
+void setSELReadAhead(SELReadAhead&& source)
+{
+    selReadAhead = std::move(source);
+}
+
+void reset()
+{
+    for (auto& command : commands)
+    {
+        command.reset();
+    }
+}
+
+int exportObject(sd_bus* bus)
+{
+    auto r = sd_bus_add_object_vtable(bus, &objectSlot, objectPath, interface,
+                                      vtable, nullptr);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to export the IPMI statistics",
+                        entry("ERROR=%s", strerror(-r)));
+    }
+    return r;
+}
+
+int startPeriodicDump(sd_event* event, unsigned periodSec)
+{
+    using namespace std::chrono;
+    dumpPeriod = duration_cast<microseconds>(seconds(periodSec));
+
+    auto now = duration_cast<microseconds>(
+                   steady_clock::now().time_since_epoch());
+    auto r = sd_event_add_time(event, &dumpSource, CLOCK_MONOTONIC,
+                               (now + dumpPeriod).count(), 0, dumpHandler,
+                               nullptr);
+    if (r < 0)
+    {
+        log<level::ERR>("Failed to start the statistics dump",
+                        entry("ERROR=%s", strerror(-r)));
+    }
+    return r;
+}
+
+} // namespace stats
+} // namespace ipmi
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <systemd/sd-bus.h>
+#include <systemd/sd-event.h>
+
+namespace ipmi
+{
+namespace stats
+{
+
+/** @brief Object exporting the statistics on ipmid's bus connection */
+constexpr auto objectPath = "/org/openbmc/HostIpmi/Statistics";
+
+/** @brief Interface of objectPath */
+constexpr auto interface = "org.openbmc.HostIpmi.Statistics";
+
+/** @brief File the statistics are periodically dumped to, if enabled */
+constexpr auto dumpPath = "/run/ipmid-stats";
+
+/** @class Histogram
+ *  @brief Log-linear latency histogram.
+ *
+ *  Values below 8 have a bucket each. Above, every power of two is split
+ *  in 8 buckets, so a value is known within 12.5% of its magnitude.
+ */
+class Histogram
+{
+    public:
+        /** @brief Buckets per power of two */
+        static constexpr unsigned subBuckets = 8;
+
+        /** @brief log2(subBuckets) */
+        static constexpr unsigned subBits = 3;
+
+        /** @brief Largest power of two tracked, about 9 hours in us */
+        static constexpr unsigned maxExponent = 35;
+
+        static constexpr size_t buckets =
+            subBuckets + (maxExponent - subBits + 1) * subBuckets;
+
+        /** @brief Records a value */
+        void record(uint64_t value)
+        {
+            ++counts[index(value)];
+            ++total;
+            largest = std::max(largest, value);
+        }
+
+        uint64_t count() const
+        {
+            return total;
+        }
+
+        uint64_t max() const
+        {
+            return largest;
+        }
+
+        /** @brief Estimates a percentile
+         *
+         *  @param[in] percent - Percentile, from 0 to 100.
+         *
+         *  @return The upper bound of the bucket holding the percentile,
+         *          capped to the largest value, or 0 if empty.
+         */
+        uint64_t percentile(double percent) const
+        {
+            if (total == 0)
+            {
+                return 0;
+            }
+
+            auto rank = static_cast<uint64_t>(percent / 100 * total + 0.5);
+            rank = std::max<uint64_t>(rank, 1);
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets; ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                {
+                    return std::min(upperBound(i), largest);
+                }
+            }
+            return largest;
+        }
+
+        /** @brief Bucket a value is counted in */
+        static size_t index(uint64_t value)
+        {
+            if (value < subBuckets)
+            {
+                return value;
+            }
+
+            unsigned exponent = 63 - __builtin_clzll(value);
+            if (exponent > maxExponent)
+            {
+                return buckets - 1;
+            }
+
+            auto sub = (value >> (exponent - subBits)) & (subBuckets - 1);
+            return subBuckets + (exponent - subBits) * subBuckets + sub;
+        }
+
+        /** @brief Largest value counted in a bucket */
+        static uint64_t upperBound(size_t index)
+        {
+            if (index < subBuckets)
+            {
+                return index;
+            }
+
+            auto shift = (index - subBuckets) / subBuckets;
+            auto sub = (index - subBuckets) % subBuckets;
+            return ((subBuckets + sub + 1) << shift) - 1;
+        }
+
+    private:
+        std::array<uint32_t, buckets> counts{};
+        uint64_t total = 0;
+        uint64_t largest = 0;
+};
+
+/** @struct Command
+ *  @brief Statistics of a single [NetFn, Cmd] pair.
+ */
+struct Command
+{
+    Histogram latency;                          //!< Handling time, in us.
+    std::map<uint8_t, uint64_t> completionCodes; //!< Responses per code.
+};
+
+/** @struct SELReadAhead
+ *  @brief Counters of the SEL read ahead, kept by the storage provider and
+ *         exported along with ipmid's own.
+ */
+struct SELReadAhead
+{
+    /** @brief Returns [entries converted ahead, walk steps served from
+     *         them, walk steps that converted their entry, entries
+     *         converted ahead and never read].
+     */
+    std::function<std::array<uint64_t, 4>()> get;
+
+    /** @brief Drops the counters */
+    std::function<void()> reset;
+};
+
+/** @brief Sets where GetSELReadAhead reads its counters from, they read as
+ *         0 until then.
+ */
+void setSELReadAhead(SELReadAhead&& source);
+
+/** @brief Accounts for a response
+ *
+ *  @param[in] netfn - Network function of the request.
+ *  @param[in] cmd - Command.
+ *  @param[in] cc - Completion code of the response.
+ *  @param[in] latencyUs - Time from request to response.
+ */
+void record(uint8_t netfn, uint8_t cmd, uint8_t cc, uint64_t latencyUs);
+
+/** @brief Drops all statistics */
+void reset();
+
+/** @brief Exports the statistics on D-Bus, at objectPath
+ *
+ *  @param[in] bus - ipmid's bus connection.
+ *
+ *  @return 0 on success, a negative errno otherwise.
+ */
+int exportObject(sd_bus* bus);
+
+/** @brief Dumps the statistics to dumpPath every period
+ *
+ *  @param[in] event - sd_event loop to run the dump from.
+ *  @param[in] periodSec - Period, in seconds.
+ *
+ *  @return 0 on success, a negative errno otherwise.
+ */
+int startPeriodicDump(sd_event* event, unsigned periodSec);
+
+} // namespace stats
+} // namespace ipmi
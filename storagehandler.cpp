@@ -2,9 +2,11 @@
 #include <arpa/inet.h>
 #include <chrono>
 #include <cstdio>
-#include <experimental/filesystem>
+#include <errno.h>
+#include <memory>
 #include <mapper.h>
 #include <string>
+#include <string.h>
 #include <systemd/sd-bus.h>
 
 #include <phosphor-logging/log.hpp>
@@ -12,8 +14,14 @@
 #include <sdbusplus/server.hpp>
 
 #include "host-ipmid/ipmid-api.h"
+#include "host-ipmid/ipmid-async.hpp"
+#include "host-ipmid/ipmid-view.hpp"
 #include "read_fru_data.hpp"
+#include "selindex.hpp"
+#include "selreadahead.hpp"
+#include "selstore.hpp"
 #include "selutility.hpp"
+#include "stats.hpp"
 #include "storageaddsel.h"
 #include "storagehandler.h"
 #include "utils.hpp"
@@ -40,22 +48,6 @@ const char* getTimeString(const uint64_t& usecSinceEpoch)
 }
 }
 
-namespace cache
-{
-    /*
-     * This cache contains the object paths of the logging entries sorted in the
-     * order of the filename(numeric order). The cache is initialized by
-     * invoking readLoggingObjectPaths with the cache as the parameter. The
-     * cache is invoked in the execution of the Get SEL info and Delete SEL
-     * entry command. The Get SEL Info command is typically invoked before the
-     * Get SEL entry command, so the cache is utilized for responding to Get SEL
-     * entry command. The cache is invalidated by clearing after Delete SEL
-     * entry and Clear SEL command.
-     */
-    ipmi::sel::ObjectPaths paths;
-
-} // namespace objectPathsCache
-
 using InternalFailure =
         sdbusplus::xyz::openbmc_project::Common::Error::InternalFailure;
 using namespace phosphor::logging;
@@ -82,32 +74,255 @@ ipmi_ret_t ipmi_storage_wildcard(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     return rc;
 }
 
+namespace
+{
+
+/** @brief Deadline of the log entry deletes of a Clear SEL command */
+constexpr auto clearSELTimeout = std::chrono::seconds(30);
+
+/** @brief Whether the erase started by a Clear SEL command is running */
+bool eraseRunning = false;
+
+/** @brief Whether the last erase failed, until another one is initiated */
+bool eraseFailed = false;
+
+/** @brief Time of the last erase, for Get SEL Info */
+uint32_t eraseTimeStamp = ipmi::sel::invalidTimeStamp;
+
+uint8_t eraseProgress()
+{
+    return eraseRunning ? ipmi::sel::eraseInProgress :
+                          ipmi::sel::eraseComplete;
+}
+
+void eraseDone(bool erased)
+{
+    eraseRunning = false;
+    eraseFailed = !erased;
+    if (erased)
+    {
+        // The records added through IPMI go once the log entries are gone.
+        ipmi::sel::store().clear();
+        eraseTimeStamp = static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+}
+
+/** @brief Erases the SEL one log entry at a time, the deletes in flight
+ *         together.
+ */
+void deleteEntries(sd_bus* bus, std::vector<ipmi::sel::EntryId>&& ids)
+{
+    sdbusplus::bus::bus dbus{bus};
+    std::string service;
+    try
+    {
+        service = ipmi::getService(dbus, ipmi::sel::logDeleteIntf,
+                                   ipmi::sel::entryPath(ids.front()));
+    }
+    catch (const std::runtime_error& e)
+    {
+        log<level::ERR>(e.what());
+        eraseDone(false);
+        return;
+    }
+
+    std::vector<ipmi::MethodCall> deletes;
+    deletes.reserve(ids.size());
+    for (auto id : ids)
+    {
+        deletes.push_back({service, ipmi::sel::entryPath(id),
+                           ipmi::sel::logDeleteIntf, "Delete"});
+    }
+
+    ipmi::fanOut(bus, std::move(deletes), clearSELTimeout,
+                 [ids](const std::vector<int>& results)
+                 {
+                     // The entries deleted, whatever the signals are behind.
+                     for (size_t i = 0; i < results.size(); ++i)
+                     {
+                         if (results[i] >= 0)
+                         {
+                             ipmi::sel::index().erase(ids[i]);
+                         }
+                     }
+
+                     auto failed = std::count_if(results.begin(),
+                                                 results.end(),
+                                                 [](int r)
+                                                 {
+                                                     return r < 0;
+                                                 });
+                     if (failed)
+                     {
+                         log<level::ERR>("Failed to delete SEL entries",
+                                         entry("FAILED=%zu",
+                                               static_cast<size_t>(failed)),
+                                         entry("TOTAL=%zu", results.size()));
+                     }
+                     eraseDone(failed == 0);
+                 });
+}
+
+/** @brief Erases the SEL with a single DeleteAll of the logging service,
+ *         falling back to deleteEntries() if it has none.
+ */
+void deleteAll(sd_bus* bus, std::vector<ipmi::sel::EntryId>&& ids)
+{
+    sdbusplus::bus::bus dbus{bus};
+    std::string service;
+    try
+    {
+        service = ipmi::getService(dbus, ipmi::sel::logDeleteAllIntf,
+                                   ipmi::sel::logObjPath);
+    }
+    catch (const std::runtime_error& e)
+    {
+        deleteEntries(bus, std::move(ids));
+        return;
+    }
+
+    std::vector<ipmi::MethodCall> calls{
+        {service, ipmi::sel::logObjPath, ipmi::sel::logDeleteAllIntf,
+         "DeleteAll"}};
+    ipmi::fanOut(bus, std::move(calls), clearSELTimeout,
+                 [bus, ids](const std::vector<int>& results) mutable
+                 {
+                     // Unknown method, interface or object
+                     if (results.front() == -EBADR)
+                     {
+                         deleteEntries(bus, std::move(ids));
+                         return;
+                     }
+
+                     if (results.front() < 0)
+                     {
+                         log<level::ERR>("Failed to delete the log entries",
+                                         entry("ERROR=%s",
+                                               strerror(-results.front())));
+                         eraseDone(false);
+                         return;
+                     }
+
+                     // Entries added since were deleted too, they leave the
+                     // index with their InterfacesRemoved signals.
+                     for (auto id : ids)
+                     {
+                         ipmi::sel::index().erase(id);
+                     }
+                     eraseDone(true);
+                 });
+}
+
+/** @brief First record ID of the SEL, of a log entry or of the store. The
+ *         SEL must not be empty.
+ */
+ipmi::sel::EntryId firstRecord(const ipmi::sel::Index& index,
+                               const ipmi::sel::Store& store)
+{
+    if (index.empty())
+    {
+        return store.first();
+    }
+    return store.empty() ? index.first() :
+           std::min<ipmi::sel::EntryId>(index.first(), store.first());
+}
+
+/** @brief Last record ID of the SEL, the SEL must not be empty */
+ipmi::sel::EntryId lastRecord(const ipmi::sel::Index& index,
+                              const ipmi::sel::Store& store)
+{
+    if (index.empty())
+    {
+        return store.last();
+    }
+    return store.empty() ? index.last() :
+           std::max<ipmi::sel::EntryId>(index.last(), store.last());
+}
+
+/** @brief Record ID after a record of the SEL, or lastEntry */
+uint16_t nextRecord(const ipmi::sel::Index& index,
+                    const ipmi::sel::Store& store, ipmi::sel::EntryId id)
+{
+    ipmi::sel::EntryId next = ipmi::sel::lastEntry;
+    ipmi::sel::EntryId logged = 0;
+    // From a log entry in constant time, the IDs of the store are searched.
+    auto found = index.contains(id) ? index.next(id, logged) :
+                                      index.after(id, logged);
+    if (found)
+    {
+        next = logged;
+    }
+
+    uint16_t stored = 0;
+    if (id < ipmi::sel::lastStoreId &&
+        store.after(static_cast<uint16_t>(id), stored) && stored < next)
+    {
+        next = stored;
+    }
+    return static_cast<uint16_t>(next);
+}
+
+/** @brief Tells whether a record ID is the one of a log entry */
+bool loggedId(uint16_t id)
+{
+    return ipmi::sel::index().contains(id);
+}
+
+/** @brief Reads the index of the log entries and opens the store
+ *
+ *  Log entry IDs count up and may reach the IDs of the store. The log
+ *  entries keep theirs, a store record whose ID a log entry took moves to a
+ *  free one, so that a record ID names one record.
+ */
+void openSEL(const ipmi::sel::Index& index, ipmi::sel::Store& store)
+{
+    ipmi::sel::watchIndex(ipmid_get_sd_bus_connection());
+    store.open();
+    if (index.empty() || store.empty() || index.last() < store.first())
+    {
+        return;
+    }
+    store.yield(loggedId);
+}
+
+} // namespace
+
 ipmi_ret_t getSELInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                       ipmi_request_t request, ipmi_response_t response,
                       ipmi_data_len_t data_len, ipmi_context_t context)
 {
-    std::vector<uint8_t> outPayload(sizeof(ipmi::sel::GetSELInfoResponse));
-    auto responseData = reinterpret_cast<ipmi::sel::GetSELInfoResponse*>
-            (outPayload.data());
+    ipmi::ResponseView resp(response, data_len);
+    ipmi::sel::GetSELInfoResponse info{};
+    auto responseData = &info;
 
     responseData->selVersion = ipmi::sel::selVersion;
-    // Last erase timestamp is not available from log manager.
-    responseData->eraseTimeStamp = ipmi::sel::invalidTimeStamp;
+    responseData->eraseTimeStamp = eraseTimeStamp;
     responseData->operationSupport = ipmi::sel::operationSupport;
 
-    ipmi::sel::readLoggingObjectPaths(cache::paths);
-    responseData->entries = 0;
-    responseData->addTimeStamp = ipmi::sel::invalidTimeStamp;
+    const auto& index = ipmi::sel::index();
+    auto& store = ipmi::sel::store();
+    openSEL(index, store);
+    responseData->entries = static_cast<uint16_t>(index.size() +
+                                                  store.size());
+    responseData->freeSpace = static_cast<uint16_t>(std::min<size_t>(
+        (store.capacity() - store.size()) * ipmi::sel::selRecordSize,
+        UINT16_MAX));
+    responseData->addTimeStamp = store.addTimeStamp();
 
-    if (!cache::paths.empty())
+    if (!index.empty())
     {
-        responseData->entries = static_cast<uint16_t>(cache::paths.size());
-
         try
         {
-            responseData->addTimeStamp = static_cast<uint32_t>(
-                    (ipmi::sel::getEntryTimeStamp(cache::paths.back())
-                    .count()));
+            auto logged = static_cast<uint32_t>(
+                    (ipmi::sel::getEntryTimeStamp(
+                         ipmi::sel::entryPath(index.last())).count()));
+            if (responseData->addTimeStamp == ipmi::sel::invalidTimeStamp ||
+                logged > responseData->addTimeStamp)
+            {
+                responseData->addTimeStamp = logged;
+            }
         }
         catch (InternalFailure& e)
         {
@@ -118,8 +333,7 @@ ipmi_ret_t getSELInfo(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         }
     }
 
-    memcpy(response, outPayload.data(), outPayload.size());
-    *data_len = outPayload.size();
+    resp.pack(info);
 
     return IPMI_CC_OK;
 }
@@ -128,100 +342,92 @@ ipmi_ret_t getSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                        ipmi_request_t request, ipmi_response_t response,
                        ipmi_data_len_t data_len, ipmi_context_t context)
 {
-    auto requestData = reinterpret_cast<const ipmi::sel::GetSELEntryRequest*>
-                   (request);
+    ipmi::RequestView req(request, *data_len);
+    ipmi::ResponseView resp(response, data_len);
+
+    auto requestData = req.get<ipmi::sel::GetSELEntryRequest>();
+    if (requestData == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
 
     if (requestData->reservationID != 0)
     {
         if (g_sel_reserve != requestData->reservationID)
         {
-            *data_len = 0;
             return IPMI_CC_INVALID_RESERVATION_ID;
         }
     }
 
-    if (cache::paths.empty())
+    // An index that could not be read is empty, the store still serves.
+    auto& index = ipmi::sel::index();
+    auto& store = ipmi::sel::store();
+    openSEL(index, store);
+    if (index.empty() && store.empty())
     {
-        *data_len = 0;
         return IPMI_CC_SENSOR_INVALID;
     }
 
-    ipmi::sel::ObjectPaths::const_iterator iter;
+    ipmi::sel::EntryId id = requestData->selRecordID;
 
     // Check for the requested SEL Entry.
     if (requestData->selRecordID == ipmi::sel::firstEntry)
     {
-        iter = cache::paths.begin();
+        id = firstRecord(index, store);
     }
     else if (requestData->selRecordID == ipmi::sel::lastEntry)
     {
-        iter = cache::paths.end();
+        id = lastRecord(index, store);
     }
-    else
+    else if (!index.contains(id) && !store.contains(id))
     {
-        std::string objPath = std::string(ipmi::sel::logBasePath) + "/" +
-                              std::to_string(requestData->selRecordID);
-
-        iter = std::find(cache::paths.begin(), cache::paths.end(), objPath);
-        if (iter == cache::paths.end())
-        {
-            *data_len = 0;
-            return IPMI_CC_SENSOR_INVALID;
-        }
+        return IPMI_CC_SENSOR_INVALID;
     }
 
     ipmi::sel::GetSELEntryResponse record {};
 
-    // Convert the log entry into SEL record.
-    try
+    // Records added through IPMI are stored as is, the log entries are
+    // converted into SEL records, once.
+    auto stored = store.get(id, record);
+    auto converted = !stored && !index.record(id, record);
+    if (converted)
     {
-        record = ipmi::sel::convertLogEntrytoSEL(*iter);
-    }
-    catch (InternalFailure& e)
-    {
-        *data_len = 0;
-        return IPMI_CC_UNSPECIFIED_ERROR;
-    }
-    catch (const std::runtime_error& e)
-    {
-        log<level::ERR>(e.what());
-        *data_len = 0;
-        return IPMI_CC_UNSPECIFIED_ERROR;
-    }
-
-
-    // Identify the next SEL record ID
-    if(iter != cache::paths.end())
-    {
-        ++iter;
-        if (iter == cache::paths.end())
+        try
         {
-            record.nextRecordID = ipmi::sel::lastEntry;
+            record = ipmi::sel::convertLogEntrytoSEL(
+                         ipmi::sel::entryPath(id));
         }
-        else
+        catch (InternalFailure& e)
         {
-            namespace fs = std::experimental::filesystem;
-            fs::path path(*iter);
-            record.nextRecordID = static_cast<uint16_t>
-                     (std::stoul(std::string(path.filename().c_str())));
+            return IPMI_CC_UNSPECIFIED_ERROR;
+        }
+        catch (const std::runtime_error& e)
+        {
+            log<level::ERR>(e.what());
+            return IPMI_CC_UNSPECIFIED_ERROR;
         }
+        index.keep(id, record);
     }
-    else
+
+    // While the host reads this one, convert the entries it reads next.
+    if (!stored)
     {
-        record.nextRecordID = ipmi::sel::lastEntry;
+        ipmi::sel::readAhead().served(ipmid_get_sd_bus_connection(), id,
+                                      converted);
     }
 
+    // Identify the next SEL record ID
+    record.nextRecordID = nextRecord(index, store, id);
+
     if (requestData->readLength == ipmi::sel::entireRecord)
     {
-        memcpy(response, &record, sizeof(record));
-        *data_len = sizeof(record);
+        resp.pack(record);
     }
     else
     {
         if (requestData->offset >= ipmi::sel::selRecordSize ||
             requestData->readLength > ipmi::sel::selRecordSize)
         {
-            *data_len = 0;
             return IPMI_CC_INVALID_FIELD_REQUEST;
         }
 
@@ -229,10 +435,10 @@ ipmi_ret_t getSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
         auto readLength = std::min(diff,
                                    static_cast<int>(requestData->readLength));
 
-        memcpy(response, &record.nextRecordID, sizeof(record.nextRecordID));
-        memcpy(static_cast<uint8_t*>(response) + sizeof(record.nextRecordID),
-               &record.recordID + requestData->offset, readLength);
-        *data_len = sizeof(record.nextRecordID) + readLength;
+        uint16_t nextRecordID = record.nextRecordID;
+        resp.pack(nextRecordID);
+        resp.append(reinterpret_cast<const uint8_t*>(&record.recordID) +
+                    requestData->offset, readLength);
     }
 
     return IPMI_CC_OK;
@@ -242,185 +448,150 @@ ipmi_ret_t deleteSELEntry(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                           ipmi_request_t request, ipmi_response_t response,
                           ipmi_data_len_t data_len, ipmi_context_t context)
 {
-    namespace fs = std::experimental::filesystem;
-    auto requestData = reinterpret_cast<const ipmi::sel::DeleteSELEntryRequest*>
-            (request);
+    ipmi::RequestView req(request, *data_len);
+    ipmi::ResponseView resp(response, data_len);
+
+    auto requestData = req.get<ipmi::sel::DeleteSELEntryRequest>();
+    if (requestData == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
 
     if (g_sel_reserve != requestData->reservationID)
     {
-        *data_len = 0;
         return IPMI_CC_INVALID_RESERVATION_ID;
     }
 
-    ipmi::sel::readLoggingObjectPaths(cache::paths);
-
-    if (cache::paths.empty())
+    auto& index = ipmi::sel::index();
+    auto& store = ipmi::sel::store();
+    openSEL(index, store);
+    if (index.empty() && store.empty())
     {
-        *data_len = 0;
         return IPMI_CC_SENSOR_INVALID;
     }
 
-    ipmi::sel::ObjectPaths::const_iterator iter;
-    uint16_t delRecordID = 0;
+    ipmi::sel::EntryId id = requestData->selRecordID;
 
     if (requestData->selRecordID == ipmi::sel::firstEntry)
     {
-        iter = cache::paths.begin();
-        fs::path path(*iter);
-        delRecordID = static_cast<uint16_t>
-                (std::stoul(std::string(path.filename().c_str())));
+        id = firstRecord(index, store);
     }
     else if (requestData->selRecordID == ipmi::sel::lastEntry)
     {
-        iter = cache::paths.end();
-        fs::path path(*iter);
-        delRecordID = static_cast<uint16_t>
-                (std::stoul(std::string(path.filename().c_str())));
+        id = lastRecord(index, store);
     }
-    else
+    else if (!index.contains(id) && !store.contains(id))
     {
-        std::string objPath = std::string(ipmi::sel::logBasePath) + "/" +
-                              std::to_string(requestData->selRecordID);
+        return IPMI_CC_SENSOR_INVALID;
+    }
 
-        iter = std::find(cache::paths.begin(), cache::paths.end(), objPath);
-        if (iter == cache::paths.end())
-        {
-            *data_len = 0;
-            return IPMI_CC_SENSOR_INVALID;
-        }
-        delRecordID = requestData->selRecordID;
+    uint16_t delRecordID = static_cast<uint16_t>(id);
+    if (store.erase(delRecordID))
+    {
+        resp.pack(delRecordID);
+        return IPMI_CC_OK;
     }
 
+    auto objPath = ipmi::sel::entryPath(id);
+
     sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
     std::string service;
 
     try
     {
-        service = ipmi::getService(bus, ipmi::sel::logDeleteIntf, *iter);
+        service = ipmi::getService(bus, ipmi::sel::logDeleteIntf, objPath);
     }
     catch (const std::runtime_error& e)
     {
         log<level::ERR>(e.what());
-        *data_len = 0;
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
 
     auto methodCall = bus.new_method_call(service.c_str(),
-                                          (*iter).c_str(),
+                                          objPath.c_str(),
                                           ipmi::sel::logDeleteIntf,
                                           "Delete");
-    auto reply = bus.call(methodCall);
+    auto reply = ipmi::call(bus, methodCall);
     if (reply.is_method_error())
     {
-        *data_len = 0;
         return IPMI_CC_UNSPECIFIED_ERROR;
     }
 
-    // Invalidate the cache of dbus entry objects.
-    cache::paths.clear();
-    memcpy(response, &delRecordID, sizeof(delRecordID));
-    *data_len = sizeof(delRecordID);
+    // Not waiting for InterfacesRemoved, the next command may come first.
+    index.erase(id);
+    resp.pack(delRecordID);
 
     return IPMI_CC_OK;
 }
 
-ipmi_ret_t clearSEL(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_request_t request,
-                    ipmi_response_t response, ipmi_data_len_t data_len,
-                    ipmi_context_t context)
+void clearSEL(ipmi_netfn_t netfn, ipmi_cmd_t cmd, ipmi_request_t request,
+              size_t len, ipmid_responder_t responder, ipmi_context_t context)
 {
+    if (len != sizeof(ipmi::sel::ClearSELRequest))
+    {
+        responder(IPMI_CC_REQ_DATA_LEN_INVALID, {});
+        return;
+    }
+
     auto requestData = reinterpret_cast<const ipmi::sel::ClearSELRequest*>
             (request);
 
     if (g_sel_reserve != requestData->reservationID)
     {
-        *data_len = 0;
-        return IPMI_CC_INVALID_RESERVATION_ID;
+        responder(IPMI_CC_INVALID_RESERVATION_ID, {});
+        return;
     }
 
     if (requestData->charC != 'C' ||
         requestData->charL != 'L' ||
         requestData->charR != 'R')
     {
-        *data_len = 0;
-        return IPMI_CC_INVALID_FIELD_REQUEST;
+        responder(IPMI_CC_INVALID_FIELD_REQUEST, {});
+        return;
     }
 
-    uint8_t eraseProgress = ipmi::sel::eraseComplete;
-
-    /*
-     * Erasure status cannot be fetched from DBUS, so always return erasure
-     * status as `erase completed`.
-     */
-    if (requestData->eraseOperation == ipmi::sel::getEraseStatus)
+    if (requestData->eraseOperation == ipmi::sel::getEraseStatus ||
+        eraseRunning)
     {
-        memcpy(response, &eraseProgress, sizeof(eraseProgress));
-        *data_len = sizeof(eraseProgress);
-        return IPMI_CC_OK;
+        // The erase progress has no failed state.
+        if (eraseFailed)
+        {
+            responder(IPMI_CC_UNSPECIFIED_ERROR, {});
+            return;
+        }
+        responder(IPMI_CC_OK, {eraseProgress()});
+        return;
     }
 
-    sdbusplus::bus::bus bus{ipmid_get_sd_bus_connection()};
-    auto depth = 0;
-
-    auto mapperCall = bus.new_method_call(ipmi::sel::mapperBusName,
-                                          ipmi::sel::mapperObjPath,
-                                          ipmi::sel::mapperIntf,
-                                          "GetSubTreePaths");
-    mapperCall.append(ipmi::sel::logBasePath);
-    mapperCall.append(depth);
-    mapperCall.append(ipmi::sel::ObjectPaths({ipmi::sel::logEntryIntf}));
-
-    auto reply = bus.call(mapperCall);
-    if (reply.is_method_error())
+    auto bus = ipmid_get_sd_bus_connection();
+    const auto& index = ipmi::sel::index();
+    if (!ipmi::sel::watchIndex(bus))
     {
-        memcpy(response, &eraseProgress, sizeof(eraseProgress));
-        *data_len = sizeof(eraseProgress);
-        return IPMI_CC_OK;
+        responder(IPMI_CC_UNSPECIFIED_ERROR, {});
+        return;
     }
 
-    ipmi::sel::ObjectPaths objectPaths;
-    reply.read(objectPaths);
-    if (objectPaths.empty())
+    if (index.empty())
     {
-        memcpy(response, &eraseProgress, sizeof(eraseProgress));
-        *data_len = sizeof(eraseProgress);
-        return IPMI_CC_OK;
+        eraseDone(true);
+        responder(IPMI_CC_OK, {ipmi::sel::eraseComplete});
+        return;
     }
 
-    std::string service;
-
-    try
-    {
-        service = ipmi::getService(bus,
-                                   ipmi::sel::logDeleteIntf,
-                                   objectPaths.front());
-    }
-    catch (const std::runtime_error& e)
-    {
-        log<level::ERR>(e.what());
-        *data_len = 0;
-        return IPMI_CC_UNSPECIFIED_ERROR;
-    }
+    // Answered right away, the host polls for the end of the erase. The
+    // requests that arrive meanwhile, like watchdog resets, are handled as
+    // the replies come in.
+    eraseRunning = true;
+    eraseFailed = false;
+    deleteAll(bus, index.ids());
 
-    for (const auto& iter : objectPaths)
+    // Failed before any delete could be sent, e.g. without the mapper.
+    if (eraseFailed)
     {
-        auto methodCall = bus.new_method_call(service.c_str(),
-                                              iter.c_str(),
-                                              ipmi::sel::logDeleteIntf,
-                                              "Delete");
-
-        auto reply = bus.call(methodCall);
-        if (reply.is_method_error())
-        {
-            *data_len = 0;
-            return IPMI_CC_UNSPECIFIED_ERROR;
-        }
+        responder(IPMI_CC_UNSPECIFIED_ERROR, {});
+        return;
     }
-
-    // Invalidate the cache of dbus entry objects.
-    cache::paths.clear();
-    memcpy(response, &eraseProgress, sizeof(eraseProgress));
-    *data_len = sizeof(eraseProgress);
-    return IPMI_CC_OK;
+    responder(IPMI_CC_OK, {eraseProgress()});
 }
 
 ipmi_ret_t ipmi_storage_get_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
@@ -430,6 +601,7 @@ ipmi_ret_t ipmi_storage_get_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     using namespace std::chrono;
     uint64_t host_time_usec = 0;
     uint32_t resp = 0;
+    ipmi::ResponseView view(response, data_len);
 
     printf("IPMI Handling GET-SEL-TIME\n");
 
@@ -446,7 +618,7 @@ ipmi_ret_t ipmi_storage_get_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                           "Get");
 
         method.append(TIME_INTERFACE, PROPERTY_ELAPSED);
-        auto reply = bus.call(method);
+        auto reply = ipmi::call(bus, method);
         if (reply.is_method_error())
         {
             log<level::ERR>("Error getting time",
@@ -478,10 +650,7 @@ ipmi_ret_t ipmi_storage_get_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
     resp = htole32(resp);
 
     // From the IPMI Spec 2.0, response should be a 32-bit value
-    *data_len = sizeof(resp);
-
-    // Pack the actual response
-    memcpy(response, &resp, *data_len);
+    view.pack(resp);
 
     return IPMI_CC_OK;
 }
@@ -492,9 +661,15 @@ ipmi_ret_t ipmi_storage_set_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 {
     using namespace std::chrono;
     ipmi_ret_t rc = IPMI_CC_OK;
-    uint32_t secs = *static_cast<uint32_t*>(request);
+    uint32_t secs = 0;
+    ipmi::RequestView req(request, *data_len);
     *data_len = 0;
 
+    if (!req.unpack(secs))
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
+
     printf("Handling Set-SEL-Time:[0x%X], Cmd:[0x%X], Data:[0x%X]\n",
            netfn, cmd, secs);
 
@@ -517,7 +692,7 @@ ipmi_ret_t ipmi_storage_set_sel_time(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
                                           "Set");
 
         method.append(TIME_INTERFACE, PROPERTY_ELAPSED, value);
-        auto reply = bus.call(method);
+        auto reply = ipmi::call(bus, method);
         if (reply.is_method_error())
         {
             log<level::ERR>("Error setting time",
@@ -552,10 +727,7 @@ ipmi_ret_t ipmi_storage_reserve_sel(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 
     printf("IPMI Handling RESERVE-SEL 0x%04x\n", g_sel_reserve);
 
-    *data_len = sizeof(g_sel_reserve);
-
-    // Pack the actual response
-    memcpy(response, &g_sel_reserve, *data_len);
+    ipmi::ResponseView(response, data_len).pack(g_sel_reserve);
 
     return rc;
 }
@@ -566,17 +738,40 @@ ipmi_ret_t ipmi_storage_add_sel(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
 {
 
     ipmi_ret_t rc = IPMI_CC_OK;
-    ipmi_add_sel_request_t *p = (ipmi_add_sel_request_t*) request;
+    ipmi::RequestView req(request, *data_len);
+    ipmi::ResponseView resp(response, data_len);
+    auto p = req.get<ipmi_add_sel_request_t>();
     uint16_t recordid;
 
+    if (p == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
+
+    // System event records are stored as is, with the record ID and the
+    // timestamp of the SEL. Should the store fail, they are handed to the
+    // logging service like the other records.
+    if (p->recordtype == ipmi::sel::systemEventRecord &&
+        ipmi::sel::store().capacity() != 0)
+    {
+        ipmi::sel::GetSELEntryResponse record{};
+        memcpy(reinterpret_cast<uint8_t*>(&record.recordID), p,
+               ipmi::sel::selRecordSize);
+        ipmi::sel::watchIndex(ipmid_get_sd_bus_connection());
+        if (ipmi::sel::store().add(record, loggedId))
+        {
+            uint16_t addedRecordID = record.recordID;
+            resp.pack(addedRecordID);
+            return rc;
+        }
+    }
+
     recordid = ((uint16_t)p->eventdata[1] << 8) | p->eventdata[2];
 
     printf("IPMI Handling ADD-SEL for record 0x%04x\n", recordid);
 
-    *data_len = sizeof(g_sel_reserve);
-
     // Pack the actual response
-    memcpy(response, &p->eventdata[1], 2);
+    resp.append(&p->eventdata[1], 2);
 
     // Hostboot sends SEL with OEM record type 0xDE to indicate that there is
     // a maintenance procedure associated with eSEL record.
@@ -602,8 +797,13 @@ ipmi_ret_t ipmi_storage_get_fru_inv_area_info(
         ipmi_context_t context)
 {
     ipmi_ret_t rc = IPMI_CC_OK;
-    const FruInvenAreaInfoRequest* reqptr =
-        reinterpret_cast<const FruInvenAreaInfoRequest*>(request);
+    ipmi::RequestView req(request, *data_len);
+    ipmi::ResponseView view(response, data_len);
+    auto reqptr = req.get<FruInvenAreaInfoRequest>();
+    if (reqptr == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
     try
     {
         const auto& fruArea = getFruAreaData(reqptr->fruID);
@@ -613,15 +813,12 @@ ipmi_ret_t ipmi_storage_get_fru_inv_area_info(
         resp.sizels = size;
         resp.access = static_cast<uint8_t>(AccessMode::bytes);
 
-        *data_len = sizeof(resp);
-
         // Pack the actual response
-        memcpy(response, &resp, *data_len);
+        view.pack(resp);
     }
     catch(const InternalFailure& e)
     {
         rc = IPMI_CC_UNSPECIFIED_ERROR;
-        *data_len = 0;
         log<level::ERR>(e.what());
         report<InternalFailure>();
     }
@@ -635,8 +832,17 @@ ipmi_ret_t ipmi_storage_read_fru_data(
         ipmi_context_t context)
 {
     ipmi_ret_t rc = IPMI_CC_OK;
-    const ReadFruDataRequest* reqptr =
-         reinterpret_cast<const ReadFruDataRequest*>(request);
+    ipmi::RequestView req(request, *data_len);
+    ipmi::ResponseView resp(response, data_len);
+    auto reqptr = req.get<ReadFruDataRequest>();
+    if (reqptr == nullptr)
+    {
+        return IPMI_CC_REQ_DATA_LEN_INVALID;
+    }
+    if (reqptr->count > resp.capacity())
+    {
+        return IPMI_CC_PARM_OUT_OF_RANGE;
+    }
     auto offset =
         static_cast<uint16_t>(reqptr->offsetMS << 8 | reqptr->offsetLS);
     try
@@ -651,14 +857,11 @@ ipmi_ret_t ipmi_storage_read_fru_data(
                             entry("SIZE_OF_FRU_AREA=%s", size));
             return IPMI_CC_INVALID;
         }
-        std::copy((fruArea.begin() + offset), (fruArea.begin() + reqptr->count),
-                (static_cast<uint8_t*>(response)));
-        *data_len = reqptr->count;
+        resp.append(fruArea.data() + offset, reqptr->count);
     }
     catch (const InternalFailure& e)
     {
         rc = IPMI_CC_UNSPECIFIED_ERROR;
-        *data_len = 0;
         log<level::ERR>(e.what());
         report<InternalFailure>();
     }
@@ -709,8 +912,8 @@ void register_netfn_storage_functions()
                            PRIVILEGE_OPERATOR);
     // <Clear SEL>
     printf("Registering NetFn:[0x%X], Cmd:[0x%X]\n",NETFUN_STORAGE, IPMI_CMD_CLEAR_SEL);
-    ipmi_register_callback(NETFUN_STORAGE, IPMI_CMD_CLEAR_SEL, NULL, clearSEL,
-                           PRIVILEGE_OPERATOR);
+    ipmi_register_async_callback(NETFUN_STORAGE, IPMI_CMD_CLEAR_SEL, NULL,
+                                 clearSEL, PRIVILEGE_OPERATOR);
     // <Get FRU Inventory Area Info>
     printf("Registering NetFn:[0x%X], Cmd:[0x%X]\n", NETFUN_STORAGE,
             IPMI_CMD_GET_FRU_INV_AREA_INFO);
@@ -724,6 +927,19 @@ void register_netfn_storage_functions()
             ipmi_storage_read_fru_data, PRIVILEGE_OPERATOR);
 
     ipmi::fru::registerCallbackHandler();
+
+    // Exported on ipmid's statistics object.
+    ipmi::stats::setSELReadAhead({
+        []()
+        {
+            auto stats = ipmi::sel::readAhead().stats();
+            return std::array<uint64_t, 4>{{stats.converted, stats.hits,
+                                            stats.misses, stats.wasted}};
+        },
+        []()
+        {
+            ipmi::sel::readAhead().resetStats();
+        }});
     return;
 }
 
@@ -0,0 +1,190 @@
+/*
+ * Compares the direct indexed dispatch table against the std::map based
+ * lookup (exact match, then NetFn wildcard) that ipmid used before.
+ *
+ * The registrations mirror the ones made by the in-tree providers. Every
+ * registered command is looked up, along with the remaining commands of each
+ * registered NetFn, which are served by the NetFn wildcard or not at all.
+ *
+ * Usage: dispatch_benchmark [iterations]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <utility>
+#include <vector>
+#include "dispatch.hpp"
+
+namespace
+{
+
+using NetFnCmd = std::pair<ipmi_netfn_t, ipmi_cmd_t>;
+using HandlerContext = std::pair<ipmid_callback_t, ipmi_context_t>;
+
+ipmi_ret_t handler(ipmi_netfn_t, ipmi_cmd_t, ipmi_request_t,
+                   ipmi_response_t, ipmi_data_len_t, ipmi_context_t)
+{
+    return IPMI_CC_OK;
+}
+
+const std::vector<NetFnCmd> registrations =
+{
+    {NETFUN_CHASSIS, 0x00}, // Get Chassis Capabilities
+    {NETFUN_CHASSIS, 0x01}, // Get Chassis Status
+    {NETFUN_CHASSIS, 0x02}, // Chassis Control
+    {NETFUN_CHASSIS, 0x04}, // Chassis Identify
+    {NETFUN_CHASSIS, 0x08}, // Set System Boot Options
+    {NETFUN_CHASSIS, 0x09}, // Get System Boot Options
+    {NETFUN_CHASSIS, IPMI_CMD_WILDCARD},
+    {NETFUN_SENSOR, 0x20}, // Get SDR Info
+    {NETFUN_SENSOR, 0x21}, // Get SDR
+    {NETFUN_SENSOR, 0x22}, // Reserve SDR Repository
+    {NETFUN_SENSOR, 0x2D}, // Get Sensor Reading
+    {NETFUN_SENSOR, 0x2F}, // Get Sensor Type
+    {NETFUN_SENSOR, 0x30}, // Set Sensor Reading
+    {NETFUN_SENSOR, IPMI_CMD_WILDCARD},
+    {NETFUN_APP, 0x01}, // Get Device ID
+    {NETFUN_APP, 0x02}, // Cold Reset
+    {NETFUN_APP, 0x03}, // Warm Reset
+    {NETFUN_APP, 0x04}, // Get Self Test Results
+    {NETFUN_APP, 0x06}, // Set ACPI Power State
+    {NETFUN_APP, 0x08}, // Get Device GUID
+    {NETFUN_APP, 0x22}, // Reset Watchdog Timer
+    {NETFUN_APP, 0x24}, // Set Watchdog Timer
+    {NETFUN_APP, 0x2E}, // Set BMC Global Enables
+    {NETFUN_APP, 0x31}, // Get Message Flags
+    {NETFUN_APP, 0x35}, // Read Event Message Buffer
+    {NETFUN_APP, 0x36}, // Get BT Interface Capabilities
+    {NETFUN_APP, 0x40}, // Set Channel Access
+    {NETFUN_APP, 0x41}, // Get Channel Access
+    {NETFUN_APP, 0x42}, // Get Channel Info
+    {NETFUN_APP, IPMI_CMD_WILDCARD},
+    {NETFUN_STORAGE, 0x10}, // Get FRU Inventory Area Info
+    {NETFUN_STORAGE, 0x11}, // Read FRU Data
+    {NETFUN_STORAGE, 0x40}, // Get SEL Info
+    {NETFUN_STORAGE, 0x42}, // Reserve SEL
+    {NETFUN_STORAGE, 0x43}, // Get SEL Entry
+    {NETFUN_STORAGE, 0x44}, // Add SEL Entry
+    {NETFUN_STORAGE, 0x46}, // Delete SEL Entry
+    {NETFUN_STORAGE, 0x47}, // Clear SEL
+    {NETFUN_STORAGE, 0x48}, // Get SEL Time
+    {NETFUN_STORAGE, 0x49}, // Set SEL Time
+    {NETFUN_STORAGE, IPMI_CMD_WILDCARD},
+    {NETFUN_TRANSPORT, 0x01}, // Set LAN Configuration Parameters
+    {NETFUN_TRANSPORT, 0x02}, // Get LAN Configuration Parameters
+    {NETFUN_TRANSPORT, IPMI_CMD_WILDCARD},
+    {NETFUN_GRPEXT, 0x00}, // Group Extension Command
+    {NETFUN_GRPEXT, 0x03}, // Get Power Limit
+    {NETFUN_GRPEXT, 0x04}, // Set Power Limit
+    {NETFUN_GRPEXT, 0x05}, // Apply Power Limit
+    {NETFUN_GRPEXT, 0x06}, // Get Asset Tag
+    {NETFUN_GRPEXT, 0x08}, // Set Asset Tag
+    {NETFUN_GRPEXT, 0x09}, // Get Management Controller ID String
+    {NETFUN_GRPEXT, 0x0A}, // Set Management Controller ID String
+};
+
+/** @brief The lookup ipmi_netfn_router() used to perform */
+ipmid_callback_t mapLookup(const std::map<NetFnCmd, HandlerContext>& map,
+                           ipmi_netfn_t netfn, ipmi_cmd_t cmd)
+{
+    auto iter = map.find(std::make_pair(netfn, cmd));
+    if (iter == map.end())
+    {
+        iter = map.find(std::make_pair(netfn, IPMI_CMD_WILDCARD));
+        if (iter == map.end())
+        {
+            return nullptr;
+        }
+    }
+    return iter->second.first;
+}
+
+template <typename Lookup>
+double run(const std::vector<NetFnCmd>& commands, unsigned long iterations,
+           Lookup&& lookup)
+{
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; ++i)
+    {
+        for (const auto& command : commands)
+        {
+            found += lookup(command.first, command.second) != nullptr;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Keep the lookups from being optimized away.
+    if (found == 0)
+    {
+        fprintf(stderr, "No handler was found\n");
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = end - start;
+    return elapsed.count() / (iterations * commands.size());
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned long iterations = 10000;
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], nullptr, 0);
+    }
+
+    std::map<NetFnCmd, HandlerContext> map;
+    ipmi::dispatch::Table table;
+    for (const auto& reg : registrations)
+    {
+        map.emplace(reg, std::make_pair(handler, nullptr));
+        table.add(reg.first, reg.second, nullptr, handler, PRIVILEGE_USER);
+    }
+    table.freeze();
+
+    std::vector<NetFnCmd> exact;
+    std::vector<NetFnCmd> fallback;
+    for (const auto& reg : registrations)
+    {
+        if (reg.second != IPMI_CMD_WILDCARD)
+        {
+            exact.push_back(reg);
+        }
+    }
+    for (const auto& reg : registrations)
+    {
+        if (reg.second != IPMI_CMD_WILDCARD)
+        {
+            continue;
+        }
+        for (unsigned cmd = 0; cmd < ipmi::dispatch::maxCmd; ++cmd)
+        {
+            if (!map.count(std::make_pair(reg.first, cmd)))
+            {
+                fallback.emplace_back(reg.first, cmd);
+            }
+        }
+    }
+
+    auto byMap = [&map](ipmi_netfn_t netfn, ipmi_cmd_t cmd)
+    {
+        return mapLookup(map, netfn, cmd);
+    };
+    auto byTable = [&table](ipmi_netfn_t netfn, ipmi_cmd_t cmd)
+    {
+        return table.find(netfn, cmd).handler;
+    };
+
+    printf("%-24s %10s %12s %12s\n", "lookup", "commands", "map (ns)",
+           "table (ns)");
+    printf("%-24s %10zu %12.2f %12.2f\n", "registered commands",
+           exact.size(), run(exact, iterations, byMap),
+           run(exact, iterations, byTable));
+    printf("%-24s %10zu %12.2f %12.2f\n", "wildcard fallback",
+           fallback.size(), run(fallback, iterations, byMap),
+           run(fallback, iterations, byTable));
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "dispatch.hpp"
+#include <gtest/gtest.h>
+
+namespace
+{
+
+ipmi_ret_t exactHandler(ipmi_netfn_t, ipmi_cmd_t, ipmi_request_t,
+                        ipmi_response_t, ipmi_data_len_t, ipmi_context_t)
+{
+    return IPMI_CC_OK;
+}
+
+ipmi_ret_t wildcardHandler(ipmi_netfn_t, ipmi_cmd_t, ipmi_request_t,
+                           ipmi_response_t, ipmi_data_len_t, ipmi_context_t)
+{
+    return IPMI_CC_INVALID;
+}
+
+void asyncHandler(ipmi_netfn_t, ipmi_cmd_t, ipmi_request_t, size_t,
+                  ipmid_responder_t, ipmi_context_t)
+{
+}
+
+} // namespace
+
+using ipmi::dispatch::Table;
+
+TEST(DispatchTable, UnregisteredHasNoHandler)
+{
+    Table table;
+    EXPECT_FALSE(table.find(NETFUN_APP, 0x01).registered());
+    EXPECT_FALSE(table.find(0xFF, 0x01).registered());
+}
+
+TEST(DispatchTable, ExactRegistration)
+{
+    Table table;
+    int context = 0;
+    EXPECT_TRUE(table.add(NETFUN_APP, 0x01, &context, exactHandler,
+                          PRIVILEGE_USER));
+
+    const auto& slot = table.find(NETFUN_APP, 0x01);
+    EXPECT_EQ(exactHandler, slot.handler);
+    EXPECT_EQ(&context, slot.context);
+    EXPECT_EQ(PRIVILEGE_USER, slot.priv);
+    EXPECT_TRUE(slot.exact);
+    EXPECT_EQ(nullptr, table.find(NETFUN_APP, 0x02).handler);
+}
+
+TEST(DispatchTable, WildcardFallbackIsPrecomputed)
+{
+    Table table;
+    EXPECT_TRUE(table.add(NETFUN_STORAGE, 0x40, nullptr, exactHandler,
+                          PRIVILEGE_USER));
+    EXPECT_TRUE(table.add(NETFUN_STORAGE, IPMI_CMD_WILDCARD, nullptr,
+                          wildcardHandler, PRIVILEGE_OPERATOR));
+    // Exact registrations made after the wildcard still take precedence.
+    EXPECT_TRUE(table.add(NETFUN_STORAGE, 0x42, nullptr, exactHandler,
+                          PRIVILEGE_USER));
+
+    EXPECT_EQ(exactHandler, table.find(NETFUN_STORAGE, 0x40).handler);
+    EXPECT_EQ(exactHandler, table.find(NETFUN_STORAGE, 0x42).handler);
+
+    const auto& slot = table.find(NETFUN_STORAGE, 0x41);
+    EXPECT_EQ(wildcardHandler, slot.handler);
+    EXPECT_EQ(PRIVILEGE_OPERATOR, slot.priv);
+    EXPECT_FALSE(slot.exact);
+
+    // Other NetFns are not affected.
+    EXPECT_EQ(nullptr, table.find(NETFUN_SENSOR, 0x41).handler);
+}
+
+TEST(DispatchTable, DuplicateRegistrationIsRejected)
+{
+    Table table;
+    EXPECT_TRUE(table.add(NETFUN_CHASSIS, 0x01, nullptr, exactHandler,
+                          PRIVILEGE_USER));
+    EXPECT_FALSE(table.add(NETFUN_CHASSIS, 0x01, nullptr, wildcardHandler,
+                           PRIVILEGE_USER));
+    EXPECT_EQ(exactHandler, table.find(NETFUN_CHASSIS, 0x01).handler);
+}
+
+TEST(DispatchTable, FrozenTableRejectsRegistration)
+{
+    Table table;
+    table.freeze();
+    EXPECT_FALSE(table.add(NETFUN_APP, 0x01, nullptr, exactHandler,
+                           PRIVILEGE_USER));
+    table.thaw();
+    EXPECT_TRUE(table.add(NETFUN_APP, 0x01, nullptr, exactHandler,
+                          PRIVILEGE_USER));
+}
+
+TEST(DispatchTable, InvalidNetFnIsRejected)
+{
+    Table table;
+    EXPECT_FALSE(table.add(0x40, 0x01, nullptr, exactHandler,
+                           PRIVILEGE_USER));
+}
+
+TEST(DispatchTable, WhitelistSurvivesRegistration)
+{
+    Table table;
+    table.allow(NETFUN_APP, 0x01);
+    EXPECT_TRUE(table.find(NETFUN_APP, 0x01).whitelisted);
+
+    EXPECT_TRUE(table.add(NETFUN_APP, IPMI_CMD_WILDCARD, nullptr,
+                          wildcardHandler, PRIVILEGE_USER));
+    EXPECT_TRUE(table.add(NETFUN_APP, 0x01, nullptr, exactHandler,
+                          PRIVILEGE_USER));
+
+    EXPECT_TRUE(table.find(NETFUN_APP, 0x01).whitelisted);
+    EXPECT_FALSE(table.find(NETFUN_APP, 0x02).whitelisted);
+    EXPECT_FALSE(table.find(0xFF, 0x01).whitelisted);
+}
+
+TEST(DispatchTable, AsyncRegistration)
+{
+    Table table;
+    EXPECT_TRUE(table.add(NETFUN_STORAGE, 0x47, nullptr, asyncHandler,
+                          PRIVILEGE_OPERATOR));
+
+    const auto& slot = table.find(NETFUN_STORAGE, 0x47);
+    EXPECT_TRUE(slot.registered());
+    EXPECT_EQ(nullptr, slot.handler);
+    EXPECT_EQ(asyncHandler, slot.asyncHandler);
+
+    // A synchronous handler for the same command is a duplicate.
+    EXPECT_FALSE(table.add(NETFUN_STORAGE, 0x47, nullptr, exactHandler,
+                           PRIVILEGE_OPERATOR));
+    EXPECT_FALSE(table.find(NETFUN_STORAGE, 0x46).registered());
+}
+
+TEST(DispatchTable, ReadOnlyOnlyForExactRegistrations)
+{
+    Table table;
+    EXPECT_FALSE(table.markReadOnly(NETFUN_SENSOR, 0x2d));
+
+    EXPECT_TRUE(table.add(NETFUN_SENSOR, IPMI_CMD_WILDCARD, nullptr,
+                          wildcardHandler, PRIVILEGE_USER));
+    EXPECT_TRUE(table.add(NETFUN_SENSOR, 0x2d, nullptr, asyncHandler,
+                          PRIVILEGE_USER));
+    EXPECT_FALSE(table.find(NETFUN_SENSOR, 0x2d).readOnly);
+
+    EXPECT_TRUE(table.markReadOnly(NETFUN_SENSOR, 0x2d));
+    EXPECT_TRUE(table.find(NETFUN_SENSOR, 0x2d).readOnly);
+    // Not the commands falling back to the wildcard
+    EXPECT_FALSE(table.markReadOnly(NETFUN_SENSOR, 0x2e));
+    EXPECT_FALSE(table.find(NETFUN_SENSOR, 0x2e).readOnly);
+    EXPECT_FALSE(table.markReadOnly(0x40, 0x2d));
+}
@@ -0,0 +1,160 @@
+#include "mock-bus.hpp"
+#include "settings.hpp"
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <host-ipmid/ipmid-init.hpp>
+#include <memory>
+#include <sdbusplus/bus.hpp>
+#include <string>
+
+// Tests of the deferred initialization of init.cpp and of the settings
+// lookups it runs, on the mock bus.
+
+using namespace ipmi::test;
+using ipmi::init::Done;
+using ipmi::init::Once;
+
+namespace
+{
+
+constexpr auto restrictionModeIntf =
+    "xyz.openbmc_project.Control.Security.RestrictionMode";
+constexpr auto restrictionModePath =
+    "/xyz/openbmc_project/control/host0/restriction_mode";
+constexpr auto powerRestoreIntf =
+    "xyz.openbmc_project.Control.Power.RestorePolicy";
+constexpr auto powerRestorePath =
+    "/xyz/openbmc_project/control/host0/power_restore_policy";
+constexpr auto settingsService = "xyz.openbmc_project.Settings";
+
+class InitOnce : public ::testing::Test
+{
+    protected:
+        InitOnce() :
+            once("test state",
+                 [this](Done&& done)
+                 {
+                     ++starts;
+                     pending = std::move(done);
+                 })
+        {
+        }
+
+        MockBus mock;
+        size_t starts = 0;
+        Done pending;
+        Once once;
+};
+
+} // namespace
+
+TEST_F(InitOnce, NotReadyUntilDone)
+{
+    EXPECT_FALSE(once.ready());
+    // Started from the event loop
+    EXPECT_EQ(0u, starts);
+    mock.process();
+    EXPECT_EQ(1u, starts);
+
+    EXPECT_FALSE(once.ready());
+    mock.process();
+    EXPECT_EQ(1u, starts);
+
+    pending(0);
+    EXPECT_TRUE(once.ready());
+    mock.process();
+    EXPECT_EQ(1u, starts);
+}
+
+TEST_F(InitOnce, FailureIsRetriedOnNextUse)
+{
+    EXPECT_FALSE(once.ready());
+    mock.process();
+    pending(-ENOENT);
+
+    EXPECT_FALSE(once.ready());
+    mock.process();
+    EXPECT_EQ(2u, starts);
+    pending(0);
+    EXPECT_TRUE(once.ready());
+}
+
+TEST_F(InitOnce, SettingsAreFetchedConcurrently)
+{
+    mock.addObject(restrictionModePath, settingsService,
+                   {{restrictionModeIntf, {}}});
+    mock.addObject(powerRestorePath, settingsService,
+                   {{powerRestoreIntf, {}}});
+    sdbusplus::bus::bus dbus(mock.bus());
+
+    std::unique_ptr<settings::Objects> restriction;
+    std::unique_ptr<settings::Objects> power;
+    size_t fetched = 0;
+    settings::Objects::fetch(
+        dbus, {restrictionModeIntf},
+        [&](std::unique_ptr<settings::Objects>&& objects)
+        {
+            restriction = std::move(objects);
+            ++fetched;
+        });
+    settings::Objects::fetch(
+        dbus, {powerRestoreIntf},
+        [&](std::unique_ptr<settings::Objects>&& objects)
+        {
+            power = std::move(objects);
+            ++fetched;
+        });
+
+    // Both lookups are sent before either reply is read.
+    EXPECT_EQ(0u, fetched);
+    while (fetched < 2)
+    {
+        ASSERT_GT(sd_event_run(mock.event(), 1000000), 0);
+    }
+    EXPECT_EQ(2u, mock.calls(mapperInterface, "GetSubTree"));
+
+    ASSERT_NE(nullptr, restriction);
+    EXPECT_EQ(restrictionModePath,
+              restriction->map.at(restrictionModeIntf).front());
+    ASSERT_NE(nullptr, power);
+    EXPECT_EQ(powerRestorePath, power->map.at(powerRestoreIntf).front());
+}
+
+TEST_F(InitOnce, MissingSettingsFetchNothing)
+{
+    sdbusplus::bus::bus dbus(mock.bus());
+
+    bool fetched = false;
+    std::unique_ptr<settings::Objects> found;
+    settings::Objects::fetch(
+        dbus, {restrictionModeIntf},
+        [&](std::unique_ptr<settings::Objects>&& objects)
+        {
+            found = std::move(objects);
+            fetched = true;
+        });
+    while (!fetched)
+    {
+        ASSERT_GT(sd_event_run(mock.event(), 1000000), 0);
+    }
+    EXPECT_EQ(nullptr, found);
+}
+
+TEST_F(InitOnce, StartAllStartsLaterOnesAtOnce)
+{
+    // Last, every Once constructed after this starts right away.
+    ipmi::init::startAll();
+    mock.process();
+    EXPECT_EQ(1u, starts);
+
+    size_t laterStarts = 0;
+    Once later("later state",
+               [&laterStarts](Done&& done)
+               {
+                   ++laterStarts;
+                   done(0);
+               });
+    mock.process();
+    EXPECT_EQ(1u, laterStarts);
+    EXPECT_TRUE(later.ready());
+}
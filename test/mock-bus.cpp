@@ -0,0 +1,1191 @@
+#include <algorithm>
+#include <errno.h>
+#include <future>
+#include <stdexcept>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <system_error>
+#include <systemd/sd-id128.h>
+#include <unistd.h>
+#include "mock-bus.hpp"
+
+namespace ipmi
+{
+namespace test
+{
+
+namespace
+{
+
+constexpr auto propertiesInterface = "org.freedesktop.DBus.Properties";
+constexpr auto objectManagerInterface = "org.freedesktop.DBus.ObjectManager";
+constexpr auto deleteInterface = "xyz.openbmc_project.Object.Delete";
+constexpr auto deleteAllInterface =
+    "xyz.openbmc_project.Collection.DeleteAll";
+constexpr auto notFoundError =
+    "xyz.openbmc_project.Common.Error.ResourceNotFound";
+
+MockBus* currentBus = nullptr;
+
+void check(int r, const char* what)
+{
+    if (r < 0)
+    {
+        throw std::system_error(-r, std::generic_category(), what);
+    }
+}
+
+/** @brief Reads an array of strings */
+int readStrings(sd_bus_message* m, std::vector<std::string>& strings)
+{
+    auto r = sd_bus_message_enter_container(m, 'a', "s");
+    const char* string = nullptr;
+    while (r >= 0 && (r = sd_bus_message_read(m, "s", &string)) > 0)
+    {
+        strings.emplace_back(string);
+    }
+    return r < 0 ? r : sd_bus_message_exit_container(m);
+}
+
+int appendStrings(sd_bus_message* m, const std::vector<std::string>& strings)
+{
+    auto r = sd_bus_message_open_container(m, 'a', "s");
+    for (const auto& string : strings)
+    {
+        if (r >= 0)
+        {
+            r = sd_bus_message_append(m, "s", string.c_str());
+        }
+    }
+    return r < 0 ? r : sd_bus_message_close_container(m);
+}
+
+/** @brief Appends a{sv} of the properties */
+int appendProperties(sd_bus_message* m,
+                     const MockBus::Properties& properties)
+{
+    auto r = sd_bus_message_open_container(m, 'a', "{sv}");
+    for (const auto& property : properties)
+    {
+        if (r >= 0)
+        {
+            r = sd_bus_message_open_container(m, 'e', "sv");
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_append(m, "s", property.first.c_str());
+        }
+        if (r >= 0)
+        {
+            r = property.second.append(m);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_close_container(m);
+        }
+    }
+    return r < 0 ? r : sd_bus_message_close_container(m);
+}
+
+/** @brief Appends a{sa{sv}} of the interfaces */
+int appendInterfaces(sd_bus_message* m,
+                     const MockBus::Interfaces& interfaces)
+{
+    auto r = sd_bus_message_open_container(m, 'a', "{sa{sv}}");
+    for (const auto& interface : interfaces)
+    {
+        if (r >= 0)
+        {
+            r = sd_bus_message_open_container(m, 'e', "sa{sv}");
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_append(m, "s", interface.first.c_str());
+        }
+        if (r >= 0)
+        {
+            r = appendProperties(m, interface.second);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_close_container(m);
+        }
+    }
+    return r < 0 ? r : sd_bus_message_close_container(m);
+}
+
+/** @brief Appends {sas}, a service and the interfaces of an object */
+template <typename Object>
+int appendServiceEntry(sd_bus_message* m, const Object& object)
+{
+    std::vector<std::string> names;
+    for (const auto& interface : object.interfaces)
+    {
+        names.push_back(interface.first);
+    }
+
+    auto r = sd_bus_message_open_container(m, 'e', "sas");
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(m, "s", object.service.c_str());
+    }
+    if (r >= 0)
+    {
+        r = appendStrings(m, names);
+    }
+    return r < 0 ? r : sd_bus_message_close_container(m);
+}
+
+/** @brief Sends a reply built by append, or the error it returned */
+template <typename Append>
+int reply(sd_bus_message* call, Append append)
+{
+    sd_bus_message* reply = nullptr;
+    auto r = sd_bus_message_new_method_return(call, &reply);
+    if (r >= 0)
+    {
+        r = append(reply);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_send(nullptr, reply, nullptr);
+    }
+    sd_bus_message_unref(reply);
+    return r;
+}
+
+} // namespace
+
+int Value::append(sd_bus_message* m) const
+{
+    auto r = sd_bus_message_open_container(m, 'v', signature.c_str());
+    if (r < 0)
+    {
+        return r;
+    }
+
+    if (signature == "b")
+    {
+        r = sd_bus_message_append(m, "b", static_cast<int>(boolean));
+    }
+    else if (signature == "y")
+    {
+        r = sd_bus_message_append(m, "y", static_cast<uint8_t>(unsigned64));
+    }
+    else if (signature == "u")
+    {
+        r = sd_bus_message_append(m, "u", static_cast<uint32_t>(unsigned64));
+    }
+    else if (signature == "t")
+    {
+        r = sd_bus_message_append(m, "t", unsigned64);
+    }
+    else if (signature == "x")
+    {
+        r = sd_bus_message_append(m, "x", signed64);
+    }
+    else if (signature == "d")
+    {
+        r = sd_bus_message_append(m, "d", real);
+    }
+    else if (signature == "s")
+    {
+        r = sd_bus_message_append(m, "s", string.c_str());
+    }
+    else if (signature == "as")
+    {
+        r = appendStrings(m, strings);
+    }
+    else
+    {
+        r = sd_bus_message_open_container(m, 'a', "(sss)");
+        for (const auto& association : associations)
+        {
+            if (r >= 0)
+            {
+                r = sd_bus_message_append(m, "(sss)",
+                                          std::get<0>(association).c_str(),
+                                          std::get<1>(association).c_str(),
+                                          std::get<2>(association).c_str());
+            }
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_close_container(m);
+        }
+    }
+
+    return r < 0 ? r : sd_bus_message_close_container(m);
+}
+
+int Value::read(sd_bus_message* m)
+{
+    char type = 0;
+    const char* contents = nullptr;
+    auto r = sd_bus_message_peek_type(m, &type, &contents);
+    if (r < 0)
+    {
+        return r;
+    }
+    if (type != 'v' || contents == nullptr || signature != contents)
+    {
+        return -EINVAL;
+    }
+
+    r = sd_bus_message_enter_container(m, 'v', contents);
+    if (r < 0)
+    {
+        return r;
+    }
+
+    if (signature == "b")
+    {
+        int value = 0;
+        r = sd_bus_message_read(m, "b", &value);
+        boolean = value;
+    }
+    else if (signature == "y")
+    {
+        uint8_t value = 0;
+        r = sd_bus_message_read(m, "y", &value);
+        unsigned64 = value;
+    }
+    else if (signature == "u")
+    {
+        uint32_t value = 0;
+        r = sd_bus_message_read(m, "u", &value);
+        unsigned64 = value;
+    }
+    else if (signature == "t")
+    {
+        r = sd_bus_message_read(m, "t", &unsigned64);
+    }
+    else if (signature == "x")
+    {
+        r = sd_bus_message_read(m, "x", &signed64);
+    }
+    else if (signature == "d")
+    {
+        r = sd_bus_message_read(m, "d", &real);
+    }
+    else if (signature == "s")
+    {
+        const char* value = nullptr;
+        r = sd_bus_message_read(m, "s", &value);
+        if (r >= 0)
+        {
+            string = value;
+        }
+    }
+    else if (signature == "as")
+    {
+        strings.clear();
+        r = readStrings(m, strings);
+    }
+    else
+    {
+        associations.clear();
+        r = sd_bus_message_enter_container(m, 'a', "(sss)");
+        const char* forward = nullptr;
+        const char* reverse = nullptr;
+        const char* path = nullptr;
+        while (r >= 0 &&
+               (r = sd_bus_message_read(m, "(sss)", &forward, &reverse,
+                                        &path)) > 0)
+        {
+            associations.emplace_back(forward, reverse, path);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_exit_container(m);
+        }
+    }
+
+    return r < 0 ? r : sd_bus_message_exit_container(m);
+}
+
+MockBus::MockBus()
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0,
+                   fds) < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "socketpair");
+    }
+
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0)
+    {
+        auto error = errno;
+        close(fds[0]);
+        close(fds[1]);
+        throw std::system_error(error, std::generic_category(), "eventfd");
+    }
+
+    try
+    {
+        check(sd_bus_new(&client), "sd_bus_new");
+        check(sd_bus_set_fd(client, fds[0], fds[0]), "sd_bus_set_fd");
+        fds[0] = -1;
+        check(sd_bus_start(client), "sd_bus_start");
+        check(sd_event_new(&clientEvent), "sd_event_new");
+        check(sd_bus_attach_event(client, clientEvent,
+                                  SD_EVENT_PRIORITY_NORMAL),
+              "sd_bus_attach_event");
+    }
+    catch (...)
+    {
+        if (fds[0] >= 0)
+        {
+            close(fds[0]);
+        }
+        close(fds[1]);
+        close(wakeFd);
+        sd_bus_unref(client);
+        sd_event_unref(clientEvent);
+        throw;
+    }
+
+    service = std::thread(&MockBus::serve, this, fds[1]);
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [this]() { return started; });
+    if (serverEvent == nullptr)
+    {
+        guard.unlock();
+        service.join();
+        close(wakeFd);
+        sd_bus_detach_event(client);
+        sd_bus_unref(client);
+        sd_event_unref(clientEvent);
+        throw std::runtime_error("Failed to start the mock services");
+    }
+
+    currentBus = this;
+}
+
+MockBus::~MockBus()
+{
+    if (currentBus == this)
+    {
+        currentBus = nullptr;
+    }
+
+    run([this]()
+    {
+        sd_event_exit(serverEvent, 0);
+    });
+    service.join();
+    close(wakeFd);
+
+    sd_bus_detach_event(client);
+    sd_bus_flush_close_unref(client);
+    sd_event_unref(clientEvent);
+}
+
+MockBus* MockBus::current()
+{
+    return currentBus;
+}
+
+void MockBus::process()
+{
+    while (sd_event_run(clientEvent, 0) > 0)
+    {
+    }
+}
+
+void MockBus::serve(int fd)
+{
+    sd_id128_t id;
+    auto r = sd_id128_randomize(&id);
+    if (r >= 0)
+    {
+        r = sd_bus_new(&server);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_set_fd(server, fd, fd);
+        fd = r >= 0 ? -1 : fd;
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_set_server(server, 1, id);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_add_filter(server, nullptr, onMessage, this);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_start(server);
+    }
+    sd_event* event = nullptr;
+    if (r >= 0)
+    {
+        r = sd_event_new(&event);
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_attach_event(server, event, SD_EVENT_PRIORITY_NORMAL);
+    }
+    if (r >= 0)
+    {
+        r = sd_event_add_io(event, nullptr, wakeFd, EPOLLIN, onWork, this);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        serverEvent = r >= 0 ? event : nullptr;
+        started = true;
+    }
+    ready.notify_all();
+
+    if (r >= 0)
+    {
+        sd_event_loop(event);
+    }
+
+    sd_bus_detach_event(server);
+    sd_bus_flush_close_unref(server);
+    server = nullptr;
+    sd_event_unref(event);
+}
+
+void MockBus::run(std::function<void()>&& func)
+{
+    std::promise<void> done;
+    auto finished = done.get_future();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        work.emplace_back([&func, &done]()
+        {
+            try
+            {
+                func();
+                done.set_value();
+            }
+            catch (...)
+            {
+                done.set_exception(std::current_exception());
+            }
+        });
+    }
+
+    uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) != sizeof(one))
+    {
+        throw std::system_error(errno, std::generic_category(), "write");
+    }
+    finished.get();
+}
+
+int MockBus::onWork(sd_event_source* source, int fd, uint32_t revents,
+                    void* userData)
+{
+    auto self = static_cast<MockBus*>(userData);
+
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        return -errno;
+    }
+
+    std::deque<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> guard(self->lock);
+        pending.swap(self->work);
+    }
+    for (auto& func : pending)
+    {
+        func();
+    }
+    return 0;
+}
+
+int MockBus::onMessage(sd_bus_message* m, void* userData,
+                       sd_bus_error* error)
+{
+    if (!sd_bus_message_is_method_call(m, nullptr, nullptr))
+    {
+        return 0;
+    }
+
+    auto r = static_cast<MockBus*>(userData)->dispatch(m);
+    if (r < 0)
+    {
+        sd_bus_reply_method_errno(m, r, nullptr);
+    }
+    // Every call is answered here, nothing is left for sd-bus' own
+    // dispatching.
+    return 1;
+}
+
+int MockBus::dispatch(sd_bus_message* m)
+{
+    auto nullable = [](const char* string)
+    {
+        return std::string(string == nullptr ? "" : string);
+    };
+    auto path = nullable(sd_bus_message_get_path(m));
+    auto interface = nullable(sd_bus_message_get_interface(m));
+    auto member = nullable(sd_bus_message_get_member(m));
+
+    ++served[std::make_pair(interface, member)];
+
+    auto method = methods.find(std::make_pair(interface, member));
+    if (method != methods.end())
+    {
+        return method->second(m);
+    }
+
+    if (path == mapperPath && interface == mapperInterface)
+    {
+        if (member == "GetObject")
+        {
+            return getObject(m);
+        }
+        if (member == "GetSubTree" || member == "GetSubTreePaths")
+        {
+            return getSubTree(m, member == "GetSubTreePaths");
+        }
+    }
+    else if (interface == objectManagerInterface &&
+             member == "GetManagedObjects")
+    {
+        return getManagedObjects(m, path);
+    }
+    else if (interface == deleteAllInterface && member == "DeleteAll")
+    {
+        return deleteAll(m, path);
+    }
+    else if (interface == propertiesInterface ||
+             (interface == deleteInterface && member == "Delete"))
+    {
+        auto object = objects.find(path);
+        if (object == objects.end())
+        {
+            return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_UNKNOWN_OBJECT,
+                                              "No object %s", path.c_str());
+        }
+
+        if (member == "Get")
+        {
+            return getProperty(m, object->second);
+        }
+        if (member == "GetAll")
+        {
+            return getAllProperties(m, object->second);
+        }
+        if (member == "Set")
+        {
+            return setPropertyCall(m, object->second);
+        }
+        if (member == "Delete" &&
+            object->second.interfaces.count(deleteInterface) != 0)
+        {
+            erase(path);
+            return sd_bus_reply_method_return(m, "");
+        }
+    }
+
+    return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_UNKNOWN_METHOD,
+                                      "Unknown method %s.%s on %s",
+                                      interface.c_str(), member.c_str(),
+                                      path.c_str());
+}
+
+int MockBus::getObject(sd_bus_message* m)
+{
+    const char* path = nullptr;
+    std::vector<std::string> interfaces;
+    auto r = sd_bus_message_read(m, "s", &path);
+    if (r >= 0)
+    {
+        r = readStrings(m, interfaces);
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+
+    auto object = objects.find(path);
+    bool found = object != objects.end() && interfaces.empty();
+    for (const auto& interface : interfaces)
+    {
+        found = found || (object != objects.end() &&
+                          object->second.interfaces.count(interface) != 0);
+    }
+    if (!found)
+    {
+        return sd_bus_reply_method_errorf(m, notFoundError, "No object %s",
+                                          path);
+    }
+
+    return reply(m, [&object](sd_bus_message* reply)
+    {
+        auto r = sd_bus_message_open_container(reply, 'a', "{sas}");
+        if (r >= 0)
+        {
+            r = appendServiceEntry(reply, object->second);
+        }
+        return r < 0 ? r : sd_bus_message_close_container(reply);
+    });
+}
+
+int MockBus::getSubTree(sd_bus_message* m, bool pathsOnly)
+{
+    const char* root = nullptr;
+    int32_t depth = 0;
+    std::vector<std::string> interfaces;
+    auto r = sd_bus_message_read(m, "si", &root, &depth);
+    if (r >= 0)
+    {
+        r = readStrings(m, interfaces);
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+
+    auto found = below(root, depth, interfaces);
+    if (pathsOnly)
+    {
+        return reply(m, [&found](sd_bus_message* reply)
+        {
+            auto r = sd_bus_message_open_container(reply, 'a', "s");
+            for (const auto& object : found)
+            {
+                if (r >= 0)
+                {
+                    r = sd_bus_message_append(reply, "s",
+                                              object->first.c_str());
+                }
+            }
+            return r < 0 ? r : sd_bus_message_close_container(reply);
+        });
+    }
+
+    return reply(m, [&found](sd_bus_message* reply)
+    {
+        auto r = sd_bus_message_open_container(reply, 'a', "{sa{sas}}");
+        for (const auto& object : found)
+        {
+            if (r >= 0)
+            {
+                r = sd_bus_message_open_container(reply, 'e', "sa{sas}");
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_append(reply, "s", object->first.c_str());
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_open_container(reply, 'a', "{sas}");
+            }
+            if (r >= 0)
+            {
+                r = appendServiceEntry(reply, object->second);
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_close_container(reply);
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_close_container(reply);
+            }
+        }
+        return r < 0 ? r : sd_bus_message_close_container(reply);
+    });
+}
+
+int MockBus::getProperty(sd_bus_message* m, const Object& object)
+{
+    const char* interface = nullptr;
+    const char* property = nullptr;
+    auto r = sd_bus_message_read(m, "ss", &interface, &property);
+    if (r < 0)
+    {
+        return r;
+    }
+
+    auto properties = object.interfaces.find(interface);
+    if (properties == object.interfaces.end())
+    {
+        return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_UNKNOWN_INTERFACE,
+                                          "No interface %s", interface);
+    }
+    auto value = properties->second.find(property);
+    if (value == properties->second.end())
+    {
+        return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_UNKNOWN_PROPERTY,
+                                          "No property %s", property);
+    }
+
+    return reply(m, [&value](sd_bus_message* reply)
+    {
+        return value->second.append(reply);
+    });
+}
+
+int MockBus::getAllProperties(sd_bus_message* m, const Object& object)
+{
+    const char* interface = nullptr;
+    auto r = sd_bus_message_read(m, "s", &interface);
+    if (r < 0)
+    {
+        return r;
+    }
+
+    auto properties = object.interfaces.find(interface);
+    if (properties == object.interfaces.end())
+    {
+        return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_UNKNOWN_INTERFACE,
+                                          "No interface %s", interface);
+    }
+
+    return reply(m, [&properties](sd_bus_message* reply)
+    {
+        return appendProperties(reply, properties->second);
+    });
+}
+
+int MockBus::setPropertyCall(sd_bus_message* m, Object& object)
+{
+    const char* interface = nullptr;
+    const char* property = nullptr;
+    auto r = sd_bus_message_read(m, "ss", &interface, &property);
+    if (r < 0)
+    {
+        return r;
+    }
+
+    auto properties = object.interfaces.find(interface);
+    if (properties == object.interfaces.end())
+    {
+        return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_UNKNOWN_INTERFACE,
+                                          "No interface %s", interface);
+    }
+    auto value = properties->second.find(property);
+    if (value == properties->second.end())
+    {
+        return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_UNKNOWN_PROPERTY,
+                                          "No property %s", property);
+    }
+
+    auto updated = value->second;
+    r = updated.read(m);
+    if (r == -EINVAL)
+    {
+        return sd_bus_reply_method_errorf(m, SD_BUS_ERROR_INVALID_ARGS,
+                                          "%s is of type %s", property,
+                                          value->second.type().c_str());
+    }
+    if (r < 0)
+    {
+        return r;
+    }
+
+    value->second = updated;
+    emitPropertyChanged(sd_bus_message_get_path(m), interface, property,
+                        updated);
+    return sd_bus_reply_method_return(m, "");
+}
+
+int MockBus::getManagedObjects(sd_bus_message* m, const std::string& root)
+{
+    // Only the objects of the service the call is addressed to
+    auto destination = sd_bus_message_get_destination(m);
+    std::vector<Objects::const_iterator> found;
+    for (const auto& object : below(root, 0, {}))
+    {
+        if (destination == nullptr || object->second.service == destination)
+        {
+            found.push_back(object);
+        }
+    }
+
+    return reply(m, [&found](sd_bus_message* reply)
+    {
+        auto r = sd_bus_message_open_container(reply, 'a', "{oa{sa{sv}}}");
+        for (const auto& object : found)
+        {
+            if (r >= 0)
+            {
+                r = sd_bus_message_open_container(reply, 'e', "oa{sa{sv}}");
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_append(reply, "o", object->first.c_str());
+            }
+            if (r >= 0)
+            {
+                r = appendInterfaces(reply, object->second.interfaces);
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_close_container(reply);
+            }
+        }
+        return r < 0 ? r : sd_bus_message_close_container(reply);
+    });
+}
+
+int MockBus::deleteAll(sd_bus_message* m, const std::string& root)
+{
+    std::vector<std::string> paths;
+    for (const auto& object : below(root, 0, {deleteInterface}))
+    {
+        paths.push_back(object->first);
+    }
+    for (const auto& path : paths)
+    {
+        erase(path);
+    }
+    return sd_bus_reply_method_return(m, "");
+}
+
+std::vector<MockBus::Objects::const_iterator> MockBus::below(
+    const std::string& root, int depth,
+    const std::vector<std::string>& interfaces) const
+{
+    auto prefix = root == "/" ? root : root + "/";
+    std::vector<Objects::const_iterator> found;
+
+    for (auto object = objects.lower_bound(prefix);
+         object != objects.end() &&
+         object->first.compare(0, prefix.size(), prefix) == 0;
+         ++object)
+    {
+        auto levels = 1 + std::count(object->first.begin() + prefix.size(),
+                                     object->first.end(), '/');
+        if (depth > 0 && levels > depth)
+        {
+            continue;
+        }
+
+        bool match = interfaces.empty();
+        for (const auto& interface : interfaces)
+        {
+            match = match ||
+                    object->second.interfaces.count(interface) != 0;
+        }
+        if (match)
+        {
+            found.push_back(object);
+        }
+    }
+
+    return found;
+}
+
+std::string MockBus::managerOf(const std::string& path) const
+{
+    auto parent = path;
+    while (parent.size() > 1)
+    {
+        parent.erase(std::max<size_t>(parent.rfind('/'), 1));
+        auto object = objects.find(parent);
+        if (object != objects.end() &&
+            object->second.interfaces.count(objectManagerInterface) != 0)
+        {
+            return parent;
+        }
+    }
+    return "/";
+}
+
+void MockBus::store(const std::string& path, const std::string& service,
+                    Interfaces&& interfaces)
+{
+    auto& object = objects[path];
+    object.service = service;
+    object.interfaces = std::move(interfaces);
+}
+
+void MockBus::erase(const std::string& path)
+{
+    auto object = objects.find(path);
+    if (object == objects.end())
+    {
+        return;
+    }
+
+    std::vector<std::string> names;
+    for (const auto& interface : object->second.interfaces)
+    {
+        names.push_back(interface.first);
+    }
+
+    sd_bus_message* signal = nullptr;
+    auto r = sd_bus_message_new_signal(server, &signal,
+                                       managerOf(path).c_str(),
+                                       objectManagerInterface,
+                                       "InterfacesRemoved");
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(signal, "o", path.c_str());
+    }
+    if (r >= 0)
+    {
+        r = appendStrings(signal, names);
+    }
+    if (r >= 0)
+    {
+        sd_bus_send(nullptr, signal, nullptr);
+    }
+    sd_bus_message_unref(signal);
+
+    objects.erase(object);
+}
+
+void MockBus::emitPropertyChanged(const std::string& path,
+                                  const std::string& interface,
+                                  const std::string& property,
+                                  const Value& value)
+{
+    sd_bus_message* signal = nullptr;
+    auto r = sd_bus_message_new_signal(server, &signal, path.c_str(),
+                                       propertiesInterface,
+                                       "PropertiesChanged");
+    if (r >= 0)
+    {
+        r = sd_bus_message_append(signal, "s", interface.c_str());
+    }
+    if (r >= 0)
+    {
+        r = appendProperties(signal, {{property, value}});
+    }
+    if (r >= 0)
+    {
+        r = appendStrings(signal, {});
+    }
+    if (r >= 0)
+    {
+        sd_bus_send(nullptr, signal, nullptr);
+    }
+    sd_bus_message_unref(signal);
+}
+
+void MockBus::populate(const Scale& scale)
+{
+    run([this, &scale]()
+    {
+        using Strings = std::vector<std::string>;
+        const Interfaces manager{{objectManagerInterface, {}}};
+
+        store(loggingPath, loggingService,
+              {{objectManagerInterface, {}}, {deleteAllInterface, {}}});
+        for (size_t i = 1; i <= scale.logEntries; ++i)
+        {
+            store(std::string(logEntryRoot) + "/" + std::to_string(i),
+                  loggingService,
+                  {{"xyz.openbmc_project.Logging.Entry",
+                    {{"Id", static_cast<uint32_t>(i)},
+                     {"Severity", "xyz.openbmc_project.Logging.Entry.Level."
+                                  "Error"},
+                     {"Message", "xyz.openbmc_project.Common.Error."
+                                 "InternalFailure"},
+                     {"Timestamp", static_cast<uint64_t>(
+                                       1500000000000ull + i * 1000)},
+                     {"Resolved", false},
+                     {"AdditionalData", Strings{"_PID=1"}}}},
+                   {deleteInterface, {}},
+                   {"org.openbmc.Associations",
+                    {{"associations", Value::Associations{}}}}});
+        }
+
+        // A hwmon instance per 32 sensors
+        for (size_t i = 0; i < scale.sensors; ++i)
+        {
+            store(std::string(sensorRoot) + "/temp" + std::to_string(i),
+                  "xyz.openbmc_project.Hwmon-" + std::to_string(i / 32),
+                  {{"xyz.openbmc_project.Sensor.Value",
+                    {{"Value", static_cast<int64_t>(25000 + i)},
+                     {"Unit", "xyz.openbmc_project.Sensor.Value.Unit."
+                              "DegreesC"},
+                     {"Scale", static_cast<int64_t>(-3)}}}});
+        }
+
+        store(inventoryRoot, inventoryService, Interfaces(manager));
+        store(std::string(inventoryRoot) + "/system", inventoryService,
+              {{"xyz.openbmc_project.Inventory.Item",
+                {{"Present", true}, {"PrettyName", "System"}}}});
+        store(motherboardPath, inventoryService,
+              {{"xyz.openbmc_project.Inventory.Item",
+                {{"Present", true}, {"PrettyName", "Motherboard"}}}});
+        for (size_t i = 0; i < scale.inventoryItems; ++i)
+        {
+            auto index = std::to_string(i);
+            store(std::string(motherboardPath) + "/dimm" + index,
+                  inventoryService,
+                  {{"xyz.openbmc_project.Inventory.Item",
+                    {{"Present", true}, {"PrettyName", "DIMM " + index}}},
+                   {"xyz.openbmc_project.Inventory.Decorator.Asset",
+                    {{"Manufacturer", "Mock"},
+                     {"PartNumber", "PN" + index},
+                     {"SerialNumber", "SN" + index}}}});
+        }
+
+        store(networkRoot, networkService, Interfaces(manager));
+        store(std::string(networkRoot) + "/config", networkService,
+              {{"xyz.openbmc_project.Network.SystemConfiguration",
+                {{"HostName", "bmc"}, {"DefaultGateway", "10.0.0.1"}}}});
+        for (size_t i = 0; i < scale.networkInterfaces; ++i)
+        {
+            auto name = "eth" + std::to_string(i);
+            auto path = std::string(networkRoot) + "/" + name;
+            auto subnet = "10.0." + std::to_string(i) + ".";
+            char mac[18];
+            snprintf(mac, sizeof(mac), "02:00:00:00:%02zx:%02zx",
+                     (i >> 8) & 0xff, i & 0xff);
+            store(path, networkService,
+                  {{"xyz.openbmc_project.Network.EthernetInterface",
+                    {{"InterfaceName", name}, {"DHCPEnabled", false}}},
+                   {"xyz.openbmc_project.Network.MACAddress",
+                    {{"MACAddress", mac}}}});
+            store(path + "/ipv4/1", networkService,
+                  {{"xyz.openbmc_project.Network.IP",
+                    {{"Address", subnet + "2"},
+                     {"PrefixLength", static_cast<uint8_t>(24)},
+                     {"Gateway", subnet + "1"},
+                     {"Type", "xyz.openbmc_project.Network.IP.Protocol."
+                              "IPv4"},
+                     {"Origin", "xyz.openbmc_project.Network.IP."
+                                "AddressOrigin.Static"}}},
+                   {deleteInterface, {}}});
+        }
+
+        store(hostTimePath, timeService,
+              {{"xyz.openbmc_project.Time.EpochTime",
+                {{"Elapsed", static_cast<uint64_t>(1500000000000000ull)}}}});
+    });
+}
+
+void MockBus::addObject(const std::string& path, const std::string& service,
+                        const Interfaces& interfaces)
+{
+    run([this, &path, &service, &interfaces]()
+    {
+        store(path, service, Interfaces(interfaces));
+
+        sd_bus_message* signal = nullptr;
+        auto r = sd_bus_message_new_signal(server, &signal,
+                                           managerOf(path).c_str(),
+                                           objectManagerInterface,
+                                           "InterfacesAdded");
+        if (r >= 0)
+        {
+            r = sd_bus_message_append(signal, "o", path.c_str());
+        }
+        if (r >= 0)
+        {
+            r = appendInterfaces(signal, interfaces);
+        }
+        if (r >= 0)
+        {
+            sd_bus_send(nullptr, signal, nullptr);
+        }
+        sd_bus_message_unref(signal);
+    });
+}
+
+void MockBus::removeObject(const std::string& path)
+{
+    run([this, &path]()
+    {
+        erase(path);
+    });
+}
+
+bool MockBus::hasObject(const std::string& path)
+{
+    bool found = false;
+    run([this, &path, &found]()
+    {
+        found = objects.count(path) != 0;
+    });
+    return found;
+}
+
+size_t MockBus::countObjects(const std::string& root)
+{
+    size_t count = 0;
+    run([this, &root, &count]()
+    {
+        count = below(root, 0, {}).size();
+    });
+    return count;
+}
+
+void MockBus::setProperty(const std::string& path,
+                          const std::string& interface,
+                          const std::string& property, const Value& value)
+{
+    run([this, &path, &interface, &property, &value]()
+    {
+        auto& properties = objects.at(path).interfaces.at(interface);
+        properties.erase(property);
+        properties.emplace(property, value);
+        emitPropertyChanged(path, interface, property, value);
+    });
+}
+
+void MockBus::emitSignal(const std::string& path, const std::string& interface,
+                         const std::string& member, Append&& append)
+{
+    run([this, &path, &interface, &member, &append]()
+    {
+        sd_bus_message* signal = nullptr;
+        auto r = sd_bus_message_new_signal(server, &signal, path.c_str(),
+                                           interface.c_str(),
+                                           member.c_str());
+        if (r >= 0)
+        {
+            r = append(signal);
+        }
+        if (r >= 0)
+        {
+            sd_bus_send(nullptr, signal, nullptr);
+        }
+        sd_bus_message_unref(signal);
+    });
+}
+
+void MockBus::addMethod(const std::string& interface,
+                        const std::string& member, Method&& method)
+{
+    run([this, &interface, &member, &method]()
+    {
+        methods[std::make_pair(interface, member)] = std::move(method);
+    });
+}
+
+size_t MockBus::calls(const std::string& interface, const std::string& member)
+{
+    size_t count = 0;
+    run([this, &interface, &member, &count]()
+    {
+        auto found = served.find(std::make_pair(interface, member));
+        count = found == served.end() ? 0 : found->second;
+    });
+    return count;
+}
+
+void MockBus::resetCalls()
+{
+    run([this]()
+    {
+        served.clear();
+    });
+}
+
+} // namespace test
+} // namespace ipmi
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <systemd/sd-bus.h>
+#include <systemd/sd-event.h>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace ipmi
+{
+namespace test
+{
+
+constexpr auto mapperBusName = "xyz.openbmc_project.ObjectMapper";
+constexpr auto mapperPath = "/xyz/openbmc_project/object_mapper";
+constexpr auto mapperInterface = "xyz.openbmc_project.ObjectMapper";
+
+constexpr auto loggingService = "xyz.openbmc_project.Logging";
+constexpr auto loggingPath = "/xyz/openbmc_project/logging";
+constexpr auto logEntryRoot = "/xyz/openbmc_project/logging/entry";
+
+constexpr auto sensorRoot = "/xyz/openbmc_project/sensors/temperature";
+
+constexpr auto inventoryService = "xyz.openbmc_project.Inventory.Manager";
+constexpr auto inventoryRoot = "/xyz/openbmc_project/inventory";
+constexpr auto motherboardPath =
+    "/xyz/openbmc_project/inventory/system/chassis/motherboard";
+
+constexpr auto networkService = "xyz.openbmc_project.Network";
+constexpr auto networkRoot = "/xyz/openbmc_project/network";
+
+constexpr auto timeService = "xyz.openbmc_project.Time.Manager";
+constexpr auto hostTimePath = "/xyz/openbmc_project/time/host";
+
+/** @class Value
+ *  @brief A property value, of one of the D-Bus types the providers read.
+ *
+ *  Integer literals have to be cast to the intended type.
+ */
+class Value
+{
+    public:
+        using Associations =
+            std::vector<std::tuple<std::string, std::string, std::string>>;
+
+        Value(bool value) : signature("b"), boolean(value) {}
+        Value(uint8_t value) : signature("y"), unsigned64(value) {}
+        Value(uint32_t value) : signature("u"), unsigned64(value) {}
+        Value(uint64_t value) : signature("t"), unsigned64(value) {}
+        Value(int64_t value) : signature("x"), signed64(value) {}
+        Value(double value) : signature("d"), real(value) {}
+        Value(const char* value) : signature("s"), string(value) {}
+        Value(const std::string& value) : signature("s"), string(value) {}
+        Value(const std::vector<std::string>& value) :
+            signature("as"), strings(value) {}
+        Value(const Associations& value) :
+            signature("a(sss)"), associations(value) {}
+
+        /** @brief D-Bus signature of the value */
+        const std::string& type() const
+        {
+            return signature;
+        }
+
+        bool getBool() const
+        {
+            return boolean;
+        }
+
+        uint64_t getUnsigned() const
+        {
+            return unsigned64;
+        }
+
+        int64_t getSigned() const
+        {
+            return signed64;
+        }
+
+        const std::string& getString() const
+        {
+            return string;
+        }
+
+        /** @brief Appends the value to a message, as a variant
+         *
+         *  @return 0 on success, a negative errno otherwise.
+         */
+        int append(sd_bus_message* m) const;
+
+        /** @brief Reads a variant of the same type as the value from a
+         *         message
+         *
+         *  @return 0 on success, -EINVAL if the variant holds another type,
+         *          a negative errno otherwise.
+         */
+        int read(sd_bus_message* m);
+
+    private:
+        std::string signature;
+        bool boolean = false;
+        uint64_t unsigned64 = 0;
+        int64_t signed64 = 0;
+        double real = 0;
+        std::string string;
+        std::vector<std::string> strings;
+        Associations associations;
+};
+
+/** @class MockBus
+ *  @brief Stand-in for the BMC's D-Bus services, to run the providers on a
+ *         build host.
+ *
+ *  The providers get a client connection to a private sd-bus server over a
+ *  socketpair, there is no dbus-daemon. A thread serves the object mapper,
+ *  org.freedesktop.DBus.Properties, ObjectManager and the Delete and
+ *  DeleteAll methods from a store of objects, whatever bus name a call is
+ *  addressed to. Other methods can be added with addMethod().
+ *
+ *  The store is only touched on that thread, every other member function
+ *  waits for it to be done there.
+ */
+class MockBus
+{
+    public:
+        using Properties = std::map<std::string, Value>;
+        using Interfaces = std::map<std::string, Properties>;
+
+        /** @brief Answers a method call, on the service thread
+         *
+         *  @param[in] call - The method call, to read arguments from and
+         *                    reply to with sd_bus_reply_method_*.
+         *
+         *  @return A negative errno to reply with an error.
+         */
+        using Method = std::function<int(sd_bus_message* call)>;
+
+        /** @brief Appends the arguments of a signal, on the service thread
+         *
+         *  @return A negative errno on failure.
+         */
+        using Append = std::function<int(sd_bus_message* signal)>;
+
+        /** @struct Scale
+         *  @brief Number of objects populate() creates per service.
+         */
+        struct Scale
+        {
+            size_t logEntries = 0;
+            size_t sensors = 0;
+            size_t inventoryItems = 0;
+            size_t networkInterfaces = 0;
+        };
+
+        MockBus();
+        ~MockBus();
+        MockBus(const MockBus&) = delete;
+        MockBus& operator=(const MockBus&) = delete;
+        MockBus(MockBus&&) = delete;
+        MockBus& operator=(MockBus&&) = delete;
+
+        /** @brief The latest MockBus, the one ipmid_get_sd_bus_connection()
+         *         returns in tests, or nullptr.
+         */
+        static MockBus* current();
+
+        /** @brief Client connection, for the code under test */
+        sd_bus* bus() const
+        {
+            return client;
+        }
+
+        /** @brief Event loop of the client connection */
+        sd_event* event() const
+        {
+            return clientEvent;
+        }
+
+        /** @brief Runs the client events that are ready, e.g. signals from
+         *         the services and work posted by the providers.
+         */
+        void process();
+
+        /** @brief Creates the objects of the logging, sensor, inventory,
+         *         network and time services
+         *
+         *  Log entry N, N from 1, is logEntryRoot/N. Sensor N, from 0, is
+         *  sensorRoot/tempN. Inventory item N is motherboardPath/dimmN and
+         *  network interface N is networkRoot/ethN, with an IPv4 address.
+         */
+        void populate(const Scale& scale);
+
+        /** @brief Adds an object, replacing any at path
+         *
+         *  InterfacesAdded is emitted from the closest ancestor implementing
+         *  the ObjectManager.
+         */
+        void addObject(const std::string& path, const std::string& service,
+                       const Interfaces& interfaces);
+
+        /** @brief Removes an object, emitting InterfacesRemoved */
+        void removeObject(const std::string& path);
+
+        bool hasObject(const std::string& path);
+
+        /** @brief Number of objects below root, root excluded */
+        size_t countObjects(const std::string& root);
+
+        /** @brief Updates a property, emitting PropertiesChanged */
+        void setProperty(const std::string& path, const std::string& interface,
+                         const std::string& property, const Value& value);
+
+        /** @brief Emits a signal that is not about the objects of the
+         *         store, e.g. a request of the IPMI bridge.
+         */
+        void emitSignal(const std::string& path, const std::string& interface,
+                        const std::string& member, Append&& append);
+
+        /** @brief Handles interface.member calls on every object, before the
+         *         built in methods.
+         */
+        void addMethod(const std::string& interface, const std::string& member,
+                       Method&& method);
+
+        /** @brief Number of interface.member calls served so far */
+        size_t calls(const std::string& interface, const std::string& member);
+
+        /** @brief Forgets the calls served so far */
+        void resetCalls();
+
+    private:
+        struct Object
+        {
+            std::string service;
+            Interfaces interfaces;
+        };
+
+        using Objects = std::map<std::string, Object>;
+
+        /** @brief Runs work on the service thread and waits for it */
+        void run(std::function<void()>&& work);
+
+        void serve(int fd);
+
+        static int onWork(sd_event_source* source, int fd, uint32_t revents,
+                          void* userData);
+        static int onMessage(sd_bus_message* m, void* userData,
+                             sd_bus_error* error);
+
+        int dispatch(sd_bus_message* m);
+        int getObject(sd_bus_message* m);
+        int getSubTree(sd_bus_message* m, bool pathsOnly);
+        int getProperty(sd_bus_message* m, const Object& object);
+        int getAllProperties(sd_bus_message* m, const Object& object);
+        int setPropertyCall(sd_bus_message* m, Object& object);
+        int getManagedObjects(sd_bus_message* m, const std::string& root);
+        int deleteAll(sd_bus_message* m, const std::string& root);
+
+        void store(const std::string& path, const std::string& service,
+                   Interfaces&& interfaces);
+        void erase(const std::string& path);
+        void emitPropertyChanged(const std::string& path,
+                                 const std::string& interface,
+                                 const std::string& property,
+                                 const Value& value);
+        std::string managerOf(const std::string& path) const;
+
+        /** @brief Objects strictly below root, at most depth levels down,
+         *         0 for any, implementing one of interfaces, if any.
+         */
+        std::vector<Objects::const_iterator> below(
+            const std::string& root, int depth,
+            const std::vector<std::string>& interfaces) const;
+
+        sd_bus* client = nullptr;
+        sd_event* clientEvent = nullptr;
+
+        std::thread service;
+        sd_bus* server = nullptr;
+        sd_event* serverEvent = nullptr;
+        int wakeFd = -1;
+
+        std::mutex lock;
+        std::condition_variable ready;
+        bool started = false;
+        std::deque<std::function<void()>> work;
+
+        Objects objects;
+        std::map<std::pair<std::string, std::string>, Method> methods;
+        std::map<std::pair<std::string, std::string>, size_t> served;
+};
+
+} // namespace test
+} // namespace ipmi
@@ -0,0 +1,97 @@
+#include <functional>
+#include <memory>
+#include <stdio.h>
+#include <host-ipmid/ipmid-api.h>
+#include <host-ipmid/ipmid-async.hpp>
+#include "ipmid.hpp"
+#include "dispatch.hpp"
+#include "mock-bus.hpp"
+#include "stats.hpp"
+
+// Stands in for ipmid in the tests of the providers. The handlers register
+// in the dispatch table, the tests call them from there, and they reach
+// D-Bus through the current MockBus.
+
+using ipmi::test::MockBus;
+
+FILE *ipmiio = stderr, *ipmidbus = stderr, *ipmicmddetails = stderr;
+
+unsigned short g_sel_reserve = 0xFFFF;
+
+unsigned short get_sel_reserve_id(void)
+{
+    return g_sel_reserve;
+}
+
+void ipmi_register_callback(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                            ipmi_context_t context, ipmid_callback_t handler,
+                            ipmi_cmd_privilege_t priv)
+{
+    ipmi::dispatch::table().add(netfn, cmd, context, handler, priv);
+}
+
+void ipmi_register_callback_concurrency(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                                        ipmi_context_t context,
+                                        ipmid_callback_t handler,
+                                        ipmi_cmd_privilege_t priv,
+                                        ipmi_cmd_concurrency_t concurrency)
+{
+    ipmi::dispatch::table().add(netfn, cmd, context, handler, priv,
+                                concurrency);
+}
+
+void ipmi_register_async_callback(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                                  ipmi_context_t context,
+                                  ipmid_async_callback_t handler,
+                                  ipmi_cmd_privilege_t priv)
+{
+    ipmi::dispatch::table().add(netfn, cmd, context, handler, priv);
+}
+
+// The statistics object is ipmid's, the tests read the counters directly.
+void ipmi::stats::setSELReadAhead(SELReadAhead&& source)
+{
+}
+
+void ipmi_register_read_only(ipmi_netfn_t netfn, ipmi_cmd_t cmd)
+{
+    ipmi::dispatch::table().markReadOnly(netfn, cmd);
+}
+
+sd_bus *ipmid_get_sd_bus_connection(void)
+{
+    return MockBus::current()->bus();
+}
+
+sd_event *ipmid_get_sd_event_connection(void)
+{
+    return MockBus::current()->event();
+}
+
+sd_bus_slot *ipmid_get_sd_bus_slot(void)
+{
+    return nullptr;
+}
+
+static int run_posted_work(sd_event_source *source, void *userdata)
+{
+    std::unique_ptr<std::function<void()>> work(
+        static_cast<std::function<void()>*>(userdata));
+    sd_event_source_unref(source);
+    (*work)();
+    return 0;
+}
+
+// Runs from MockBus::process(), like ipmid runs it from its event loop.
+void ipmid_post(std::function<void()>&& work)
+{
+    auto data = new std::function<void()>(std::move(work));
+    sd_event_source *source = nullptr;
+
+    if (sd_event_add_defer(ipmid_get_sd_event_connection(), &source,
+                           run_posted_work, data) < 0)
+    {
+        std::unique_ptr<std::function<void()>> inlineWork(data);
+        (*inlineWork)();
+    }
+}
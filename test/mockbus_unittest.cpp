@@ -0,0 +1,238 @@
+#include "mock-bus.hpp"
+#include <gtest/gtest.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using ipmi::test::MockBus;
+
+namespace
+{
+
+constexpr auto propertiesInterface = "org.freedesktop.DBus.Properties";
+
+/** @brief Calls a mapper method returning paths */
+std::vector<std::string> getSubTreePaths(MockBus& mock, const char* root,
+                                         int32_t depth,
+                                         const char* interface)
+{
+    sd_bus_message* reply = nullptr;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    std::vector<std::string> paths;
+
+    auto r = sd_bus_call_method(mock.bus(), ipmi::test::mapperBusName,
+                                ipmi::test::mapperPath,
+                                ipmi::test::mapperInterface,
+                                "GetSubTreePaths", &error, &reply, "sias",
+                                root, depth, 1, interface);
+    EXPECT_LE(0, r);
+    if (r >= 0)
+    {
+        r = sd_bus_message_enter_container(reply, 'a', "s");
+        const char* path = nullptr;
+        while (r >= 0 && (r = sd_bus_message_read(reply, "s", &path)) > 0)
+        {
+            paths.emplace_back(path);
+        }
+    }
+
+    sd_bus_error_free(&error);
+    sd_bus_message_unref(reply);
+    return paths;
+}
+
+int onPropertiesChanged(sd_bus_message* m, void* userData,
+                        sd_bus_error* error)
+{
+    ++*static_cast<int*>(userData);
+    return 0;
+}
+
+} // namespace
+
+TEST(MockBus, MapperFindsPopulatedObjects)
+{
+    MockBus mock;
+    MockBus::Scale scale;
+    scale.logEntries = 5000;
+    scale.sensors = 300;
+    mock.populate(scale);
+
+    EXPECT_EQ(&mock, MockBus::current());
+    EXPECT_EQ(5000u, getSubTreePaths(mock, ipmi::test::logEntryRoot, 0,
+                                    "xyz.openbmc_project.Logging.Entry")
+                        .size());
+    EXPECT_EQ(300u, getSubTreePaths(mock, "/xyz/openbmc_project/sensors", 0,
+                                   "xyz.openbmc_project.Sensor.Value")
+                       .size());
+    // The sensors are two levels below
+    EXPECT_EQ(0u, getSubTreePaths(mock, "/xyz/openbmc_project/sensors", 1,
+                                  "xyz.openbmc_project.Sensor.Value")
+                      .size());
+    EXPECT_EQ(3u, mock.calls(ipmi::test::mapperInterface, "GetSubTreePaths"));
+}
+
+TEST(MockBus, GetObjectNamesTheService)
+{
+    MockBus mock;
+    MockBus::Scale scale;
+    scale.sensors = 40;
+    mock.populate(scale);
+
+    sd_bus_message* reply = nullptr;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    auto path = std::string(ipmi::test::sensorRoot) + "/temp33";
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), ipmi::test::mapperBusName,
+                                    ipmi::test::mapperPath,
+                                    ipmi::test::mapperInterface, "GetObject",
+                                    &error, &reply, "sas", path.c_str(), 0));
+
+    const char* service = nullptr;
+    ASSERT_LE(0, sd_bus_message_enter_container(reply, 'a', "{sas}"));
+    ASSERT_LT(0, sd_bus_message_enter_container(reply, 'e', "sas"));
+    ASSERT_LT(0, sd_bus_message_read(reply, "s", &service));
+    EXPECT_STREQ("xyz.openbmc_project.Hwmon-1", service);
+    sd_bus_message_unref(reply);
+
+    EXPECT_GT(0, sd_bus_call_method(mock.bus(), ipmi::test::mapperBusName,
+                                    ipmi::test::mapperPath,
+                                    ipmi::test::mapperInterface, "GetObject",
+                                    &error, &reply, "sas",
+                                    "/xyz/openbmc_project/none", 0));
+    EXPECT_STREQ("xyz.openbmc_project.Common.Error.ResourceNotFound",
+                 error.name);
+    sd_bus_error_free(&error);
+}
+
+TEST(MockBus, PropertiesCanBeReadAndSet)
+{
+    MockBus mock;
+    MockBus::Scale scale;
+    scale.sensors = 1;
+    mock.populate(scale);
+
+    int changes = 0;
+    sd_bus_slot* slot = nullptr;
+    ASSERT_LE(0, sd_bus_add_match(mock.bus(), &slot,
+                                  "type='signal',member='PropertiesChanged'",
+                                  onPropertiesChanged, &changes));
+
+    auto path = std::string(ipmi::test::sensorRoot) + "/temp0";
+    sd_bus_message* reply = nullptr;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    int64_t value = 0;
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), "xyz.openbmc_project.Hwmon-0",
+                                    path.c_str(), propertiesInterface, "Get",
+                                    &error, &reply, "ss",
+                                    "xyz.openbmc_project.Sensor.Value",
+                                    "Value"));
+    ASSERT_LE(0, sd_bus_message_read(reply, "v", "x", &value));
+    EXPECT_EQ(25000, value);
+    sd_bus_message_unref(reply);
+
+    mock.setProperty(path, "xyz.openbmc_project.Sensor.Value", "Value",
+                     static_cast<int64_t>(30000));
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), "xyz.openbmc_project.Hwmon-0",
+                                    path.c_str(), propertiesInterface, "Set",
+                                    &error, nullptr, "ssv",
+                                    "xyz.openbmc_project.Sensor.Value",
+                                    "Value", "x", static_cast<int64_t>(31000)));
+
+    // A value of the wrong type is refused
+    EXPECT_GT(0, sd_bus_call_method(mock.bus(), "xyz.openbmc_project.Hwmon-0",
+                                    path.c_str(), propertiesInterface, "Set",
+                                    &error, nullptr, "ssv",
+                                    "xyz.openbmc_project.Sensor.Value",
+                                    "Value", "s", "hot"));
+    sd_bus_error_free(&error);
+
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), "xyz.openbmc_project.Hwmon-0",
+                                    path.c_str(), propertiesInterface, "Get",
+                                    &error, &reply, "ss",
+                                    "xyz.openbmc_project.Sensor.Value",
+                                    "Value"));
+    ASSERT_LE(0, sd_bus_message_read(reply, "v", "x", &value));
+    EXPECT_EQ(31000, value);
+    sd_bus_message_unref(reply);
+
+    mock.process();
+    EXPECT_EQ(2, changes);
+    sd_bus_slot_unref(slot);
+}
+
+TEST(MockBus, DeleteRemovesObjects)
+{
+    MockBus mock;
+    MockBus::Scale scale;
+    scale.logEntries = 10;
+    mock.populate(scale);
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    auto path = std::string(ipmi::test::logEntryRoot) + "/3";
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), ipmi::test::loggingService,
+                                    path.c_str(),
+                                    "xyz.openbmc_project.Object.Delete",
+                                    "Delete", &error, nullptr, ""));
+    EXPECT_FALSE(mock.hasObject(path));
+    EXPECT_EQ(9u, mock.countObjects(ipmi::test::logEntryRoot));
+
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), ipmi::test::loggingService,
+                                    ipmi::test::loggingPath,
+                                    "xyz.openbmc_project.Collection.DeleteAll",
+                                    "DeleteAll", &error, nullptr, ""));
+    EXPECT_EQ(0u, mock.countObjects(ipmi::test::logEntryRoot));
+    EXPECT_TRUE(mock.hasObject(ipmi::test::loggingPath));
+}
+
+TEST(MockBus, GetManagedObjectsReturnsTheService)
+{
+    MockBus mock;
+    MockBus::Scale scale;
+    scale.networkInterfaces = 2;
+    scale.inventoryItems = 4;
+    mock.populate(scale);
+
+    sd_bus_message* reply = nullptr;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), ipmi::test::networkService,
+                                    ipmi::test::networkRoot,
+                                    "org.freedesktop.DBus.ObjectManager",
+                                    "GetManagedObjects", &error, &reply, ""));
+
+    size_t objects = 0;
+    ASSERT_LE(0, sd_bus_message_enter_container(reply, 'a', "{oa{sa{sv}}}"));
+    while (sd_bus_message_enter_container(reply, 'e', "oa{sa{sv}}") > 0)
+    {
+        ++objects;
+        ASSERT_LE(0, sd_bus_message_skip(reply, "oa{sa{sv}}"));
+        ASSERT_LE(0, sd_bus_message_exit_container(reply));
+    }
+    sd_bus_message_unref(reply);
+
+    // config, and an interface and its address per interface
+    EXPECT_EQ(5u, objects);
+}
+
+TEST(MockBus, AddedMethodsAreCalled)
+{
+    MockBus mock;
+    mock.addMethod("xyz.openbmc_project.Test", "Echo",
+                   [](sd_bus_message* m)
+                   {
+                       uint32_t value = 0;
+                       auto r = sd_bus_message_read(m, "u", &value);
+                       return r < 0 ? r :
+                              sd_bus_reply_method_return(m, "u", value + 1);
+                   });
+
+    sd_bus_message* reply = nullptr;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    uint32_t value = 0;
+    ASSERT_LE(0, sd_bus_call_method(mock.bus(), "xyz.openbmc_project.Test",
+                                    "/", "xyz.openbmc_project.Test", "Echo",
+                                    &error, &reply, "u", 41));
+    ASSERT_LE(0, sd_bus_message_read(reply, "u", &value));
+    EXPECT_EQ(42u, value);
+    sd_bus_message_unref(reply);
+    EXPECT_EQ(1u, mock.calls("xyz.openbmc_project.Test", "Echo"));
+}
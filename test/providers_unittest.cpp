@@ -0,0 +1,142 @@
+#include "dispatch.hpp"
+#include "providers.hpp"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+using namespace ipmi::providers;
+
+class ProvidersManifest : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            char name[] = "/tmp/ipmid-providers-XXXXXX";
+            ASSERT_NE(nullptr, mkdtemp(name));
+            directory = std::string(name) + "/";
+            path = directory + "manifest";
+        }
+
+        void TearDown() override
+        {
+            unlink(path.c_str());
+            unlink((directory + "libbroken.so").c_str());
+            rmdir(directory.c_str());
+        }
+
+        void write(const std::string& text)
+        {
+            std::ofstream file(path);
+            file << text;
+        }
+
+        std::string directory;
+        std::string path;
+};
+
+TEST_F(ProvidersManifest, ReadsBackWhatIsWritten)
+{
+    Manifest manifest(2);
+    manifest[0].name = "libapphandler.so";
+    manifest[0].commands = {{0x06, 0x01}, {0x06, 0x22}, {0x2c, 0xff}};
+    manifest[1].name = "libsysintfcmds.so";
+    manifest[1].eager = true;
+    manifest[1].commands = {{0x06, 0x31}};
+    ASSERT_TRUE(writeManifest(path, manifest));
+
+    Manifest read;
+    ASSERT_TRUE(readManifest(path, read));
+    ASSERT_EQ(2u, read.size());
+    for (size_t i = 0; i < read.size(); ++i)
+    {
+        EXPECT_EQ(manifest[i].name, read[i].name);
+        EXPECT_EQ(manifest[i].eager, read[i].eager);
+        EXPECT_EQ(manifest[i].commands, read[i].commands);
+    }
+}
+
+TEST_F(ProvidersManifest, SkipsCommentsAndBlankLines)
+{
+    write("# Providers\n"
+          "\n"
+          "libstorage.so 0x0a:0x40   0x0A:0x43\n"
+          "   \n"
+          "libempty.so\n");
+
+    Manifest manifest;
+    ASSERT_TRUE(readManifest(path, manifest));
+    ASSERT_EQ(2u, manifest.size());
+    EXPECT_EQ("libstorage.so", manifest[0].name);
+    EXPECT_FALSE(manifest[0].eager);
+    std::vector<std::pair<uint8_t, uint8_t>> commands{{0x0a, 0x40},
+                                                      {0x0a, 0x43}};
+    EXPECT_EQ(commands, manifest[0].commands);
+    EXPECT_EQ("libempty.so", manifest[1].name);
+    EXPECT_TRUE(manifest[1].commands.empty());
+}
+
+TEST_F(ProvidersManifest, RejectsMalformedCommands)
+{
+    const char* lines[] = {
+        "lib.so 0x06\n",        // No command
+        "lib.so 0x06:\n",       // Empty command
+        "lib.so 0x40:0x01\n",   // NetFn out of range
+        "lib.so 0x06:0x100\n",  // Command out of range
+        "lib.so 0x06:0x01x\n",  // Trailing garbage
+        "lib.so lazy\n",        // Unknown keyword
+    };
+
+    for (auto line : lines)
+    {
+        write(line);
+        Manifest manifest(1);
+        EXPECT_FALSE(readManifest(path, manifest)) << line;
+        // Left as it was
+        EXPECT_EQ(1u, manifest.size()) << line;
+    }
+}
+
+TEST_F(ProvidersManifest, MissingFile)
+{
+    Manifest manifest;
+    EXPECT_FALSE(readManifest(directory + "missing", manifest));
+}
+
+TEST_F(ProvidersManifest, CommandsWithoutProviderLoadNothing)
+{
+    Loader loader;
+    loader.loadEager(directory, Manifest());
+    EXPECT_TRUE(loader.manifest().empty());
+    EXPECT_FALSE(loader.load(0x06, 0x01));
+    EXPECT_FALSE(loader.load(0x3f, 0xff));
+    EXPECT_FALSE(loader.load(0x40, 0x01));
+}
+
+TEST_F(ProvidersManifest, DeferredProviderIsOpenedOnce)
+{
+    // Not a library, dlopen() fails on it.
+    std::ofstream(directory + "libbroken.so") << "broken";
+
+    Manifest manifest(1);
+    manifest[0].name = "libbroken.so";
+    manifest[0].commands = {{0x30, 0x01}, {0x31, 0xff}};
+
+    Loader loader;
+    loader.loadEager(directory, manifest);
+    EXPECT_TRUE(loader.manifest().empty());
+
+    auto& table = ipmi::dispatch::table();
+    table.freeze();
+    EXPECT_FALSE(loader.load(0x30, 0x02));
+    // The wildcard of NetFn 0x31 maps every command to the provider.
+    EXPECT_FALSE(loader.load(0x31, 0x05));
+    EXPECT_TRUE(table.isFrozen());
+    EXPECT_TRUE(loader.manifest().empty());
+
+    // Not retried once it failed.
+    EXPECT_FALSE(loader.load(0x30, 0x01));
+    EXPECT_TRUE(loader.manifest().empty());
+}
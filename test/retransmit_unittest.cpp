@@ -0,0 +1,134 @@
+#include "retransmit.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <host-ipmid/ipmid-api.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+using namespace ipmi::retransmit;
+
+namespace
+{
+
+constexpr auto bridge = ":1.42";
+
+const uint8_t addSel[] = {0x00, 0x00, 0x02, 0x10, 0x20, 0x30};
+
+Request addSelRequest(uint8_t seq)
+{
+    return Request{seq, 0x0a, 0, 0x44, hash(addSel, sizeof(addSel))};
+}
+
+class RetransmitCache : public ::testing::Test
+{
+    protected:
+        Match lookup(const Request& request, const char* sender = bridge)
+        {
+            return cache.request(sender, request, cc, data);
+        }
+
+        void answer(const Request& request, uint8_t code = IPMI_CC_OK)
+        {
+            const uint8_t recordId[] = {0x01, 0x00};
+            cache.response(bridge, request, code, recordId,
+                           sizeof(recordId));
+        }
+
+        Cache cache;
+        uint8_t cc = 0xff;
+        std::vector<uint8_t> data;
+};
+
+} // namespace
+
+TEST(RetransmitHash, DependsOnEveryByte)
+{
+    uint8_t other[sizeof(addSel)];
+    std::copy(addSel, addSel + sizeof(addSel), other);
+    other[sizeof(other) - 1] ^= 1;
+    EXPECT_NE(hash(addSel, sizeof(addSel)), hash(other, sizeof(other)));
+    EXPECT_NE(hash(addSel, 0), hash(addSel, 1));
+}
+
+TEST_F(RetransmitCache, RetryGetsTheResponse)
+{
+    auto request = addSelRequest(7);
+    EXPECT_EQ(Match::first, lookup(request));
+    answer(request);
+
+    EXPECT_EQ(Match::answered, lookup(request));
+    EXPECT_EQ(IPMI_CC_OK, cc);
+    EXPECT_EQ((std::vector<uint8_t>{0x01, 0x00}), data);
+    EXPECT_EQ(1u, cache.stats().answered);
+    EXPECT_EQ(0u, cache.stats().inProgress);
+}
+
+TEST_F(RetransmitCache, RetryWhileInProgressIsDropped)
+{
+    auto request = addSelRequest(7);
+    EXPECT_EQ(Match::first, lookup(request));
+    EXPECT_EQ(Match::inProgress, lookup(request));
+    EXPECT_EQ(1u, cache.stats().inProgress);
+
+    answer(request);
+    EXPECT_EQ(Match::answered, lookup(request));
+}
+
+TEST_F(RetransmitCache, OtherRequestsAreNew)
+{
+    auto request = addSelRequest(7);
+    EXPECT_EQ(Match::first, lookup(request));
+    answer(request);
+
+    auto nextSeq = addSelRequest(8);
+    EXPECT_EQ(Match::first, lookup(nextSeq));
+
+    auto otherData = request;
+    otherData.hash ^= 1;
+    EXPECT_EQ(Match::first, lookup(otherData));
+
+    auto otherCmd = request;
+    otherCmd.cmd = 0x43;
+    EXPECT_EQ(Match::first, lookup(otherCmd));
+
+    // Every bridge has sequence numbers of its own
+    EXPECT_EQ(Match::first, lookup(request, ":1.43"));
+
+    EXPECT_EQ(0u, cache.stats().answered);
+}
+
+TEST_F(RetransmitCache, OldestRequestsAreForgotten)
+{
+    for (size_t seq = 0; seq <= ringSize; ++seq)
+    {
+        auto request = addSelRequest(seq);
+        EXPECT_EQ(Match::first, lookup(request));
+        answer(request);
+    }
+
+    EXPECT_EQ(Match::answered, lookup(addSelRequest(ringSize)));
+    EXPECT_EQ(Match::answered, lookup(addSelRequest(1)));
+    EXPECT_EQ(Match::first, lookup(addSelRequest(0)));
+}
+
+TEST_F(RetransmitCache, BusyResponsesAreNotKept)
+{
+    auto request = addSelRequest(7);
+    EXPECT_EQ(Match::first, lookup(request));
+    answer(request, IPMI_CC_BUSY);
+    EXPECT_EQ(Match::first, lookup(request));
+}
+
+TEST(RetransmitCacheAge, OldResponsesDoNotAnswer)
+{
+    Cache cache(std::chrono::milliseconds(10));
+    auto request = addSelRequest(7);
+    uint8_t cc = 0;
+    std::vector<uint8_t> data;
+
+    EXPECT_EQ(Match::first, cache.request(bridge, request, cc, data));
+    cache.response(bridge, request, IPMI_CC_OK, nullptr, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(Match::first, cache.request(bridge, request, cc, data));
+}
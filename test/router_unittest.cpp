@@ -0,0 +1,288 @@
+#include "dispatch.hpp"
+#include "ipmid.hpp"
+#include "mock-bus.hpp"
+#include "sensorhandler.h"
+#include <errno.h>
+#include <functional>
+#include <gtest/gtest.h>
+#include <host-ipmid/ipmid-async.hpp>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// End to end tests of ipmid's request path in ipmid.cpp. The requests come
+// in as signals of the mock bridge, the responses go back to it with
+// sendMessage calls.
+
+// Defined by ipmid.cpp, set up here the way ipmid's main does.
+extern sd_bus *bus;
+extern sd_event *events;
+extern sd_bus_slot *ipmid_slot;
+extern bool restricted_mode;
+int watch_ipmi_requests(void);
+
+namespace internal
+{
+
+struct BridgeStats
+{
+    uint64_t sent;
+    uint64_t failed;
+};
+
+extern std::map<std::string, BridgeStats> bridgeStats;
+
+} // namespace internal
+
+using ipmi::test::MockBus;
+
+namespace
+{
+
+constexpr auto bridgePath = "/org/openbmc/HostIpmi/1";
+constexpr auto bridgeInterface = "org.openbmc.HostIpmi";
+
+/** @struct Response
+ *  @brief A response sent to the bridge.
+ */
+struct Response
+{
+    uint8_t seq;
+    uint8_t netfn;
+    uint8_t cmd;
+    uint8_t cc;
+    std::vector<uint8_t> data;
+};
+
+/** @brief Stands in for the asynchronous Get Sensor Reading of
+ *         sensorhandler.cpp, keeping the responders until the test answers.
+ */
+struct SensorReading
+{
+    static void handle(ipmi_netfn_t netfn, ipmi_cmd_t cmd,
+                       ipmi_request_t request, size_t len,
+                       ipmid_responder_t responder, ipmi_context_t context)
+    {
+        ++calls;
+        responders.push_back(std::move(responder));
+    }
+
+    static size_t calls;
+    static std::vector<ipmid_responder_t> responders;
+};
+
+size_t SensorReading::calls = 0;
+std::vector<ipmid_responder_t> SensorReading::responders;
+
+class Router : public ::testing::Test
+{
+    protected:
+        Router()
+        {
+            static bool registered = false;
+            if (!registered)
+            {
+                ipmi_register_async_callback(NETFUN_SENSOR,
+                                             IPMI_CMD_GET_SENSOR_READING,
+                                             nullptr, SensorReading::handle,
+                                             PRIVILEGE_USER);
+                ipmi_register_read_only(NETFUN_SENSOR,
+                                        IPMI_CMD_GET_SENSOR_READING);
+                registered = true;
+            }
+            SensorReading::calls = 0;
+            SensorReading::responders.clear();
+
+            bus = mock.bus();
+            events = mock.event();
+            restricted_mode = false;
+            EXPECT_LE(0, watch_ipmi_requests());
+
+            mock.addMethod(bridgeInterface, "sendMessage",
+                           [this](sd_bus_message* m)
+                           {
+                               return received(m);
+                           });
+        }
+
+        ~Router()
+        {
+            // Answers what the handler still holds while the bus is up.
+            SensorReading::responders.clear();
+            ipmid_slot = sd_bus_slot_unref(ipmid_slot);
+            bus = nullptr;
+            events = nullptr;
+        }
+
+        /** @brief Sends a request as the bridge does */
+        void request(uint8_t seq, uint8_t netfn, uint8_t cmd,
+                     const std::vector<uint8_t>& data)
+        {
+            mock.emitSignal(bridgePath, bridgeInterface, "ReceivedMessage",
+                            [&](sd_bus_message* signal)
+                            {
+                                auto r = sd_bus_message_append(signal, "yyyy",
+                                                               seq, netfn, 0,
+                                                               cmd);
+                                return r < 0 ? r :
+                                       sd_bus_message_append_array(
+                                           signal, 'y', data.data(),
+                                           data.size());
+                            });
+            mock.process();
+        }
+
+        /** @brief Serves the sendMessage calls, on the service thread */
+        int received(sd_bus_message* m)
+        {
+            Response response{};
+            const void* data = nullptr;
+            size_t size = 0;
+            uint8_t lun = 0;
+            auto r = sd_bus_message_read(m, "yyyyy", &response.seq,
+                                         &response.netfn, &lun,
+                                         &response.cmd, &response.cc);
+            if (r >= 0)
+            {
+                r = sd_bus_message_read_array(m, 'y', &data, &size);
+            }
+            if (r < 0)
+            {
+                return r;
+            }
+            response.data.assign(static_cast<const uint8_t*>(data),
+                                 static_cast<const uint8_t*>(data) + size);
+
+            std::lock_guard<std::mutex> guard(lock);
+            responses.push_back(std::move(response));
+            if (failures > 0)
+            {
+                --failures;
+                return -EIO;
+            }
+            return sd_bus_reply_method_return(m, "x", int64_t(0));
+        }
+
+        /** @brief Runs the event loop until done, for a second at most */
+        bool runUntil(const std::function<bool()>& done)
+        {
+            for (int i = 0; i < 100; ++i)
+            {
+                if (done())
+                {
+                    return true;
+                }
+                sd_event_run(mock.event(), 10000);
+            }
+            return done();
+        }
+
+        /** @brief Runs the event loop until count responses were sent */
+        std::vector<Response> waitFor(size_t count)
+        {
+            runUntil([this, count]()
+                     {
+                         std::lock_guard<std::mutex> guard(lock);
+                         return responses.size() >= count;
+                     });
+            std::lock_guard<std::mutex> guard(lock);
+            return responses;
+        }
+
+        std::mutex lock;
+        std::vector<Response> responses;
+        // sendMessage calls still to fail with an error.
+        size_t failures = 0;
+
+        // Last, its service thread stops before the responses go.
+        MockBus mock;
+};
+
+} // namespace
+
+TEST_F(Router, IdenticalReadOnlyRequestsShareTheResponse)
+{
+    request(0x10, NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, {0x42});
+    request(0x11, NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, {0x42});
+
+    // The second waits for the response to the first
+    EXPECT_EQ(1u, SensorReading::calls);
+    ASSERT_EQ(1u, SensorReading::responders.size());
+    EXPECT_TRUE(waitFor(1).empty());
+
+    SensorReading::responders.front()(IPMI_CC_OK, {0x2A, 0x40, 0x00});
+    auto sent = waitFor(2);
+    ASSERT_EQ(2u, sent.size());
+
+    // Each with its own sequence number
+    EXPECT_NE(sent[0].seq, sent[1].seq);
+    for (const auto& response : sent)
+    {
+        EXPECT_TRUE(response.seq == 0x10 || response.seq == 0x11);
+        EXPECT_EQ(NETFUN_SENSOR | 0x01, response.netfn);
+        EXPECT_EQ(IPMI_CMD_GET_SENSOR_READING, response.cmd);
+        EXPECT_EQ(IPMI_CC_OK, response.cc);
+        EXPECT_EQ(std::vector<uint8_t>({0x2A, 0x40, 0x00}), response.data);
+    }
+
+    // Another request once answered runs the handler again
+    request(0x12, NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, {0x42});
+    EXPECT_EQ(2u, SensorReading::calls);
+}
+
+TEST_F(Router, WaitersGetAnErrorWhenTheResponderIsDropped)
+{
+    request(0x20, NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, {0x43});
+    request(0x21, NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, {0x43});
+    EXPECT_EQ(1u, SensorReading::calls);
+
+    // The handler gives up without answering
+    SensorReading::responders.clear();
+    auto sent = waitFor(2);
+    ASSERT_EQ(2u, sent.size());
+    EXPECT_NE(sent[0].seq, sent[1].seq);
+    for (const auto& response : sent)
+    {
+        EXPECT_EQ(IPMI_CC_UNSPECIFIED_ERROR, response.cc);
+        EXPECT_TRUE(response.data.empty());
+    }
+}
+
+TEST_F(Router, FailedSendsAreCountedAndTheLoopGoesOn)
+{
+    const auto& stats = internal::bridgeStats[""];
+    const auto sent = stats.sent;
+    const auto failed = stats.failed;
+
+    // The bridge fails the first sendMessage
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        failures = 1;
+    }
+    request(0x30, NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, {0x44});
+    ASSERT_EQ(1u, SensorReading::responders.size());
+    SensorReading::responders.back()(IPMI_CC_OK, {0x2A, 0x40, 0x00});
+    ASSERT_EQ(1u, waitFor(1).size());
+    EXPECT_TRUE(runUntil([&]()
+                         {
+                             return stats.failed == failed + 1;
+                         }));
+    EXPECT_EQ(sent + 1, stats.sent);
+
+    // The next request is still handled and its response delivered
+    request(0x31, NETFUN_SENSOR, IPMI_CMD_GET_SENSOR_READING, {0x45});
+    EXPECT_EQ(2u, SensorReading::calls);
+    ASSERT_EQ(2u, SensorReading::responders.size());
+    SensorReading::responders.back()(IPMI_CC_OK, {0x2B, 0x40, 0x00});
+    auto delivered = waitFor(2);
+    ASSERT_EQ(2u, delivered.size());
+    EXPECT_EQ(0x31, delivered.back().seq);
+    EXPECT_EQ(std::vector<uint8_t>({0x2B, 0x40, 0x00}), delivered.back().data);
+    EXPECT_EQ(sent + 2, stats.sent);
+
+    // Its successful reply leaves the failures as they were
+    sd_event_run(mock.event(), 10000);
+    EXPECT_EQ(failed + 1, stats.failed);
+}
@@ -0,0 +1,189 @@
+/*
+ * Compares the SEL index of selindex.cpp against the rescans the SEL
+ * commands used to do: reading the log entry paths from the mapper and
+ * sorting them for every Get SEL Info and Delete SEL Entry, and looking a
+ * record up with std::find on the paths for every Get SEL Entry.
+ *
+ * The log entries are the ones of the mock logging service, with 1000,
+ * 5000 and 10000 entries, or the counts given on the command line.
+ *
+ * Usage: sel_benchmark [entries...]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "mock-bus.hpp"
+#include "selindex.hpp"
+#include "selutility.hpp"
+#include "utils.hpp"
+
+using ipmi::test::MockBus;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double microseconds(Clock::duration elapsed)
+{
+    return std::chrono::duration<double, std::micro>(elapsed).count();
+}
+
+/** @brief What readLoggingObjectPaths() did for every Get SEL Info and
+ *         Delete SEL Entry.
+ */
+std::vector<std::string> rescan(sd_bus* bus)
+{
+    std::vector<std::string> paths;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message* reply = nullptr;
+    auto r = ipmi::callMethod(bus, ipmi::sel::mapperBusName,
+                              ipmi::sel::mapperObjPath, ipmi::sel::mapperIntf,
+                              "GetSubTreePaths", &error, &reply, "sias",
+                              ipmi::sel::logBasePath, 0, 1,
+                              ipmi::sel::logEntryIntf);
+    sd_bus_error_free(&error);
+    if (r < 0)
+    {
+        fprintf(stderr, "GetSubTreePaths failed: %s\n", strerror(-r));
+        return paths;
+    }
+
+    std::vector<std::pair<unsigned long, std::string>> entries;
+    ipmi::visitSubTreePaths(reply,
+                            [&entries](const char* path)
+                            {
+                                auto id = strrchr(path, '/');
+                                entries.emplace_back(
+                                    strtoul(id ? id + 1 : path, nullptr, 10),
+                                    path);
+                                return false;
+                            });
+    sd_bus_message_unref(reply);
+
+    std::sort(entries.begin(), entries.end(),
+              [](const std::pair<unsigned long, std::string>& a,
+                 const std::pair<unsigned long, std::string>& b)
+              {
+                  return a.first < b.first;
+              });
+    for (auto& entry : entries)
+    {
+        paths.push_back(std::move(entry.second));
+    }
+    return paths;
+}
+
+/** @brief What Get SEL Entry did to find a record and the one after it */
+uint16_t findInPaths(const std::vector<std::string>& paths, uint16_t recordId)
+{
+    auto objPath = std::string(ipmi::sel::logBasePath) + "/" +
+                   std::to_string(recordId);
+    auto iter = std::find(paths.begin(), paths.end(), objPath);
+    if (iter == paths.end() || ++iter == paths.end())
+    {
+        return ipmi::sel::lastEntry;
+    }
+    auto id = strrchr(iter->c_str(), '/');
+    return static_cast<uint16_t>(std::stoul(id + 1));
+}
+
+uint16_t findInIndex(const ipmi::sel::Index& index, uint16_t recordId)
+{
+    ipmi::sel::EntryId following = 0;
+    if (!index.contains(recordId) || !index.next(recordId, following))
+    {
+        return ipmi::sel::lastEntry;
+    }
+    return static_cast<uint16_t>(following);
+}
+
+void run(size_t entries)
+{
+    MockBus mock;
+    MockBus::Scale scale;
+    scale.logEntries = entries;
+    mock.populate(scale);
+    auto bus = mock.bus();
+
+    // Get SEL Info, and the lookup of Delete SEL Entry
+    constexpr auto infoRuns = 10;
+    auto start = Clock::now();
+    size_t found = 0;
+    for (auto i = 0; i < infoRuns; ++i)
+    {
+        found += rescan(bus).size();
+    }
+    auto rescanInfo = microseconds(Clock::now() - start) / infoRuns;
+
+    start = Clock::now();
+    ipmi::sel::watchIndex(bus);
+    auto build = microseconds(Clock::now() - start);
+
+    const auto& index = ipmi::sel::index();
+    start = Clock::now();
+    for (auto i = 0; i < infoRuns; ++i)
+    {
+        ipmi::sel::watchIndex(bus);
+        found += index.size();
+    }
+    auto indexInfo = microseconds(Clock::now() - start) / infoRuns;
+
+    // Get SEL Entry, walking the whole SEL
+    auto paths = rescan(bus);
+    start = Clock::now();
+    for (size_t id = 1; id <= entries; ++id)
+    {
+        found += findInPaths(paths, id);
+    }
+    auto rescanEntry = microseconds(Clock::now() - start) / entries;
+
+    start = Clock::now();
+    for (size_t id = 1; id <= entries; ++id)
+    {
+        found += findInIndex(index, id);
+    }
+    auto indexEntry = microseconds(Clock::now() - start) / entries;
+
+    // Keep the lookups from being optimized away.
+    if (found == 0)
+    {
+        fprintf(stderr, "No entry was found\n");
+    }
+
+    printf("%8zu %-20s %14.2f %14.2f\n", entries, "Get SEL Info",
+           rescanInfo, indexInfo);
+    printf("%8zu %-20s %14.2f %14.2f\n", entries, "Get SEL Entry",
+           rescanEntry, indexEntry);
+    printf("%8zu %-20s %14s %14.2f\n", entries, "index read once", "",
+           build);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> counts{1000, 5000, 10000};
+    if (argc > 1)
+    {
+        counts.clear();
+        for (int i = 1; i < argc; ++i)
+        {
+            counts.push_back(strtoul(argv[i], nullptr, 0));
+        }
+    }
+
+    printf("%8s %-20s %14s %14s\n", "entries", "command", "rescan (us)",
+           "index (us)");
+    for (auto entries : counts)
+    {
+        run(entries);
+    }
+
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include "selstore.hpp"
+#include <cstddef>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Tests of the SEL store of selstore.cpp, on files of a temporary directory.
+
+using ipmi::sel::GetSELEntryResponse;
+using ipmi::sel::Store;
+
+namespace
+{
+
+class SELStore : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            char name[] = "/tmp/ipmid-selstore-XXXXXX";
+            ASSERT_NE(nullptr, mkdtemp(name));
+            directory = name;
+            path = directory + "/ipmi/sel";
+        }
+
+        void TearDown() override
+        {
+            unlink(path.c_str());
+            rmdir((directory + "/ipmi").c_str());
+            rmdir(directory.c_str());
+        }
+
+        /** @brief A system event record, for sensor number */
+        static GetSELEntryResponse event(uint8_t number)
+        {
+            GetSELEntryResponse record{};
+            record.recordType = ipmi::sel::systemEventRecord;
+            record.generatorID = 0x0020;
+            record.eventMsgRevision = 0x04;
+            record.sensorType = 0x07;
+            record.sensorNum = number;
+            record.eventType = 0x6F;
+            record.eventData1 = 0x01;
+            return record;
+        }
+
+        std::string directory;
+        std::string path;
+};
+
+} // namespace
+
+TEST_F(SELStore, KeepsTheRecordsAdded)
+{
+    Store store(path, 4);
+    ASSERT_TRUE(store.open());
+    EXPECT_TRUE(store.empty());
+
+    auto first = event(1);
+    ASSERT_TRUE(store.add(first));
+    EXPECT_EQ(ipmi::sel::firstStoreId, first.recordID);
+    EXPECT_NE(0u, first.timeStamp);
+    auto second = event(2);
+    ASSERT_TRUE(store.add(second));
+    EXPECT_EQ(ipmi::sel::firstStoreId + 1, second.recordID);
+
+    GetSELEntryResponse record{};
+    ASSERT_TRUE(store.get(second.recordID, record));
+    EXPECT_EQ(2, record.sensorNum);
+    EXPECT_EQ(ipmi::sel::systemEventRecord, record.recordType);
+    EXPECT_EQ(second.timeStamp, record.timeStamp);
+    EXPECT_EQ(second.timeStamp, store.addTimeStamp());
+
+    uint16_t following = 0;
+    ASSERT_TRUE(store.after(0, following));
+    EXPECT_EQ(first.recordID, following);
+    ASSERT_TRUE(store.after(first.recordID, following));
+    EXPECT_EQ(second.recordID, following);
+    EXPECT_FALSE(store.after(second.recordID, following));
+}
+
+TEST_F(SELStore, SurvivesAReopen)
+{
+    uint16_t id = 0;
+    {
+        Store store(path, 4);
+        auto record = event(3);
+        ASSERT_TRUE(store.add(record));
+        id = record.recordID;
+        auto deleted = event(4);
+        ASSERT_TRUE(store.add(deleted));
+        ASSERT_TRUE(store.erase(deleted.recordID));
+    }
+
+    Store store(path, 4);
+    ASSERT_TRUE(store.open());
+    ASSERT_EQ(1u, store.size());
+    GetSELEntryResponse record{};
+    ASSERT_TRUE(store.get(id, record));
+    EXPECT_EQ(3, record.sensorNum);
+
+    // The IDs carry on from the last record added
+    auto next = event(5);
+    ASSERT_TRUE(store.add(next));
+    EXPECT_EQ(id + 1, next.recordID);
+}
+
+TEST_F(SELStore, DropsTheOldestOnceFull)
+{
+    Store store(path, 3);
+    for (uint8_t i = 0; i < 5; ++i)
+    {
+        auto record = event(i);
+        ASSERT_TRUE(store.add(record));
+    }
+
+    EXPECT_EQ(3u, store.size());
+    EXPECT_EQ(ipmi::sel::firstStoreId + 2, store.first());
+    EXPECT_EQ(ipmi::sel::firstStoreId + 4, store.last());
+
+    store.clear();
+    EXPECT_TRUE(store.empty());
+    Store reopened(path, 3);
+    ASSERT_TRUE(reopened.open());
+    EXPECT_TRUE(reopened.empty());
+}
+
+TEST_F(SELStore, TakesAFreeSlotBeforeTheOldest)
+{
+    Store store(path, 3);
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        auto record = event(i);
+        ASSERT_TRUE(store.add(record));
+    }
+    ASSERT_TRUE(store.erase(ipmi::sel::firstStoreId + 1));
+
+    // The erased record's slot, none of the others is dropped
+    auto record = event(3);
+    ASSERT_TRUE(store.add(record));
+    EXPECT_EQ(ipmi::sel::firstStoreId + 3, record.recordID);
+    EXPECT_EQ(3u, store.size());
+    EXPECT_TRUE(store.contains(ipmi::sel::firstStoreId));
+    EXPECT_TRUE(store.contains(ipmi::sel::firstStoreId + 2));
+
+    // Full again, the oldest makes way
+    record = event(4);
+    ASSERT_TRUE(store.add(record));
+    EXPECT_EQ(3u, store.size());
+    EXPECT_FALSE(store.contains(ipmi::sel::firstStoreId));
+
+    Store reopened(path, 3);
+    ASSERT_TRUE(reopened.open());
+    EXPECT_EQ(3u, reopened.size());
+    EXPECT_EQ(ipmi::sel::firstStoreId + 2, reopened.first());
+    EXPECT_EQ(ipmi::sel::firstStoreId + 4, reopened.last());
+    GetSELEntryResponse kept{};
+    ASSERT_TRUE(reopened.get(ipmi::sel::firstStoreId + 3, kept));
+    EXPECT_EQ(3, kept.sensorNum);
+}
+
+TEST_F(SELStore, KeepsOffTakenIDs)
+{
+    Store store(path, 4);
+    auto taken = [](uint16_t id)
+    {
+        return id == ipmi::sel::firstStoreId;
+    };
+    auto record = event(1);
+    ASSERT_TRUE(store.add(record, taken));
+    EXPECT_EQ(ipmi::sel::firstStoreId + 1, record.recordID);
+    EXPECT_EQ(0u, store.yield(taken));
+
+    // Taken after it was added, the record moves
+    auto later = [](uint16_t id)
+    {
+        return id <= ipmi::sel::firstStoreId + 1;
+    };
+    EXPECT_EQ(1u, store.yield(later));
+    EXPECT_FALSE(store.contains(ipmi::sel::firstStoreId + 1));
+    ASSERT_EQ(1u, store.size());
+
+    Store reopened(path, 4);
+    ASSERT_TRUE(reopened.open());
+    GetSELEntryResponse moved{};
+    ASSERT_TRUE(reopened.get(ipmi::sel::firstStoreId + 2, moved));
+    EXPECT_EQ(ipmi::sel::firstStoreId + 2, moved.recordID);
+    EXPECT_EQ(1, moved.sensorNum);
+    EXPECT_EQ(record.timeStamp, moved.timeStamp);
+}
+
+TEST_F(SELStore, TornRecordsAreFree)
+{
+    {
+        Store store(path, 4);
+        auto kept = event(6);
+        ASSERT_TRUE(store.add(kept));
+        auto torn = event(7);
+        ASSERT_TRUE(store.add(torn));
+    }
+
+    // As if the power went while the second record was written
+    auto fd = open(path.c_str(), O_RDWR);
+    ASSERT_LE(0, fd);
+    uint8_t sensorNum = 8;
+    auto offset = sizeof(ipmi::sel::StoreHeader) +
+                  sizeof(ipmi::sel::StoreSlot) +
+                  offsetof(ipmi::sel::StoreSlot, record) + 11;
+    ASSERT_EQ(1, pwrite(fd, &sensorNum, 1, offset));
+    close(fd);
+
+    Store store(path, 4);
+    ASSERT_TRUE(store.open());
+    ASSERT_EQ(1u, store.size());
+    EXPECT_EQ(ipmi::sel::firstStoreId, store.first());
+}
+
+TEST_F(SELStore, AnotherCapacityStartsOver)
+{
+    {
+        Store store(path, 4);
+        auto record = event(9);
+        ASSERT_TRUE(store.add(record));
+    }
+
+    Store store(path, 8);
+    ASSERT_TRUE(store.open());
+    EXPECT_TRUE(store.empty());
+
+    struct stat st{};
+    ASSERT_EQ(0, stat(path.c_str(), &st));
+    EXPECT_EQ(sizeof(ipmi::sel::StoreHeader) +
+              8 * sizeof(ipmi::sel::StoreSlot),
+              static_cast<size_t>(st.st_size));
+}
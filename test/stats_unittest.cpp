@@ -0,0 +1,59 @@
+#include "stats.hpp"
+#include <gtest/gtest.h>
+
+using ipmi::stats::Histogram;
+
+TEST(StatsHistogram, Empty)
+{
+    Histogram histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.max());
+    EXPECT_EQ(0u, histogram.percentile(50));
+}
+
+TEST(StatsHistogram, SmallValuesAreExact)
+{
+    for (uint64_t value = 0; value < Histogram::subBuckets; ++value)
+    {
+        EXPECT_EQ(value, Histogram::index(value));
+        EXPECT_EQ(value, Histogram::upperBound(value));
+    }
+}
+
+TEST(StatsHistogram, BucketsBoundTheirValues)
+{
+    for (uint64_t value = 1; value < (1ull << 20); value = value * 3 / 2 + 1)
+    {
+        auto upper = Histogram::upperBound(Histogram::index(value));
+        EXPECT_GE(upper, value);
+        // Within an eighth of the magnitude of the value
+        EXPECT_LE(upper - value, value / Histogram::subBuckets);
+    }
+}
+
+TEST(StatsHistogram, HugeValuesAreClamped)
+{
+    EXPECT_EQ(Histogram::buckets - 1, Histogram::index(~0ull));
+}
+
+TEST(StatsHistogram, Percentiles)
+{
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value)
+    {
+        histogram.record(value);
+    }
+
+    EXPECT_EQ(1000u, histogram.count());
+    EXPECT_EQ(1000u, histogram.max());
+
+    auto p50 = histogram.percentile(50);
+    EXPECT_GE(p50, 500u);
+    EXPECT_LE(p50, 500u + 500u / Histogram::subBuckets);
+
+    auto p99 = histogram.percentile(99);
+    EXPECT_GE(p99, 990u);
+    EXPECT_LE(p99, 1000u);
+
+    EXPECT_EQ(1000u, histogram.percentile(100));
+}
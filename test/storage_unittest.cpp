@@ -0,0 +1,606 @@
+#include "config.h"
+#include "dispatch.hpp"
+#include "fruread.hpp"
+#include "mock-bus.hpp"
+#include "selreadahead.hpp"
+#include "selstore.hpp"
+#include "selutility.hpp"
+#include "sensorhandler.h"
+#include "storagehandler.h"
+#include "types.hpp"
+#include <chrono>
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// End to end tests of the SEL commands of storagehandler.cpp, on the mock
+// logging service.
+
+// Normally generated from the machine's YAML.
+extern const ipmi::sensor::InvObjectIDMap invSensors = {
+    {SYSTEM_SENSOR, {0x01, 0x12, 0x6F, 0x00}},
+    {BOARD_SENSOR, {0x02, 0x07, 0x6F, 0x00}},
+};
+extern const FruMap frus = {};
+
+extern unsigned short g_sel_reserve;
+
+// Only for the eSEL path of Add SEL, which is not tested.
+int find_openbmc_path(uint8_t, dbus_interface_t*)
+{
+    return -1;
+}
+
+using ipmi::test::MockBus;
+
+namespace
+{
+
+/** @brief Calls a synchronous handler like the router does
+ *
+ *  @return The completion code.
+ */
+ipmi_ret_t call(uint8_t cmd, const std::vector<uint8_t>& request,
+                std::vector<uint8_t>& response)
+{
+    const auto& slot = ipmi::dispatch::table().find(NETFUN_STORAGE, cmd);
+    EXPECT_NE(nullptr, slot.handler);
+
+    auto data = request;
+    data.resize(MAX_IPMI_BUFFER);
+    response.assign(MAX_IPMI_BUFFER, 0);
+    size_t len = request.size();
+    auto cc = slot.handler(NETFUN_STORAGE, cmd, data.data(), response.data(),
+                           &len, slot.context);
+    response.resize(len);
+    return cc;
+}
+
+/** @brief Calls the Clear SEL handler like the router does
+ *
+ *  @return The completion code.
+ */
+ipmi_ret_t clearSEL(uint8_t operation, std::vector<uint8_t>& response)
+{
+    const auto& slot = ipmi::dispatch::table().find(NETFUN_STORAGE,
+                                                    IPMI_CMD_CLEAR_SEL);
+    EXPECT_NE(nullptr, slot.asyncHandler);
+
+    bool answered = false;
+    ipmi_ret_t cc = IPMI_CC_UNSPECIFIED_ERROR;
+    std::vector<uint8_t> request{0x34, 0x12, 'C', 'L', 'R', operation};
+    slot.asyncHandler(NETFUN_STORAGE, IPMI_CMD_CLEAR_SEL, request.data(),
+                      request.size(),
+                      [&](ipmi_ret_t rc, const std::vector<uint8_t>& data)
+                      {
+                          answered = true;
+                          cc = rc;
+                          response = data;
+                      },
+                      slot.context);
+    EXPECT_TRUE(answered);
+    return cc;
+}
+
+/** @brief Little endian 16 bit field of a response */
+uint16_t field16(const std::vector<uint8_t>& response, size_t offset)
+{
+    return response.at(offset) | (response.at(offset + 1) << 8);
+}
+
+class SELCommands : public ::testing::Test
+{
+    protected:
+        SELCommands()
+        {
+            // Only where it is tested, its calls would add to the counts.
+            ipmi::sel::readAhead().setMaxDepth(0);
+
+            char name[] = "/tmp/ipmid-storage-XXXXXX";
+            EXPECT_NE(nullptr, mkdtemp(name));
+            directory = name;
+            EXPECT_TRUE(ipmi::sel::store().relocate(directory + "/sel"));
+        }
+
+        ~SELCommands()
+        {
+            unlink((directory + "/sel").c_str());
+            rmdir(directory.c_str());
+        }
+
+        void populate(size_t entries)
+        {
+            MockBus::Scale scale;
+            scale.logEntries = entries;
+            mock.populate(scale);
+        }
+
+        MockBus mock;
+        std::string directory;
+};
+
+} // namespace
+
+TEST_F(SELCommands, GetSELInfoCountsEntries)
+{
+    populate(5000);
+
+    std::vector<uint8_t> response;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    printf("Get SEL Info with 5000 entries: %lld us\n",
+           static_cast<long long>(std::chrono::duration_cast<
+               std::chrono::microseconds>(elapsed).count()));
+
+    ASSERT_EQ(sizeof(ipmi::sel::GetSELInfoResponse), response.size());
+    EXPECT_EQ(ipmi::sel::selVersion, response[0]);
+    EXPECT_EQ(5000, field16(response, 1));
+    EXPECT_EQ(1u, mock.calls("xyz.openbmc_project.ObjectMapper",
+                             "GetSubTreePaths"));
+}
+
+TEST_F(SELCommands, GetSELEntryWalksTheEntries)
+{
+    populate(3);
+
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+
+    // Reservation 0, first entry, whole record
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY,
+                               {0x00, 0x00, 0x00, 0x00, 0x00, 0xFF},
+                               response));
+    ASSERT_EQ(sizeof(ipmi::sel::GetSELEntryResponse), response.size());
+    EXPECT_EQ(2, field16(response, 0));
+    EXPECT_EQ(1, field16(response, 2));
+
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY,
+                               {0x00, 0x00, 0x03, 0x00, 0x00, 0xFF},
+                               response));
+    EXPECT_EQ(ipmi::sel::lastEntry, field16(response, 0));
+    EXPECT_EQ(3, field16(response, 2));
+
+    EXPECT_EQ(IPMI_CC_SENSOR_INVALID,
+              call(IPMI_CMD_GET_SEL_ENTRY,
+                   {0x00, 0x00, 0x04, 0x00, 0x00, 0xFF}, response));
+}
+
+TEST_F(SELCommands, GetSELEntryConvertsOnce)
+{
+    populate(3);
+    constexpr auto eventTypeOffset = 14;
+    const std::vector<uint8_t> getFirst{0x00, 0x00, 0x01, 0x00, 0x00, 0xFF};
+
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY, getFirst, response));
+    EXPECT_EQ(0x6F, response.at(eventTypeOffset));
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY, getFirst, response));
+    EXPECT_EQ(1u, mock.calls("org.freedesktop.DBus.Properties", "GetAll"));
+
+    // Resolving the log entry only flips the event direction
+    mock.setProperty(std::string(ipmi::test::logEntryRoot) + "/1",
+                     "xyz.openbmc_project.Logging.Entry", "Resolved", true);
+    mock.process();
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY, getFirst, response));
+    EXPECT_EQ(ipmi::sel::deassertEvent | 0x6F, response.at(eventTypeOffset));
+    EXPECT_EQ(1u, mock.calls("org.freedesktop.DBus.Properties", "GetAll"));
+
+    // Other changes have it converted again
+    mock.setProperty(std::string(ipmi::test::logEntryRoot) + "/1",
+                     "xyz.openbmc_project.Logging.Entry", "Message",
+                     "xyz.openbmc_project.Common.Error.InternalFailure");
+    mock.process();
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY, getFirst, response));
+    EXPECT_EQ(2u, mock.calls("org.freedesktop.DBus.Properties", "GetAll"));
+}
+
+TEST_F(SELCommands, GetSELEntryReadsAhead)
+{
+    populate(20);
+    auto& readAhead = ipmi::sel::readAhead();
+    readAhead.setMaxDepth(8);
+    readAhead.resetStats();
+
+    // Walked like ipmitool does, by the nextRecordID of every response
+    auto walk = [this](uint16_t id, bool wait)
+    {
+        std::vector<uint8_t> response;
+        EXPECT_EQ(IPMI_CC_OK,
+                  call(IPMI_CMD_GET_SEL_ENTRY,
+                       {0x00, 0x00, static_cast<uint8_t>(id),
+                        static_cast<uint8_t>(id >> 8), 0x00, 0xFF},
+                       response));
+        EXPECT_EQ(id == 0 ? 1 : id, field16(response, 2));
+        while (wait && !ipmi::sel::readAhead().idle())
+        {
+            mock.process();
+        }
+        return field16(response, 0);
+    };
+
+    // Faster than the conversions, the first steps convert their entry and
+    // the read ahead goes deeper.
+    uint16_t id = walk(0, false);
+    id = walk(id, false);
+    EXPECT_EQ(4u, readAhead.depth());
+    id = walk(id, true);
+    EXPECT_EQ(8u, readAhead.depth());
+
+    while (id != ipmi::sel::lastEntry)
+    {
+        id = walk(id, true);
+    }
+    EXPECT_EQ(8u, readAhead.depth());
+
+    auto stats = readAhead.stats();
+    EXPECT_EQ(17u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(22u, mock.calls("org.freedesktop.DBus.Properties", "GetAll"));
+
+    // The records converted ahead are kept, a second walk reads none.
+    id = walk(0, true);
+    while (id != ipmi::sel::lastEntry)
+    {
+        id = walk(id, true);
+    }
+    EXPECT_EQ(22u, mock.calls("org.freedesktop.DBus.Properties", "GetAll"));
+}
+
+TEST_F(SELCommands, GetSELEntryReadsLessAheadWhenWasted)
+{
+    populate(20);
+    auto& readAhead = ipmi::sel::readAhead();
+    readAhead.setMaxDepth(8);
+    readAhead.resetStats();
+
+    auto read = [this](uint16_t id, bool wait)
+    {
+        std::vector<uint8_t> response;
+        EXPECT_EQ(IPMI_CC_OK,
+                  call(IPMI_CMD_GET_SEL_ENTRY,
+                       {0x00, 0x00, static_cast<uint8_t>(id),
+                        static_cast<uint8_t>(id >> 8), 0x00, 0xFF},
+                       response));
+        while (wait && !ipmi::sel::readAhead().idle())
+        {
+            mock.process();
+        }
+        return field16(response, 0);
+    };
+
+    // Walked deep enough to convert 4 to 11 ahead
+    uint16_t id = read(0, false);
+    id = read(id, false);
+    id = read(id, true);
+    ASSERT_EQ(8u, readAhead.depth());
+    EXPECT_EQ(0u, readAhead.stats().wasted);
+
+    // The host reads elsewhere, the next walk goes half as deep
+    read(15, true);
+    EXPECT_EQ(4u, readAhead.depth());
+    EXPECT_EQ(8u, readAhead.stats().wasted);
+
+    // And again, but not below where the first walk starts
+    read(1, true);
+    EXPECT_EQ(2u, readAhead.depth());
+    EXPECT_EQ(12u, readAhead.stats().wasted);
+    read(5, true);
+    EXPECT_EQ(2u, readAhead.depth());
+
+    // A walk reading all it was converted ahead keeps the depth
+    id = read(2, true);
+    while (id != ipmi::sel::lastEntry)
+    {
+        id = read(id, true);
+    }
+    read(1, true);
+    EXPECT_EQ(2u, readAhead.depth());
+    EXPECT_EQ(12u, readAhead.stats().wasted);
+}
+
+TEST_F(SELCommands, DeleteSELEntryRemovesTheLogEntry)
+{
+    populate(3);
+    g_sel_reserve = 0x1234;
+
+    std::vector<uint8_t> response;
+    EXPECT_EQ(IPMI_CC_INVALID_RESERVATION_ID,
+              call(IPMI_CMD_DELETE_SEL, {0x00, 0x00, 0x02, 0x00}, response));
+
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_DELETE_SEL, {0x34, 0x12, 0x02, 0x00}, response));
+    EXPECT_EQ(2, field16(response, 0));
+    EXPECT_FALSE(mock.hasObject(std::string(ipmi::test::logEntryRoot) + "/2"));
+    EXPECT_EQ(2u, mock.countObjects(ipmi::test::logEntryRoot));
+
+    // Gone from the SEL before the InterfacesRemoved signal is dispatched
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY,
+                               {0x00, 0x00, 0x01, 0x00, 0x00, 0xFF},
+                               response));
+    EXPECT_EQ(3, field16(response, 0));
+    EXPECT_EQ(IPMI_CC_SENSOR_INVALID,
+              call(IPMI_CMD_GET_SEL_ENTRY,
+                   {0x00, 0x00, 0x02, 0x00, 0x00, 0xFF}, response));
+    mock.process();
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(2, field16(response, 1));
+}
+
+TEST_F(SELCommands, AddSELStoresSystemEvents)
+{
+    populate(3);
+    g_sel_reserve = 0x1234;
+
+    // Platform event of sensor 0x42, as the host adds it
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_ADD_SEL,
+                   {0x00, 0x00, ipmi::sel::systemEventRecord,
+                    0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x07, 0x42,
+                    0x6F, 0x01, 0xFF, 0xFF},
+                   response));
+    ASSERT_EQ(2u, response.size());
+    EXPECT_EQ(ipmi::sel::firstStoreId, field16(response, 0));
+
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(4, field16(response, 1));
+
+    // After the log entries
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY,
+                               {0x00, 0x00, 0x03, 0x00, 0x00, 0xFF},
+                               response));
+    EXPECT_EQ(ipmi::sel::firstStoreId, field16(response, 0));
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY,
+                               {0x00, 0x00, 0xFF, 0xFF, 0x00, 0xFF},
+                               response));
+    EXPECT_EQ(ipmi::sel::lastEntry, field16(response, 0));
+    EXPECT_EQ(ipmi::sel::firstStoreId, field16(response, 2));
+    EXPECT_EQ(ipmi::sel::systemEventRecord, response.at(4));
+    EXPECT_EQ(0x42, response.at(13));
+
+    // Read without the logging service, that only converted entry 3
+    EXPECT_EQ(1u, mock.calls("org.freedesktop.DBus.Properties", "GetAll"));
+
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_DELETE_SEL, {0x34, 0x12, 0x00, 0x80}, response));
+    EXPECT_EQ(ipmi::sel::firstStoreId, field16(response, 0));
+    EXPECT_EQ(3u, mock.countObjects(ipmi::test::logEntryRoot));
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(3, field16(response, 1));
+}
+
+TEST_F(SELCommands, AddSELFallsBackWithoutTheStore)
+{
+    populate(3);
+    ASSERT_FALSE(ipmi::sel::store().relocate("/dev/null/sel"));
+
+    // Handed to the logging service, answered with the ID of the event data
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_ADD_SEL,
+                   {0x00, 0x00, ipmi::sel::systemEventRecord,
+                    0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x07, 0x42,
+                    0x6F, 0x01, 0x12, 0x34},
+                   response));
+    ASSERT_EQ(2u, response.size());
+    EXPECT_EQ(0x12, response.at(0));
+    EXPECT_EQ(0x34, response.at(1));
+    EXPECT_TRUE(ipmi::sel::store().empty());
+}
+
+TEST_F(SELCommands, LogEntriesAndStoredRecordsHaveDistinctIDs)
+{
+    populate(3);
+    g_sel_reserve = 0x1234;
+
+    std::vector<uint8_t> response;
+    const std::vector<uint8_t> event{0x00, 0x00,
+                                     ipmi::sel::systemEventRecord,
+                                     0x00, 0x00, 0x00, 0x00, 0x20, 0x00,
+                                     0x04, 0x07, 0x42, 0x6F, 0x01, 0xFF,
+                                     0xFF};
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_ADD_SEL, event, response));
+    EXPECT_EQ(ipmi::sel::firstStoreId, field16(response, 0));
+
+    // The log entry IDs count up to the one of the stored record
+    auto logEntry = [this](uint32_t id)
+    {
+        mock.addObject(std::string(ipmi::test::logEntryRoot) + "/" +
+                           std::to_string(id),
+                       ipmi::test::loggingService,
+                       {{"xyz.openbmc_project.Logging.Entry",
+                         {{"Id", id},
+                          {"Timestamp", static_cast<uint64_t>(
+                                            1500000000000ull + id * 1000)},
+                          {"Resolved", false}}},
+                        {"xyz.openbmc_project.Object.Delete", {}},
+                        {"org.openbmc.Associations",
+                         {{"associations",
+                           ipmi::test::Value::Associations{}}}}});
+    };
+    logEntry(ipmi::sel::firstStoreId);
+    mock.process();
+
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(5, field16(response, 1));
+
+    // The log entry keeps its ID, the stored record moved to the next one
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_GET_SEL_ENTRY,
+                   {0x00, 0x00, 0x00, 0x80, 0x00, 0xFF}, response));
+    EXPECT_EQ(ipmi::sel::firstStoreId + 1, field16(response, 0));
+    EXPECT_EQ(ipmi::sel::firstStoreId, field16(response, 2));
+    EXPECT_EQ(1500000000u + ipmi::sel::firstStoreId,
+              static_cast<uint32_t>(field16(response, 5) |
+                                    (field16(response, 7) << 16)));
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_GET_SEL_ENTRY,
+                   {0x00, 0x00, 0x01, 0x80, 0x00, 0xFF}, response));
+    EXPECT_EQ(ipmi::sel::lastEntry, field16(response, 0));
+    EXPECT_EQ(0x42, response.at(13));
+
+    // Records added after skip the IDs of the log entries
+    logEntry(ipmi::sel::firstStoreId + 2);
+    mock.process();
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_ADD_SEL, event, response));
+    EXPECT_EQ(ipmi::sel::firstStoreId + 3, field16(response, 0));
+
+    // Deleting the log entry leaves the stored record
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_DELETE_SEL, {0x34, 0x12, 0x00, 0x80}, response));
+    EXPECT_EQ(4u, mock.countObjects(ipmi::test::logEntryRoot));
+    EXPECT_TRUE(ipmi::sel::store().contains(ipmi::sel::firstStoreId + 1));
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(6, field16(response, 1));
+}
+
+TEST_F(SELCommands, SELFollowsTheLoggingService)
+{
+    populate(3);
+
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(3, field16(response, 1));
+
+    mock.addObject(std::string(ipmi::test::logEntryRoot) + "/4",
+                   ipmi::test::loggingService,
+                   {{"xyz.openbmc_project.Logging.Entry",
+                     {{"Id", static_cast<uint32_t>(4)},
+                      {"Timestamp", static_cast<uint64_t>(1500000004000ull)},
+                      {"Resolved", false}}},
+                    {"org.openbmc.Associations",
+                     {{"associations", ipmi::test::Value::Associations{}}}}});
+    mock.removeObject(std::string(ipmi::test::logEntryRoot) + "/2");
+    mock.process();
+
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(3, field16(response, 1));
+
+    // Last entry, then the entry after the one removed
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY,
+                               {0x00, 0x00, 0xFF, 0xFF, 0x00, 0xFF},
+                               response));
+    EXPECT_EQ(ipmi::sel::lastEntry, field16(response, 0));
+    EXPECT_EQ(4, field16(response, 2));
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_ENTRY,
+                               {0x00, 0x00, 0x01, 0x00, 0x00, 0xFF},
+                               response));
+    EXPECT_EQ(3, field16(response, 0));
+
+    // Read from the mapper once, then from the signals
+    EXPECT_EQ(1u, mock.calls("xyz.openbmc_project.ObjectMapper",
+                             "GetSubTreePaths"));
+}
+
+TEST_F(SELCommands, ClearSELErasesInTheBackground)
+{
+    populate(50);
+    g_sel_reserve = 0x1234;
+
+    auto clear = [](uint8_t operation)
+    {
+        std::vector<uint8_t> response;
+        EXPECT_EQ(IPMI_CC_OK, clearSEL(operation, response));
+        EXPECT_EQ(1u, response.size());
+        return response.empty() ? 0xFF : response[0];
+    };
+
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(ipmi::sel::invalidTimeStamp,
+              static_cast<uint32_t>(field16(response, 9) |
+                                    (field16(response, 11) << 16)));
+
+    // Answered before the erase is done, then polled
+    EXPECT_EQ(ipmi::sel::eraseInProgress, clear(ipmi::sel::initiateErase));
+    EXPECT_EQ(ipmi::sel::eraseInProgress, clear(ipmi::sel::getEraseStatus));
+    for (int i = 0; i < 1000 &&
+         clear(ipmi::sel::getEraseStatus) != ipmi::sel::eraseComplete; ++i)
+    {
+        sd_event_run(mock.event(), 100000);
+    }
+    EXPECT_EQ(ipmi::sel::eraseComplete, clear(ipmi::sel::getEraseStatus));
+    EXPECT_EQ(0u, mock.countObjects(ipmi::test::logEntryRoot));
+
+    // With a single call to the logging service
+    EXPECT_EQ(1u, mock.calls("xyz.openbmc_project.Collection.DeleteAll",
+                             "DeleteAll"));
+    EXPECT_EQ(0u, mock.calls("xyz.openbmc_project.Object.Delete", "Delete"));
+
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(0, field16(response, 1));
+    EXPECT_NE(ipmi::sel::invalidTimeStamp,
+              static_cast<uint32_t>(field16(response, 9) |
+                                    (field16(response, 11) << 16)));
+}
+
+TEST_F(SELCommands, ClearSELFailsWithoutTheLoggingService)
+{
+    populate(3);
+    g_sel_reserve = 0x1234;
+
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_ADD_SEL,
+                   {0x00, 0x00, ipmi::sel::systemEventRecord,
+                    0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x07, 0x42,
+                    0x6F, 0x01, 0xFF, 0xFF},
+                   response));
+
+    // Neither DeleteAll nor Delete can be sent, failed before the answer
+    mock.addMethod("xyz.openbmc_project.ObjectMapper", "GetObject",
+                   [](sd_bus_message*)
+                   {
+                       return -ENOENT;
+                   });
+    EXPECT_EQ(IPMI_CC_UNSPECIFIED_ERROR,
+              clearSEL(ipmi::sel::initiateErase, response));
+    EXPECT_EQ(IPMI_CC_UNSPECIFIED_ERROR,
+              clearSEL(ipmi::sel::getEraseStatus, response));
+
+    // Nothing erased, the stored record neither
+    EXPECT_EQ(3u, mock.countObjects(ipmi::test::logEntryRoot));
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(4, field16(response, 1));
+}
+
+TEST_F(SELCommands, ClearSELReportsAFailedErase)
+{
+    populate(3);
+    g_sel_reserve = 0x1234;
+
+    std::vector<uint8_t> response;
+    ASSERT_EQ(IPMI_CC_OK,
+              call(IPMI_CMD_ADD_SEL,
+                   {0x00, 0x00, ipmi::sel::systemEventRecord,
+                    0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x07, 0x42,
+                    0x6F, 0x01, 0xFF, 0xFF},
+                   response));
+
+    mock.addMethod("xyz.openbmc_project.Collection.DeleteAll", "DeleteAll",
+                   [](sd_bus_message*)
+                   {
+                       return -EIO;
+                   });
+    ASSERT_EQ(IPMI_CC_OK, clearSEL(ipmi::sel::initiateErase, response));
+    ASSERT_EQ(1u, response.size());
+    EXPECT_EQ(ipmi::sel::eraseInProgress, response[0]);
+
+    // The polls that follow the failure answer it
+    for (int i = 0; i < 1000 &&
+         clearSEL(ipmi::sel::getEraseStatus, response) == IPMI_CC_OK; ++i)
+    {
+        sd_event_run(mock.event(), 100000);
+    }
+    EXPECT_EQ(IPMI_CC_UNSPECIFIED_ERROR,
+              clearSEL(ipmi::sel::getEraseStatus, response));
+
+    EXPECT_EQ(3u, mock.countObjects(ipmi::test::logEntryRoot));
+    ASSERT_EQ(IPMI_CC_OK, call(IPMI_CMD_GET_SEL_INFO, {}, response));
+    EXPECT_EQ(4, field16(response, 1));
+}
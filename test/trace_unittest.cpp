@@ -0,0 +1,110 @@
+#include "trace.hpp"
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+using namespace ipmi::trace;
+
+class TraceCapture : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            char name[] = "/tmp/ipmid-capture-XXXXXX";
+            auto fd = mkstemp(name);
+            ASSERT_GE(fd, 0);
+            close(fd);
+            path = name;
+        }
+
+        void TearDown() override
+        {
+            stopCapture();
+            unlink(path.c_str());
+        }
+
+        std::string path;
+};
+
+TEST_F(TraceCapture, RequestsReadBackInOrder)
+{
+    ASSERT_TRUE(startCapture(path.c_str()));
+    EXPECT_TRUE(enabled());
+
+    const uint8_t data[] = {0x01, 0x02, 0x03};
+    request(0x10, 0x0a, 0, 0x40, data, 0);
+    request(0x11, 0x0a, 0, 0x43, data, sizeof(data));
+    response(0x11, 0x0a, 0, 0x43, 0, data, sizeof(data), 10);
+    stopCapture();
+    EXPECT_FALSE(enabled());
+
+    Reader reader;
+    ASSERT_TRUE(reader.load(path.c_str()));
+    ASSERT_EQ(2u, reader.records().size());
+    EXPECT_EQ(0u, reader.overwritten());
+
+    const auto& first = reader.records()[0];
+    EXPECT_EQ(1u, first.first);
+    EXPECT_EQ(Direction::request, first.second->direction);
+    EXPECT_EQ(0x40, first.second->cmd);
+    EXPECT_EQ(0, first.second->len);
+
+    const auto& second = reader.records()[1];
+    EXPECT_EQ(2u, second.first);
+    EXPECT_EQ(0x11, second.second->seq);
+    EXPECT_EQ(0x0a, second.second->netfn);
+    EXPECT_EQ(0x43, second.second->cmd);
+    ASSERT_EQ(sizeof(data), second.second->len);
+    EXPECT_EQ(0, memcmp(data, second.second->payload, sizeof(data)));
+}
+
+TEST_F(TraceCapture, TruncatedRecordIsIgnored)
+{
+    ASSERT_TRUE(startCapture(path.c_str()));
+    request(0x10, 0x06, 0, 0x01, path.data(), 0);
+    request(0x11, 0x06, 0, 0x01, path.data(), 0);
+    stopCapture();
+
+    ASSERT_EQ(0, truncate(path.c_str(),
+                          sizeof(Header) + sizeof(Record) * 2 - 1));
+
+    Reader reader;
+    ASSERT_TRUE(reader.load(path.c_str()));
+    EXPECT_EQ(1u, reader.records().size());
+}
+
+TEST_F(TraceCapture, RecordBeingWrittenIsIgnored)
+{
+    ASSERT_TRUE(startCapture(path.c_str()));
+    request(0x10, 0x06, 0, 0x01, path.data(), 0);
+    request(0x11, 0x06, 0, 0x01, path.data(), 0);
+    stopCapture();
+
+    // The second record as the writer leaves it while filling it.
+    auto file = fopen(path.c_str(), "r+");
+    ASSERT_NE(nullptr, file);
+    const uint32_t writing = 0;
+    ASSERT_EQ(0, fseek(file, sizeof(Header) + sizeof(Record), SEEK_SET));
+    ASSERT_EQ(1u, fwrite(&writing, sizeof(writing), 1, file));
+    fclose(file);
+
+    Reader reader;
+    ASSERT_TRUE(reader.load(path.c_str()));
+    ASSERT_EQ(1u, reader.records().size());
+    EXPECT_EQ(1u, reader.records()[0].first);
+    EXPECT_EQ(0x10, reader.records()[0].second->seq);
+}
+
+TEST_F(TraceCapture, NotATrace)
+{
+    auto file = fopen(path.c_str(), "w");
+    ASSERT_NE(nullptr, file);
+    fprintf(file, "not a trace\n");
+    fclose(file);
+
+    Reader reader;
+    EXPECT_FALSE(reader.load(path.c_str()));
+}
@@ -0,0 +1,593 @@
+#include "mock-bus.hpp"
+#include "utils.hpp"
+#include <chrono>
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <sdbusplus/bus.hpp>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Tests of the mapper service cache of utils.cpp, on the mock bus.
+
+using namespace ipmi::test;
+
+namespace
+{
+
+constexpr auto sensorInterface = "xyz.openbmc_project.Sensor.Value";
+constexpr auto sensorPath = "/xyz/openbmc_project/sensors/temperature/temp0";
+constexpr auto sensorService = "xyz.openbmc_project.Hwmon-0";
+
+class ServiceCache : public ::testing::Test
+{
+    protected:
+        ServiceCache() : dbus(mock.bus())
+        {
+            MockBus::Scale scale;
+            scale.sensors = 2;
+            mock.populate(scale);
+            ipmi::resetServiceCacheStats();
+        }
+
+        size_t getObjectCalls()
+        {
+            return mock.calls(mapperInterface, "GetObject");
+        }
+
+        MockBus mock;
+        sdbusplus::bus::bus dbus;
+};
+
+} // namespace
+
+TEST_F(ServiceCache, SecondLookupIsAHit)
+{
+    EXPECT_EQ(sensorService,
+              ipmi::getService(dbus, sensorInterface, sensorPath));
+    EXPECT_EQ(sensorService,
+              ipmi::getService(dbus, sensorInterface, sensorPath));
+    EXPECT_EQ(1u, getObjectCalls());
+
+    auto stats = ipmi::getServiceCacheStats();
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(1u, stats.entries);
+}
+
+TEST_F(ServiceCache, FailuresAreNotCached)
+{
+    EXPECT_THROW(ipmi::getService(dbus, sensorInterface, "/no/such/object"),
+                 std::runtime_error);
+    EXPECT_THROW(ipmi::getService(dbus, sensorInterface, "/no/such/object"),
+                 std::runtime_error);
+    EXPECT_EQ(2u, getObjectCalls());
+    EXPECT_EQ(0u, ipmi::getServiceCacheStats().entries);
+}
+
+TEST_F(ServiceCache, LegacyLookupSharesTheCache)
+{
+    char* service = nullptr;
+    ASSERT_EQ(0, ipmi::getService(mock.bus(), sensorPath, &service));
+    EXPECT_STREQ(sensorService, service);
+    free(service);
+
+    service = nullptr;
+    ASSERT_EQ(0, ipmi::getService(mock.bus(), sensorPath, &service));
+    EXPECT_STREQ(sensorService, service);
+    free(service);
+
+    EXPECT_EQ(1u, getObjectCalls());
+    EXPECT_GT(0, ipmi::getService(mock.bus(), "/no/such/object", &service));
+}
+
+TEST_F(ServiceCache, InterfacesRemovedInvalidates)
+{
+    ipmi::getService(dbus, sensorInterface, sensorPath);
+    ipmi::getService(dbus, sensorInterface,
+                     "/xyz/openbmc_project/sensors/temperature/temp1");
+
+    mock.removeObject(sensorPath);
+    mock.process();
+    EXPECT_EQ(1u, ipmi::getServiceCacheStats().entries);
+    EXPECT_THROW(ipmi::getService(dbus, sensorInterface, sensorPath),
+                 std::runtime_error);
+
+    // Back on another service
+    mock.addObject(sensorPath, "xyz.openbmc_project.Hwmon-1",
+                   {{sensorInterface, {{"Value", static_cast<int64_t>(1)}}}});
+    mock.process();
+    EXPECT_EQ("xyz.openbmc_project.Hwmon-1",
+              ipmi::getService(dbus, sensorInterface, sensorPath));
+    EXPECT_EQ(4u, getObjectCalls());
+}
+
+TEST_F(ServiceCache, AnotherConnectionStartsOver)
+{
+    ipmi::getService(dbus, sensorInterface, sensorPath);
+
+    MockBus other;
+    MockBus::Scale scale;
+    scale.sensors = 1;
+    other.populate(scale);
+    sdbusplus::bus::bus otherBus(other.bus());
+
+    EXPECT_EQ(sensorService,
+              ipmi::getService(otherBus, sensorInterface, sensorPath));
+    EXPECT_EQ(1u, other.calls(mapperInterface, "GetObject"));
+    EXPECT_EQ(1u, ipmi::getServiceCacheStats().entries);
+}
+
+namespace
+{
+
+constexpr auto logEntryInterface = "xyz.openbmc_project.Logging.Entry";
+
+class ManagedObjects : public ::testing::Test
+{
+    protected:
+        ManagedObjects() : dbus(mock.bus())
+        {
+            MockBus::Scale scale;
+            scale.logEntries = 100;
+            scale.sensors = 40;
+            mock.populate(scale);
+        }
+
+        MockBus mock;
+        sdbusplus::bus::bus dbus;
+};
+
+} // namespace
+
+TEST_F(ManagedObjects, OneCallReadsEveryObject)
+{
+    auto logs = ipmi::getManagedObjects(dbus, loggingService, loggingPath);
+    EXPECT_EQ(1u, mock.calls(ipmi::OBJECT_MANAGER_INTF, "GetManagedObjects"));
+
+    EXPECT_EQ(100u, logs.paths(logEntryInterface, logEntryRoot).size());
+    EXPECT_EQ(0u, logs.paths(logEntryInterface, sensorRoot).size());
+
+    auto path = std::string(logEntryRoot) + "/42";
+    auto id = logs.find(path, logEntryInterface, "Id");
+    ASSERT_NE(nullptr, id);
+    EXPECT_EQ(42u, id->get<uint32_t>());
+    auto resolved = logs.find(path, logEntryInterface, "Resolved");
+    ASSERT_NE(nullptr, resolved);
+    EXPECT_FALSE(resolved->get<bool>());
+
+    EXPECT_EQ(nullptr, logs.find(path, sensorInterface));
+    EXPECT_EQ(nullptr, logs.find(path, logEntryInterface, "NoSuchProperty"));
+    EXPECT_EQ(nullptr, logs.find("/no/such/object", logEntryInterface));
+}
+
+TEST_F(ManagedObjects, OnlyTheObjectsOfTheService)
+{
+    auto sensors = ipmi::getManagedObjects(
+                       dbus, "xyz.openbmc_project.Hwmon-1", sensorRoot);
+    auto paths = sensors.paths(sensorInterface);
+    ASSERT_EQ(8u, paths.size());
+    EXPECT_EQ(std::string(sensorRoot) + "/temp32", paths.front());
+}
+
+TEST_F(ManagedObjects, CustomPropertyVariant)
+{
+    using AdditionalData = std::vector<std::string>;
+    using Property = sdbusplus::message::variant<uint32_t, AdditionalData>;
+
+    auto logs = ipmi::getManagedObjects<Property>(dbus, loggingService,
+                                                  loggingPath);
+    auto data = logs.find(std::string(logEntryRoot) + "/1",
+                          logEntryInterface, "AdditionalData");
+    ASSERT_NE(nullptr, data);
+    EXPECT_EQ(AdditionalData{"_PID=1"}, data->get<AdditionalData>());
+}
+
+TEST_F(ManagedObjects, MethodErrorThrows)
+{
+    mock.addMethod(ipmi::OBJECT_MANAGER_INTF, "GetManagedObjects",
+                   [](sd_bus_message*)
+                   {
+                       return -EACCES;
+                   });
+    EXPECT_ANY_THROW(ipmi::getManagedObjects(dbus, loggingService,
+                                             loggingPath));
+}
+
+namespace
+{
+
+class PropertyCache : public ::testing::Test
+{
+    protected:
+        PropertyCache() : dbus(mock.bus())
+        {
+            MockBus::Scale scale;
+            scale.sensors = 1;
+            mock.populate(scale);
+        }
+
+        int64_t value()
+        {
+            return cache.get<int64_t>(dbus, sensorService, sensorPath,
+                                      sensorInterface, "Value");
+        }
+
+        size_t getAllCalls()
+        {
+            return mock.calls(ipmi::PROP_INTF, "GetAll");
+        }
+
+        MockBus mock;
+        sdbusplus::bus::bus dbus;
+        ipmi::PropertyCache cache;
+};
+
+} // namespace
+
+TEST_F(PropertyCache, SecondGetIsAHit)
+{
+    EXPECT_EQ(25000, value());
+    EXPECT_EQ(25000, value());
+    EXPECT_EQ(-3, cache.get<int64_t>(dbus, sensorService, sensorPath,
+                                     sensorInterface, "Scale"));
+    EXPECT_EQ(1u, getAllCalls());
+    EXPECT_EQ(0u, mock.calls(ipmi::PROP_INTF, "Get"));
+
+    auto stats = cache.stats();
+    EXPECT_EQ(2u, stats.hits);
+    EXPECT_EQ(1u, stats.misses);
+    EXPECT_EQ(1u, stats.entries);
+}
+
+TEST_F(PropertyCache, FollowsPropertiesChanged)
+{
+    cache.watch(dbus, sensorService, sensorPath, sensorInterface);
+    mock.setProperty(sensorPath, sensorInterface, "Value",
+                     static_cast<int64_t>(30000));
+    mock.process();
+
+    EXPECT_EQ(30000, value());
+    EXPECT_EQ(1u, getAllCalls());
+}
+
+TEST_F(PropertyCache, InvalidateReadsAgain)
+{
+    value();
+    cache.invalidate(sensorPath, sensorInterface);
+    value();
+    EXPECT_EQ(2u, getAllCalls());
+}
+
+TEST_F(PropertyCache, UnknownObjectThrows)
+{
+    EXPECT_ANY_THROW(cache.get<int64_t>(dbus, sensorService, "/no/such/object",
+                                        sensorInterface, "Value"));
+    EXPECT_EQ(1u, cache.stats().misses);
+}
+
+namespace
+{
+
+constexpr auto deleteInterface = "xyz.openbmc_project.Object.Delete";
+
+class FanOut : public ::testing::Test
+{
+    protected:
+        FanOut()
+        {
+            MockBus::Scale scale;
+            scale.logEntries = 100;
+            mock.populate(scale);
+        }
+
+        ipmi::MethodCall deleteCall(const std::string& path)
+        {
+            return {loggingService, path, deleteInterface, "Delete"};
+        }
+
+        /** @brief Runs fanOut() and the event loop until it is done */
+        std::vector<int> run(std::vector<ipmi::MethodCall>&& calls,
+                             std::chrono::microseconds timeout,
+                             size_t window = ipmi::fanOutWindow)
+        {
+            bool done = false;
+            std::vector<int> results;
+            ipmi::fanOut(mock.bus(), std::move(calls), timeout,
+                         [&done, &results](const std::vector<int>& r)
+                         {
+                             done = true;
+                             results = r;
+                         },
+                         window);
+            for (int i = 0; i < 1000 && !done; ++i)
+            {
+                sd_event_run(mock.event(), 100000);
+            }
+            EXPECT_TRUE(done);
+            return results;
+        }
+
+        MockBus mock;
+};
+
+} // namespace
+
+TEST_F(FanOut, DeletesEveryEntry)
+{
+    std::vector<ipmi::MethodCall> calls;
+    for (int i = 1; i <= 100; ++i)
+    {
+        calls.push_back(deleteCall(std::string(logEntryRoot) + "/" +
+                                   std::to_string(i)));
+    }
+
+    auto results = run(std::move(calls), std::chrono::seconds(5), 8);
+    EXPECT_EQ(std::vector<int>(100, 0), results);
+    EXPECT_EQ(100u, mock.calls(deleteInterface, "Delete"));
+    EXPECT_EQ(0u, mock.countObjects(logEntryRoot));
+}
+
+TEST_F(FanOut, ErrorsAreReportedPerCall)
+{
+    std::vector<ipmi::MethodCall> calls{
+        deleteCall(std::string(logEntryRoot) + "/1"),
+        deleteCall("/no/such/object"),
+        deleteCall(std::string(logEntryRoot) + "/2")};
+
+    auto results = run(std::move(calls), std::chrono::seconds(5));
+    ASSERT_EQ(3u, results.size());
+    EXPECT_EQ(0, results[0]);
+    EXPECT_GT(0, results[1]);
+    EXPECT_EQ(0, results[2]);
+}
+
+TEST_F(FanOut, UnansweredCallsTimeOut)
+{
+    // Never replies
+    mock.addMethod(deleteInterface, "Delete",
+                   [](sd_bus_message*)
+                   {
+                       return 0;
+                   });
+
+    std::vector<ipmi::MethodCall> calls{
+        deleteCall(std::string(logEntryRoot) + "/1"),
+        deleteCall(std::string(logEntryRoot) + "/2")};
+
+    auto results = run(std::move(calls), std::chrono::milliseconds(50), 1);
+    EXPECT_EQ(std::vector<int>(2, -ETIMEDOUT), results);
+}
+
+TEST_F(FanOut, NoCallsIsDoneAtOnce)
+{
+    bool done = false;
+    ipmi::fanOut(mock.bus(), {}, std::chrono::seconds(1),
+                 [&done](const std::vector<int>& results)
+                 {
+                     done = results.empty();
+                 });
+    EXPECT_TRUE(done);
+}
+
+namespace
+{
+
+constexpr auto hangInterface = "xyz.openbmc_project.Test.Hang";
+
+class CallTimeouts : public ::testing::Test
+{
+    protected:
+        CallTimeouts()
+        {
+            // Never replies
+            mock.addMethod(hangInterface, "Hang",
+                           [](sd_bus_message*)
+                           {
+                               return 0;
+                           });
+            ipmi::timeout::resetStats();
+        }
+
+        ~CallTimeouts()
+        {
+            ipmi::timeout::setDefaultBudget(ipmi::timeout::defaultBudget);
+        }
+
+        int hang()
+        {
+            return ipmi::callMethod(mock.bus(), loggingService, loggingPath,
+                                    hangInterface, "Hang", nullptr, nullptr,
+                                    nullptr);
+        }
+
+        MockBus mock;
+};
+
+} // namespace
+
+TEST_F(CallTimeouts, BudgetOfTheInterface)
+{
+    ipmi::timeout::setBudget(hangInterface, std::chrono::milliseconds(50));
+    auto start = ipmi::timeout::Clock::now();
+    EXPECT_EQ(-ETIMEDOUT, hang());
+    EXPECT_LT(ipmi::timeout::Clock::now() - start, std::chrono::seconds(1));
+    ipmi::timeout::setBudget(hangInterface, ipmi::timeout::defaultBudget);
+
+    auto stats = ipmi::timeout::stats();
+    EXPECT_EQ(1u, stats.timedOut);
+    EXPECT_EQ(0u, stats.abandoned);
+}
+
+TEST_F(CallTimeouts, PropertiesTakeTheBudgetOfTheirInterface)
+{
+    // Never replies either
+    mock.addMethod(ipmi::PROP_INTF, "Get",
+                   [](sd_bus_message*)
+                   {
+                       return 0;
+                   });
+    ipmi::timeout::setBudget(hangInterface, std::chrono::milliseconds(50));
+    auto start = ipmi::timeout::Clock::now();
+    sd_bus_message* reply = nullptr;
+    EXPECT_EQ(-ETIMEDOUT,
+              ipmi::callMethod(mock.bus(), loggingService, loggingPath,
+                               ipmi::PROP_INTF, "Get", nullptr, &reply, "ss",
+                               hangInterface, "Value"));
+    EXPECT_LT(ipmi::timeout::Clock::now() - start, std::chrono::seconds(1));
+    ipmi::timeout::setBudget(hangInterface, ipmi::timeout::defaultBudget);
+    EXPECT_EQ(1u, ipmi::timeout::stats().timedOut);
+}
+
+TEST_F(CallTimeouts, DeadlineOfTheRequestCapsTheBudget)
+{
+    ipmi::timeout::Scope deadline(ipmi::timeout::Clock::now() +
+                                  std::chrono::milliseconds(50));
+    auto start = ipmi::timeout::Clock::now();
+    EXPECT_EQ(-ETIMEDOUT, hang());
+    EXPECT_LT(ipmi::timeout::Clock::now() - start, std::chrono::seconds(1));
+    EXPECT_EQ(1u, ipmi::timeout::stats().timedOut);
+}
+
+TEST_F(CallTimeouts, NoCallPastTheDeadline)
+{
+    ipmi::timeout::Scope deadline(ipmi::timeout::Clock::now() -
+                                  std::chrono::milliseconds(1));
+    char* service = nullptr;
+    EXPECT_EQ(-ETIMEDOUT, ipmi::getService(mock.bus(), "/no/such/object",
+                                           &service));
+    EXPECT_EQ(0u, mock.calls(mapperInterface, "GetObject"));
+    EXPECT_EQ(1u, ipmi::timeout::stats().abandoned);
+}
+
+TEST_F(CallTimeouts, ScopesNest)
+{
+    EXPECT_EQ(ipmi::timeout::Clock::time_point::max(),
+              ipmi::timeout::deadline());
+    auto outer = ipmi::timeout::Clock::now() + std::chrono::seconds(4);
+    {
+        ipmi::timeout::Scope request(outer);
+        {
+            ipmi::timeout::Scope nested(outer - std::chrono::seconds(1));
+            EXPECT_EQ(outer - std::chrono::seconds(1),
+                      ipmi::timeout::deadline());
+        }
+        EXPECT_EQ(outer, ipmi::timeout::deadline());
+        // The default budget, well within the deadline
+        EXPECT_EQ(2000000u, ipmi::timeout::get(nullptr));
+    }
+    EXPECT_EQ(ipmi::timeout::Clock::time_point::max(),
+              ipmi::timeout::deadline());
+}
+
+namespace
+{
+
+constexpr auto secondSensorPath =
+    "/xyz/openbmc_project/sensors/temperature/temp1";
+
+class SubTree : public ::testing::Test
+{
+    protected:
+        SubTree() : dbus(mock.bus())
+        {
+            MockBus::Scale scale;
+            scale.sensors = 12;
+            scale.logEntries = 5;
+            mock.populate(scale);
+        }
+
+        ~SubTree()
+        {
+            sd_bus_message_unref(reply);
+        }
+
+        /** @brief Calls the mapper's method, the reply goes to reply */
+        void callMapper(const char* method, const char* root,
+                        const char* interface)
+        {
+            ASSERT_LE(0, sd_bus_call_method(mock.bus(), mapperBusName,
+                                            mapperPath, mapperInterface,
+                                            method, nullptr, &reply, "sias",
+                                            root, 0, 1, interface));
+        }
+
+        MockBus mock;
+        sdbusplus::bus::bus dbus;
+        sd_bus_message* reply = nullptr;
+};
+
+} // namespace
+
+TEST_F(SubTree, VisitsEveryObject)
+{
+    callMapper("GetSubTree", sensorRoot, sensorInterface);
+
+    std::vector<std::string> paths;
+    auto r = ipmi::visitSubTree(reply,
+                                [&paths](const char* path,
+                                         const char* service,
+                                         const std::vector<const char*>&
+                                             interfaces)
+                                {
+                                    paths.emplace_back(path);
+                                    EXPECT_EQ(1u, interfaces.size());
+                                    EXPECT_STREQ(sensorInterface,
+                                                 interfaces.front());
+                                    return false;
+                                });
+    EXPECT_EQ(0, r);
+    EXPECT_EQ(12u, paths.size());
+}
+
+TEST_F(SubTree, StopsAtTheMatch)
+{
+    callMapper("GetSubTree", sensorRoot, sensorInterface);
+
+    size_t visited = 0;
+    EXPECT_EQ(0, ipmi::visitSubTree(reply,
+                                    [&visited](const char* path,
+                                               const char*,
+                                               const std::vector<const char*>&)
+                                    {
+                                        ++visited;
+                                        return strcmp(path, secondSensorPath) == 0;
+                                    }));
+    EXPECT_EQ(2u, visited);
+}
+
+TEST_F(SubTree, VisitsEveryPath)
+{
+    callMapper("GetSubTreePaths", logEntryRoot, logEntryInterface);
+
+    std::vector<std::string> paths;
+    EXPECT_EQ(0, ipmi::visitSubTreePaths(reply,
+                                         [&paths](const char* path)
+                                         {
+                                             paths.emplace_back(path);
+                                             return false;
+                                         }));
+    ASSERT_EQ(5u, paths.size());
+    EXPECT_EQ(std::string(logEntryRoot) + "/1", paths.front());
+}
+
+TEST_F(SubTree, NotAGetSubTreeReply)
+{
+    callMapper("GetSubTreePaths", logEntryRoot, logEntryInterface);
+    EXPECT_GT(0, ipmi::visitSubTree(reply,
+                                    [](const char*, const char*,
+                                       const std::vector<const char*>&)
+                                    {
+                                        return false;
+                                    }));
+}
+
+TEST_F(SubTree, AllDbusObjectsKeepsTheMatches)
+{
+    auto objects = ipmi::getAllDbusObjects(dbus, sensorRoot, sensorInterface,
+                                           "temp1");
+    // temp1, temp10 and temp11
+    ASSERT_EQ(3u, objects.size());
+    EXPECT_EQ(sensorService, objects.begin()->second.begin()->first);
+}
@@ -0,0 +1,89 @@
+#include "host-ipmid/ipmid-view.hpp"
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+namespace
+{
+
+struct Request
+{
+    uint8_t id;
+    uint16_t value;
+} __attribute__((packed));
+
+} // namespace
+
+using ipmi::RequestView;
+using ipmi::ResponseView;
+
+TEST(RequestView, GetChecksLength)
+{
+    uint8_t data[] = {0x01, 0x34, 0x12, 0xFF};
+
+    RequestView shortRequest(data, sizeof(Request) - 1);
+    EXPECT_EQ(nullptr, shortRequest.get<Request>());
+
+    RequestView request(data, sizeof(data));
+    auto fields = request.get<Request>();
+    ASSERT_NE(nullptr, fields);
+    EXPECT_EQ(0x01, fields->id);
+    EXPECT_EQ(0x1234, fields->value);
+}
+
+TEST(RequestView, UnpackChecksLength)
+{
+    uint8_t data[] = {0x78, 0x56, 0x34, 0x12};
+    uint32_t value = 0;
+
+    EXPECT_FALSE(RequestView(data, 3).unpack(value));
+    EXPECT_EQ(0u, value);
+
+    EXPECT_TRUE(RequestView(data, sizeof(data)).unpack(value));
+    EXPECT_EQ(0x12345678u, value);
+}
+
+TEST(ResponseView, StartsEmpty)
+{
+    uint8_t buffer[ipmi::maxResponseData];
+    size_t len = 10;
+
+    ResponseView response(buffer, &len);
+    EXPECT_EQ(0u, len);
+    EXPECT_EQ(ipmi::maxResponseData, response.capacity());
+}
+
+TEST(ResponseView, PackTracksLength)
+{
+    uint8_t buffer[8] = {};
+    size_t len = 0;
+    ResponseView response(buffer, &len, sizeof(buffer));
+
+    EXPECT_TRUE(response.pack(Request{0x02, 0xBEEF}));
+    EXPECT_EQ(sizeof(Request), len);
+    EXPECT_EQ(0x02, buffer[0]);
+    EXPECT_EQ(0xEF, buffer[1]);
+    EXPECT_EQ(0xBE, buffer[2]);
+
+    uint8_t tail[] = {0xAA, 0xBB};
+    EXPECT_TRUE(response.append(tail, sizeof(tail)));
+    EXPECT_EQ(sizeof(Request) + sizeof(tail), response.size());
+    EXPECT_EQ(0xBB, buffer[4]);
+
+    response.clear();
+    EXPECT_EQ(0u, len);
+}
+
+TEST(ResponseView, OverflowIsRejected)
+{
+    uint8_t buffer[4] = {};
+    size_t len = 0;
+    ResponseView response(buffer, &len, sizeof(buffer));
+
+    uint8_t data[] = {1, 2, 3};
+    EXPECT_TRUE(response.append(data, sizeof(data)));
+    EXPECT_FALSE(response.append(data, sizeof(data)));
+    EXPECT_FALSE(response.pack(uint16_t(0)));
+    EXPECT_EQ(sizeof(data), len);
+    EXPECT_TRUE(response.pack(uint8_t(4)));
+    EXPECT_EQ(4, buffer[3]);
+}
@@ -0,0 +1,158 @@
+#include "worker-pool.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using ipmi::worker::Pool;
+using ipmi::worker::Queue;
+
+TEST(WorkerQueue, FifoOrder)
+{
+    Queue<int> queue(4);
+    int value;
+    EXPECT_FALSE(queue.pop(value));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(4));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.pop(value));
+}
+
+TEST(WorkerQueue, CapacityIsRoundedUp)
+{
+    Queue<int> queue(3);
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(4));
+}
+
+TEST(WorkerQueue, WrapsAround)
+{
+    Queue<int> queue(2);
+    int value;
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_TRUE(queue.push(i));
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(i, value);
+    }
+}
+
+TEST(WorkerQueue, ConcurrentProducersAndConsumers)
+{
+    constexpr int threads = 4;
+    constexpr int perThread = 10000;
+    Queue<int> queue(64);
+    std::vector<long> sums(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&queue, t]()
+        {
+            for (int i = 1; i <= perThread; ++i)
+            {
+                while (!queue.push(i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        workers.emplace_back([&queue, &sums, t]()
+        {
+            int value;
+            for (int i = 0; i < perThread; ++i)
+            {
+                while (!queue.pop(value))
+                {
+                    std::this_thread::yield();
+                }
+                sums[t] += value;
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    long expected = static_cast<long>(threads) * perThread * (perThread + 1) / 2;
+    EXPECT_EQ(expected, std::accumulate(sums.begin(), sums.end(), 0L));
+}
+
+TEST(WorkerPool, RefusesTasksOnceFull)
+{
+    sd_event* event = nullptr;
+    ASSERT_LE(0, sd_event_new(&event));
+
+    std::atomic<bool> release{false};
+    int completed = 0;
+    {
+        Pool pool(event, 1, 2);
+        auto blocked = [&release]()
+        {
+            while (!release)
+            {
+                std::this_thread::yield();
+            }
+        };
+        auto count = [&completed]()
+        {
+            ++completed;
+        };
+
+        Pool::Work work = blocked;
+        Pool::Work done = count;
+        EXPECT_TRUE(pool.submit(Pool::parallel, std::move(work),
+                                std::move(done)));
+        work = blocked;
+        done = count;
+        EXPECT_TRUE(pool.submit(Pool::parallel, std::move(work),
+                                std::move(done)));
+
+        // A refused task is left to the caller, which still owns it.
+        bool ran = false;
+        work = [&ran]()
+        {
+            ran = true;
+        };
+        done = count;
+        EXPECT_FALSE(pool.submit(Pool::parallel, std::move(work),
+                                 std::move(done)));
+        ASSERT_TRUE(static_cast<bool>(work));
+        ASSERT_TRUE(static_cast<bool>(done));
+        work();
+        EXPECT_TRUE(ran);
+
+        release = true;
+        for (int i = 0; i < 100 && completed < 2; ++i)
+        {
+            sd_event_run(event, 100000);
+        }
+        EXPECT_EQ(2, completed);
+
+        // Room again once the tasks completed.
+        work = []() {};
+        done = count;
+        EXPECT_TRUE(pool.submit(Pool::parallel, std::move(work),
+                                std::move(done)));
+        for (int i = 0; i < 100 && completed < 3; ++i)
+        {
+            sd_event_run(event, 100000);
+        }
+        EXPECT_EQ(3, completed);
+    }
+    sd_event_unref(event);
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "trace.hpp"
+
+// Decodes the IPMI trace ring written by ipmid, either live from
+// ipmi::trace::ringPath or from a copy of it, or a capture file.
+
+using namespace ipmi::trace;
+
+namespace
+{
+
+void print(const Record& record, uint32_t sequence)
+{
+    auto seconds = static_cast<time_t>(record.timestampUs / 1000000);
+    struct tm tm;
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%F %T", gmtime_r(&seconds, &tm));
+
+    if (record.direction == Direction::request)
+    {
+        printf("%8" PRIu32 " %s.%06" PRIu64 " REQ Seq 0x%02x NetFn 0x%02x "
+               "LUN %u Cmd 0x%02x", sequence, stamp,
+               record.timestampUs % 1000000, record.seq, record.netfn,
+               record.lun, record.cmd);
+    }
+    else
+    {
+        printf("%8" PRIu32 " %s.%06" PRIu64 " RSP Seq 0x%02x NetFn 0x%02x "
+               "LUN %u Cmd 0x%02x CC 0x%02x %" PRIu32 "us", sequence, stamp,
+               record.timestampUs % 1000000, record.seq, record.netfn,
+               record.lun, record.cmd, record.cc, record.latencyUs);
+    }
+
+    printf(" [%u]", record.len);
+    auto len = std::min<size_t>(record.len, maxPayload);
+    for (size_t i = 0; i < len; ++i)
+    {
+        printf(" %02x", record.payload[i]);
+    }
+    if (len < record.len)
+    {
+        printf(" ...");
+    }
+    printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const char* path = argc > 1 ? argv[1] : ringPath;
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "-h") == 0))
+    {
+        fprintf(stderr, "Usage: %s [trace or capture file, default %s]\n",
+                argv[0], ringPath);
+        return 1;
+    }
+
+    Reader reader;
+    if (!reader.load(path))
+    {
+        return 1;
+    }
+
+    for (const auto& entry : reader.records())
+    {
+        print(*entry.second, entry.first);
+    }
+
+    if (reader.overwritten() > 0)
+    {
+        printf("%" PRIu32 " older records were overwritten\n",
+               reader.overwritten());
+    }
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace.hpp"
+
+namespace ipmi
+{
+namespace trace
+{
+
+bool Reader::load(const char* path)
+{
+    data.clear();
+    entries.clear();
+    lost = 0;
+
+    // Mapped rather than read, ipmid may still be writing to the ring. The
+    // records are copied out one at a time, checked against the writer.
+    auto fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return false;
+    }
+
+    size_t size = st.st_size;
+    if (size < sizeof(Header))
+    {
+        close(fd);
+        fprintf(stderr, "%s is not an IPMI trace\n", path);
+        return false;
+    }
+
+    auto map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return false;
+    }
+
+    auto header = static_cast<const Header*>(map);
+
+    // Captures hold as many records as were written, a partly written last
+    // record is ignored.
+    auto capacity = header->capacity;
+    if (capacity == captureCapacity)
+    {
+        capacity = (size - sizeof(Header)) / sizeof(Record);
+    }
+
+    if (header->magic != ringMagic || header->version != ringVersion ||
+        header->recordSize != sizeof(Record) ||
+        size < sizeof(Header) + capacity * sizeof(Record))
+    {
+        munmap(map, size);
+        fprintf(stderr, "%s is not a version %" PRIu32 " IPMI trace\n", path,
+                ringVersion);
+        return false;
+    }
+
+    auto head = header->head.load(std::memory_order_relaxed);
+    if (header->capacity != captureCapacity && head > header->capacity)
+    {
+        lost = head - header->capacity;
+    }
+
+    auto ring = reinterpret_cast<const Record*>(header + 1);
+    data.resize(capacity * sizeof(Record));
+    auto records = reinterpret_cast<Record*>(data.data());
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        // Records still being written, or never written, read as 0.
+        auto sequence = ring[i].sequence.load(std::memory_order_acquire);
+        if (sequence == 0)
+        {
+            continue;
+        }
+
+        memcpy(static_cast<void*>(&records[i]), &ring[i], sizeof(Record));
+
+        // The writer zeroes the sequence before it fills a record again, the
+        // copy is torn unless the sequence did not change meanwhile.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (ring[i].sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            continue;
+        }
+        entries.emplace_back(sequence, &records[i]);
+    }
+    munmap(map, size);
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b)
+              {
+                  return a.first < b.first;
+              });
+
+    return true;
+}
+
+} // namespace trace
+} // namespace ipmi
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "trace.hpp"
+
+namespace ipmi
+{
+namespace trace
+{
+
+std::atomic<bool> active{false};
+
+namespace
+{
+
+constexpr size_t ringSize = sizeof(Header) + ringCapacity * sizeof(Record);
+
+Header* header = nullptr;
+Record* records = nullptr;
+
+/** @brief Whether messages go to the ring */
+bool tracing = false;
+
+/** @brief Capture file, while capturing */
+FILE* captureFile = nullptr;
+
+/** @brief Requests captured so far */
+uint32_t captured = 0;
+
+uint64_t clockUs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/** @brief Fills a record, except for its sequence and latency */
+void fill(Record& record, Direction direction, uint8_t seq, uint8_t netfn,
+          uint8_t lun, uint8_t cmd, uint8_t cc, const void* data, size_t len)
+{
+    record.timestampUs = clockUs(CLOCK_REALTIME);
+    record.latencyUs = 0;
+    record.direction = direction;
+    record.seq = seq;
+    record.netfn = netfn;
+    record.lun = lun;
+    record.cmd = cmd;
+    record.cc = cc;
+    record.len = static_cast<uint8_t>(std::min<size_t>(len, UINT8_MAX));
+    memcpy(record.payload, data, std::min(len, maxPayload));
+}
+
+/** @brief Claims the next record and fills it, except for the latency
+ *
+ *  @param[out] position - Position of the record in the trace.
+ */
+Record& claim(uint32_t& position, Direction direction, uint8_t seq,
+              uint8_t netfn, uint8_t lun, uint8_t cmd, uint8_t cc,
+              const void* data, size_t len)
+{
+    position = header->head.fetch_add(1, std::memory_order_relaxed);
+    auto& record = records[position & (ringCapacity - 1)];
+
+    record.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    fill(record, direction, seq, netfn, lun, cmd, cc, data, len);
+    return record;
+}
+
+/** @brief Makes a claimed record visible to readers */
+void publish(Record& record, uint32_t position)
+{
+    record.sequence.store(position + 1, std::memory_order_release);
+}
+
+} // namespace
+
+bool enable()
+{
+    if (tracing)
+    {
+        return true;
+    }
+
+    if (header == nullptr)
+    {
+        auto fd = open(ringPath, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0)
+        {
+            fprintf(stderr, "ERROR: Failed to open %s: %s\n", ringPath,
+                    strerror(errno));
+            return false;
+        }
+
+        void* ring = MAP_FAILED;
+        if (ftruncate(fd, ringSize) == 0)
+        {
+            ring = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+        }
+        auto error = errno;
+        close(fd);
+        if (ring == MAP_FAILED)
+        {
+            fprintf(stderr, "ERROR: Failed to map %s: %s\n", ringPath,
+                    strerror(error));
+            return false;
+        }
+
+        header = static_cast<Header*>(ring);
+        records = reinterpret_cast<Record*>(header + 1);
+    }
+
+    // Every trace starts from an empty ring.
+    memset(static_cast<void*>(header), 0, ringSize);
+    header->magic = ringMagic;
+    header->version = ringVersion;
+    header->capacity = ringCapacity;
+    header->recordSize = sizeof(Record);
+
+    tracing = true;
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+void disable()
+{
+    tracing = false;
+    active.store(captureFile != nullptr, std::memory_order_release);
+    if (header != nullptr)
+    {
+        msync(header, ringSize, MS_ASYNC);
+    }
+}
+
+bool startCapture(const char* path)
+{
+    stopCapture();
+
+    captureFile = fopen(path, "we");
+    if (captureFile == nullptr)
+    {
+        fprintf(stderr, "ERROR: Failed to open %s: %s\n", path,
+                strerror(errno));
+        return false;
+    }
+
+    Header captureHeader;
+    memset(static_cast<void*>(&captureHeader), 0, sizeof(captureHeader));
+    captureHeader.magic = ringMagic;
+    captureHeader.version = ringVersion;
+    captureHeader.capacity = captureCapacity;
+    captureHeader.recordSize = sizeof(Record);
+    if (fwrite(&captureHeader, sizeof(captureHeader), 1, captureFile) != 1)
+    {
+        fprintf(stderr, "ERROR: Failed to write %s\n", path);
+        fclose(captureFile);
+        captureFile = nullptr;
+        return false;
+    }
+
+    captured = 0;
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+void stopCapture()
+{
+    if (captureFile == nullptr)
+    {
+        return;
+    }
+
+    if (fclose(captureFile) != 0)
+    {
+        fprintf(stderr, "ERROR: Failed to write the capture: %s\n",
+                strerror(errno));
+    }
+    captureFile = nullptr;
+    active.store(tracing, std::memory_order_release);
+}
+
+uint64_t now()
+{
+    return clockUs(CLOCK_MONOTONIC);
+}
+
+void request(uint8_t seq, uint8_t netfn, uint8_t lun, uint8_t cmd,
+             const void* data, size_t len)
+{
+    if (tracing)
+    {
+        uint32_t position;
+        auto& record = claim(position, Direction::request, seq, netfn, lun,
+                             cmd, 0, data, len);
+        publish(record, position);
+    }
+
+    if (captureFile != nullptr)
+    {
+        // Flushed per request, ipmid is usually stopped by a signal and
+        // never gets to stopCapture().
+        Record record;
+        memset(static_cast<void*>(&record), 0, sizeof(record));
+        fill(record, Direction::request, seq, netfn, lun, cmd, 0, data, len);
+        record.sequence.store(++captured, std::memory_order_relaxed);
+        if (fwrite(&record, sizeof(record), 1, captureFile) != 1 ||
+            fflush(captureFile) != 0)
+        {
+            fprintf(stderr, "ERROR: Failed to write the capture, "
+                    "stopping it\n");
+            stopCapture();
+        }
+    }
+}
+
+void response(uint8_t seq, uint8_t netfn, uint8_t lun, uint8_t cmd,
+              uint8_t cc, const void* data, size_t len, uint64_t latencyUs)
+{
+    if (!tracing)
+    {
+        return;
+    }
+
+    uint32_t position;
+    auto& record = claim(position, Direction::response, seq, netfn, lun, cmd,
+                         cc, data, len);
+    record.latencyUs = static_cast<uint32_t>(
+                           std::min<uint64_t>(latencyUs, UINT32_MAX));
+    publish(record, position);
+}
+
+} // namespace trace
+} // namespace ipmi
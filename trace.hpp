@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace ipmi
+{
+namespace trace
+{
+
+/** @brief Memory mapped file holding the trace ring */
+constexpr auto ringPath = "/run/ipmid-trace";
+
+/** @brief Identifies a trace ring file, "IPMT" */
+constexpr uint32_t ringMagic = 0x544D5049;
+
+/** @brief Layout version of the trace ring file */
+constexpr uint32_t ringVersion = 1;
+
+/** @brief Number of records in the ring, a power of two */
+constexpr uint32_t ringCapacity = 4096;
+
+/** @brief Payload bytes kept per record, the BT interface's buffer size */
+constexpr size_t maxPayload = 64;
+
+/** @brief Capacity in the header of a capture file. Captures are not
+ *         rings, their request records follow the header until the end of
+ *         the file, for ipmid-replay.
+ */
+constexpr uint32_t captureCapacity = 0;
+
+/** @brief D-Bus interface of the signal that toggles tracing */
+constexpr auto controlInterface = "org.openbmc.HostIpmi.Trace";
+
+/** @brief D-Bus member of the signal that toggles tracing, it carries a
+ *         single boolean. The object path does not matter, e.g.
+ *
+ *  dbus-send --system --type=signal /org/openbmc/HostIpmi \
+ *      org.openbmc.HostIpmi.Trace.SetEnabled boolean:true
+ */
+constexpr auto controlMember = "SetEnabled";
+
+enum class Direction : uint8_t
+{
+    request = 0,
+    response = 1,
+};
+
+/** @struct Header
+ *  @brief Start of the trace ring file.
+ */
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    /** @brief Number of records ever written. The next record goes to
+     *         head % capacity.
+     */
+    std::atomic<uint32_t> head;
+    uint32_t reserved[3];
+};
+
+/** @struct Record
+ *  @brief A single traced message.
+ *
+ *  sequence is 0 while the record is being written, then the 1-based
+ *  position of the record in the trace, so readers can tell torn and stale
+ *  records apart from valid ones.
+ */
+struct Record
+{
+    std::atomic<uint32_t> sequence;
+    uint32_t latencyUs;     //!< Handling time, responses only.
+    uint64_t timestampUs;   //!< CLOCK_REALTIME when recorded.
+    Direction direction;
+    uint8_t seq;
+    uint8_t netfn;
+    uint8_t lun;
+    uint8_t cmd;
+    uint8_t cc;             //!< Completion code, responses only.
+    uint8_t len;            //!< Payload length, may exceed maxPayload.
+    uint8_t reserved;
+    uint8_t payload[maxPayload];
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+              "The trace ring is shared with readers in other processes");
+
+/** @brief Set while tracing or capturing, only for enabled() */
+extern std::atomic<bool> active;
+
+/** @brief Whether messages should be traced or captured.
+ *
+ *  This is the only cost paid per message while tracing is off.
+ */
+inline bool enabled()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+/** @brief Starts tracing into a fresh ring at ringPath
+ *
+ *  @return true if tracing is on.
+ */
+bool enable();
+
+/** @brief Stops tracing, the ring file is left for the dump tool */
+void disable();
+
+/** @brief Starts appending every request to a capture file
+ *
+ *  @param[in] path - Capture file, truncated.
+ *
+ *  @return true if capturing.
+ */
+bool startCapture(const char* path);
+
+/** @brief Stops capturing and flushes the capture file */
+void stopCapture();
+
+/** @brief Monotonic time in microseconds, to measure handler latency */
+uint64_t now();
+
+/** @brief Records a request in the ring and the capture, only while
+ *         enabled()
+ *
+ *  @param[in] seq - Sequence number from the bridge.
+ *  @param[in] netfn - Network function.
+ *  @param[in] lun - Logical unit number.
+ *  @param[in] cmd - Command.
+ *  @param[in] data - Request data.
+ *  @param[in] len - Length of the request data.
+ */
+void request(uint8_t seq, uint8_t netfn, uint8_t lun, uint8_t cmd,
+             const void* data, size_t len);
+
+/** @brief Records a response in the ring, only while enabled()
+ *
+ *  @param[in] seq - Sequence number from the bridge.
+ *  @param[in] netfn - Network function of the request.
+ *  @param[in] lun - Logical unit number.
+ *  @param[in] cmd - Command.
+ *  @param[in] cc - Completion code.
+ *  @param[in] data - Response data, without the completion code.
+ *  @param[in] len - Length of the response data.
+ *  @param[in] latencyUs - Time from request to response.
+ */
+void response(uint8_t seq, uint8_t netfn, uint8_t lun, uint8_t cmd,
+              uint8_t cc, const void* data, size_t len, uint64_t latencyUs);
+
+/** @class Reader
+ *  @brief Loads a snapshot of a trace ring or of a capture file, for the
+ *         tools working offline.
+ *
+ *  The ring is read while ipmid writes to it, a record overwritten while
+ *  it is copied is left out of the snapshot.
+ */
+class Reader
+{
+    public:
+        /** @brief A record and its 1-based position in the trace */
+        using Entry = std::pair<uint32_t, const Record*>;
+
+        /** @brief Reads the file at path
+         *
+         *  @return false, after printing why to stderr, if the file can not
+         *          be read or is not a trace.
+         */
+        bool load(const char* path);
+
+        /** @brief The valid records, oldest first */
+        const std::vector<Entry>& records() const
+        {
+            return entries;
+        }
+
+        /** @brief Records lost because the ring wrapped */
+        uint32_t overwritten() const
+        {
+            return lost;
+        }
+
+    private:
+        std::vector<char> data;
+        std::vector<Entry> entries;
+        uint32_t lost = 0;
+};
+
+} // namespace trace
+} // namespace ipmi
@@ -580,12 +580,13 @@ ipmi_ret_t ipmi_transport_get_lan(ipmi_netfn_t netfn,
             {
                 *data_len = ipmi::network::IPV4_ADDRESS_SIZE_BYTE + 1;
             }
-            memcpy(response, &buf, *data_len);
         }
         else
         {
             rc = IPMI_CC_UNSPECIFIED_ERROR;
         }
+        // The revision at least, it is reported either way.
+        memcpy(response, &buf, *data_len);
     }
     else if (reqptr->parameter == LAN_PARM_VLAN)
     {
@@ -596,8 +597,8 @@ ipmi_ret_t ipmi_transport_get_lan(ipmi_netfn_t netfn,
         if (getNetworkData(reqptr->parameter, &buf[1], channel) == IPMI_CC_OK)
         {
             *data_len = sizeof(buf);
-            memcpy(response, &buf, *data_len);
         }
+        memcpy(response, &buf, *data_len);
     }
     else if (reqptr->parameter == LAN_PARM_IPSRC)
     {
@@ -607,8 +608,8 @@ ipmi_ret_t ipmi_transport_get_lan(ipmi_netfn_t netfn,
         if (getNetworkData(reqptr->parameter, &buff[1], channel) == IPMI_CC_OK)
         {
             *data_len = sizeof(buff);
-            memcpy(response, &buff, *data_len);
         }
+        memcpy(response, &buff, *data_len);
     }
     else
     {
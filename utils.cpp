@@ -3,9 +3,16 @@
 #include <phosphor-logging/elog-errors.hpp>
 #include "xyz/openbmc_project/Common/error.hpp"
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <array>
+#include <atomic>
 #include <dirent.h>
+#include <errno.h>
+#include <map>
 #include <net/if.h>
+#include <stdarg.h>
+#include <string.h>
 
 namespace ipmi
 {
@@ -23,6 +30,212 @@ bool isLinkLocalIP(const std::string& ipaddress);
 
 }
 
+namespace timeout
+{
+
+namespace
+{
+
+/** @brief Deadline of the request handled by the thread */
+thread_local Clock::time_point requestDeadline = Clock::time_point::max();
+
+std::chrono::microseconds fallbackBudget = defaultBudget;
+
+std::map<std::string, std::chrono::microseconds> budgets;
+
+std::atomic<uint64_t> timedOutCalls{0};
+std::atomic<uint64_t> abandonedCalls{0};
+
+/** @brief Counts and logs a call that ran out of its timeout */
+void timedOut(sd_bus_message* m)
+{
+    timeout::timedOut(sd_bus_message_get_path(m),
+                      sd_bus_message_get_interface(m),
+                      sd_bus_message_get_member(m));
+}
+
+} // namespace
+
+void timedOut(const char* path, const char* interface, const char* member)
+{
+    auto nullable = [](const char* string)
+    {
+        return string == nullptr ? "" : string;
+    };
+
+    ++timedOutCalls;
+    log<level::ERR>("D-Bus call timed out",
+                    entry("PATH=%s", nullable(path)),
+                    entry("INTERFACE=%s", nullable(interface)),
+                    entry("MEMBER=%s", nullable(member)));
+}
+
+Scope::Scope(Clock::time_point deadline) :
+    previous(requestDeadline)
+{
+    requestDeadline = deadline;
+}
+
+Scope::~Scope()
+{
+    requestDeadline = previous;
+}
+
+Clock::time_point deadline()
+{
+    return requestDeadline;
+}
+
+void setDefaultBudget(std::chrono::microseconds budget)
+{
+    fallbackBudget = budget;
+}
+
+void setBudget(const std::string& interface,
+               std::chrono::microseconds budget)
+{
+    budgets[interface] = budget;
+}
+
+uint64_t get(const char* interface)
+{
+    using namespace std::chrono;
+
+    auto budget = fallbackBudget;
+    if (interface != nullptr)
+    {
+        auto found = budgets.find(interface);
+        if (found != budgets.end())
+        {
+            budget = found->second;
+        }
+    }
+
+    if (requestDeadline != Clock::time_point::max())
+    {
+        auto left = duration_cast<microseconds>(requestDeadline -
+                                                Clock::now());
+        if (left.count() <= 0)
+        {
+            return 0;
+        }
+        budget = std::min(budget, left);
+    }
+    // 0 would be sd-bus' default timeout
+    return std::max<uint64_t>(budget.count(), 1);
+}
+
+Stats stats()
+{
+    Stats current;
+    current.timedOut = timedOutCalls;
+    current.abandoned = abandonedCalls;
+    return current;
+}
+
+void resetStats()
+{
+    timedOutCalls = 0;
+    abandonedCalls = 0;
+}
+
+void abandoned()
+{
+    ++abandonedCalls;
+}
+
+} // namespace timeout
+
+sdbusplus::message::message call(sdbusplus::bus::bus& bus,
+                                 sdbusplus::message::message& m)
+{
+    auto interface = sd_bus_message_get_interface(m.get());
+    auto timeoutUs = timeout::get(interface);
+    if (timeoutUs == 0)
+    {
+        timeout::abandoned();
+        // What bus::call() returns for a failed call
+        return sdbusplus::message::message(nullptr);
+    }
+
+    auto start = timeout::Clock::now();
+    auto reply = bus.call(m, timeoutUs);
+    if (reply.is_method_error() &&
+        timeout::Clock::now() - start >= std::chrono::microseconds(timeoutUs))
+    {
+        timeout::timedOut(m.get());
+    }
+    return reply;
+}
+
+namespace
+{
+
+/** @brief sd_bus_call(), with the timeout of timeout::get(interface) */
+int callWithin(const char* interface, sd_bus* bus, sd_bus_message* m,
+               sd_bus_error* error, sd_bus_message** reply)
+{
+    auto timeoutUs = timeout::get(interface);
+    if (timeoutUs == 0)
+    {
+        timeout::abandoned();
+        return sd_bus_error_set_errno(error, -ETIMEDOUT);
+    }
+
+    auto r = sd_bus_call(bus, m, timeoutUs, error, reply);
+    if (r == -ETIMEDOUT)
+    {
+        timeout::timedOut(m);
+    }
+    return r;
+}
+
+} // namespace
+
+int call(sd_bus* bus, sd_bus_message* m, sd_bus_error* error,
+         sd_bus_message** reply)
+{
+    return callWithin(sd_bus_message_get_interface(m), bus, m, error, reply);
+}
+
+int callMethod(sd_bus* bus, const char* destination, const char* path,
+               const char* interface, const char* member, sd_bus_error* error,
+               sd_bus_message** reply, const char* types, ...)
+{
+    sd_bus_message* m = nullptr;
+    // Properties calls are bounded by the budget of the interface whose
+    // properties they access, their first argument.
+    auto budget = interface;
+    auto r = sd_bus_message_new_method_call(bus, &m, destination, path,
+                                            interface, member);
+    if (r >= 0 && types != nullptr && *types != '\0')
+    {
+        va_list ap;
+        va_start(ap, types);
+        if (types[0] == 's' && interface != nullptr &&
+            strcmp(interface, PROP_INTF) == 0)
+        {
+            va_list first;
+            va_copy(first, ap);
+            budget = va_arg(first, const char*);
+            va_end(first);
+        }
+        r = sd_bus_message_appendv(m, types, ap);
+        va_end(ap);
+    }
+
+    if (r >= 0)
+    {
+        r = callWithin(budget, bus, m, error, reply);
+    }
+    else
+    {
+        r = sd_bus_error_set_errno(error, r);
+    }
+    sd_bus_message_unref(m);
+    return r;
+}
+
 //TODO There may be cases where an interface is implemented by multiple
 //  objects,to handle such cases we are interested on that object
 //  which are on interested busname.
@@ -46,7 +259,7 @@ DbusObjectInfo getDbusObject(sdbusplus::bus::bus& bus,
 
     mapperCall.append(serviceRoot, depth, interfaces);
 
-    auto mapperReply = bus.call(mapperCall);
+    auto mapperReply = call(bus, mapperCall);
     if (mapperReply.is_method_error())
     {
         log<level::ERR>("Error in mapper call");
@@ -153,7 +366,7 @@ Value getDbusProperty(sdbusplus::bus::bus& bus,
 
     method.append(interface, property);
 
-    auto reply = bus.call(method);
+    auto reply = call(bus, method);
 
     if (reply.is_method_error())
     {
@@ -184,7 +397,7 @@ PropertyMap getAllDbusProperties(sdbusplus::bus::bus& bus,
 
     method.append(interface);
 
-    auto reply = bus.call(method);
+    auto reply = call(bus, method);
 
     if (reply.is_method_error())
     {
@@ -198,6 +411,32 @@ PropertyMap getAllDbusProperties(sdbusplus::bus::bus& bus,
     return properties;
 }
 
+namespace internal
+{
+
+sdbusplus::message::message callGetManagedObjects(
+    sdbusplus::bus::bus& bus,
+    const std::string& service,
+    const std::string& managerPath)
+{
+    auto method = bus.new_method_call(service.c_str(),
+                                      managerPath.c_str(),
+                                      OBJECT_MANAGER_INTF,
+                                      "GetManagedObjects");
+
+    auto reply = call(bus, method);
+    if (reply.is_method_error())
+    {
+        log<level::ERR>("Failed to get the managed objects",
+                        entry("SERVICE=%s", service.c_str()),
+                        entry("PATH=%s", managerPath.c_str()));
+        elog<InternalFailure>();
+    }
+    return reply;
+}
+
+} // namespace internal
+
 void setDbusProperty(sdbusplus::bus::bus& bus,
                      const std::string& service,
                      const std::string& objPath,
@@ -213,7 +452,7 @@ void setDbusProperty(sdbusplus::bus::bus& bus,
 
     method.append(interface, property, value);
 
-    if (!bus.call(method))
+    if (!call(bus, method))
     {
         log<level::ERR>("Failed to set property",
                         entry("PROPERTY=%s", property.c_str()),
@@ -225,10 +464,212 @@ void setDbusProperty(sdbusplus::bus::bus& bus,
 }
 
 
+namespace
+{
+
+constexpr auto nameOwnerChangedRule =
+    "type='signal',sender='org.freedesktop.DBus',"
+    "path='/org/freedesktop/DBus',interface='org.freedesktop.DBus',"
+    "member='NameOwnerChanged'";
+
+// Matched from any sender, the mapper's included.
+constexpr auto interfacesAddedRule =
+    "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+    "member='InterfacesAdded'";
+constexpr auto interfacesRemovedRule =
+    "type='signal',interface='org.freedesktop.DBus.ObjectManager',"
+    "member='InterfacesRemoved'";
+
+/** @class ServiceCache
+ *  @brief Services the mapper resolved objects to, by path and interface.
+ *
+ *  An entry is dropped when its service changes owner and when interfaces
+ *  are added to or removed from its object. The cache follows the
+ *  connection it is used with, a lookup on another connection starts over
+ *  from an empty cache. Like the connections, it is not thread safe.
+ */
+class ServiceCache
+{
+    public:
+        ServiceCache() = default;
+        ~ServiceCache()
+        {
+            unwatch();
+        }
+        ServiceCache(const ServiceCache&) = delete;
+        ServiceCache& operator=(const ServiceCache&) = delete;
+        ServiceCache(ServiceCache&&) = delete;
+        ServiceCache& operator=(ServiceCache&&) = delete;
+
+        /** @brief Looks an object up, counting a hit or a miss
+         *
+         *  @param[in] bus - Connection the lookup is made on.
+         *  @param[in] path - Object path.
+         *  @param[in] interface - Interface, empty for any.
+         *  @param[out] service - The service, on a hit.
+         *
+         *  @return true on a hit.
+         */
+        bool find(sd_bus* bus, const std::string& path,
+                  const std::string& interface, std::string& service)
+        {
+            if (watch(bus))
+            {
+                auto found = services.find(Key(path, interface));
+                if (found != services.end())
+                {
+                    ++hits;
+                    service = found->second;
+                    return true;
+                }
+            }
+            ++misses;
+            return false;
+        }
+
+        /** @brief Adds the service the mapper resolved an object to */
+        void insert(sd_bus* bus, const std::string& path,
+                    const std::string& interface, const std::string& service)
+        {
+            if (watch(bus))
+            {
+                services[Key(path, interface)] = service;
+            }
+        }
+
+        CacheStats stats() const
+        {
+            CacheStats stats;
+            stats.hits = hits;
+            stats.misses = misses;
+            stats.entries = services.size();
+            return stats;
+        }
+
+        void resetStats()
+        {
+            hits = 0;
+            misses = 0;
+        }
+
+    private:
+        /** @brief Path and interface of an object */
+        using Key = std::pair<std::string, std::string>;
+
+        /** @brief Subscribes to the signals invalidating the cache on bus,
+         *         dropping the entries of any other connection.
+         *
+         *  @return Whether the cache can be used with bus.
+         */
+        bool watch(sd_bus* bus)
+        {
+            // The slots keep a reference on their connection, its address
+            // can't be reused while it is watched.
+            if (slots[0] != nullptr && sd_bus_slot_get_bus(slots[0]) == bus)
+            {
+                return true;
+            }
+            unwatch();
+
+            const std::array<std::pair<const char*,
+                                       sd_bus_message_handler_t>, 3> matches =
+            {
+                std::make_pair(nameOwnerChangedRule, onNameOwnerChanged),
+                std::make_pair(interfacesAddedRule, onInterfacesChanged),
+                std::make_pair(interfacesRemovedRule, onInterfacesChanged),
+            };
+            for (size_t i = 0; i < matches.size(); ++i)
+            {
+                auto r = sd_bus_add_match(bus, &slots[i], matches[i].first,
+                                          matches[i].second, this);
+                if (r < 0)
+                {
+                    log<level::ERR>("Failed to watch the mapper services",
+                                    entry("ERROR=%s", strerror(-r)));
+                    unwatch();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void unwatch()
+        {
+            for (auto& slot : slots)
+            {
+                slot = sd_bus_slot_unref(slot);
+            }
+            services.clear();
+        }
+
+        static int onNameOwnerChanged(sd_bus_message* m, void* userData,
+                                      sd_bus_error* error)
+        {
+            auto cache = static_cast<ServiceCache*>(userData);
+            const char* name = nullptr;
+            if (sd_bus_message_read(m, "s", &name) < 0)
+            {
+                return 0;
+            }
+
+            if (strcmp(name, MAPPER_BUS_NAME) == 0)
+            {
+                cache->services.clear();
+                return 0;
+            }
+            for (auto iter = cache->services.begin();
+                 iter != cache->services.end();)
+            {
+                if (iter->second == name)
+                {
+                    iter = cache->services.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+            return 0;
+        }
+
+        static int onInterfacesChanged(sd_bus_message* m, void* userData,
+                                       sd_bus_error* error)
+        {
+            auto cache = static_cast<ServiceCache*>(userData);
+            const char* path = nullptr;
+            if (sd_bus_message_read(m, "o", &path) < 0)
+            {
+                return 0;
+            }
+
+            auto iter = cache->services.lower_bound(Key(path, {}));
+            while (iter != cache->services.end() && iter->first.first == path)
+            {
+                iter = cache->services.erase(iter);
+            }
+            return 0;
+        }
+
+        std::array<sd_bus_slot*, 3> slots{};
+        std::map<Key, std::string> services;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+};
+
+ServiceCache serviceCache;
+
+} // namespace
+
 std::string getService(sdbusplus::bus::bus& bus,
                        const std::string& intf,
                        const std::string& path)
 {
+    std::string service;
+    if (serviceCache.find(bus.get(), path, intf, service))
+    {
+        return service;
+    }
+
     auto mapperCall = bus.new_method_call("xyz.openbmc_project.ObjectMapper",
                                           "/xyz/openbmc_project/object_mapper",
                                           "xyz.openbmc_project.ObjectMapper",
@@ -237,7 +678,7 @@ std::string getService(sdbusplus::bus::bus& bus,
     mapperCall.append(path);
     mapperCall.append(std::vector<std::string>({intf}));
 
-    auto mapperResponseMsg = bus.call(mapperCall);
+    auto mapperResponseMsg = call(bus, mapperCall);
 
     if (mapperResponseMsg.is_method_error())
     {
@@ -252,7 +693,301 @@ std::string getService(sdbusplus::bus::bus& bus,
         throw std::runtime_error("ERROR in reading the mapper response");
     }
 
-    return mapperResponse.begin()->first;
+    service = mapperResponse.begin()->first;
+    serviceCache.insert(bus.get(), path, intf, service);
+    return service;
+}
+
+int getService(sd_bus* bus, const char* path, char** service)
+{
+    std::string found;
+    if (!serviceCache.find(bus, path, {}, found))
+    {
+        sd_bus_error error = SD_BUS_ERROR_NULL;
+        sd_bus_message* reply = nullptr;
+        auto r = callMethod(bus, MAPPER_BUS_NAME, MAPPER_OBJ,
+                            MAPPER_INTF, "GetObject", &error, &reply,
+                            "sas", path, 0);
+        // The first service of the reply, in the mapper's order.
+        if (r >= 0)
+        {
+            r = sd_bus_message_enter_container(reply, 'a', "{sas}");
+        }
+        if (r > 0)
+        {
+            r = sd_bus_message_enter_container(reply, 'e', "sas");
+        }
+        const char* name = nullptr;
+        if (r > 0)
+        {
+            r = sd_bus_message_read(reply, "s", &name);
+        }
+        sd_bus_error_free(&error);
+        if (r > 0)
+        {
+            found = name;
+        }
+        sd_bus_message_unref(reply);
+
+        if (r <= 0)
+        {
+            return r < 0 ? r : -ENXIO;
+        }
+        serviceCache.insert(bus, path, {}, found);
+    }
+
+    *service = strdup(found.c_str());
+    return *service != nullptr ? 0 : -ENOMEM;
+}
+
+CacheStats getServiceCacheStats()
+{
+    return serviceCache.stats();
+}
+
+void resetServiceCacheStats()
+{
+    serviceCache.resetStats();
+}
+
+void PropertyCache::watch(sdbusplus::bus::bus& bus,
+                          const std::string& service,
+                          const std::string& objPath,
+                          const std::string& interface)
+{
+    auto& entry = watched(bus, service, objPath, interface);
+    if (!entry.fresh)
+    {
+        refresh(bus, objPath, interface, entry);
+    }
+}
+
+Value PropertyCache::get(sdbusplus::bus::bus& bus,
+                         const std::string& service,
+                         const std::string& objPath,
+                         const std::string& interface,
+                         const std::string& property)
+{
+    auto& entry = watched(bus, service, objPath, interface);
+    if (entry.fresh)
+    {
+        auto value = entry.properties.find(property);
+        if (value != entry.properties.end())
+        {
+            ++hits;
+            return value->second;
+        }
+    }
+
+    ++misses;
+    if (!entry.fresh)
+    {
+        refresh(bus, objPath, interface, entry);
+
+        auto value = entry.properties.find(property);
+        if (value != entry.properties.end())
+        {
+            return value->second;
+        }
+    }
+    return getDbusProperty(bus, service, objPath, interface, property);
+}
+
+void PropertyCache::invalidate(const std::string& objPath,
+                               const std::string& interface)
+{
+    auto entry = entries.find(Key(objPath, interface));
+    if (entry != entries.end())
+    {
+        entry->second.fresh = false;
+    }
+}
+
+CacheStats PropertyCache::stats() const
+{
+    CacheStats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.entries = entries.size();
+    return stats;
+}
+
+void PropertyCache::resetStats()
+{
+    hits = 0;
+    misses = 0;
+}
+
+PropertyCache::Entry& PropertyCache::watched(sdbusplus::bus::bus& bus,
+                                             const std::string& service,
+                                             const std::string& objPath,
+                                             const std::string& interface)
+{
+    namespace rules = sdbusplus::bus::match::rules;
+
+    // The matches keep a reference on their connection, its address can't
+    // be reused while they exist.
+    if (ownerBus != bus.get())
+    {
+        ownerMatch = std::make_unique<sdbusplus::bus::match_t>(
+            bus,
+            nameOwnerChangedRule,
+            [this](sdbusplus::message::message& msg)
+            {
+                std::string name;
+                msg.read(name);
+                for (auto& entry : entries)
+                {
+                    if (entry.second.service == name)
+                    {
+                        entry.second.fresh = false;
+                    }
+                }
+            });
+        ownerBus = bus.get();
+    }
+
+    auto& entry = entries[Key(objPath, interface)];
+    if (entry.service != service)
+    {
+        entry.service = service;
+        entry.fresh = false;
+    }
+    if (entry.bus != bus.get())
+    {
+        auto watchedEntry = &entry;
+        entry.match = std::make_unique<sdbusplus::bus::match_t>(
+            bus,
+            rules::propertiesChanged(objPath, interface),
+            [watchedEntry](sdbusplus::message::message& msg)
+            {
+                std::string interface;
+                PropertyMap changed;
+                std::vector<std::string> invalidated;
+                msg.read(interface, changed, invalidated);
+
+                for (auto& property : changed)
+                {
+                    watchedEntry->properties[property.first] =
+                        std::move(property.second);
+                }
+                if (!invalidated.empty())
+                {
+                    watchedEntry->fresh = false;
+                }
+            });
+        entry.bus = bus.get();
+        entry.fresh = false;
+    }
+    return entry;
+}
+
+void PropertyCache::refresh(sdbusplus::bus::bus& bus,
+                            const std::string& objPath,
+                            const std::string& interface,
+                            Entry& entry)
+{
+    entry.properties = getAllDbusProperties(bus, entry.service, objPath,
+                                            interface);
+    entry.fresh = true;
+}
+
+PropertyCache& propertyCache()
+{
+    static PropertyCache cache;
+    return cache;
+}
+
+int visitSubTree(sd_bus_message* reply, const SubTreeVisitor& visit)
+{
+    std::vector<const char*> interfaces;
+
+    // a{sa{sas}}
+    auto r = sd_bus_message_enter_container(reply, 'a', "{sa{sas}}");
+    while (r > 0)
+    {
+        r = sd_bus_message_enter_container(reply, 'e', "sa{sas}");
+        if (r <= 0)
+        {
+            break;
+        }
+
+        const char* path = nullptr;
+        r = sd_bus_message_read(reply, "s", &path);
+        if (r >= 0)
+        {
+            r = sd_bus_message_enter_container(reply, 'a', "{sas}");
+        }
+        while (r > 0)
+        {
+            r = sd_bus_message_enter_container(reply, 'e', "sas");
+            if (r <= 0)
+            {
+                break;
+            }
+
+            const char* service = nullptr;
+            r = sd_bus_message_read(reply, "s", &service);
+            if (r >= 0)
+            {
+                r = sd_bus_message_enter_container(reply, 'a', "s");
+            }
+            interfaces.clear();
+            const char* interface = nullptr;
+            while (r > 0 &&
+                   (r = sd_bus_message_read(reply, "s", &interface)) > 0)
+            {
+                interfaces.push_back(interface);
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_exit_container(reply);
+            }
+            if (r >= 0)
+            {
+                r = sd_bus_message_exit_container(reply);
+            }
+            if (r < 0)
+            {
+                break;
+            }
+            if (visit(path, service, interfaces))
+            {
+                return 0;
+            }
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_exit_container(reply);
+        }
+        if (r >= 0)
+        {
+            r = sd_bus_message_exit_container(reply);
+        }
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_exit_container(reply);
+    }
+    return r < 0 ? r : 0;
+}
+
+int visitSubTreePaths(sd_bus_message* reply, const PathVisitor& visit)
+{
+    auto r = sd_bus_message_enter_container(reply, 'a', "s");
+    const char* path = nullptr;
+    while (r > 0 && (r = sd_bus_message_read(reply, "s", &path)) > 0)
+    {
+        if (visit(path))
+        {
+            return 0;
+        }
+    }
+    if (r >= 0)
+    {
+        r = sd_bus_message_exit_container(reply);
+    }
+    return r < 0 ? r : 0;
 }
 
 ipmi::ObjectTree getAllDbusObjects(sdbusplus::bus::bus& bus,
@@ -272,7 +1007,7 @@ ipmi::ObjectTree getAllDbusObjects(sdbusplus::bus::bus& bus,
 
     mapperCall.append(serviceRoot, depth, interfaces);
 
-    auto mapperReply = bus.call(mapperCall);
+    auto mapperReply = call(bus, mapperCall);
     if (mapperReply.is_method_error())
     {
         log<level::ERR>("Error in mapper call",
@@ -282,22 +1017,143 @@ ipmi::ObjectTree getAllDbusObjects(sdbusplus::bus::bus& bus,
         elog<InternalFailure>();
     }
 
+    // Only the objects matching are kept
     ObjectTree objectTree;
-    mapperReply.read(objectTree);
+    auto r = visitSubTree(mapperReply.get(),
+                          [&objectTree, &match](
+                              const char* path, const char* service,
+                              const std::vector<const char*>& interfaces)
+                          {
+                              if (strstr(path, match.c_str()) != nullptr)
+                              {
+                                  objectTree[path][service].assign(
+                                      interfaces.begin(), interfaces.end());
+                              }
+                              return false;
+                          });
+    if (r < 0)
+    {
+        log<level::ERR>("Invalid mapper response",
+                        entry("SERVICEROOT=%s", serviceRoot.c_str()),
+                        entry("INTERFACE=%s", interface.c_str()));
+        elog<InternalFailure>();
+    }
+
+    return objectTree;
+}
+
+namespace
+{
 
-    for (auto it = objectTree.begin(); it != objectTree.end();)
+/** @struct FanOut
+ *  @brief Calls of a fanOut() in progress.
+ */
+struct FanOut
+{
+    sd_bus* bus;
+    std::vector<MethodCall> calls;
+    std::vector<int> results;
+    std::chrono::steady_clock::time_point deadline;
+    size_t window;
+    size_t next;        //!< Index of the next call to send.
+    size_t inFlight;    //!< Calls sent and not answered yet.
+    FanOutDone done;
+};
+
+/** @struct FanOutCall
+ *  @brief A call of a FanOut waiting for its reply.
+ */
+struct FanOutCall
+{
+    std::shared_ptr<FanOut> fanOut;
+    size_t index;
+};
+
+void sendCalls(const std::shared_ptr<FanOut>& fanOut);
+
+int onFanOutReply(sd_bus_message* m, void* userData, sd_bus_error* error)
+{
+    std::unique_ptr<FanOutCall> call(static_cast<FanOutCall*>(userData));
+    auto& fanOut = call->fanOut;
+
+    --fanOut->inFlight;
+    fanOut->results[call->index] =
+        sd_bus_message_is_method_error(m, nullptr) ?
+        -sd_bus_message_get_errno(m) : 0;
+    sendCalls(fanOut);
+    return 0;
+}
+
+/** @brief Sends calls up to the window, completes the fan out when every
+ *         call is answered.
+ */
+void sendCalls(const std::shared_ptr<FanOut>& fanOut)
+{
+    using namespace std::chrono;
+
+    while (fanOut->inFlight < fanOut->window &&
+           fanOut->next < fanOut->calls.size())
     {
-        if (it->first.find(match) == std::string::npos)
+        auto index = fanOut->next++;
+        auto remaining = duration_cast<microseconds>(
+                             fanOut->deadline - steady_clock::now());
+        if (remaining.count() <= 0)
         {
-            it = objectTree.erase(it);
+            fanOut->results[index] = -ETIMEDOUT;
+            continue;
         }
-        else
+
+        const auto& call = fanOut->calls[index];
+        sd_bus_message* m = nullptr;
+        auto r = sd_bus_message_new_method_call(fanOut->bus, &m,
+                                                call.service.c_str(),
+                                                call.path.c_str(),
+                                                call.interface.c_str(),
+                                                call.method.c_str());
+        auto pending = new FanOutCall{fanOut, index};
+        if (r >= 0)
+        {
+            // sd-bus answers the call with an error at the deadline.
+            r = sd_bus_call_async(fanOut->bus, nullptr, m, onFanOutReply,
+                                  pending, remaining.count());
+        }
+        sd_bus_message_unref(m);
+        if (r < 0)
         {
-            ++it;
+            delete pending;
+            fanOut->results[index] = r;
+            continue;
         }
+        ++fanOut->inFlight;
     }
 
-    return objectTree;
+    if (fanOut->inFlight == 0 && fanOut->next == fanOut->calls.size() &&
+        fanOut->done)
+    {
+        auto done = std::move(fanOut->done);
+        fanOut->done = nullptr;
+        done(fanOut->results);
+    }
+}
+
+} // namespace
+
+void fanOut(sd_bus* bus,
+            std::vector<MethodCall>&& calls,
+            std::chrono::microseconds timeout,
+            FanOutDone&& done,
+            size_t window)
+{
+    auto state = std::make_shared<FanOut>();
+    state->bus = bus;
+    state->results.resize(calls.size(), 0);
+    state->calls = std::move(calls);
+    state->deadline = std::chrono::steady_clock::now() + timeout;
+    state->window = std::max<size_t>(window, 1);
+    state->next = 0;
+    state->inFlight = 0;
+    state->done = std::move(done);
+    sendCalls(state);
 }
 
 void deleteAllDbusObjects(sdbusplus::bus::bus& bus,
@@ -325,6 +1181,54 @@ void deleteAllDbusObjects(sdbusplus::bus::bus& bus,
     }
 }
 
+void deleteAllDbusObjects(sd_bus* bus,
+                          const std::string& serviceRoot,
+                          const std::string& interface,
+                          const std::string& match,
+                          std::chrono::microseconds timeout,
+                          std::function<void()>&& done)
+{
+    std::vector<MethodCall> deletes;
+    try
+    {
+        sdbusplus::bus::bus dbus{bus};
+        auto objectTree = getAllDbusObjects(dbus, serviceRoot, interface,
+                                            match);
+
+        deletes.reserve(objectTree.size());
+        for (auto& object : objectTree)
+        {
+            deletes.push_back({object.second.begin()->first, object.first,
+                               DELETE_INTERFACE, "Delete"});
+        }
+    }
+    catch (InternalFailure& e)
+    {
+        log<level::INFO>("Unable to delete the objects having",
+                         entry("INTERFACE=%s", interface.c_str()),
+                         entry("SERVICE=%s", serviceRoot.c_str()));
+    }
+
+    fanOut(bus, std::move(deletes), timeout,
+           [interface, serviceRoot, done](const std::vector<int>& results)
+           {
+               auto failed = std::count_if(results.begin(), results.end(),
+                                           [](int r)
+                                           {
+                                               return r < 0;
+                                           });
+               if (failed)
+               {
+                   log<level::INFO>("Unable to delete the objects having",
+                                    entry("INTERFACE=%s", interface.c_str()),
+                                    entry("SERVICE=%s", serviceRoot.c_str()),
+                                    entry("FAILED=%zu",
+                                          static_cast<size_t>(failed)));
+               }
+               done();
+           });
+}
+
 ObjectTree getAllAncestors(sdbusplus::bus::bus& bus,
                            const std::string& path,
                            InterfaceList&& interfaces)
@@ -345,7 +1249,7 @@ ObjectTree getAllAncestors(sdbusplus::bus::bus& bus,
                                           "GetAncestors");
     mapperCall.append(path, interfaces);
 
-    auto mapperReply = bus.call(mapperCall);
+    auto mapperReply = call(bus, mapperCall);
     if (mapperReply.is_method_error())
     {
         log<level::ERR>("Error in mapper call",
@@ -387,7 +1291,7 @@ void callDbusMethod(sdbusplus::bus::bus& bus,
                          interface.c_str(),
                          method.c_str());
 
-    auto reply = bus.call(busMethod);
+    auto reply = call(bus, busMethod);
 
     if (reply.is_method_error())
     {
@@ -426,7 +1330,7 @@ void createIP(sdbusplus::bus::bus& bus,
 
     busMethod.append(protocolType, ipaddress, prefix, gateway);
 
-    auto reply = bus.call(busMethod);
+    auto reply = call(bus, busMethod);
 
     if (reply.is_method_error())
     {
@@ -452,7 +1356,7 @@ void createVLAN(sdbusplus::bus::bus& bus,
 
     busMethod.append(interfaceName, vlanID);
 
-    auto reply = bus.call(busMethod);
+    auto reply = call(bus, busMethod);
 
     if (reply.is_method_error())
     {
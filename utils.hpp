@@ -1,6 +1,11 @@
 #pragma once
 
 #include "types.hpp"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <systemd/sd-bus.h>
+#include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/server.hpp>
 
 namespace ipmi
@@ -14,15 +19,135 @@ constexpr auto ROOT = "/";
 constexpr auto HOST_MATCH = "host0";
 
 constexpr auto PROP_INTF = "org.freedesktop.DBus.Properties";
+constexpr auto OBJECT_MANAGER_INTF = "org.freedesktop.DBus.ObjectManager";
 constexpr auto DELETE_INTERFACE = "xyz.openbmc_project.Object.Delete";
 
 constexpr auto METHOD_GET = "Get";
 constexpr auto METHOD_GET_ALL = "GetAll";
 constexpr auto METHOD_SET = "Set";
 
+/** @struct CacheStats
+ *  @brief Counters of a cache of D-Bus data.
+ */
+struct CacheStats
+{
+    uint64_t hits = 0;   //!< Lookups answered from the cache.
+    uint64_t misses = 0; //!< Lookups that went to D-Bus.
+    size_t entries = 0;  //!< Objects cached.
+};
+
+namespace timeout
+{
+
+using Clock = std::chrono::steady_clock;
+
+/** @brief Time a request has to be answered in, within the 5 seconds the
+ *         BT and KCS bridges wait for ipmid.
+ */
+constexpr auto requestBudget = std::chrono::seconds(4);
+
+/** @brief Budget of the calls to the interfaces without one of their own */
+constexpr auto defaultBudget = std::chrono::seconds(2);
+
+/** @class Scope
+ *  @brief Sets the deadline of the request the calling thread handles, for
+ *         the lifetime of the object.
+ *
+ *  The calls of call() and callMethod() are bounded by the deadline, and
+ *  are not made at all once it passed.
+ */
+class Scope
+{
+    public:
+        explicit Scope(Clock::time_point deadline);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Clock::time_point previous;
+};
+
+/** @brief Deadline of the request the calling thread handles, or
+ *         Clock::time_point::max() outside of a Scope.
+ */
+Clock::time_point deadline();
+
+/** @brief Sets the budget of the calls to interfaces without one of their
+ *         own. Not thread safe, set before handling requests.
+ */
+void setDefaultBudget(std::chrono::microseconds budget);
+
+/** @brief Sets the budget of the calls to an interface. Not thread safe,
+ *         set before handling requests.
+ */
+void setBudget(const std::string& interface,
+               std::chrono::microseconds budget);
+
+/** @brief Timeout of a call to an interface: its budget, capped to what is
+ *         left of the request's deadline
+ *
+ *  @param[in] interface - Interface of the call, nullptr for the default
+ *                         budget.
+ *
+ *  @return The timeout in us, 0 if the deadline of the request passed.
+ */
+uint64_t get(const char* interface);
+
+/** @struct Stats
+ *  @brief Counters of the calls cut short, across all threads.
+ */
+struct Stats
+{
+    uint64_t timedOut = 0;  //!< Calls that ran out of their timeout.
+    uint64_t abandoned = 0; //!< Calls and requests dropped past deadline.
+};
+
+Stats stats();
+
+void resetStats();
+
+/** @brief Counts a request dropped because its deadline passed */
+void abandoned();
+
+/** @brief Counts and logs a call that ran out of its timeout, for the
+ *         asynchronous calls made with a timeout of get().
+ */
+void timedOut(const char* path, const char* interface, const char* member);
+
+} // namespace timeout
+
+/** @brief sdbusplus' bus::call(), with the timeout of timeout::get()
+ *
+ *  @return The reply, which is an error if the call failed, timed out or
+ *          was not made because the deadline of the request passed.
+ */
+sdbusplus::message::message call(sdbusplus::bus::bus& bus,
+                                 sdbusplus::message::message& m);
+
+/** @brief sd_bus_call(), with the timeout of timeout::get()
+ *
+ *  @return As sd_bus_call(), -ETIMEDOUT if the call was not made because
+ *          the deadline of the request passed.
+ */
+int call(sd_bus* bus, sd_bus_message* m, sd_bus_error* error,
+         sd_bus_message** reply);
+
+/** @brief sd_bus_call_method(), with the timeout of timeout::get()
+ *
+ *  Properties calls take the budget of the interface named by their first
+ *  argument, e.g. Get of a sensor's Value.
+ */
+int callMethod(sd_bus* bus, const char* destination, const char* path,
+               const char* interface, const char* member, sd_bus_error* error,
+               sd_bus_message** reply, const char* types, ...);
+
 /**
  * @brief Get the DBUS Service name for the input dbus path
  *
+ * The services are cached process wide until their owner changes or
+ * interfaces are added to or removed from the object.
+ *
  * @param[in] bus - DBUS Bus Object
  * @param[in] intf - DBUS Interface
  * @param[in] path - DBUS Object Path
@@ -32,6 +157,24 @@ std::string getService(sdbusplus::bus::bus& bus,
                        const std::string& intf,
                        const std::string& path);
 
+/** @brief Gets the service of an object, whatever its interfaces, through
+ *         the getService() cache. A drop-in for libmapper's
+ *         mapper_get_service().
+ *
+ *  @param[in] bus - Bus connection.
+ *  @param[in] path - Object path.
+ *  @param[out] service - The service, to be freed by the caller.
+ *
+ *  @return 0 on success, a negative errno otherwise.
+ */
+int getService(sd_bus* bus, const char* path, char** service);
+
+/** @brief Counters of the getService() cache */
+CacheStats getServiceCacheStats();
+
+/** @brief Zeroes the hit and miss counters of the getService() cache */
+void resetServiceCacheStats();
+
 /** @brief Gets the dbus object info implementing the given interface
  *         from the given subtree.
  *  @param[in] bus - DBUS Bus Object.
@@ -87,6 +230,143 @@ PropertyMap getAllDbusProperties(sdbusplus::bus::bus& bus,
                                  const std::string& objPath,
                                  const std::string& interface);
 
+/** @class ManagedObjects
+ *  @brief Snapshot of the objects of a service, read with a single
+ *         GetManagedObjects call by getManagedObjects().
+ *
+ *  @tparam Property - Variant the properties are read into. A property of
+ *                     a type it can't hold is left default constructed.
+ */
+template <typename Property = Value>
+class ManagedObjects
+{
+    public:
+        using Properties = std::map<DbusProperty, Property>;
+        using Interfaces = std::map<DbusInterface, Properties>;
+        using Objects = std::map<DbusObjectPath, Interfaces>;
+
+        ManagedObjects() = default;
+        explicit ManagedObjects(Objects&& objects) :
+            objects(std::move(objects)) {}
+
+        /** @brief Properties of an interface of an object
+         *  @return nullptr if the object doesn't implement the interface.
+         */
+        const Properties* find(const std::string& path,
+                               const std::string& interface) const
+        {
+            auto object = objects.find(path);
+            if (object == objects.end())
+            {
+                return nullptr;
+            }
+            auto properties = object->second.find(interface);
+            return properties != object->second.end() ?
+                   &properties->second : nullptr;
+        }
+
+        /** @brief A property of an object
+         *  @return nullptr if the object doesn't have the property.
+         */
+        const Property* find(const std::string& path,
+                             const std::string& interface,
+                             const std::string& property) const
+        {
+            auto properties = find(path, interface);
+            if (properties == nullptr)
+            {
+                return nullptr;
+            }
+            auto value = properties->find(property);
+            return value != properties->end() ? &value->second : nullptr;
+        }
+
+        /** @brief Paths of the objects below root, root excluded,
+         *         implementing interface, in lexical order.
+         *  @param[in] interface - Interface, empty for any.
+         *  @param[in] root - Root of the subtree.
+         */
+        std::vector<DbusObjectPath> paths(const std::string& interface,
+                                          const std::string& root = ROOT) const
+        {
+            auto prefix = root;
+            if (prefix.empty() || prefix.back() != '/')
+            {
+                prefix += '/';
+            }
+
+            std::vector<DbusObjectPath> found;
+            for (auto iter = objects.lower_bound(prefix);
+                 iter != objects.end() &&
+                 iter->first.compare(0, prefix.size(), prefix) == 0;
+                 ++iter)
+            {
+                if (interface.empty() || iter->second.count(interface) != 0)
+                {
+                    found.push_back(iter->first);
+                }
+            }
+            return found;
+        }
+
+        /** @brief Every object of the snapshot, by path */
+        const Objects& all() const
+        {
+            return objects;
+        }
+
+        size_t size() const
+        {
+            return objects.size();
+        }
+
+    private:
+        Objects objects;
+};
+
+namespace internal
+{
+
+/** @brief Calls GetManagedObjects, see ipmi::getManagedObjects()
+ *  @return The reply, a method error is reported with InternalFailure.
+ */
+sdbusplus::message::message callGetManagedObjects(
+    sdbusplus::bus::bus& bus,
+    const std::string& service,
+    const std::string& managerPath);
+
+} // namespace internal
+
+/** @brief Reads every object of a service in a single D-Bus call, rather
+ *         than a GetAll per object.
+ *  @param[in] bus - DBUS Bus Object.
+ *  @param[in] service - Dbus service name.
+ *  @param[in] managerPath - Object implementing the ObjectManager of the
+ *                           service, the objects below it are read.
+ *  @return The snapshot, reading it makes no D-Bus call.
+ */
+template <typename Property = Value>
+ManagedObjects<Property> getManagedObjects(sdbusplus::bus::bus& bus,
+                                           const std::string& service,
+                                           const std::string& managerPath)
+{
+    using Objects = typename ManagedObjects<Property>::Objects;
+    using Reply = std::map<sdbusplus::message::object_path,
+                           typename ManagedObjects<Property>::Interfaces>;
+
+    auto reply = internal::callGetManagedObjects(bus, service, managerPath);
+    Reply objectPaths;
+    reply.read(objectPaths);
+
+    Objects objects;
+    for (auto& object : objectPaths)
+    {
+        objects.emplace_hint(objects.end(), object.first.str,
+                             std::move(object.second));
+    }
+    return ManagedObjects<Property>(std::move(objects));
+}
+
 /** @brief Sets the property value of the given object.
  *  @param[in] bus - DBUS Bus Object.
  *  @param[in] service - Dbus service name.
@@ -102,6 +382,156 @@ void setDbusProperty(sdbusplus::bus::bus& bus,
                      const std::string& property,
                      const Value& value);
 
+/** @class PropertyCache
+ *  @brief Properties of D-Bus objects, kept up to date from their
+ *         PropertiesChanged signals rather than read on every use.
+ *
+ *  An interface is watched from its first get(), or watch(). Its
+ *  properties are then read with a single GetAll, and again only after
+ *  its service changed owner or a property was invalidated. Properties
+ *  missing from GetAll are read with a Get every time.
+ *
+ *  Only for properties that emit PropertiesChanged. Like the bus
+ *  connection, it is not thread safe.
+ */
+class PropertyCache
+{
+    public:
+        PropertyCache() = default;
+        ~PropertyCache() = default;
+        PropertyCache(const PropertyCache&) = delete;
+        PropertyCache& operator=(const PropertyCache&) = delete;
+        PropertyCache(PropertyCache&&) = delete;
+        PropertyCache& operator=(PropertyCache&&) = delete;
+
+        /** @brief Starts watching an interface of an object, reading its
+         *         properties now rather than on the first get().
+         *  @param[in] bus - DBUS Bus Object.
+         *  @param[in] service - Dbus service name.
+         *  @param[in] objPath - Dbus object path.
+         *  @param[in] interface - Dbus interface.
+         */
+        void watch(sdbusplus::bus::bus& bus,
+                   const std::string& service,
+                   const std::string& objPath,
+                   const std::string& interface);
+
+        /** @brief Gets the value of a property, watching its interface
+         *  @param[in] bus - DBUS Bus Object.
+         *  @param[in] service - Dbus service name.
+         *  @param[in] objPath - Dbus object path.
+         *  @param[in] interface - Dbus interface.
+         *  @param[in] property - name of the property.
+         *  @return On success returns the value of the property.
+         */
+        Value get(sdbusplus::bus::bus& bus,
+                  const std::string& service,
+                  const std::string& objPath,
+                  const std::string& interface,
+                  const std::string& property);
+
+        template <typename T>
+        T get(sdbusplus::bus::bus& bus,
+              const std::string& service,
+              const std::string& objPath,
+              const std::string& interface,
+              const std::string& property)
+        {
+            return get(bus, service, objPath, interface, property)
+                       .template get<T>();
+        }
+
+        /** @brief Reads the properties of an interface again on the next
+         *         get(), e.g. after setting one of them.
+         */
+        void invalidate(const std::string& objPath,
+                        const std::string& interface);
+
+        CacheStats stats() const;
+
+        /** @brief Zeroes the hit and miss counters */
+        void resetStats();
+
+    private:
+        /** @struct Entry
+         *  @brief A watched interface.
+         */
+        struct Entry
+        {
+            sd_bus* bus = nullptr;
+            std::string service;
+            PropertyMap properties;
+            bool fresh = false;
+            std::unique_ptr<sdbusplus::bus::match_t> match;
+        };
+
+        /** @brief Path and interface of an object */
+        using Key = std::pair<std::string, std::string>;
+
+        /** @brief Entry of an interface, subscribing to its signals on bus
+         *         if not yet.
+         */
+        Entry& watched(sdbusplus::bus::bus& bus,
+                       const std::string& service,
+                       const std::string& objPath,
+                       const std::string& interface);
+
+        /** @brief Reads the properties of a watched interface */
+        void refresh(sdbusplus::bus::bus& bus,
+                     const std::string& objPath,
+                     const std::string& interface,
+                     Entry& entry);
+
+        std::map<Key, Entry> entries;
+        sd_bus* ownerBus = nullptr;
+        std::unique_ptr<sdbusplus::bus::match_t> ownerMatch;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+};
+
+/** @brief The process wide PropertyCache */
+PropertyCache& propertyCache();
+
+/** @brief Called for every service of every object of a mapper GetSubTree
+ *         reply, in the order of the reply
+ *
+ *  @param[in] path - Object path.
+ *  @param[in] service - Service of the object.
+ *  @param[in] interfaces - Interfaces of the object on the service.
+ *
+ *  The strings point into the reply, copy them to keep them.
+ *
+ *  @return true to stop there.
+ */
+using SubTreeVisitor =
+    std::function<bool(const char* path, const char* service,
+                       const std::vector<const char*>& interfaces)>;
+
+/** @brief Called for every path of a mapper GetSubTreePaths reply
+ *
+ *  @return true to stop there.
+ */
+using PathVisitor = std::function<bool(const char* path)>;
+
+/** @brief Reads a GetSubTree reply entry by entry, without building the
+ *         whole tree
+ *
+ *  @param[in] reply - Mapper GetSubTree reply.
+ *  @param[in] visit - Visitor of the entries.
+ *
+ *  @return 0 on success, stopped or not, a negative errno otherwise.
+ */
+int visitSubTree(sd_bus_message* reply, const SubTreeVisitor& visit);
+
+/** @brief Reads a GetSubTreePaths reply path by path
+ *
+ *  @param[in] reply - Mapper GetSubTreePaths reply.
+ *  @param[in] visit - Visitor of the paths.
+ *
+ *  @return 0 on success, stopped or not, a negative errno otherwise.
+ */
+int visitSubTreePaths(sd_bus_message* reply, const PathVisitor& visit);
+
 /** @brief  Gets all the dbus objects from the given service root
  *          which matches the object identifier.
  *  @param[in] bus - DBUS Bus Object.
@@ -115,8 +545,56 @@ ObjectTree getAllDbusObjects(sdbusplus::bus::bus& bus,
                              const std::string& interface,
                              const std::string& match);
 
+/** @struct MethodCall
+ *  @brief A method call without arguments, see fanOut().
+ */
+struct MethodCall
+{
+    std::string service;
+    std::string path;
+    std::string interface;
+    std::string method;
+};
+
+/** @brief Completion of fanOut()
+ *  @param[in] results - Result of each call, in order: 0, or a negative
+ *                       errno. -ETIMEDOUT for the calls not answered by
+ *                       the deadline.
+ */
+using FanOutDone = std::function<void(const std::vector<int>& results)>;
+
+/** @brief Most calls fanOut() keeps in flight by default, well below the
+ *         bus' limit of pending replies per connection.
+ */
+constexpr size_t fanOutWindow = 32;
+
+/** @brief Issues method calls without waiting for each reply before the
+ *         next call, at most window of them in flight.
+ *
+ *  The replies are dispatched by the event loop of the bus, done runs from
+ *  there once every call is answered or timed out. It runs before fanOut()
+ *  returns if no call could be sent. A service handles the calls of a
+ *  connection in order, so if every call fits in the window they are
+ *  handled before any call the caller makes after fanOut() returns. The
+ *  calls beyond the window are sent as replies come in, only done tells
+ *  when they were handled.
+ *
+ *  @param[in] bus - Bus connection, attached to an event loop.
+ *  @param[in] calls - Method calls.
+ *  @param[in] timeout - Deadline of all the calls, from now.
+ *  @param[in] done - Completion.
+ *  @param[in] window - Most calls in flight, the remaining calls are sent
+ *                      as replies come in.
+ */
+void fanOut(sd_bus* bus,
+            std::vector<MethodCall>&& calls,
+            std::chrono::microseconds timeout,
+            FanOutDone&& done,
+            size_t window = fanOutWindow);
+
 /** @brief Deletes all the dbus objects from the given service root
            which matches the object identifier.
+ *
  *  @param[in] bus - DBUS Bus Object.
  *  @param[in] serviceRoot - Service root path.
  *  @param[in] interface - Dbus interface.
@@ -127,6 +605,27 @@ void deleteAllDbusObjects(sdbusplus::bus::bus& bus,
                           const std::string& interface,
                           const std::string& match = {});
 
+/** @brief Deletes all the dbus objects from the given service root which
+ *         match the object identifier, the deletes in flight together.
+ *
+ *  The objects are looked up before fanOut() sends the deletes, a delete
+ *  that fails is logged and does not stop the others. done runs as
+ *  fanOut() runs its completion.
+ *
+ *  @param[in] bus - Bus connection, attached to an event loop.
+ *  @param[in] serviceRoot - Service root path.
+ *  @param[in] interface - Dbus interface.
+ *  @param[in] match - Identifier for object.
+ *  @param[in] timeout - Deadline of all the deletes, from now.
+ *  @param[in] done - Completion.
+ */
+void deleteAllDbusObjects(sd_bus* bus,
+                          const std::string& serviceRoot,
+                          const std::string& interface,
+                          const std::string& match,
+                          std::chrono::microseconds timeout,
+                          std::function<void()>&& done);
+
 /** @brief Gets the ancestor objects of the given object
            which implements the given interface.
  *  @param[in] bus - Dbus bus object.
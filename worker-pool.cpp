@@ -0,0 +1,212 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <stdexcept>
+#include "worker-pool.hpp"
+
+namespace ipmi
+{
+namespace worker
+{
+
+Pool::Pool(sd_event* event, size_t threads, size_t depth) :
+    pending(depth),
+    finished(depth),
+    depth(depth)
+{
+    if (sem_init(&available, 0, 0) < 0)
+    {
+        throw std::runtime_error("Failed to create the worker semaphore");
+    }
+
+    completionFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (completionFd < 0)
+    {
+        sem_destroy(&available);
+        throw std::runtime_error("Failed to create the worker eventfd");
+    }
+
+    auto r = sd_event_add_io(event, &completionSource, completionFd, EPOLLIN,
+                             onCompletion, this);
+    if (r < 0)
+    {
+        close(completionFd);
+        sem_destroy(&available);
+        throw std::runtime_error("Failed to watch the worker eventfd");
+    }
+
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers.emplace_back(&Pool::run, this);
+    }
+}
+
+Pool::~Pool()
+{
+    stopping = true;
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        sem_post(&available);
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    Task* task;
+    while (pending.pop(task))
+    {
+        delete task;
+    }
+    while (finished.pop(task))
+    {
+        delete task;
+    }
+    for (auto& key : serialized)
+    {
+        for (auto waiting : key.second)
+        {
+            delete waiting;
+        }
+    }
+
+    sd_event_source_unref(completionSource);
+    close(completionFd);
+    sem_destroy(&available);
+}
+
+bool Pool::submit(int key, Work&& work, Work&& done)
+{
+    if (inFlight >= depth)
+    {
+        return false;
+    }
+
+    auto task = new Task{key, std::move(work), std::move(done)};
+    ++inFlight;
+
+    if (key != parallel)
+    {
+        auto it = serialized.find(key);
+        if (it != serialized.end())
+        {
+            // Another task of the key is in flight, it starts this one once
+            // it completes.
+            it->second.push_back(task);
+            return true;
+        }
+        serialized.emplace(key, std::deque<Task*>());
+    }
+
+    start(task);
+    return true;
+}
+
+void Pool::start(Task* task)
+{
+    // Never fails, there are no more than depth tasks in flight.
+    if (pending.push(task))
+    {
+        sem_post(&available);
+        return;
+    }
+
+    task->work();
+    --inFlight;
+    complete(task);
+}
+
+void Pool::complete(Task* task)
+{
+    std::unique_ptr<Task> owner(task);
+    task->done();
+
+    if (task->key == parallel)
+    {
+        return;
+    }
+
+    auto it = serialized.find(task->key);
+    if (it == serialized.end())
+    {
+        return;
+    }
+    if (it->second.empty())
+    {
+        serialized.erase(it);
+        return;
+    }
+
+    auto next = it->second.front();
+    it->second.pop_front();
+    start(next);
+}
+
+void Pool::run()
+{
+    for (;;)
+    {
+        if (sem_wait(&available) < 0)
+        {
+            // Interrupted by a signal
+            continue;
+        }
+        if (stopping)
+        {
+            return;
+        }
+
+        Task* task;
+        if (!pending.pop(task))
+        {
+            continue;
+        }
+
+        try
+        {
+            task->work();
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "ERROR: Exception in worker task: %s\n",
+                    e.what());
+        }
+
+        // Never fails, there are no more than depth tasks in flight.
+        finished.push(task);
+
+        uint64_t one = 1;
+        if (write(completionFd, &one, sizeof(one)) < 0)
+        {
+            fprintf(stderr, "ERROR: Failed to signal a worker completion: "
+                    "%s\n", strerror(errno));
+        }
+    }
+}
+
+int Pool::onCompletion(sd_event_source* source, int fd, uint32_t revents,
+                       void* userData)
+{
+    auto pool = static_cast<Pool*>(userData);
+
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        fprintf(stderr, "ERROR: Failed to read the worker eventfd: %s\n",
+                strerror(errno));
+    }
+
+    Task* task;
+    while (pool->finished.pop(task))
+    {
+        --pool->inFlight;
+        pool->complete(task);
+    }
+    return 0;
+}
+
+} // namespace worker
+} // namespace ipmi
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+#include <stdint.h>
+#include <systemd/sd-event.h>
+
+namespace ipmi
+{
+namespace worker
+{
+
+/** @class Queue
+ *  @brief Bounded lock-free multi-producer multi-consumer queue.
+ *
+ *  Every cell carries a sequence number which tells producers and consumers
+ *  whether the cell is free for the current lap, so neither side ever takes
+ *  a lock.
+ */
+template <typename T>
+class Queue
+{
+    public:
+        Queue() = delete;
+        ~Queue() = default;
+        Queue(const Queue&) = delete;
+        Queue& operator=(const Queue&) = delete;
+        Queue(Queue&&) = delete;
+        Queue& operator=(Queue&&) = delete;
+
+        /** @brief Constructs an empty queue
+         *
+         *  @param[in] capacity - Maximum number of elements, rounded up to
+         *                        a power of two.
+         */
+        explicit Queue(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            mask = size - 1;
+            cells.reset(new Cell[size]);
+            for (size_t i = 0; i < size; ++i)
+            {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        /** @brief Appends a value
+         *
+         *  @return false if the queue is full.
+         */
+        bool push(T value)
+        {
+            Cell* cell;
+            auto pos = tail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell = &cells[pos & mask];
+                auto seq = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<intptr_t>(seq) -
+                            static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (tail.compare_exchange_weak(pos, pos + 1,
+                                                   std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = tail.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** @brief Removes the oldest value
+         *
+         *  @param[out] value - The value removed.
+         *
+         *  @return false if the queue is empty.
+         */
+        bool pop(T& value)
+        {
+            Cell* cell;
+            auto pos = head.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell = &cells[pos & mask];
+                auto seq = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<intptr_t>(seq) -
+                            static_cast<intptr_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (head.compare_exchange_weak(pos, pos + 1,
+                                                   std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = head.load(std::memory_order_relaxed);
+                }
+            }
+            value = std::move(cell->value);
+            cell->sequence.store(pos + mask + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+
+        /** @brief Producer and consumer positions, on separate cache lines */
+        alignas(64) std::atomic<size_t> tail{0};
+        alignas(64) std::atomic<size_t> head{0};
+};
+
+/** @class Pool
+ *  @brief Runs work on worker threads and its completion on the event loop.
+ *
+ *  Tasks are handed to the workers through a lock-free queue. Finished tasks
+ *  come back through a second one, and an eventfd wakes up the event loop
+ *  to run their completions.
+ */
+class Pool
+{
+    public:
+        using Work = std::function<void()>;
+
+        /** @brief Key of tasks that may run concurrently with any other */
+        static constexpr int parallel = -1;
+
+        Pool() = delete;
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+        Pool(Pool&&) = delete;
+        Pool& operator=(Pool&&) = delete;
+
+        /** @brief Starts the worker threads
+         *
+         *  @param[in] event - sd_event loop to run completions on.
+         *  @param[in] threads - Number of worker threads.
+         *  @param[in] depth - Maximum number of tasks in flight.
+         *
+         *  @error std::runtime_error on failure to set up the pool.
+         */
+        Pool(sd_event* event, size_t threads, size_t depth = 64);
+
+        /** @brief Stops the workers. Tasks that did not run yet are
+         *         dropped without their completion.
+         */
+        ~Pool();
+
+        /** @brief Runs work on a worker thread, then done on the event loop.
+         *
+         *  Tasks sharing a key other than parallel run one at a time, in
+         *  the order they were submitted. Must be called from the event loop.
+         *
+         *  @param[in] key - Serialization key, or parallel.
+         *  @param[in] work - Runs on a worker thread.
+         *  @param[in] done - Runs on the event loop once work has returned.
+         *
+         *  @return false if too many tasks are in flight, the caller should
+         *          then do the work itself.
+         */
+        bool submit(int key, Work&& work, Work&& done);
+
+    private:
+        struct Task
+        {
+            int key;
+            Work work;
+            Work done;
+        };
+
+        /** @brief Worker thread main loop */
+        void run();
+
+        /** @brief Hands a task to the workers */
+        void start(Task* task);
+
+        /** @brief Runs the completion of a task and starts the next one
+         *         waiting on the same key.
+         */
+        void complete(Task* task);
+
+        /** @brief Drains the finished tasks when the eventfd fires */
+        static int onCompletion(sd_event_source* source, int fd,
+                                uint32_t revents, void* userData);
+
+        /** @brief Tasks for the workers */
+        Queue<Task*> pending;
+
+        /** @brief Tasks the workers finished */
+        Queue<Task*> finished;
+
+        /** @brief Counts the tasks in pending, workers sleep on it */
+        sem_t available;
+
+        /** @brief Signalled by the workers when they finish a task */
+        int completionFd = -1;
+
+        /** @brief Event source of completionFd */
+        sd_event_source* completionSource = nullptr;
+
+        std::vector<std::thread> workers;
+
+        std::atomic<bool> stopping{false};
+
+        /** @brief Maximum number of tasks in flight */
+        size_t depth;
+
+        /** @brief Tasks submitted and not yet completed, including those
+         *         waiting on their key. Only used from the event loop.
+         */
+        size_t inFlight = 0;
+
+        /** @brief Keys with a task in flight and the tasks waiting for it.
+         *         Only used from the event loop.
+         */
+        std::map<int, std::deque<Task*>> serialized;
+};
+
+} // namespace worker
+} // namespace ipmi